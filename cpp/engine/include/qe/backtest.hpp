@@ -1,27 +1,37 @@
 #pragma once
 
 #include <cstddef>
+#include <span>
 #include <vector>
 
 #include "qe/data.hpp"
 
 namespace qe {
 
-// Transaction cost model (basis points)
+// Transaction cost model (basis points). A trade is a change of position (flat <-> long);
+// each one costs fee_bps + slippage_bps of the equity before that step, taken off that
+// step's strategy return.
 struct BacktestCosts {
   double fee_bps = 0.0;
   double slippage_bps = 0.0;
+
+  // fraction of equity charged per trade
+  double per_trade() const { return (fee_bps + slippage_bps) / 10000.0; }
 };
 
+// what a backtest hands back: the per-step series and the metrics, or the metrics alone
+enum class BacktestOutput { Full, MetricsOnly };
+
 struct BacktestResult {
-  std::vector<double> equity;     // equity curve
-  std::vector<double> strat_ret;  // strategy returns per step
+  std::vector<double> equity;     // equity curve (empty with BacktestOutput::MetricsOnly)
+  std::vector<double> strat_ret;  // strategy returns per step, net of costs (likewise)
   double total_return = 0.0;
   double max_drawdown = 0.0;
   double sharpe = 0.0;
+  double win_rate = 0.0;          // compute_win_rate(strat_ret)
 
   std::size_t n_trades = 0;
-  double total_cost = 0.0;
+  double total_cost = 0.0;        // sum of the trade charges, in equity units
 };
 
 BacktestResult backtest_sma_crossover(
@@ -32,4 +42,32 @@ BacktestResult backtest_sma_crossover(
   BacktestCosts costs = {}
 );
 
+// Same strategy on a close column (e.g. OhlcvColumns::close), no copies of the input.
+// MetricsOnly leaves equity / strat_ret empty and runs in O(1) memory whatever the length;
+// its metrics are bit-identical to Full's.
+BacktestResult backtest_sma_crossover(
+  std::span<const double> close,
+  std::size_t fast_window,
+  std::size_t slow_window,
+  double initial_equity = 1.0,
+  BacktestCosts costs = {},
+  BacktestOutput output = BacktestOutput::Full
+);
+
+// Same backtest writing the per-step series into caller buffers of close.size() - 1 values,
+// with nothing heap-allocated. Returns, both SMAs, the signal, equity, drawdown and the mean
+// return come out of one pass over close, the variance out of a second over strat_ret; the
+// results are bit-identical to the overloads above. Both buffers empty is MetricsOnly (the
+// second pass then recomputes the returns from close). std::invalid_argument for any other
+// size. The returned result carries the metrics and leaves equity / strat_ret empty.
+BacktestResult backtest_sma_crossover(
+  std::span<const double> close,
+  std::size_t fast_window,
+  std::size_t slow_window,
+  double initial_equity,
+  BacktestCosts costs,
+  std::span<double> strat_ret,
+  std::span<double> equity
+);
+
 } // 
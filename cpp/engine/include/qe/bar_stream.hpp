@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "qe/data.hpp"
+#include "qe/qec.hpp"
+
+namespace qe {
+
+struct BarStreamOptions {
+  // bars per batch handed out by next()
+  std::size_t batch_rows = 65536;
+
+  // ceiling for the stream's own buffers (read buffer + one batch of columns);
+  // batch_rows is lowered if it would not fit
+  std::size_t max_bytes = std::size_t{32} << 20;
+
+  // fields to read (see CsvReadOptions::columns); unselected batch columns stay empty
+  Columns columns = Columns::All;
+};
+
+// Pull-based reader over an OHLCV CSV or .qec file that never holds more than one
+// batch of bars, so memory stays flat regardless of file size.
+//
+//   qe::BarStream s(path);
+//   qe::OhlcvColumns batch;
+//   while (s.next(batch)) { ... }
+//
+// CSV errors match read_ohlcv_columns (same messages and line numbers).
+// Compressed .qec files are decoded one kCodecBlock block at a time.
+class BarStream {
+public:
+  explicit BarStream(const std::string& path, BarStreamOptions opts = {});
+
+  // replaces batch with the next 1..batch_rows() bars; returns false once the data is exhausted
+  bool next(OhlcvColumns& batch);
+
+  std::size_t batch_rows() const { return batch_rows_; }
+  std::size_t rows_read() const { return rows_read_; }
+
+private:
+  bool next_csv(OhlcvColumns& batch);
+  void refill();
+  bool next_qec(OhlcvColumns& batch);
+  bool next_compressed(OhlcvColumns& batch);
+  void read_block_tables(std::uint64_t file_size);
+  void decode_block(std::size_t b);
+
+  std::string path_;
+  std::ifstream in_;
+  std::size_t batch_rows_ = 0;
+  std::size_t rows_read_ = 0;
+  unsigned mask_ = 0;
+
+  // csv state: buf_[pos_, len_) is unparsed input
+  std::vector<char> buf_;
+  std::size_t pos_ = 0;
+  std::size_t len_ = 0;
+  std::size_t line_no_ = 1;
+  bool eof_ = false;
+
+  // qec state
+  bool qec_ = false;
+  QecHeader header_{};
+
+  // compressed qec: per-column block tables (small) and the one decoded block being handed out
+  struct EncodedColumnFile {
+    std::uint64_t words_at = 0; // file offset of the packed words
+    std::uint64_t words = 0;
+    std::vector<std::uint64_t> block_bit;
+  };
+  std::vector<EncodedColumnFile> encoded_;
+  std::vector<std::uint64_t> word_buf_;
+  OhlcvColumns block_;
+  std::size_t block_rows_ = 0;
+  std::size_t block_pos_ = 0;
+  std::size_t next_block_ = 0;
+};
+
+} // namespace qe
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "qe/data.hpp"
+
+namespace qe {
+
+// Compressed column encoding for cached OHLCV data.
+//
+//  timestamps: delta-of-delta, variable-width buckets (evenly spaced bars cost 1 bit each)
+//  doubles:    per block, either scaled decimal (every value is exactly k / 10^d, as for
+//              fixed-decimal prices and volumes: deltas of k in variable-width buckets) or
+//              Gorilla XOR against the previous value (repeats cost 1 bit, small moves
+//              reuse the previous leading/trailing-zero window). Both are bit-exact.
+//
+// Values are cut into blocks of kCodecBlock; every block starts with a raw value, so
+// any block decodes on its own from block_bit[b]. Bits are packed MSB-first into
+// little-endian 64-bit words.
+inline constexpr std::size_t kCodecBlock = 4096;
+
+// non-owning view, e.g. into a mapped compressed .qec file
+struct EncodedColumnView {
+  std::size_t size = 0;                      // values
+  std::span<const std::uint64_t> block_bit;  // first bit of each block
+  std::span<const std::uint64_t> words;
+
+  std::size_t blocks() const { return block_bit.size(); }
+  std::size_t block_size(std::size_t b) const;
+  std::size_t bytes() const { return (block_bit.size() + words.size()) * 8; }
+};
+
+struct EncodedColumn {
+  std::size_t size = 0;
+  std::vector<std::uint64_t> block_bit;
+  std::vector<std::uint64_t> words;
+
+  EncodedColumnView view() const { return {size, block_bit, words}; }
+};
+
+EncodedColumn encode_timestamps(std::span<const std::int64_t> values);
+EncodedColumn encode_doubles(std::span<const double> values);
+
+// decodes block b into out[0, col.block_size(b)) and returns that count
+std::size_t decode_timestamps_block(const EncodedColumnView& col, std::size_t b, std::int64_t* out);
+std::size_t decode_doubles_block(const EncodedColumnView& col, std::size_t b, double* out);
+
+// same, for a block whose bits start at first_bit of words (used when only part
+// of a column has been read from disk)
+void decode_timestamps(std::span<const std::uint64_t> words, std::uint64_t first_bit,
+                       std::size_t count, std::int64_t* out);
+void decode_doubles(std::span<const std::uint64_t> words, std::uint64_t first_bit,
+                    std::size_t count, double* out);
+
+// false if the double block at first_bit starts with a mode no encoder writes (a corrupt
+// file); decode_doubles throws std::runtime_error for such a block, and for an XOR
+// window that does not fit in 64 bits
+bool double_block_mode_valid(std::span<const std::uint64_t> words, std::uint64_t first_bit);
+
+struct CompressedOhlcvView {
+  EncodedColumnView ts;
+  EncodedColumnView open;
+  EncodedColumnView high;
+  EncodedColumnView low;
+  EncodedColumnView close;
+  EncodedColumnView volume;
+
+  std::size_t size() const { return close.size; }
+  std::size_t blocks() const { return close.blocks(); }
+  std::size_t bytes() const;
+
+  // replaces out with the bars of block b; unselected columns are left empty
+  void decode_block(std::size_t b, OhlcvColumns& out, Columns columns = Columns::All) const;
+  OhlcvColumns decode(Columns columns = Columns::All) const;
+};
+
+// OHLCV held compressed in memory; decode() or decode_block() to use it
+struct CompressedOhlcv {
+  EncodedColumn ts;
+  EncodedColumn open;
+  EncodedColumn high;
+  EncodedColumn low;
+  EncodedColumn close;
+  EncodedColumn volume;
+
+  std::size_t size() const { return close.size; }
+  CompressedOhlcvView view() const {
+    return {ts.view(), open.view(), high.view(), low.view(), close.view(), volume.view()};
+  }
+};
+
+CompressedOhlcv compress(const OhlcvView& data);
+
+} // namespace qe
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace qe {
+
+// Rolling covariance / correlation across many aligned series (e.g. one return series per
+// symbol of a universe). Bars are pushed time-major: one bar is n_series values.
+//
+// The matrix of cross products of the window is kept up to date with a rank-2 update per
+// bar (the new bar added, the one leaving subtracted), so a bar costs O(n_series^2) whatever
+// the window. Once per window turnover it is rebuilt exactly around the window mean, which
+// bounds the drift of the running sums as rolling_std does. Updates run row segment by row
+// segment over column tiles that keep the bars in cache, with the vector kernels, and the
+// rows can be split across threads.
+//
+// Population moments (divide by window), as rolling_std. A NaN makes the entries of its
+// series NaN until it has left the window and the next rebuild has run (at most one more
+// window); a series with zero variance has NaN correlations.
+class RollingCovariance {
+public:
+  // threads = 0 uses all cores; small updates run on the calling thread regardless
+  RollingCovariance(std::size_t n_series, std::size_t window, std::size_t threads = 1);
+
+  std::size_t n_series() const { return n_; }
+  std::size_t window() const { return window_; }
+  std::size_t count() const { return count_; }
+  bool ready() const { return count_ >= window_; }
+
+  // one bar of n_series values
+  void push(std::span<const double> bar);
+
+  // bars.size() / n_series bars, time-major; pushing them together lets the updates that
+  // only matter at the end be skipped or batched (a bar block is applied per tile)
+  void push_bars(std::span<const double> bars);
+
+  // n_series x n_series, row-major, of the current window (NaN until ready)
+  void covariance(std::span<double> out) const;
+  void correlation(std::span<double> out) const;
+
+private:
+  void rebuild();
+  void update(std::size_t first_bar, std::size_t k, std::span<const double> bars);
+  template <class Fn>
+  void for_row_shards(std::size_t work, Fn&& fn);
+
+  std::size_t n_;
+  std::size_t window_;
+  std::size_t threads_;
+
+  std::vector<double> ring_;      // the window's bars, bar c at row c % window
+  std::size_t count_ = 0;
+
+  std::vector<double> shift_;     // per-series center of the cross products (window mean at the last rebuild)
+  std::vector<double> sum_;       // sum of (x - shift) over the window
+  std::vector<double> cross_;     // upper triangle (j >= i) of sum (x - shift)(x - shift)^T, row-major n x n
+
+  // per-update scratch: centered bars entering (added_) and leaving (removed_), each k x n
+  // followed by its transpose (a row's coefficients); a rebuild keeps the centered window in
+  // added_ and its transpose in removed_
+  std::vector<double> added_;
+  std::vector<double> removed_;
+  std::vector<std::size_t> shard_rows_; // row boundaries giving each thread a similar triangle area
+};
+
+struct RollingCovOptions {
+  std::size_t window = 60;
+  std::size_t stride = 1;     // visit every stride-th bar once the window is full
+  std::size_t threads = 1;    // 0 = all cores
+};
+
+// The rolling matrix of bars (time-major, n_series values per bar) at bars t = window - 1,
+// window - 1 + stride, ...: visit(t, matrix) gets the n_series x n_series row-major matrix,
+// valid during the call. Throws std::invalid_argument if bars.size() is not a multiple of
+// n_series, or window, stride or n_series is 0.
+using MatrixVisitor = std::function<void(std::size_t, std::span<const double>)>;
+void rolling_covariance(std::span<const double> bars, std::size_t n_series, const RollingCovOptions& opts,
+                        const MatrixVisitor& visit);
+void rolling_correlation(std::span<const double> bars, std::size_t n_series, const RollingCovOptions& opts,
+                         const MatrixVisitor& visit);
+
+// equal-length series -> one time-major matrix (bar t holds series[0][t], series[1][t], ...)
+std::vector<double> time_major(const std::vector<std::span<const double>>& series);
+
+} // namespace qe
@@ -1,14 +1,41 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include "qe/data.hpp"
 
 namespace qe {
 
+inline constexpr std::size_t kMaxCsvThreads = 256;
+
+struct CsvReadOptions {
+  // worker threads for parsing; 0 = std::thread::hardware_concurrency().
+  // the body is split into newline-aligned byte ranges, one per worker, and the
+  // result is identical to the serial parse (row order, values, error messages).
+  std::size_t threads = 1;
+
+  // smallest byte range worth a worker; small files stay single-threaded
+  std::size_t min_chunk_bytes = std::size_t{1} << 20;
+
+  // fields to convert; unselected fields are skipped without being parsed or validated
+  // (rows get NaN / an empty timestamp, columns are left empty)
+  Columns columns = Columns::All;
+};
+
 // OHLCV CSV with header:
 // timestamp,open,high,low,close,volume
 // reads an OHLCV CSV file with headers
 //  values : timestamp,open,high,low,close,volume
-OhlcvTable read_ohlcv_csv(const std::string& path);
+// the file is memory-mapped and parsed in place (std::from_chars), blank lines
+// and CRLF endings are tolerated; malformed rows throw std::runtime_error.
+OhlcvTable read_ohlcv_csv(const std::string& path, CsvReadOptions opts = {});
+
+// same file format, columnar output; timestamps are parsed to epoch ns (see qe/timestamp.hpp)
+// and an unparseable timestamp is reported like any other malformed field.
+OhlcvColumns read_ohlcv_columns(const std::string& path, CsvReadOptions opts = {});
+
+// projected reads, e.g. read_ohlcv_columns(path, Columns::Close) for close-only workloads
+OhlcvTable read_ohlcv_csv(const std::string& path, Columns columns, CsvReadOptions opts = {});
+OhlcvColumns read_ohlcv_columns(const std::string& path, Columns columns, CsvReadOptions opts = {});
 
 } 
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -16,4 +20,79 @@ struct OhlcvRow {
 
 using OhlcvTable = std::vector<OhlcvRow>;
 
+// Field selection for projected loads (csv_reader.hpp, DatasetOptions, BarStreamOptions).
+// Columns that are not selected are never converted and come back empty (NaN / "" in rows).
+enum class Columns : unsigned {
+  None = 0,
+  Timestamp = 1u << 0,
+  Open = 1u << 1,
+  High = 1u << 2,
+  Low = 1u << 3,
+  Close = 1u << 4,
+  Volume = 1u << 5,
+  All = (1u << 6) - 1,
+};
+
+constexpr Columns operator|(Columns a, Columns b) {
+  return static_cast<Columns>(static_cast<unsigned>(a) | static_cast<unsigned>(b));
+}
+
+constexpr bool has_column(Columns set, Columns c) {
+  return (static_cast<unsigned>(set) & static_cast<unsigned>(c)) != 0;
+}
+
+// Non-owning columnar view; backed by OhlcvColumns or a mapped .qec file (see qe/dataset.hpp)
+struct OhlcvView {
+  std::span<const std::int64_t> ts;
+  std::span<const double> open;
+  std::span<const double> high;
+  std::span<const double> low;
+  std::span<const double> close;
+  std::span<const double> volume;
+
+  // rows; a projected load leaves unselected columns empty, so this is the longest column
+  std::size_t size() const {
+    return std::max({ts.size(), open.size(), high.size(), low.size(), close.size(), volume.size()});
+  }
+  bool empty() const { return size() == 0; }
+
+  // every column has size() rows (nothing projected away)
+  bool complete() const {
+    const std::size_t n = size();
+    return ts.size() == n && open.size() == n && high.size() == n && low.size() == n && close.size() == n &&
+           volume.size() == n;
+  }
+
+  // rows [first, first + count) of every column (empty columns stay empty)
+  OhlcvView subview(std::size_t first, std::size_t count) const {
+    auto sub = [&](auto col) { return col.empty() ? col : col.subspan(first, count); };
+    return {sub(ts), sub(open), sub(high), sub(low), sub(close), sub(volume)};
+  }
+};
+
+// Columnar (struct-of-arrays) OHLCV: one contiguous array per field, 48 bytes per bar.
+// ts holds epoch nanoseconds (UTC), see qe/timestamp.hpp.
+// Indicator/backtest entry points take the columns directly as std::span<const double>.
+struct OhlcvColumns {
+  std::vector<std::int64_t> ts;
+  std::vector<double> open;
+  std::vector<double> high;
+  std::vector<double> low;
+  std::vector<double> close;
+  std::vector<double> volume;
+
+  std::size_t size() const { return view().size(); }
+  bool empty() const { return size() == 0; }
+
+  void reserve(std::size_t n);
+  void resize(std::size_t n);
+  void clear();
+  void push_back(std::int64_t t, double o, double h, double l, double c, double v);
+
+  OhlcvView view() const { return {ts, open, high, low, close, volume}; }
+};
+
+// row -> column conversion, parses every timestamp (throws std::invalid_argument if one is invalid)
+OhlcvColumns to_columns(const OhlcvTable& rows);
+
 } // namespace qe
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "qe/data.hpp"
+#include "qe/mapped_file.hpp"
+#include "qe/ts_index.hpp"
+
+namespace qe {
+
+struct DatasetOptions {
+  // check the .qec payload checksum on open (one pass over the data)
+  bool verify_checksum = false;
+
+  // CSV parse threads (see CsvReadOptions::threads); ignored for .qec
+  std::size_t threads = 1;
+
+  // fields a CSV or compressed .qec load converts (see CsvReadOptions::columns);
+  // a mapped .qec costs nothing per column and always exposes all of them
+  Columns columns = Columns::All;
+};
+
+// Loaded OHLCV data behind one columnar view: either columns parsed from CSV
+// (or decoded from a compressed .qec), or a mapped .qec file used in place.
+// Moving a Dataset keeps view() valid.
+class Dataset {
+public:
+  Dataset() = default;
+  explicit Dataset(OhlcvColumns columns);
+
+  const OhlcvView& view() const { return view_; }
+  std::size_t size() const { return view_.size(); }
+  bool is_mapped() const { return mapped_.is_open(); }
+
+  static Dataset from_qec(MappedFile file, bool verify_checksum, Columns columns = Columns::All);
+
+  // narrows view() to rows [first, first + count) without copying
+  void keep_rows(std::size_t first, std::size_t count);
+
+private:
+  OhlcvColumns owned_;
+  MappedFile mapped_;
+  OhlcvView view_;
+};
+
+// detects the format by magic bytes: .qec is mapped, anything else is parsed as OHLCV CSV
+Dataset load_dataset(const std::string& path, DatasetOptions opts = {});
+
+// only the bars selected by range (see TimeRange), without reading the rest of the file:
+// a .qec ts column is binary-searched in place, a CSV is sought via its sidecar index
+// (qe/ts_index.hpp, built on first use). opts.threads and opts.columns are ignored for CSV ranges.
+Dataset load_dataset_range(const std::string& path, const TimeRange& range, DatasetOptions opts = {});
+
+} // namespace qe
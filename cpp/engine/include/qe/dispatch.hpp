@@ -0,0 +1,29 @@
+#pragma once
+
+namespace qe {
+
+// Instruction sets the numeric kernels (returns, rolling mean, backtest signal and metrics,
+// win rate, black_scholes_batch) are compiled for. On x86-64 one qe_engine build carries all
+// three and runs the best one the CPU supports; elsewhere only Scalar exists.
+enum class Isa {
+  Scalar,
+  Avx2,
+  Avx512, // AVX-512 F + DQ
+};
+
+// "scalar", "avx2" or "avx512"
+const char* isa_name(Isa isa);
+
+// best variant this CPU (and build) supports, from CPUID
+Isa detected_isa();
+
+// Variant the kernels use. Decided on first use: detected_isa(), or the QE_ISA environment
+// variable (scalar, avx2 or avx512) when the CPU supports it. Unknown or unsupported values
+// are ignored.
+Isa active_isa();
+
+// Switches the kernels to `isa`, lowered to detected_isa() if the CPU lacks it, and returns
+// the variant now in use. For tests and benchmarks; do not call while kernels are running.
+Isa set_active_isa(Isa isa);
+
+} // namespace qe
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <fstream>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -7,4 +10,18 @@ namespace qe {
 
 void write_equity_csv(const std::string& path, const std::vector<double>& equity);
 
+// appends an equity curve to "i,equity" CSV one batch at a time (used by streamed backtests);
+// the output is identical to write_equity_csv over the concatenated batches
+class EquityCsvWriter {
+public:
+  explicit EquityCsvWriter(const std::string& path);
+
+  void write(std::span<const double> equity);
+  std::size_t rows() const { return next_; }
+
+private:
+  std::ofstream out_;
+  std::size_t next_ = 0;
+};
+
 } 
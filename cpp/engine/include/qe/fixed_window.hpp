@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "qe/backtest.hpp"
+
+namespace qe {
+
+// Windows the production configs use, compiled with the window as a constant (every kernel
+// variant, see qe/dispatch.hpp): rolling_mean<W> for W in kFixedWindows and
+// backtest_sma_crossover<Fast, Slow> for the pairs in kFixedPairs. Results are bit-identical
+// to the runtime-window functions; other windows do not compile.
+struct WindowPair {
+  std::size_t fast;
+  std::size_t slow;
+};
+
+inline constexpr std::size_t kFixedWindows[] = {5, 10, 20, 50, 200};
+inline constexpr WindowPair kFixedPairs[] = {{5, 20}, {10, 50}, {50, 200}};
+
+namespace detail {
+
+inline constexpr std::size_t kNoSlot = static_cast<std::size_t>(-1);
+
+constexpr std::size_t fixed_window_slot(std::size_t window) {
+  for (std::size_t k = 0; k < std::size(kFixedWindows); ++k) {
+    if (kFixedWindows[k] == window) return k;
+  }
+  return kNoSlot;
+}
+
+constexpr std::size_t fixed_pair_slot(std::size_t fast, std::size_t slow) {
+  for (std::size_t k = 0; k < std::size(kFixedPairs); ++k) {
+    if (kFixedPairs[k].fast == fast && kFixedPairs[k].slow == slow) return k;
+  }
+  return kNoSlot;
+}
+
+void fixed_rolling_mean(std::size_t slot, std::span<const double> values, std::span<double> out);
+
+BacktestResult fixed_sma_crossover(std::size_t slot, std::span<const double> close, double initial_equity,
+                                   BacktestCosts costs, std::span<double> strat_ret, std::span<double> equity);
+
+} // namespace detail
+
+// rolling_mean(values, W, out)
+template <std::size_t W>
+void rolling_mean(std::span<const double> values, std::span<double> out) {
+  constexpr std::size_t slot = detail::fixed_window_slot(W);
+  static_assert(slot != detail::kNoSlot, "rolling_mean<W>: W is not one of kFixedWindows");
+  detail::fixed_rolling_mean(slot, values, out);
+}
+
+template <std::size_t W>
+std::vector<double> rolling_mean(std::span<const double> values) {
+  std::vector<double> out(values.size());
+  rolling_mean<W>(values, out);
+  return out;
+}
+
+// The allocation-free backtest_sma_crossover (one fused pass over close) with the windows
+// compiled in. strat_ret and equity take close.size() - 1 values, or are both empty for the
+// metrics alone.
+template <std::size_t Fast, std::size_t Slow>
+BacktestResult backtest_sma_crossover(std::span<const double> close, double initial_equity, BacktestCosts costs,
+                                      std::span<double> strat_ret, std::span<double> equity) {
+  constexpr std::size_t slot = detail::fixed_pair_slot(Fast, Slow);
+  static_assert(slot != detail::kNoSlot, "backtest_sma_crossover<Fast, Slow>: not one of kFixedPairs");
+  return detail::fixed_sma_crossover(slot, close, initial_equity, costs, strat_ret, equity);
+}
+
+template <std::size_t Fast, std::size_t Slow>
+BacktestResult backtest_sma_crossover(std::span<const double> close, double initial_equity = 1.0,
+                                      BacktestCosts costs = {}, BacktestOutput output = BacktestOutput::Full) {
+  if (output == BacktestOutput::MetricsOnly) {
+    return backtest_sma_crossover<Fast, Slow>(close, initial_equity, costs, {}, {});
+  }
+  const std::size_t steps = close.empty() ? 0 : close.size() - 1;
+  std::vector<double> strat_ret(steps);
+  std::vector<double> equity(steps);
+  BacktestResult out = backtest_sma_crossover<Fast, Slow>(close, initial_equity, costs, strat_ret, equity);
+  out.strat_ret = std::move(strat_ret);
+  out.equity = std::move(equity);
+  return out;
+}
+
+// Runtime lookup for windows read from a config: the compiled instantiation, or nullptr
+// when the window / pair has none and the caller takes the runtime-window function.
+using FixedRollingMean = void (*)(std::span<const double>, std::span<double>);
+using FixedSmaCrossover = BacktestResult (*)(std::span<const double>, double, BacktestCosts, std::span<double>,
+                                             std::span<double>);
+
+FixedRollingMean find_fixed_rolling_mean(std::size_t window);
+FixedSmaCrossover find_fixed_sma_crossover(std::size_t fast, std::size_t slow);
+
+} // namespace qe
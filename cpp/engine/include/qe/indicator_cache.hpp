@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace qe {
+
+// 64-bit hash of the values' bytes, the identity of a series in the cache: two loads of the
+// same data hash alike wherever they live in memory
+std::uint64_t content_hash(std::span<const double> values);
+
+// a column to compute indicators from; hash it once and reuse the source for every lookup
+struct SeriesSource {
+  std::span<const double> values;
+  std::string column;             // e.g. "close"
+  std::uint64_t content_hash = 0;
+};
+
+SeriesSource make_series_source(std::span<const double> values, std::string column);
+
+enum class IndicatorKind { Returns, RollingMean, RollingStd, RollingMin, RollingMax };
+
+const char* indicator_kind_name(IndicatorKind kind);
+
+struct IndicatorKey {
+  std::uint64_t content_hash = 0;
+  std::size_t length = 0;
+  std::string column;
+  IndicatorKind kind = IndicatorKind::Returns;
+  std::size_t window = 0;
+  std::size_t first = 0;          // computed over values[first..]
+
+  bool operator==(const IndicatorKey&) const = default;
+};
+
+struct IndicatorCacheStats {
+  std::size_t hits = 0;
+  std::size_t misses = 0;
+  std::size_t evictions = 0;
+  std::size_t entries = 0;
+  std::size_t bytes = 0;          // held by cached series
+  std::size_t max_bytes = 0;
+
+  double hit_rate() const {
+    const std::size_t lookups = hits + misses;
+    return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+  }
+};
+
+// Memoizes indicator series by (content hash, column, kind, parameters) so strategies run
+// over the same data share one SMA / volatility series instead of each rebuilding it.
+// Series are handed out as shared read-only vectors: evicting one (least recently used
+// first, once the held bytes pass max_bytes) only drops the cache's reference. A series
+// larger than max_bytes is computed and returned but not kept. Thread-safe; a miss is
+// computed outside the lock, so two threads missing the same key may both compute it.
+class IndicatorCache {
+public:
+  using Series = std::shared_ptr<const std::vector<double>>;
+
+  explicit IndicatorCache(std::size_t max_bytes = std::size_t{256} << 20);
+
+  // cached series for key, or compute() stored under it
+  Series get_or_compute(const IndicatorKey& key, const std::function<std::vector<double>()>& compute);
+
+  // compute_returns / rolling_mean / rolling_std / rolling_min / rolling_max of
+  // source.values[first..]
+  Series returns(const SeriesSource& source, std::size_t first = 0);
+  Series rolling_mean(const SeriesSource& source, std::size_t window, std::size_t first = 0);
+  Series rolling_std(const SeriesSource& source, std::size_t window, std::size_t first = 0);
+  Series rolling_min(const SeriesSource& source, std::size_t window, std::size_t first = 0);
+  Series rolling_max(const SeriesSource& source, std::size_t window, std::size_t first = 0);
+
+  IndicatorCacheStats stats() const;
+  void clear();
+
+private:
+  struct KeyHash {
+    std::size_t operator()(const IndicatorKey& k) const;
+  };
+  struct Entry {
+    Series series;
+    std::size_t bytes = 0;
+    std::list<IndicatorKey>::iterator lru;
+  };
+
+  void evict_to(std::size_t limit);
+
+  mutable std::mutex mutex_;
+  std::size_t max_bytes_;
+  std::list<IndicatorKey> lru_; // most recently used first
+  std::unordered_map<IndicatorKey, Entry, KeyHash> entries_;
+  IndicatorCacheStats stats_;
+};
+
+} // namespace qe
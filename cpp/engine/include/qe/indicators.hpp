@@ -1,6 +1,9 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
+#include <memory_resource>
+#include <span>
 #include <vector>
 #include "qe/data.hpp"
 
@@ -8,11 +11,334 @@ namespace qe {
 
 // close-to-close: (close[i] - close[i-1]) / close[i-1]
 std::vector<double> compute_returns(const OhlcvTable& data);
+std::vector<double> compute_returns(std::span<const double> close);
 
-// rolling mean: output same length as input, leading values are nil until window fills
-std::vector<double> rolling_mean(const std::vector<double>& values, std::size_t window);
+// rolling mean: output same length as input, leading values are nil until window fills.
+// the window sum is a running sum of (newest - leaving) values taken as a blocked prefix
+// scan (vectorized); it equals the direct window sum to rounding (~1e-15 relative).
+std::vector<double> rolling_mean(std::span<const double> values, std::size_t window);
 
 // rolling std dev: output same length as input, leading values nil till window fills.
-std::vector<double> rolling_std(const std::vector<double>& values, std::size_t window);
+// O(n) in the series length, independent of window. Each value is within 1e-9 relative,
+// or 1e-12 times the largest |value| in its window (whichever is larger), of the exact
+// two-pass std dev of that window; a window of identical values gives exactly 0.
+std::vector<double> rolling_std(std::span<const double> values, std::size_t window);
+
+// The same three into caller buffers, for hot loops that reuse their storage. out must be
+// close.size() - 1 long for compute_returns (0 when close has fewer than 2 values) and
+// values.size() long for the rolling ones, else std::invalid_argument. compute_returns and
+// rolling_mean never allocate; rolling_std takes its window ring (window values) from scratch.
+void compute_returns(std::span<const double> close, std::span<double> out);
+void rolling_mean(std::span<const double> values, std::size_t window, std::span<double> out);
+void rolling_std(std::span<const double> values, std::size_t window, std::span<double> out,
+                 std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+// Rolling means for several windows from one pass over values: a compensated (double-double)
+// prefix sum is built once, then each window costs one subtraction per value. Window k is
+// NaN before index windows[k] - 1, as in rolling_mean, and agrees with rolling_mean to
+// rounding (~1e-15 relative; the prefix sums carry their own error term).
+enum class MatrixLayout {
+  WindowMajor, // data[k * length + i]: each window's series is contiguous
+  TimeMajor,   // data[i * windows.size() + k]: all windows at one time are contiguous
+};
+
+struct RollingMeans {
+  std::vector<std::size_t> windows;
+  std::size_t length = 0; // values per window (the input length)
+  MatrixLayout layout = MatrixLayout::WindowMajor;
+  std::vector<double> data;
+
+  // mean over windows[k] ending at index i
+  double at(std::size_t k, std::size_t i) const {
+    return layout == MatrixLayout::WindowMajor ? data[k * length + i] : data[i * windows.size() + k];
+  }
+};
+
+// throws std::invalid_argument if a window is 0
+RollingMeans rolling_means(std::span<const double> values, const std::vector<std::size_t>& windows,
+                           MatrixLayout layout = MatrixLayout::WindowMajor);
+
+// same, refilling out and reusing its buffer (repeated calls in a sweep allocate nothing)
+void rolling_means(std::span<const double> values, const std::vector<std::size_t>& windows,
+                   MatrixLayout layout, RollingMeans& out);
+
+// exponential moving average, alpha = 2 / (period + 1). nil for the first period - 1 values,
+// then seeded with their simple mean; a NaN input propagates.
+std::vector<double> ema(std::span<const double> values, std::size_t period);
+
+// Wilder's RSI in [0, 100]: nil for the first `period` values (period changes are needed),
+// then seeded with the simple average gain / loss and smoothed by (period - 1) / period.
+// 100 when the average loss is 0, 50 when price has not moved at all.
+std::vector<double> rsi(std::span<const double> values, std::size_t period);
+
+// Wilder's average true range. true range = max(high - low, |high - prev close|,
+// |low - prev close|), just high - low on the first bar; nil for the first period - 1 bars.
+// high, low and close must have the same length.
+std::vector<double> atr(std::span<const double> high, std::span<const double> low,
+                        std::span<const double> close, std::size_t period);
+
+// Bollinger bands: middle = rolling_mean, upper / lower = middle +/- k * rolling_std
+struct BollingerSeries {
+  std::vector<double> middle;
+  std::vector<double> upper;
+  std::vector<double> lower;
+};
+BollingerSeries bollinger(std::span<const double> values, std::size_t window, double k = 2.0);
+
+// rolling min / max of the non-NaN values in each window (NaN if there are none), nil until
+// the window fills. Amortized O(1) per value whatever the window (monotonic deque).
+std::vector<double> rolling_min(std::span<const double> values, std::size_t window);
+std::vector<double> rolling_max(std::span<const double> values, std::size_t window);
+
+// Donchian channel: upper = rolling_max(high), lower = rolling_min(low), middle = their
+// average. high and low must have the same length.
+struct DonchianSeries {
+  std::vector<double> upper;
+  std::vector<double> middle;
+  std::vector<double> lower;
+};
+DonchianSeries donchian(std::span<const double> high, std::span<const double> low, std::size_t window);
+
+// max drawdown (peak - trough) / peak of each trailing window of an equity curve, with the
+// peak taken inside the window: for a positive series, what max_drawdown gives for that
+// slice (to rounding). NaN values are skipped, nil until the window fills (NaN if the window
+// has no values). Amortized O(1) per value whatever the window.
+std::vector<double> rolling_max_drawdown(std::span<const double> equity, std::size_t window);
+
+// ---- push-one-bar state ----
+// Each class takes one value (bar) per push() in O(1) (amortized for min / max) and keeps
+// only what its window needs, so a live feed updates without recomputing history. push()
+// returns the new value(), which is nil exactly where the batch function's output is:
+// pushing a whole series reproduces the batch function bit for bit. Window storage is
+// allocated once in the constructor (RollingMean / RollingStd from the given resource).
+
+class RollingMean {
+public:
+  explicit RollingMean(std::size_t window,
+                       std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+  double push(double v);
+  double value() const { return value_; }
+  std::size_t window() const { return ring_.size(); }
+
+private:
+  std::pmr::vector<double> ring_;
+  std::size_t head_ = 0;
+  std::size_t count_ = 0;
+  double value_;
+
+  // running window sum in rolling_mean's blocked order
+  double carry_ = 0.0;
+  double block_[4] = {};
+};
+
+class RollingStd {
+public:
+  explicit RollingStd(std::size_t window,
+                      std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+  double push(double v);
+  double value() const { return value_; }
+  std::size_t window() const { return ring_.size(); }
+
+private:
+  std::pmr::vector<double> ring_;
+  std::size_t head_ = 0;
+  std::size_t count_ = 0;
+  double value_;
+
+  // sliding moments, updated exactly as in rolling_std
+  double mean_ = 0.0;
+  double m2_ = 0.0;
+  double m2_peak_ = 0.0;
+  std::size_t nonfinite_ = 0; // NaN/inf values in the window
+};
+
+class Ema {
+public:
+  explicit Ema(std::size_t period);
+
+  double push(double v);
+  double value() const { return value_; }
+
+private:
+  std::size_t period_;
+  double alpha_;
+  std::size_t count_ = 0;
+  double seed_sum_ = 0.0;
+  double value_;
+};
+
+class Rsi {
+public:
+  explicit Rsi(std::size_t period);
+
+  double push(double v);
+  double value() const { return value_; }
+
+private:
+  std::size_t period_;
+  std::size_t count_ = 0;
+  double prev_ = 0.0;
+  double avg_gain_ = 0.0;
+  double avg_loss_ = 0.0;
+  double value_;
+};
+
+class Atr {
+public:
+  explicit Atr(std::size_t period);
+
+  double push(double high, double low, double close);
+  double value() const { return value_; }
+
+private:
+  std::size_t period_;
+  std::size_t count_ = 0;
+  double prev_close_ = 0.0;
+  double tr_sum_ = 0.0;
+  double value_;
+};
+
+struct BollingerBand {
+  double middle;
+  double upper;
+  double lower;
+};
+
+class Bollinger {
+public:
+  explicit Bollinger(std::size_t window, double k = 2.0);
+
+  BollingerBand push(double v);
+  BollingerBand value() const { return value_; }
+
+private:
+  RollingMean mean_;
+  RollingStd std_;
+  double k_;
+  BollingerBand value_;
+};
+
+namespace detail {
+
+// Monotonic deque over the last `window` indices, kept in a ring of `window` slots allocated
+// once. A candidate is dropped when a newer value is at least as extreme (!Better(kept, v)),
+// so front() is the extreme of the window; each value enters and leaves once.
+template <class Better>
+class MonotonicRing {
+public:
+  explicit MonotonicRing(std::size_t window) : slots_(window) {}
+
+  // value v at index i (one more than the previous call's); NaN values are never kept
+  void push(std::size_t i, double v) {
+    // expire first: then at most window - 1 candidates remain, so the new one always fits
+    while (size_ > 0 && slots_[head_].index + slots_.size() <= i) {
+      head_ = slot(1);
+      --size_;
+    }
+    if (v != v) return;
+    while (size_ > 0 && !Better{}(slots_[slot(size_ - 1)].value, v)) --size_;
+    slots_[slot(size_)] = {i, v};
+    ++size_;
+  }
+
+  bool empty() const { return size_ == 0; }
+  double front() const { return slots_[head_].value; }
+
+private:
+  struct Slot {
+    std::size_t index;
+    double value;
+  };
+
+  std::size_t slot(std::size_t k) const {
+    const std::size_t s = head_ + k;
+    return s < slots_.size() ? s : s - slots_.size();
+  }
+
+  std::vector<Slot> slots_;
+  std::size_t head_ = 0;
+  std::size_t size_ = 0;
+};
+
+} // namespace detail
+
+class RollingMin {
+public:
+  explicit RollingMin(std::size_t window);
+
+  double push(double v);
+  double value() const { return value_; }
+
+private:
+  std::size_t window_;
+  std::size_t count_ = 0;
+  detail::MonotonicRing<std::less<>> candidates_; // increasing values
+  double value_;
+};
+
+class RollingMax {
+public:
+  explicit RollingMax(std::size_t window);
+
+  double push(double v);
+  double value() const { return value_; }
+
+private:
+  std::size_t window_;
+  std::size_t count_ = 0;
+  detail::MonotonicRing<std::greater<>> candidates_; // decreasing values
+  double value_;
+};
+
+struct DonchianBand {
+  double upper;
+  double middle;
+  double lower;
+};
+
+class Donchian {
+public:
+  explicit Donchian(std::size_t window);
+
+  DonchianBand push(double high, double low);
+  DonchianBand value() const { return value_; }
+
+private:
+  RollingMax upper_;
+  RollingMin lower_;
+  DonchianBand value_;
+};
+
+class RollingMaxDrawdown {
+public:
+  explicit RollingMaxDrawdown(std::size_t window);
+
+  double push(double equity);
+  double value() const { return value_; }
+
+private:
+  // summary of a run of values: a drawdown's peak has to come before its trough, so runs
+  // combine as max(left.max_dd, right.max_dd, (left.peak - right.trough) / left.peak)
+  struct Run {
+    double peak;
+    double trough;
+    double max_dd;
+  };
+  static Run combine(const Run& a, const Run& b);
+
+  // two-stack queue in one ring: the oldest front_ values carry the summary of themselves
+  // up to the end of the front part, newer ones are folded into back_; when the front runs
+  // out it is rebuilt from everything in the window (amortized O(1) per push)
+  std::vector<double> ring_;
+  std::vector<Run> suffix_;
+  std::size_t head_ = 0;
+  std::size_t size_ = 0;
+  std::size_t front_ = 0;
+  Run back_;
+  std::size_t count_ = 0;
+  double value_;
+};
 
 } // namespace qe
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace qe {
+
+// memory_resource that forwards to an upstream resource and counts what passes through, to
+// check that paths meant to reuse their buffers (rolling_std's scratch) stop allocating
+// after warm-up. Not thread-safe, like the pmr pool resources.
+class CountingResource : public std::pmr::memory_resource {
+public:
+  explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+    : upstream_(upstream) {}
+
+  std::size_t allocations() const { return allocations_; }
+  std::size_t bytes_allocated() const { return bytes_; }
+
+private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    ++allocations_;
+    bytes_ += bytes;
+    return upstream_->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+    upstream_->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  std::pmr::memory_resource* upstream_;
+  std::size_t allocations_ = 0;
+  std::size_t bytes_ = 0;
+};
+
+} // namespace qe
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "qe/data.hpp"
+#include "qe/dataset.hpp"
+
+namespace qe {
+
+using SymbolId = std::uint32_t;
+
+// Interns symbol names into dense ids 0..size()-1, in first-seen order.
+class SymbolTable {
+public:
+  SymbolId intern(std::string_view name);
+  std::optional<SymbolId> find(std::string_view name) const;
+
+  const std::string& name(SymbolId id) const { return names_.at(id); }
+  const std::vector<std::string>& names() const { return names_; }
+  std::size_t size() const { return names_.size(); }
+
+private:
+  struct Hash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+  };
+
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, SymbolId, Hash, std::equal_to<>> ids_;
+};
+
+// rows [offset, offset + count) of the arena
+struct SymbolRange {
+  std::size_t offset = 0;
+  std::size_t count = 0;
+};
+
+// Many instruments in one columnar arena: bars are grouped by symbol id and each symbol's
+// bars are contiguous and in input order, so slice() is a plain view that the span-based
+// indicator/backtest APIs take without copying:
+//
+//   qe::MultiDataset ds = qe::load_multi_dataset("data/universe/");
+//   qe::backtest_sma_crossover(ds.slice("AAPL").close, 10, 50);
+class MultiDataset {
+public:
+  MultiDataset() = default;
+  MultiDataset(SymbolTable symbols, OhlcvColumns arena, std::vector<SymbolRange> ranges);
+
+  const SymbolTable& symbols() const { return symbols_; }
+  std::size_t symbol_count() const { return symbols_.size(); }
+
+  // all bars of all symbols
+  std::size_t size() const { return arena_.size(); }
+  OhlcvView view() const { return arena_.view(); }
+
+  SymbolRange range(SymbolId id) const { return ranges_.at(id); }
+  OhlcvView slice(SymbolId id) const;
+
+  // throws std::out_of_range for an unknown symbol
+  OhlcvView slice(std::string_view symbol) const;
+
+private:
+  SymbolTable symbols_;
+  OhlcvColumns arena_;
+  std::vector<SymbolRange> ranges_;
+};
+
+// true for a directory, or a CSV whose header has a "symbol" column
+bool is_multi_symbol_source(const std::string& path);
+
+// path is either
+//  - a directory: every *.csv / *.qec file is one symbol named after its stem; files are
+//    taken in name order and loaded on opts.threads threads (0 = all cores), or
+//  - a long-format CSV: a "symbol" column anywhere in the header, the other columns being
+//    timestamp,open,high,low,close,volume in that order. Rows of different symbols may be
+//    interleaved; each symbol keeps its rows in file order.
+// every column is loaded (opts.columns is ignored).
+// throws std::runtime_error on IO/parse errors (CSV messages as in read_ohlcv_columns).
+MultiDataset load_multi_dataset(const std::string& path, DatasetOptions opts = {});
+
+} // namespace qe
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <span>
 
 namespace qe {
     
@@ -59,6 +60,15 @@ struct BsResult {
 // Compute prices + greeks in one call 
 BsResult black_scholes_all(double S, double K, double r, double sigma, double T);
 
+// Call and put prices for many contracts at once: element i prices S[i], K[i], r[i], sigma[i],
+// T[i] (same rules as black_scholes_call) into call[i] / put[i]. All spans must have the same
+// length. Runs on the dispatched kernels (qe/dispatch.hpp): the scalar variant matches
+// black_scholes_call/put exactly, the AVX2/AVX-512 ones use their own exp/log/erfc and agree
+// to within 1e-12 * max(S, K).
+void black_scholes_batch(std::span<const double> S, std::span<const double> K,
+                         std::span<const double> r, std::span<const double> sigma,
+                         std::span<const double> T, std::span<double> call, std::span<double> put);
+
 double implied_vol_call(double market_price, double S, double K, double r, double T,
                         double sigma_lo = 1e-6, double sigma_hi = 5.0);
 
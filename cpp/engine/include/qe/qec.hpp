@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "qe/column_codec.hpp"
+#include "qe/data.hpp"
+
+namespace qe {
+
+// .qec — binary columnar OHLCV cache, meant to be mmapped and used in place.
+//
+// layout (little-endian):
+//  [0, 128)  QecHeader
+//  then one column per field in fixed order ts(int64), open, high, low, close, volume (double),
+//  each starting at a 64-byte aligned offset recorded in the header.
+//
+// header_checksum covers header bytes [0, 120); payload_checksum covers the column bytes.
+// readers always check magic/version/header checksum; the payload checksum is opt-in
+// since it costs a full pass over the data.
+//
+// with kQecFlagCompressed each column is instead an encoded blob (see qe/column_codec.hpp):
+//  u64 values, u64 blocks, u64 words, u64 block_bit[blocks], u64 words[words]
+inline constexpr char kQecMagic[8] = {'\x89', 'Q', 'E', 'C', '\r', '\n', '\x1a', '\n'};
+inline constexpr std::uint32_t kQecVersion = 1;
+inline constexpr std::uint32_t kQecVersionCompressed = 2; // so v1 readers reject compressed files
+inline constexpr std::size_t kQecAlign = 64;
+inline constexpr std::size_t kQecColumns = 6;
+inline constexpr std::uint32_t kQecFlagCompressed = 1;
+
+struct QecHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t header_bytes;
+  std::uint64_t rows;
+  std::uint32_t columns;
+  std::uint32_t flags;
+  std::uint64_t payload_checksum;
+  std::uint64_t column_offset[kQecColumns];
+  std::uint8_t reserved[32];
+  std::uint64_t header_checksum;
+};
+
+static_assert(sizeof(QecHeader) == 128, "QecHeader must stay 128 bytes");
+
+// true if the bytes start with the .qec magic
+bool is_qec(std::string_view bytes);
+
+struct QecWriteOptions {
+  // delta-of-delta / XOR encoded columns: several times smaller, decoded on load
+  bool compress = false;
+};
+
+// writes data as .qec (throws std::runtime_error on IO failure)
+void write_qec(const std::string& path, const OhlcvView& data, QecWriteOptions opts = {});
+
+// validates the header at the start of head against the total file size (throws std::runtime_error)
+QecHeader parse_qec_header(std::string_view head, std::uint64_t file_size);
+
+// validates a mapped .qec image and returns views into it (throws std::runtime_error,
+// also for a compressed file, which has no raw columns to view)
+OhlcvView qec_view(std::string_view bytes, bool verify_payload = false);
+
+bool qec_is_compressed(const QecHeader& h);
+
+// validates a mapped compressed .qec image and returns views of its encoded columns,
+// so blocks can be decoded straight out of the page cache (throws std::runtime_error)
+CompressedOhlcvView qec_compressed_view(std::string_view bytes, bool verify_payload = false);
+
+// word-wise 64-bit content hash used for the checksums
+std::uint64_t qec_checksum(const void* data, std::size_t n);
+
+} // namespace qe
@@ -19,4 +19,17 @@ void write_report_json(
   const BacktestResult& result
 );
 
+// same report from metrics alone, for runs that never materialize the series
+// (e.g. streamed backtests, where result.equity/strat_ret are empty)
+void write_report_json(
+  const std::string& path,
+  const std::string& strategy_name,
+  std::size_t fast_window,
+  std::size_t slow_window,
+  double initial_equity,
+  const BacktestResult& result,
+  double win_rate,
+  std::size_t n_steps
+);
+
 } 
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "qe/data.hpp"
+
+namespace qe {
+
+// "30s", "5m", "1h", "1d" (also "min") -> interval in nanoseconds.
+// throws std::invalid_argument on anything else or a zero interval.
+std::int64_t parse_bar_interval(std::string_view text);
+
+// One-pass OHLCV aggregation into fixed UTC-aligned buckets of interval_ns
+// (bucket = floor(ts / interval) * interval, used as the output bar's ts).
+// Each output bar keeps first open, max high, min low, last close and summed volume (the
+// high / low skip NaNs, NaN only if the bucket has none);
+// state is one bar, so it works the same on a whole table or batch by batch.
+//
+//   qe::Resampler rs(qe::parse_bar_interval("1h"));
+//   while (stream.next(batch)) { rs.process(batch.view(), hourly); ... }
+//   rs.finish(hourly); // last, possibly partial, bucket
+//
+// Input must be in time order (throws std::invalid_argument if a bar falls in an
+// earlier bucket than the one being built) and have all six columns (std::invalid_argument
+// for a projected view). Empty buckets produce no bar. A bar whose bucket would start
+// before the int64 range (very large intervals, or ts near its minimum) throws
+// std::invalid_argument too.
+class Resampler {
+public:
+  explicit Resampler(std::int64_t interval_ns);
+
+  // out is replaced with the bars completed by this batch
+  void process(const OhlcvView& in, OhlcvColumns& out);
+
+  // out is replaced with the bar still being built (if any); the resampler is then empty
+  void finish(OhlcvColumns& out);
+
+  std::int64_t interval_ns() const { return interval_; }
+
+private:
+  void add(const OhlcvView& in, std::size_t i, OhlcvColumns& out);
+  void emit(OhlcvColumns& out);
+
+  std::int64_t interval_;
+  bool open_ = false;
+  std::int64_t bucket_ = 0;
+  double o_ = 0.0;
+  double h_ = 0.0;
+  double l_ = 0.0;
+  double c_ = 0.0;
+  double v_ = 0.0;
+};
+
+// whole-table form of Resampler
+OhlcvColumns resample(const OhlcvView& in, std::int64_t interval_ns);
+
+} // namespace qe
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "qe/backtest.hpp"
+#include "qe/fixed_window.hpp"
+#include "qe/indicators.hpp"
+
+namespace qe {
+
+class IndicatorCache;
+struct SeriesSource;
+
+// A long/flat strategy for backtest_strategy. Step i earns the return from close[i] to
+// close[i + 1]; on_bar(close, i) is called for i = 0, 1, ... in order and gives the position
+// for that step (0 flat, anything else long) from the closes it has seen: close holds
+// close[0..i] only, so the bar it trades on is never visible. (backtest_sma_crossover keeps
+// its SMAs over close[1..], which do include close[i + 1], for compatibility; it does not run
+// through this interface.) A strategy keeps its own state between bars; the engine copies the
+// strategy it is given before the first bar, and again when it has to run the bars a second
+// time.
+template <class S>
+concept Strategy = std::copyable<S> && requires(S& s, std::span<const double> close, std::size_t i) {
+  { s.on_bar(close, i) } -> std::convertible_to<int>;
+};
+
+namespace detail {
+
+// writes the strategy returns and trade flags of steps [first, last) (out[0] and traded[0]
+// are step first); called for consecutive chunks from first = 0, and from first = 0 again to
+// restart the strategy
+using StrategySignal = void (*)(void* ctx, std::size_t first, std::size_t last, double* out,
+                                std::uint8_t* traded);
+
+// the engine behind backtest_strategy: validates the inputs as backtest_sma_crossover does
+// (close.size() >= 2 here) and runs the fused equity, cost and metrics pass over signal's
+// chunks
+BacktestResult strategy_pass(std::span<const double> close, double initial_equity, BacktestCosts costs,
+                             StrategySignal signal, void* ctx, std::span<double> strat_ret,
+                             std::span<double> equity);
+
+// the per-bar loop for strategy S, instantiated inline so on_bar is a direct call
+template <Strategy S>
+struct StrategyRun {
+  const S& strategy;
+  std::span<const double> close;
+  double cost;
+  S state;
+  int pos;
+
+  static void signal(void* ctx, std::size_t first, std::size_t last, double* out, std::uint8_t* traded) {
+    StrategyRun& run = *static_cast<StrategyRun*>(ctx);
+    if (first == 0) {
+      run.state = run.strategy;
+      run.pos = 0;
+    }
+    // a local the stores to out and traded cannot alias, so its fields stay in registers
+    S s = std::move(run.state);
+    const double* c = run.close.data();
+    int pos = run.pos;
+    for (std::size_t i = first; i < last; ++i) {
+      const int next = s.on_bar(run.close.first(i + 1), i) != 0 ? 1 : 0;
+      // compute_returns, and the SMA crossover's signal step
+      const double r = c[i] == 0.0 ? std::numeric_limits<double>::quiet_NaN() : (c[i + 1] - c[i]) / c[i];
+      const double x = static_cast<double>(next) * r;
+      traded[i - first] = next != pos ? 1 : 0;
+      out[i - first] = next != pos ? x - run.cost : x;
+      pos = next;
+    }
+    run.state = std::move(s);
+    run.pos = pos;
+  }
+};
+
+} // namespace detail
+
+// Backtests any Strategy on the engine backtest_sma_crossover runs on: the strategy gives a
+// position per bar, and the engine compounds the equity, charges a trade wherever the
+// position changes, and folds drawdown, mean, variance and win rate in the same fused pass,
+// chunk by chunk, with one indirect call per chunk and none per bar. The cost model and the
+// metrics are backtest_sma_crossover's, bit for bit for the same positions (on every kernel
+// variant). strat_ret and equity take close.size() - 1 values, or are both empty for the
+// metrics alone in O(1) memory (the bars then run twice). std::invalid_argument for fewer
+// than 2 closes, initial_equity <= 0, negative costs or mis-sized buffers.
+template <Strategy S>
+BacktestResult backtest_strategy(std::span<const double> close, const S& strategy, double initial_equity,
+                                 BacktestCosts costs, std::span<double> strat_ret, std::span<double> equity) {
+  detail::StrategyRun<S> run{strategy, close, costs.per_trade(), strategy, 0};
+  return detail::strategy_pass(close, initial_equity, costs, &detail::StrategyRun<S>::signal, &run, strat_ret,
+                               equity);
+}
+
+template <Strategy S>
+BacktestResult backtest_strategy(std::span<const double> close, const S& strategy, double initial_equity = 1.0,
+                                 BacktestCosts costs = {}, BacktestOutput output = BacktestOutput::Full) {
+  if (output == BacktestOutput::MetricsOnly) {
+    return backtest_strategy(close, strategy, initial_equity, costs, {}, {});
+  }
+  const std::size_t steps = close.empty() ? 0 : close.size() - 1;
+  std::vector<double> strat_ret(steps);
+  std::vector<double> equity(steps);
+  BacktestResult out = backtest_strategy(close, strategy, initial_equity, costs, strat_ret, equity);
+  out.strat_ret = std::move(strat_ret);
+  out.equity = std::move(equity);
+  return out;
+}
+
+// Donchian channel breakout: long from the step after a close above every one of the slow
+// closes before it, flat from the step after a close below every one of the fast closes
+// before it (no signal before that many closes exist; NaN closes are left out of the channels
+// and never cross). The channels are RollingMax and RollingMin, O(1) per bar. Both windows
+// > 0, else std::invalid_argument; the registry runs it with fast < slow as the SMA crossover.
+class Breakout {
+public:
+  Breakout(std::size_t fast_window, std::size_t slow_window) : low_(fast_window), high_(slow_window) {}
+
+  int on_bar(std::span<const double> close, std::size_t i) {
+    // close[i] is tested against the channels of the closes before it (NaN until they are
+    // full), then joins them
+    const double c = close[i];
+    if (c > high_.value()) {
+      pos_ = 1;
+    } else if (c < low_.value()) {
+      pos_ = 0;
+    }
+    low_.push(c);
+    high_.push(c);
+    return pos_;
+  }
+
+private:
+  RollingMin low_;
+  RollingMax high_;
+  int pos_ = 0;
+};
+
+// The strategies a config (BacktestConfig::strategy), the CLI and the sweeps can name, each
+// with its instantiated kernels. All of them take a (fast, slow) window pair with
+// 0 < fast < slow and at least slow + 1 closes (std::invalid_argument otherwise):
+//   sma_crossover  backtest_sma_crossover (the compiled-window kernel for kFixedPairs), and
+//                  backtest_sma_crossover_batch, one pair per SIMD lane
+//   breakout       backtest_strategy over Breakout(fast, slow), one pair after another, or
+//                  over its channels from an IndicatorCache, one per window, not per pair
+struct StrategyKernels {
+  const char* name;
+  // one backtest; strat_ret and equity as backtest_strategy's (both empty for metrics only)
+  BacktestResult (*run)(std::span<const double> close, WindowPair windows, double initial_equity,
+                        BacktestCosts costs, std::span<double> strat_ret, std::span<double> equity);
+  // the metrics of run for every pair, all validated first
+  std::vector<BacktestResult> (*batch)(std::span<const double> close, std::span<const WindowPair> pairs,
+                                       double initial_equity, BacktestCosts costs);
+  // run, bit for bit, with the series it derives from close shared with other runs through
+  // cache; nullptr where batch already shares its pass over close among pairs (SIMD lanes)
+  BacktestResult (*cached)(const SeriesSource& close, WindowPair windows, double initial_equity,
+                           BacktestCosts costs, IndicatorCache& cache, std::span<double> strat_ret,
+                           std::span<double> equity);
+};
+
+// every registered strategy, sma_crossover first
+std::span<const StrategyKernels> strategies();
+
+// the strategy called name; std::invalid_argument listing the known ones otherwise
+const StrategyKernels& find_strategy(std::string_view name);
+
+// strategy.run with the series allocated for BacktestOutput::Full
+BacktestResult run_backtest(const StrategyKernels& strategy, std::span<const double> close, WindowPair windows,
+                            double initial_equity = 1.0, BacktestCosts costs = {},
+                            BacktestOutput output = BacktestOutput::Full);
+
+} // namespace qe
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "qe/backtest.hpp"
+#include "qe/indicators.hpp"
+
+namespace qe {
+
+// Batch-at-a-time versions of compute_returns / rolling_mean / rolling_std and the
+// SMA crossover backtest. Each object carries its window state across process() calls,
+// so feeding a series in any batch split (e.g. from BarStream) yields exactly the values
+// of the whole-series function, with memory bounded by the window, not the series.
+
+// close-to-close returns; the very first close of the stream produces no output
+class ReturnsStream {
+public:
+  // out is replaced with the returns ending at each close of this batch
+  void process(std::span<const double> close, std::vector<double>& out);
+
+private:
+  double prev_ = 0.0;
+  bool has_prev_ = false;
+};
+
+// rolling mean over the whole stream, NaN until the first window fills (push() is RollingMean's)
+class RollingMeanStream : public RollingMean {
+public:
+  using RollingMean::RollingMean;
+
+  // out is replaced with one value per input value
+  void process(std::span<const double> values, std::vector<double>& out);
+};
+
+// rolling (population) std dev over the whole stream, NaN until the first window fills
+class RollingStdStream : public RollingStd {
+public:
+  using RollingStd::RollingStd;
+
+  void process(std::span<const double> values, std::vector<double>& out);
+};
+
+// backtest_sma_crossover fed one batch of closes at a time with O(slow_window) memory.
+// Equity, drawdown, win counts, trades and costs match the batch function exactly; sharpe
+// uses a running (Welford) variance and agrees with the two-pass value to ~1e-12 relative.
+class SmaCrossoverStream {
+public:
+  SmaCrossoverStream(std::size_t fast_window, std::size_t slow_window,
+                     double initial_equity = 1.0, BacktestCosts costs = {});
+
+  // equity_out, if given, is replaced with the equity after each step of this batch
+  void process(std::span<const double> close, std::vector<double>* equity_out = nullptr);
+
+  // metrics over everything processed so far (equity/strat_ret are left empty).
+  // throws std::invalid_argument if fewer than slow_window + 1 closes were seen.
+  BacktestResult result() const;
+
+  std::size_t steps() const { return steps_; }
+  double final_equity() const { return equity_; }
+  double win_rate() const;
+
+private:
+  std::size_t slow_window_;
+  double initial_equity_;
+
+  double prev_close_ = 0.0;
+  std::size_t closes_ = 0;
+
+  RollingMean fast_;
+  RollingMean slow_;
+
+  double cost_;  // BacktestCosts::per_trade
+  int pos_ = 0;
+  double equity_;
+  double peak_ = 0.0;
+  double max_dd_ = 0.0;
+  std::size_t steps_ = 0;
+
+  // Welford moments of the strategy returns
+  double mean_ = 0.0;
+  double m2_ = 0.0;
+
+  std::size_t wins_ = 0;
+  std::size_t counted_ = 0;
+
+  std::size_t trades_ = 0;
+  double total_cost_ = 0.0;
+};
+
+} // namespace qe
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "qe/backtest.hpp"
+#include "qe/fixed_window.hpp"
+#include "qe/strategy.hpp"
+
+namespace qe {
+
+// lo, lo + step, ... up to and including hi
+struct WindowRange {
+  std::size_t lo = 0;
+  std::size_t hi = 0;
+  std::size_t step = 1;
+};
+
+// "lo:hi" or "lo:hi:step" (a single "n" is n:n); std::invalid_argument otherwise
+WindowRange parse_window_range(const std::string& text);
+
+// every (fast, slow) with fast < slow, fast-major; std::invalid_argument if a step or lo is 0
+std::vector<WindowPair> sma_grid(const WindowRange& fast, const WindowRange& slow);
+
+// backtest_sma_crossover(close, p.fast, p.slow, initial_equity, costs, BacktestOutput::MetricsOnly)
+// for every pair, bit for bit, evaluated up to kSmaBatchLanes pairs at a time in one pass over
+// close (one pair per SIMD lane). Every pair is validated first (std::invalid_argument as the
+// single backtest).
+inline constexpr std::size_t kSmaBatchLanes = 16;
+std::vector<BacktestResult> backtest_sma_crossover_batch(std::span<const double> close,
+                                                         std::span<const WindowPair> pairs,
+                                                         double initial_equity = 1.0, BacktestCosts costs = {});
+
+struct SweepOptions {
+  double initial_equity = 1.0;
+  BacktestCosts costs;
+  std::size_t threads = 0;    // 0 = all cores
+  // shared by every pair of a strategy with a cached kernel (its series come back from the
+  // cache after the first pair that needs them); nullptr, or a strategy without one, runs batch
+  IndicatorCache* cache = nullptr;
+};
+
+struct SweepRow {
+  std::size_t fast = 0;
+  std::size_t slow = 0;
+  double total_return = 0.0;
+  double sharpe = 0.0;
+  double max_drawdown = 0.0;
+  double win_rate = 0.0;
+  std::size_t n_trades = 0;
+  double total_cost = 0.0;
+};
+
+// One SMA crossover backtest per grid pair over one close column, spread over a
+// work-stealing pool. The close column is shared read-only; a task is up to kSmaBatchLanes
+// consecutive pairs through backtest_sma_crossover_batch (metrics only, no per-bar memory).
+// Rows come back in grid order with the metrics backtest_sma_crossover gives for each pair.
+// Every pair is validated before any runs (std::invalid_argument: fast >= slow, a zero
+// window, close shorter than slow + 1, negative costs).
+std::vector<SweepRow> sweep_sma_crossover(std::span<const double> close, std::span<const WindowPair> grid,
+                                          const SweepOptions& opts = {});
+
+// The same sweep for any registered strategy: a task is up to kSmaBatchLanes consecutive
+// pairs through strategy.batch, or through strategy.cached one by one when opts.cache is set,
+// and the rows carry strategy.run's metrics for each pair either way.
+// sweep_sma_crossover is sweep_strategy(find_strategy("sma_crossover"), ...).
+std::vector<SweepRow> sweep_strategy(const StrategyKernels& strategy, std::span<const double> close,
+                                     std::span<const WindowPair> grid, const SweepOptions& opts = {});
+
+// "fast,slow,total_return,sharpe,max_drawdown,win_rate,n_trades,total_cost" CSV, one line per row
+void write_sweep_csv(const std::string& path, const std::vector<SweepRow>& rows);
+
+} // namespace qe
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace qe {
+
+// Timestamps are int64 nanoseconds since the Unix epoch (UTC).
+//
+// Accepted text forms:
+//  YYYY-MM-DD
+//  YYYY-MM-DD[T| ]HH:MM[:SS[.fffffffff]][Z|+HH:MM|-HH:MM]
+//  integer epoch: scaled by magnitude (s < 1e11 <= ms < 1e14 <= us < 1e17 <= ns)
+bool try_parse_timestamp_ns(std::string_view text, std::int64_t& out);
+
+// throws std::invalid_argument on anything try_parse_timestamp_ns rejects
+std::int64_t parse_timestamp_ns(std::string_view text);
+
+// YYYY-MM-DD at midnight, otherwise YYYY-MM-DDTHH:MM:SS[.fffffffff]
+std::string format_timestamp(std::int64_t ns);
+
+} // namespace qe
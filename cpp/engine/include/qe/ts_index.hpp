@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "qe/data.hpp"
+
+namespace qe {
+
+// Sparse timestamp -> byte offset index over a time-ordered OHLCV CSV, so a date range
+// can be read by seeking instead of parsing the whole file. One entry per `stride` data rows.
+//
+// Stored as a sidecar next to the CSV (<csv>.qei, little-endian):
+//  64-byte TsIndexHeader, then `entries` TsIndexEntry records.
+// The sidecar remembers the CSV's size and mtime and is rebuilt when either changes.
+// (.qec files need no sidecar: their ts column is searched in place.)
+inline constexpr char kTsIndexMagic[8] = {'\x89', 'Q', 'E', 'I', '\r', '\n', '\x1a', '\n'};
+inline constexpr std::uint32_t kTsIndexVersion = 1;
+inline constexpr std::size_t kTsIndexStride = 4096;
+
+struct TsIndexEntry {
+  std::int64_t ts;       // timestamp of row (i * stride)
+  std::uint64_t offset;  // byte offset of that row's first character
+  std::uint64_t line;    // 1-based file line of that row (header is line 1)
+};
+
+struct TsIndexHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t stride;
+  std::uint64_t rows;
+  std::uint64_t source_size;
+  std::int64_t source_mtime;
+  std::uint64_t entries;
+  std::uint64_t entries_checksum;
+  std::uint64_t reserved;
+};
+
+static_assert(sizeof(TsIndexEntry) == 24, "TsIndexEntry must stay 24 bytes");
+static_assert(sizeof(TsIndexHeader) == 64, "TsIndexHeader must stay 64 bytes");
+
+struct TsIndex {
+  std::size_t stride = kTsIndexStride;
+  std::uint64_t rows = 0;
+  std::uint64_t source_size = 0;
+  std::int64_t source_mtime = 0;
+  std::vector<TsIndexEntry> entries;
+};
+
+// Bars with start_ns <= ts < end_ns, preceded by up to warmup_bars earlier bars
+// (e.g. slow_window, so rolling signals are defined from the first bar in range).
+struct TimeRange {
+  std::int64_t start_ns = std::numeric_limits<std::int64_t>::min();
+  std::int64_t end_ns = std::numeric_limits<std::int64_t>::max();
+  std::size_t warmup_bars = 0;
+};
+
+// one pass over the CSV (line scan, timestamp field of every row; other fields are not parsed).
+// throws std::runtime_error on IO errors, a bad timestamp or out-of-order timestamps.
+TsIndex build_ts_index(const std::string& csv_path, std::size_t stride = kTsIndexStride);
+
+// sidecar IO; read returns nullopt if the file is missing, damaged or from another version
+void write_ts_index(const std::string& path, const TsIndex& index);
+std::optional<TsIndex> read_ts_index(const std::string& path);
+
+std::string ts_index_path(const std::string& csv_path);
+
+// sidecar index for csv_path if it is still fresh, otherwise builds one and tries to
+// save it (a read-only directory just means the index is rebuilt next time)
+TsIndex load_ts_index(const std::string& csv_path);
+
+// parses only the CSV rows selected by range, seeking via index (built from the same file).
+// row values, error messages and line numbers match read_ohlcv_columns.
+OhlcvColumns read_ohlcv_columns(const std::string& csv_path, const TsIndex& index,
+                                const TimeRange& range);
+
+} // namespace qe
@@ -2,53 +2,22 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <limits>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 
+#include "qe/fixed_window.hpp"
+#include "qe/indicator_cache.hpp"
 #include "qe/indicators.hpp"
+#include "qe/strategy.hpp"
+#include "qe/sweep.hpp"
 
-namespace qe {
-
-static bool is_nan(double x) {
-  return std::isnan(x);
-}
-
-static double compute_max_drawdown(const std::vector<double>& equity) {
-  if (equity.empty()) return 0.0;
-
-  double peak = equity[0];
-  double max_dd = 0.0;
-
-  for (double v : equity) {
-    peak = std::max(peak, v);
-    if (peak > 0.0) {
-      double dd = (peak - v) / peak;
-      max_dd = std::max(max_dd, dd);
-    }
-  }
-  return max_dd;
-}
-
-static double compute_sharpe(const std::vector<double>& r) {
-  // Sharpe on per-period returns (no annualization yet)
-  if (r.empty()) return 0.0;
-
-  double mean = 0.0;
-  for (double x : r) mean += x;
-  mean /= static_cast<double>(r.size());
+#include "kernels.hpp"
 
-  double var = 0.0;
-  for (double x : r) {
-    double d = x - mean;
-    var += d * d;
-  }
-  var /= static_cast<double>(r.size());
-
-  double sd = std::sqrt(var);
-  if (sd == 0.0) return 0.0;
-  return mean / sd;
-}
+namespace qe {
 
 BacktestResult backtest_sma_crossover(
   const OhlcvTable& data,
@@ -57,6 +26,36 @@ BacktestResult backtest_sma_crossover(
   double initial_equity,
   BacktestCosts costs
 ) {
+  std::vector<double> close;
+  close.reserve(data.size());
+  for (const auto& row : data) close.push_back(row.close);
+  return backtest_sma_crossover(std::span<const double>(close), fast_window, slow_window,
+                                initial_equity, costs);
+}
+
+BacktestResult backtest_sma_crossover(
+  std::span<const double> close,
+  std::size_t fast_window,
+  std::size_t slow_window,
+  double initial_equity,
+  BacktestCosts costs,
+  BacktestOutput output
+) {
+  if (output == BacktestOutput::MetricsOnly) {
+    return backtest_sma_crossover(close, fast_window, slow_window, initial_equity, costs, {}, {});
+  }
+  const std::size_t steps = close.empty() ? 0 : close.size() - 1;
+  std::vector<double> strat_ret(steps);
+  std::vector<double> equity(steps);
+  BacktestResult out = backtest_sma_crossover(close, fast_window, slow_window, initial_equity, costs,
+                                              strat_ret, equity);
+  out.strat_ret = std::move(strat_ret);
+  out.equity = std::move(equity);
+  return out;
+}
+
+static void check_inputs(std::size_t rows, std::size_t fast_window, std::size_t slow_window,
+                         double initial_equity, const BacktestCosts& costs) {
   if (fast_window == 0 || slow_window == 0) {
     throw std::invalid_argument("windows must be > 0");
   }
@@ -64,55 +63,224 @@ BacktestResult backtest_sma_crossover(
     throw std::invalid_argument("fast_window must be < slow_window");
   }
   const std::size_t min_rows = slow_window + 1;
-  if (data.size() < min_rows) {
+  if (rows < min_rows) {
     throw std::invalid_argument(
       "not enough data: need at least " + std::to_string(min_rows) +
       " rows for slow_window=" + std::to_string(slow_window) +
-      " (got " + std::to_string(data.size()) + ")"
+      " (got " + std::to_string(rows) + ")"
     );
   }
 
   if (initial_equity <= 0.0) {
     throw std::invalid_argument("initial_equity must be > 0");
   }
+  if (!(costs.fee_bps >= 0.0) || !(costs.slippage_bps >= 0.0)) {
+    throw std::invalid_argument("fee_bps and slippage_bps must be >= 0");
+  }
+}
 
-  // close-to-close returns (length n-1)
-  std::vector<double> r = compute_returns(data);
+static void check_outputs(std::size_t rows, std::span<double> strat_ret, std::span<double> equity) {
+  if (strat_ret.empty() && equity.empty()) return; // metrics only
+  if (strat_ret.size() != rows - 1 || equity.size() != rows - 1) {
+    throw std::invalid_argument("strat_ret and equity must have close.size() - 1 values (or both none)");
+  }
+}
 
-  // close vector aligned to returns indices
-  // returns[i] corresponds to close[i] -> close[i+1]
-  std::vector<double> close;
-  close.reserve(data.size());
-  for (const auto& row : data) close.push_back(row.close);
+static BacktestResult finish_pass(const kernels::BacktestPass& pass, double initial_equity) {
+  BacktestResult out;
+  out.total_return = (pass.final_equity / initial_equity) - 1.0;
+  out.max_drawdown = pass.max_drawdown;
+  // Sharpe on per-period returns (no annualization yet), win rate as compute_win_rate
+  const double sd = std::sqrt(pass.var);
+  out.sharpe = sd == 0.0 ? 0.0 : pass.mean / sd;
+  out.win_rate = pass.wins.total == 0 ? 0.0
+                                      : static_cast<double>(pass.wins.wins) / static_cast<double>(pass.wins.total);
+  out.n_trades = pass.trades;
+  out.total_cost = pass.total_cost;
+  return out;
+}
 
-  // Compute SMAs on returns index space by using close[1..] (aligned to r indices)
-  std::vector<double> close_aligned(close.begin() + 1, close.end()); // length N-1
-  std::vector<double> fast = rolling_mean(close_aligned, fast_window);
-  std::vector<double> slow = rolling_mean(close_aligned, slow_window);
+// the series pointers for the kernel, null for metrics only
+static double* series_out(std::span<double> s) {
+  return s.empty() ? nullptr : s.data();
+}
 
-  BacktestResult out;
-  out.strat_ret.assign(r.size(), 0.0);
-  out.equity.assign(r.size(), initial_equity);
+BacktestResult backtest_sma_crossover(
+  std::span<const double> close,
+  std::size_t fast_window,
+  std::size_t slow_window,
+  double initial_equity,
+  BacktestCosts costs,
+  std::span<double> strat_ret,
+  std::span<double> equity
+) {
+  check_inputs(close.size(), fast_window, slow_window, initial_equity, costs);
+  check_outputs(close.size(), strat_ret, equity);
+
+  const kernels::BacktestPass pass =
+    kernels::sma_backtest(close.data(), close.size(), fast_window, slow_window, initial_equity, costs.per_trade(),
+                          series_out(strat_ret), series_out(equity));
+  return finish_pass(pass, initial_equity);
+}
+
+BacktestResult detail::fixed_sma_crossover(std::size_t slot, std::span<const double> close,
+                                           double initial_equity, BacktestCosts costs,
+                                           std::span<double> strat_ret, std::span<double> equity) {
+  check_inputs(close.size(), kFixedPairs[slot].fast, kFixedPairs[slot].slow, initial_equity, costs);
+  check_outputs(close.size(), strat_ret, equity);
+
+  const kernels::BacktestPass pass =
+    kernels::sma_backtest_fixed(slot, close.data(), close.size(), initial_equity, costs.per_trade(),
+                                series_out(strat_ret), series_out(equity));
+  return finish_pass(pass, initial_equity);
+}
+
+std::vector<BacktestResult> backtest_sma_crossover_batch(std::span<const double> close,
+                                                         std::span<const WindowPair> pairs,
+                                                         double initial_equity, BacktestCosts costs) {
+  static_assert(kSmaBatchLanes == kernels::kBatchLanes);
+  for (const WindowPair& p : pairs) check_inputs(close.size(), p.fast, p.slow, initial_equity, costs);
+
+  std::vector<BacktestResult> out;
+  out.reserve(pairs.size());
+  for (std::size_t b = 0; b < pairs.size(); b += kSmaBatchLanes) {
+    const std::size_t lanes = std::min(kSmaBatchLanes, pairs.size() - b);
+    std::size_t fast[kSmaBatchLanes];
+    std::size_t slow[kSmaBatchLanes];
+    for (std::size_t k = 0; k < lanes; ++k) {
+      fast[k] = pairs[b + k].fast;
+      slow[k] = pairs[b + k].slow;
+    }
+    kernels::BacktestPass pass[kSmaBatchLanes];
+    kernels::sma_backtest_batch(close.data(), close.size(), fast, slow, lanes, initial_equity, costs.per_trade(),
+                                pass);
+    for (std::size_t k = 0; k < lanes; ++k) out.push_back(finish_pass(pass[k], initial_equity));
+  }
+  return out;
+}
+
+BacktestResult detail::strategy_pass(std::span<const double> close, double initial_equity, BacktestCosts costs,
+                                     StrategySignal signal, void* ctx, std::span<double> strat_ret,
+                                     std::span<double> equity) {
+  if (close.size() < 2) {
+    throw std::invalid_argument("not enough data: need at least 2 rows (got " + std::to_string(close.size()) +
+                                ")");
+  }
+  if (initial_equity <= 0.0) {
+    throw std::invalid_argument("initial_equity must be > 0");
+  }
+  if (!(costs.fee_bps >= 0.0) || !(costs.slippage_bps >= 0.0)) {
+    throw std::invalid_argument("fee_bps and slippage_bps must be >= 0");
+  }
+  check_outputs(close.size(), strat_ret, equity);
+
+  const kernels::BacktestPass pass =
+    kernels::strategy_backtest(close.size() - 1, initial_equity, costs.per_trade(), signal, ctx,
+                               series_out(strat_ret), series_out(equity));
+  return finish_pass(pass, initial_equity);
+}
+
+template <std::size_t... K>
+static FixedSmaCrossover fixed_sma_crossover_at(std::size_t slot, std::index_sequence<K...>) {
+  static constexpr FixedSmaCrossover fns[] = {&backtest_sma_crossover<kFixedPairs[K].fast, kFixedPairs[K].slow>...};
+  return fns[slot];
+}
+
+FixedSmaCrossover find_fixed_sma_crossover(std::size_t fast, std::size_t slow) {
+  const std::size_t slot = detail::fixed_pair_slot(fast, slow);
+  if (slot == detail::kNoSlot) return nullptr;
+  return fixed_sma_crossover_at(slot, std::make_index_sequence<std::size(kFixedPairs)>{});
+}
 
-  double eq = initial_equity;
-  int pos = 0; // 0 = flat, 1 = long
+static BacktestResult run_sma_crossover(std::span<const double> close, WindowPair windows, double initial_equity,
+                                        BacktestCosts costs, std::span<double> strat_ret,
+                                        std::span<double> equity) {
+  if (const FixedSmaCrossover fixed = find_fixed_sma_crossover(windows.fast, windows.slow)) {
+    return fixed(close, initial_equity, costs, strat_ret, equity);
+  }
+  return backtest_sma_crossover(close, windows.fast, windows.slow, initial_equity, costs, strat_ret, equity);
+}
 
-  for (std::size_t i = 0; i < r.size(); ++i) {
-    // Only trade when both SMAs are defined, throw error if not (?)
-    if (!is_nan(fast[i]) && !is_nan(slow[i])) {
-      pos = (fast[i] > slow[i]) ? 1 : 0;
+static BacktestResult run_breakout(std::span<const double> close, WindowPair windows, double initial_equity,
+                                   BacktestCosts costs, std::span<double> strat_ret, std::span<double> equity) {
+  check_inputs(close.size(), windows.fast, windows.slow, initial_equity, costs);
+  return backtest_strategy(close, Breakout(windows.fast, windows.slow), initial_equity, costs, strat_ret, equity);
+}
+
+namespace {
+
+// Breakout over channels computed up front: low[i - 1] and high[i - 1] cover the closes
+// before close[i], as Breakout's RollingMin and RollingMax do when close[i] is tested
+struct ChannelBreakout {
+  const double* low;
+  const double* high;
+  int pos = 0;
+
+  int on_bar(std::span<const double> close, std::size_t i) {
+    if (i == 0) return pos;
+    if (close[i] > high[i - 1]) {
+      pos = 1;
+    } else if (close[i] < low[i - 1]) {
+      pos = 0;
     }
+    return pos;
+  }
+};
+
+} // namespace
 
-    double sr = static_cast<double>(pos) * r[i];
-    out.strat_ret[i] = sr;
+static BacktestResult cached_breakout(const SeriesSource& close, WindowPair windows, double initial_equity,
+                                      BacktestCosts costs, IndicatorCache& cache, std::span<double> strat_ret,
+                                      std::span<double> equity) {
+  check_inputs(close.values.size(), windows.fast, windows.slow, initial_equity, costs);
+  const IndicatorCache::Series low = cache.rolling_min(close, windows.fast);
+  const IndicatorCache::Series high = cache.rolling_max(close, windows.slow);
+  return backtest_strategy(close.values, ChannelBreakout{low->data(), high->data()}, initial_equity, costs,
+                           strat_ret, equity);
+}
+
+static std::vector<BacktestResult> batch_breakout(std::span<const double> close, std::span<const WindowPair> pairs,
+                                                  double initial_equity, BacktestCosts costs) {
+  for (const WindowPair& p : pairs) check_inputs(close.size(), p.fast, p.slow, initial_equity, costs);
 
-    eq *= (1.0 + sr);
-    out.equity[i] = eq;
+  std::vector<BacktestResult> out;
+  out.reserve(pairs.size());
+  for (const WindowPair& p : pairs) {
+    out.push_back(backtest_strategy(close, Breakout(p.fast, p.slow), initial_equity, costs, {}, {}));
   }
+  return out;
+}
+
+static constexpr StrategyKernels kStrategies[] = {
+  {"sma_crossover", run_sma_crossover, backtest_sma_crossover_batch, nullptr},
+  {"breakout", run_breakout, batch_breakout, cached_breakout},
+};
 
-  out.total_return = (out.equity.back() / initial_equity) - 1.0;
-  out.max_drawdown = compute_max_drawdown(out.equity);
-  out.sharpe = compute_sharpe(out.strat_ret);
+std::span<const StrategyKernels> strategies() {
+  return kStrategies;
+}
+
+const StrategyKernels& find_strategy(std::string_view name) {
+  std::string known;
+  for (const StrategyKernels& s : kStrategies) {
+    if (name == s.name) return s;
+    known += known.empty() ? "" : ", ";
+    known += s.name;
+  }
+  throw std::invalid_argument("unknown strategy '" + std::string(name) + "' (known: " + known + ")");
+}
+
+BacktestResult run_backtest(const StrategyKernels& strategy, std::span<const double> close, WindowPair windows,
+                            double initial_equity, BacktestCosts costs, BacktestOutput output) {
+  if (output == BacktestOutput::MetricsOnly) {
+    return strategy.run(close, windows, initial_equity, costs, {}, {});
+  }
+  const std::size_t steps = close.empty() ? 0 : close.size() - 1;
+  std::vector<double> strat_ret(steps);
+  std::vector<double> equity(steps);
+  BacktestResult out = strategy.run(close, windows, initial_equity, costs, strat_ret, equity);
+  out.strat_ret = std::move(strat_ret);
+  out.equity = std::move(equity);
   return out;
 }
 
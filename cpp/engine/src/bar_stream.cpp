@@ -0,0 +1,285 @@
+#include "qe/bar_stream.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#include "qe/timestamp.hpp"
+
+#include "csv_parse.hpp"
+
+namespace qe {
+
+namespace {
+
+constexpr std::size_t kBytesPerBar = 6 * 8;
+constexpr std::size_t kMinBuffer = std::size_t{64} << 10;
+constexpr std::size_t kMaxBuffer = std::size_t{8} << 20;
+
+} // namespace
+
+BarStream::BarStream(const std::string& path, BarStreamOptions opts)
+  : path_(path), in_(path, std::ios::binary), mask_(static_cast<unsigned>(opts.columns)) {
+  if (!in_) {
+    throw std::runtime_error("Failed to open data file: " + path);
+  }
+
+  in_.seekg(0, std::ios::end);
+  const auto file_size = static_cast<std::uint64_t>(in_.tellg());
+  in_.seekg(0, std::ios::beg);
+
+  char head[sizeof(QecHeader)] = {};
+  in_.read(head, static_cast<std::streamsize>(std::min<std::uint64_t>(file_size, sizeof(head))));
+  const std::string_view head_view(head, static_cast<std::size_t>(in_.gcount()));
+  in_.clear();
+
+  std::size_t buffer_bytes = 0;
+  if (is_qec(head_view)) {
+    qec_ = true;
+    header_ = parse_qec_header(head_view, file_size);
+    if (qec_is_compressed(header_)) {
+      // one decoded block is held on top of the batch
+      buffer_bytes = kCodecBlock * kBytesPerBar;
+    }
+  } else {
+    if (file_size == 0) {
+      throw std::runtime_error("CSV file is empty: " + path);
+    }
+    buffer_bytes = std::clamp(opts.max_bytes / 4, kMinBuffer, kMaxBuffer);
+  }
+
+  const std::size_t budget = opts.max_bytes > buffer_bytes ? opts.max_bytes - buffer_bytes : 0;
+  batch_rows_ = std::min(opts.batch_rows, budget / kBytesPerBar);
+  if (batch_rows_ == 0) {
+    throw std::invalid_argument("BarStream: batch_rows and max_bytes must allow at least one bar");
+  }
+
+  if (qec_) {
+    if (qec_is_compressed(header_)) read_block_tables(file_size);
+    return;
+  }
+
+  buf_.resize(buffer_bytes);
+  in_.seekg(0, std::ios::beg);
+
+  // skip header line
+  for (;;) {
+    const char* b = buf_.data() + pos_;
+    const char* nl = static_cast<const char*>(std::memchr(b, '\n', len_ - pos_));
+    if (nl) {
+      pos_ = static_cast<std::size_t>(nl - buf_.data()) + 1;
+      break;
+    }
+    if (eof_) {
+      pos_ = len_;
+      break;
+    }
+    pos_ = len_; // header bytes are not needed, drop them as we go
+    refill();
+  }
+}
+
+void BarStream::refill() {
+  const std::size_t keep = len_ - pos_;
+  std::memmove(buf_.data(), buf_.data() + pos_, keep);
+  pos_ = 0;
+  len_ = keep;
+
+  in_.read(buf_.data() + len_, static_cast<std::streamsize>(buf_.size() - len_));
+  const auto got = static_cast<std::size_t>(in_.gcount());
+  len_ += got;
+  if (got == 0) eof_ = true;
+}
+
+bool BarStream::next(OhlcvColumns& batch) {
+  return qec_ ? next_qec(batch) : next_csv(batch);
+}
+
+bool BarStream::next_csv(OhlcvColumns& batch) {
+  using namespace csv_detail;
+
+  batch.clear();
+  std::vector<double>* cols[] = {&batch.open, &batch.high, &batch.low, &batch.close, &batch.volume};
+  if (mask_ & 1u) batch.ts.reserve(batch_rows_);
+  for (int f = 0; f < 5; ++f) {
+    if ((mask_ >> (f + 1)) & 1u) cols[f]->reserve(batch_rows_);
+  }
+  std::size_t rows = 0;
+
+  std::string_view ts;
+  double vals[5];
+
+  while (rows < batch_rows_) {
+    const char* b = buf_.data() + pos_;
+    const char* nl = static_cast<const char*>(std::memchr(b, '\n', len_ - pos_));
+    const char* line_end = nullptr;
+
+    if (nl) {
+      line_end = nl;
+      pos_ = static_cast<std::size_t>(nl - buf_.data()) + 1;
+    } else if (eof_) {
+      if (pos_ == len_) break;
+      line_end = buf_.data() + len_; // last line without a newline
+      pos_ = len_;
+    } else {
+      // move the partial line to the front and refill
+      if (len_ - pos_ == buf_.size()) {
+        throw std::runtime_error(
+          "CSV parse error in " + path_ + " at line " + std::to_string(line_no_ + 1) +
+          ": line longer than the stream buffer"
+        );
+      }
+      refill();
+      continue;
+    }
+
+    ++line_no_;
+    if (line_end > b && line_end[-1] == '\r') --line_end;
+    if (line_end == b) continue;
+
+    const int bad = parse_fields(b, line_end, ts, vals, mask_);
+    if (bad >= 0) throw_parse_error(path_, line_no_, static_cast<std::size_t>(bad));
+
+    if (mask_ & 1u) {
+      std::int64_t t = 0;
+      if (!try_parse_timestamp_ns(ts, t)) throw_parse_error(path_, line_no_, 0);
+      batch.ts.push_back(t);
+    }
+    for (int f = 0; f < 5; ++f) {
+      if ((mask_ >> (f + 1)) & 1u) cols[f]->push_back(vals[f]);
+    }
+    ++rows;
+  }
+
+  rows_read_ += rows;
+  return rows != 0;
+}
+
+bool BarStream::next_qec(OhlcvColumns& batch) {
+  if (!encoded_.empty()) return next_compressed(batch);
+
+  const std::uint64_t remaining = header_.rows - rows_read_;
+  const auto n = static_cast<std::size_t>(std::min<std::uint64_t>(batch_rows_, remaining));
+  batch.clear();
+  if (n == 0) return false;
+
+  batch.ts.resize((mask_ & 1u) ? n : 0);
+  std::vector<double>* cols[] = {&batch.open, &batch.high, &batch.low, &batch.close, &batch.volume};
+  for (std::size_t f = 0; f < 5; ++f) cols[f]->resize(((mask_ >> (f + 1)) & 1u) ? n : 0);
+
+  void* dst[kQecColumns] = {batch.ts.data(), batch.open.data(), batch.high.data(),
+                            batch.low.data(), batch.close.data(), batch.volume.data()};
+  for (std::size_t c = 0; c < kQecColumns; ++c) {
+    if (!((mask_ >> c) & 1u)) continue;
+    in_.seekg(static_cast<std::streamoff>(header_.column_offset[c] + rows_read_ * 8));
+    in_.read(static_cast<char*>(dst[c]), static_cast<std::streamsize>(n * 8));
+    if (!in_) {
+      throw std::runtime_error("qec: short read from " + path_);
+    }
+  }
+
+  rows_read_ += n;
+  return true;
+}
+
+void BarStream::read_block_tables(std::uint64_t file_size) {
+  const std::uint64_t blocks = (header_.rows + kCodecBlock - 1) / kCodecBlock;
+  encoded_.resize(kQecColumns);
+
+  for (std::size_t c = 0; c < kQecColumns; ++c) {
+    std::uint64_t blob[3]; // values, blocks, word count
+    in_.seekg(static_cast<std::streamoff>(header_.column_offset[c]));
+    in_.read(reinterpret_cast<char*>(blob), sizeof(blob));
+
+    // the block table and words must fit in the rest of the file before anything is sized
+    // from them (as qec_compressed_view checks; parse_qec_header put the blob header in it)
+    const std::uint64_t avail = (file_size - header_.column_offset[c]) / 8;
+    if (!in_ || blob[0] != header_.rows || blob[1] != blocks || blob[2] > avail ||
+        sizeof(blob) / 8 + blocks > avail - blob[2]) {
+      throw std::runtime_error("qec: corrupt compressed column in " + path_);
+    }
+
+    EncodedColumnFile& col = encoded_[c];
+    col.block_bit.resize(static_cast<std::size_t>(blocks));
+    in_.read(reinterpret_cast<char*>(col.block_bit.data()), static_cast<std::streamsize>(blocks * 8));
+    col.words_at = header_.column_offset[c] + sizeof(blob) + blocks * 8;
+    col.words = blob[2];
+    if (!in_) {
+      throw std::runtime_error("qec: short read from " + path_);
+    }
+    for (std::size_t b = 0; b < col.block_bit.size(); ++b) {
+      if (col.block_bit[b] >= col.words * 64 || (b && col.block_bit[b] < col.block_bit[b - 1])) {
+        throw std::runtime_error("qec: corrupt compressed column in " + path_);
+      }
+    }
+  }
+}
+
+void BarStream::decode_block(std::size_t b) {
+  block_rows_ = std::min(kCodecBlock, static_cast<std::size_t>(header_.rows) - b * kCodecBlock);
+  block_.resize(block_rows_);
+  block_pos_ = 0;
+
+  for (std::size_t c = 0; c < kQecColumns; ++c) {
+    if (!((mask_ >> c) & 1u)) continue;
+    const EncodedColumnFile& col = encoded_[c];
+    const std::uint64_t first_bit = col.block_bit[b];
+    const std::uint64_t end_bit = (b + 1 < col.block_bit.size()) ? col.block_bit[b + 1] : col.words * 64;
+
+    // only the words this block's bits live in
+    const std::uint64_t w0 = first_bit / 64;
+    const std::uint64_t w1 = std::min(col.words, (end_bit + 63) / 64);
+    word_buf_.resize(static_cast<std::size_t>(w1 - w0));
+    in_.seekg(static_cast<std::streamoff>(col.words_at + w0 * 8));
+    in_.read(reinterpret_cast<char*>(word_buf_.data()), static_cast<std::streamsize>(word_buf_.size() * 8));
+    if (!in_) {
+      throw std::runtime_error("qec: short read from " + path_);
+    }
+
+    const std::uint64_t bit = first_bit - w0 * 64;
+    if (c == 0) {
+      decode_timestamps(word_buf_, bit, block_rows_, block_.ts.data());
+    } else {
+      if (!double_block_mode_valid(word_buf_, bit)) {
+        throw std::runtime_error("qec: corrupt compressed column in " + path_);
+      }
+      double* dst[] = {block_.open.data(), block_.high.data(), block_.low.data(),
+                       block_.close.data(), block_.volume.data()};
+      decode_doubles(word_buf_, bit, block_rows_, dst[c - 1]);
+    }
+  }
+}
+
+bool BarStream::next_compressed(OhlcvColumns& batch) {
+  batch.clear();
+  std::size_t rows = 0;
+
+  auto append = [&](auto& dst, const auto& src, std::size_t take, unsigned bit) {
+    if (!((mask_ >> bit) & 1u)) return;
+    const auto from = src.begin() + static_cast<std::ptrdiff_t>(block_pos_);
+    dst.insert(dst.end(), from, from + static_cast<std::ptrdiff_t>(take));
+  };
+
+  while (rows < batch_rows_) {
+    if (block_pos_ == block_rows_) {
+      if (next_block_ == encoded_[0].block_bit.size()) break;
+      decode_block(next_block_++);
+    }
+
+    const std::size_t take = std::min(batch_rows_ - rows, block_rows_ - block_pos_);
+    append(batch.ts, block_.ts, take, 0);
+    append(batch.open, block_.open, take, 1);
+    append(batch.high, block_.high, take, 2);
+    append(batch.low, block_.low, take, 3);
+    append(batch.close, block_.close, take, 4);
+    append(batch.volume, block_.volume, take, 5);
+    block_pos_ += take;
+    rows += take;
+  }
+
+  rows_read_ += rows;
+  return rows != 0;
+}
+
+} // namespace qe
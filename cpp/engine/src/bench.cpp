@@ -3,10 +3,24 @@
 #include "qe/csv_reader.hpp"
 #include "qe/indicators.hpp"
 #include "qe/backtest.hpp"
+#include "qe/column_codec.hpp"
+#include "qe/streaming.hpp"
+#include "qe/dispatch.hpp"
+#include "qe/indicator_cache.hpp"
+#include "qe/covariance.hpp"
+#include "qe/fixed_window.hpp"
+#include "qe/sweep.hpp"
 
+#include "kernels.hpp"
+
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
 #include <iostream>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
 using qe::BacktestCosts;
@@ -22,17 +36,89 @@ static std::size_t clamp_min(std::size_t v, std::size_t lo) {
   return (v < lo) ? lo : v;
 }
 
+// the previous O(n * window) rolling_std, kept as the accuracy/speed reference
+static std::vector<double> rolling_std_two_pass(const std::vector<double>& v, std::size_t w) {
+  std::vector<double> out(v.size(), 0.0);
+  for (std::size_t i = w - 1; i < v.size(); ++i) {
+    double mean = 0.0;
+    for (std::size_t j = i + 1 - w; j <= i; ++j) mean += v[j];
+    mean /= static_cast<double>(w);
+    double var = 0.0;
+    for (std::size_t j = i + 1 - w; j <= i; ++j) var += (v[j] - mean) * (v[j] - mean);
+    out[i] = std::sqrt(var / static_cast<double>(w));
+  }
+  return out;
+}
+
 int run_benchmarks(const std::string& csv_path, std::size_t iters) {
   if (iters == 0) {
     throw std::invalid_argument("--iters must be > 0");
   }
 
-  OhlcvTable table = read_ohlcv_csv(csv_path);
+  OhlcvColumns table = read_ohlcv_columns(csv_path);
   if (table.size() < 3) {
     throw std::invalid_argument("need at least 3 rows for benchmarks");
   }
 
-  std::vector<double> ret = compute_returns(table);
+  // load throughput, row table vs columns
+  const double mb = static_cast<double>(std::filesystem::file_size(csv_path)) / 1e6;
+  {
+    auto t0 = std::chrono::steady_clock::now();
+    volatile double sink = 0.0;
+
+    for (std::size_t i = 0; i < iters; ++i) {
+      auto t = read_ohlcv_csv(csv_path);
+      if (!t.empty()) {
+        sink += t.back().close;
+      }
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    const double ms = ms_since(t0, t1);
+    std::cout << "[bench] read_ohlcv_csv: " << ms
+              << " ms (" << iters << " iters, "
+              << (ms > 0.0 ? mb * static_cast<double>(iters) / (ms / 1000.0) : 0.0)
+              << " MB/s)\n";
+  }
+  {
+    auto t0 = std::chrono::steady_clock::now();
+    volatile double sink = 0.0;
+
+    for (std::size_t i = 0; i < iters; ++i) {
+      auto t = read_ohlcv_columns(csv_path);
+      if (!t.empty()) {
+        sink += t.close.back();
+      }
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    const double ms = ms_since(t0, t1);
+    std::cout << "[bench] read_ohlcv_columns: " << ms
+              << " ms (" << iters << " iters, "
+              << (ms > 0.0 ? mb * static_cast<double>(iters) / (ms / 1000.0) : 0.0)
+              << " MB/s)\n";
+  }
+  {
+    // close-only projection, what backtest/indicators load
+    auto t0 = std::chrono::steady_clock::now();
+    volatile double sink = 0.0;
+
+    for (std::size_t i = 0; i < iters; ++i) {
+      auto t = read_ohlcv_columns(csv_path, Columns::Close);
+      if (!t.empty()) {
+        sink += t.close.back();
+      }
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    const double ms = ms_since(t0, t1);
+    std::cout << "[bench] read_ohlcv_columns (close only): " << ms
+              << " ms (" << iters << " iters, "
+              << (ms > 0.0 ? mb * static_cast<double>(iters) / (ms / 1000.0) : 0.0)
+              << " MB/s)\n";
+  }
+
+  std::vector<double> ret = compute_returns(table.close);
 
   // compute_returns
   {
@@ -40,7 +126,7 @@ int run_benchmarks(const std::string& csv_path, std::size_t iters) {
     volatile double sink = 0.0;
 
     for (std::size_t i = 0; i < iters; ++i) {
-      auto r = compute_returns(table);
+      auto r = compute_returns(table.close);
       if (!r.empty()) {
         sink += r.back();
       }
@@ -71,6 +157,63 @@ int run_benchmarks(const std::string& csv_path, std::size_t iters) {
               << " ms (" << iters << " iters)\n";
   }
 
+  // one rolling_mean per window vs rolling_means over all of them (a sweep's SMA set)
+  {
+    const std::vector<std::size_t> windows = {5, 10, 20, 50, 200};
+    const std::span<const double> close_aligned = std::span<const double>(table.close).subspan(1);
+
+    auto t0 = std::chrono::steady_clock::now();
+    volatile double sink = 0.0;
+    for (std::size_t i = 0; i < iters; ++i) {
+      for (std::size_t w : windows) sink = sink + rolling_mean(close_aligned, w).back();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    RollingMeans means; // refilled in place, as a sweep would
+    for (std::size_t i = 0; i < iters; ++i) {
+      rolling_means(close_aligned, windows, MatrixLayout::WindowMajor, means);
+      sink = sink + means.data.back();
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    std::cout << "[bench] rolling_mean x" << windows.size() << ": " << ms_since(t0, t1)
+              << " ms vs rolling_means: " << ms_since(t1, t2) << " ms (" << iters << " iters)\n";
+  }
+
+  // rolling extremes and trailing drawdown: cost per bar should not depend on the window
+  for (std::size_t w : {20, 5000}) {
+    if (table.size() < w) break;
+
+    auto t0 = std::chrono::steady_clock::now();
+    volatile double sink = 0.0;
+    for (std::size_t i = 0; i < iters; ++i) {
+      const DonchianSeries ch = donchian(table.high, table.low, w);
+      sink = sink + ch.middle.back();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iters; ++i) sink = sink + rolling_max_drawdown(table.close, w).back();
+    auto t2 = std::chrono::steady_clock::now();
+    std::cout << "[bench] donchian w=" << w << ": " << ms_since(t0, t1) << " ms, rolling_max_drawdown: "
+              << ms_since(t1, t2) << " ms (" << iters << " iters)\n";
+  }
+
+  // rolling_std against the two-pass reference (run once; it is O(n * window))
+  for (std::size_t w : {20, 60, 250}) {
+    if (ret.size() < w) break;
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<double> fast;
+    for (std::size_t i = 0; i < iters; ++i) fast = rolling_std(ret, w);
+    auto t1 = std::chrono::steady_clock::now();
+    const std::vector<double> ref = rolling_std_two_pass(ret, w);
+    auto t2 = std::chrono::steady_clock::now();
+
+    double max_rel = 0.0;
+    for (std::size_t i = w - 1; i < ret.size(); ++i) {
+      if (ref[i] > 0.0) max_rel = std::max(max_rel, std::fabs(fast[i] - ref[i]) / ref[i]);
+    }
+    std::cout << "[bench] rolling_std w=" << w << ": " << ms_since(t0, t1) / static_cast<double>(iters)
+              << " ms/iter vs two-pass " << ms_since(t1, t2) << " ms (max rel diff " << max_rel << ")\n";
+  }
+
   // backtest loop
   {
     // ensure slow_window < table.size()
@@ -90,7 +233,7 @@ int run_benchmarks(const std::string& csv_path, std::size_t iters) {
       c.fee_bps = 1.0;
       c.slippage_bps = 1.0;
 
-      auto r = backtest_sma_crossover(table, fast, slow, 1.0, c);
+      auto r = backtest_sma_crossover(table.close, fast, slow, 1.0, c);
       if (!r.equity.empty()) {
         sink += r.equity.back();
       }
@@ -100,6 +243,309 @@ int run_benchmarks(const std::string& csv_path, std::size_t iters) {
     std::cout << "[bench] backtest_sma_crossover (fast=" << fast
               << " slow=" << slow << ", 2bps): " << ms_since(t0, t1)
               << " ms (" << iters << " iters)\n";
+
+    // the same runs into reused buffers: one fused pass plus the variance pass, nothing
+    // allocated (tests/test_backtest.cpp counts the heap on this path)
+    std::vector<double> strat_ret(table.close.size() - 1);
+    std::vector<double> equity(table.close.size() - 1);
+    BacktestCosts c;
+    c.fee_bps = 1.0;
+    c.slippage_bps = 1.0;
+    auto t2 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iters; ++i) {
+      sink = sink + backtest_sma_crossover(table.close, fast, slow, 1.0, c, strat_ret, equity).sharpe;
+    }
+    auto t3 = std::chrono::steady_clock::now();
+    std::cout << "[bench] backtest_sma_crossover, reused buffers: " << ms_since(t2, t3) << " ms ("
+              << iters << " iters)\n";
+
+    // no series at all: two passes over close, nothing per bar kept
+    auto t4 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iters; ++i) {
+      sink = sink + backtest_sma_crossover(table.close, fast, slow, 1.0, c, BacktestOutput::MetricsOnly).sharpe;
+    }
+    auto t5 = std::chrono::steady_clock::now();
+    std::cout << "[bench] backtest_sma_crossover, metrics only: " << ms_since(t4, t5) << " ms (" << iters
+              << " iters, " << 2 * table.close.size() * sizeof(double) / (1 << 20)
+              << " MB of series not kept)\n";
+  }
+
+  // runtime windows vs the compiled fixed-window kernels (qe/fixed_window.hpp), both into
+  // reused buffers
+  if (table.close.size() > 201) {
+    const std::span<const double> close_aligned = std::span<const double>(table.close).subspan(1);
+    std::vector<double> mean(close_aligned.size());
+    volatile double sink = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iters; ++i) {
+      rolling_mean(close_aligned, 20, mean);
+      sink = sink + mean.back();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iters; ++i) {
+      rolling_mean<20>(close_aligned, mean);
+      sink = sink + mean.back();
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    std::cout << "[bench] rolling_mean w=20: " << ms_since(t0, t1) << " ms vs rolling_mean<20>: "
+              << ms_since(t1, t2) << " ms (" << iters << " iters)\n";
+
+    std::vector<double> strat_ret(table.close.size() - 1);
+    std::vector<double> equity(table.close.size() - 1);
+    for (const WindowPair& p : kFixedPairs) {
+      const FixedSmaCrossover fixed = find_fixed_sma_crossover(p.fast, p.slow);
+      auto t3 = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < iters; ++i) {
+        sink = sink + backtest_sma_crossover(table.close, p.fast, p.slow, 1.0, {}, strat_ret, equity).sharpe;
+      }
+      auto t4 = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < iters; ++i) {
+        sink = sink + fixed(table.close, 1.0, {}, strat_ret, equity).sharpe;
+      }
+      auto t5 = std::chrono::steady_clock::now();
+      std::cout << "[bench] backtest_sma_crossover " << p.fast << "/" << p.slow << ": " << ms_since(t3, t4)
+                << " ms vs fixed: " << ms_since(t4, t5) << " ms (" << iters << " iters)\n";
+    }
+  }
+
+  // a sweep grid on the last 200k bars: one metrics-only backtest call per pair, the pairs
+  // batched across SIMD lanes, and sweep_sma_crossover
+  if (table.close.size() > 1001) {
+    const std::size_t bars = std::min<std::size_t>(table.close.size(), 200000);
+    const std::span<const double> close = std::span<const double>(table.close).last(bars);
+    const std::vector<WindowPair> grid = sma_grid({5, 50, 5}, {20, 200, 20});
+
+    volatile double sink = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (const WindowPair& p : grid) {
+      sink = sink + backtest_sma_crossover(close, p.fast, p.slow, 1.0, {}, BacktestOutput::MetricsOnly).sharpe;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    const std::vector<BacktestResult> batched = backtest_sma_crossover_batch(close, grid);
+    auto t2 = std::chrono::steady_clock::now();
+    const std::vector<SweepRow> rows = sweep_sma_crossover(close, grid);
+    auto t3 = std::chrono::steady_clock::now();
+    sink = sink + batched.back().sharpe + rows.back().sharpe;
+    const double n = static_cast<double>(grid.size());
+    std::cout << "[bench] sweep " << grid.size() << " pairs x " << bars << " bars: one call each "
+              << n / (ms_since(t0, t1) / 1000.0) << " backtests/s vs batched (" << kSmaBatchLanes
+              << " lanes, " << kernels::isa() << ") " << n / (ms_since(t1, t2) / 1000.0)
+              << " backtests/s vs sweep_sma_crossover " << n / (ms_since(t2, t3) / 1000.0) << " backtests/s ("
+              << std::thread::hardware_concurrency() << " cores)\n";
+  }
+
+  // the same grid for breakout, each pair building its channels vs the pairs sharing them
+  if (table.close.size() > 1001) {
+    const std::size_t bars = std::min<std::size_t>(table.close.size(), 200000);
+    const std::span<const double> close = std::span<const double>(table.close).last(bars);
+    const std::vector<WindowPair> grid = sma_grid({5, 50, 5}, {20, 200, 20});
+    const StrategyKernels& breakout = find_strategy("breakout");
+
+    SweepOptions opts;
+    auto t0 = std::chrono::steady_clock::now();
+    const std::vector<SweepRow> plain = sweep_strategy(breakout, close, grid, opts);
+    auto t1 = std::chrono::steady_clock::now();
+    IndicatorCache cache;
+    opts.cache = &cache;
+    const std::vector<SweepRow> shared = sweep_strategy(breakout, close, grid, opts);
+    auto t2 = std::chrono::steady_clock::now();
+    volatile double sink = 0.0;
+    sink = sink + plain.back().sharpe + shared.back().sharpe;
+    const IndicatorCacheStats st = cache.stats();
+    const double n = static_cast<double>(grid.size());
+    std::cout << "[bench] breakout sweep " << grid.size() << " pairs x " << bars << " bars: "
+              << n / (ms_since(t0, t1) / 1000.0) << " backtests/s vs cached channels "
+              << n / (ms_since(t1, t2) / 1000.0) << " backtests/s (hit rate " << st.hit_rate() << ", "
+              << static_cast<double>(st.bytes) / 1e6 << " MB held)\n";
+  }
+
+  // a small breakout grid, each run rebuilding its channels vs sharing them through the cache
+  if (table.close.size() > 201) {
+    const std::size_t fasts[] = {5, 10, 20};
+    const std::size_t slows[] = {50, 100, 200};
+    const StrategyKernels& breakout = find_strategy("breakout");
+
+    auto t0 = std::chrono::steady_clock::now();
+    volatile double sink = 0.0;
+    for (std::size_t i = 0; i < iters; ++i) {
+      for (std::size_t f : fasts) {
+        for (std::size_t sl : slows) sink = sink + breakout.run(table.close, {f, sl}, 1.0, {}, {}, {}).sharpe;
+      }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    IndicatorCache cache;
+    for (std::size_t i = 0; i < iters; ++i) {
+      const SeriesSource src = make_series_source(table.close, "close"); // hashed once per dataset
+      for (std::size_t f : fasts) {
+        for (std::size_t sl : slows) sink = sink + breakout.cached(src, {f, sl}, 1.0, {}, cache, {}, {}).sharpe;
+      }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    const IndicatorCacheStats st = cache.stats();
+    std::cout << "[bench] 3x3 breakout grid: " << ms_since(t0, t1) << " ms vs cached: " << ms_since(t1, t2)
+              << " ms (" << iters << " iters, hit rate " << st.hit_rate() << ", "
+              << static_cast<double>(st.bytes) / 1e6 << " MB held)\n";
+  }
+
+  // rolling covariance of a 500-symbol universe (lagged copies of the returns, ten years of
+  // daily bars), incremental vs a full recompute per window on a sample of bars
+  if (table.close.size() > 2600) {
+    const std::size_t n = 500;
+    const std::size_t bars_n = 2520;
+    const std::size_t w = 60;
+    std::vector<double> bars(bars_n * n);
+    for (std::size_t t = 0; t < bars_n; ++t) {
+      for (std::size_t k = 0; k < n; ++k) {
+        const double r = ret[1 + (t + k * 7) % (ret.size() - 1)];
+        bars[t * n + k] = std::isnan(r) ? 0.0 : r;
+      }
+    }
+
+    volatile double sink = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    rolling_covariance(bars, n, {w, 1, 1}, [&](std::size_t, std::span<const double> m) { sink = sink + m[1]; });
+    auto t1 = std::chrono::steady_clock::now();
+
+    const std::size_t sample = 5;
+    std::vector<double> mean(n);
+    std::vector<double> cov(n * n);
+    for (std::size_t s = 0; s < sample; ++s) {
+      const std::size_t t = bars_n - 1 - s;
+      std::fill(mean.begin(), mean.end(), 0.0);
+      std::fill(cov.begin(), cov.end(), 0.0);
+      for (std::size_t b = t + 1 - w; b <= t; ++b) {
+        for (std::size_t i = 0; i < n; ++i) mean[i] += bars[b * n + i] / static_cast<double>(w);
+      }
+      for (std::size_t b = t + 1 - w; b <= t; ++b) {
+        for (std::size_t i = 0; i < n; ++i) {
+          const double di = bars[b * n + i] - mean[i];
+          for (std::size_t j = i; j < n; ++j) cov[i * n + j] += di * (bars[b * n + j] - mean[j]);
+        }
+      }
+      sink = sink + cov[1];
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    const double per_bar = ms_since(t1, t2) / static_cast<double>(sample);
+    std::cout << "[bench] rolling_covariance " << n << " series x " << bars_n << " bars (w=" << w
+              << "): " << ms_since(t0, t1) << " ms vs recompute: ~"
+              << per_bar * static_cast<double>(bars_n - w + 1) << " ms (" << per_bar << " ms per bar)\n";
+  }
+
+  // raw kernels (src/kernels_*.cpp), bytes read + written per call, once per variant this CPU runs
+  if (table.close.size() > 1) {
+    const std::vector<double>& close = table.close;
+    const std::size_t n = close.size();
+    std::vector<double> out(n);
+    std::vector<std::uint8_t> traded(n);
+    const std::vector<double> equity = backtest_sma_crossover(close, 5, 20).equity;
+    const std::vector<double> sma_fast = rolling_mean(std::span<const double>(close).subspan(1), 5);
+    const std::vector<double> sma_slow = rolling_mean(std::span<const double>(close).subspan(1), 20);
+
+    // synthetic option chain
+    const std::size_t n_bs = std::size_t{1} << 16;
+    std::vector<double> bs_s(n_bs), bs_k(n_bs), bs_r(n_bs), bs_sigma(n_bs), bs_t(n_bs);
+    std::vector<double> bs_call(n_bs), bs_put(n_bs);
+    for (std::size_t i = 0; i < n_bs; ++i) {
+      bs_s[i] = 100.0;
+      bs_k[i] = 50.0 + static_cast<double>(i % 101);
+      bs_r[i] = 0.03;
+      bs_sigma[i] = 0.1 + 0.01 * static_cast<double>(i % 50);
+      bs_t[i] = 0.25 * static_cast<double>(1 + i % 8);
+    }
+
+    auto report = [&](const char* name, std::size_t bytes, auto&& fn) {
+      volatile double sink = 0.0;
+      auto t0 = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < iters; ++i) sink = sink + fn();
+      auto t1 = std::chrono::steady_clock::now();
+      const double ms = ms_since(t0, t1);
+      std::cout << "[bench] kernel " << name << " (" << kernels::isa() << "): " << ms << " ms ("
+                << iters << " iters, "
+                << (ms > 0.0 ? static_cast<double>(bytes) * static_cast<double>(iters) / (ms / 1000.0) / 1e9 : 0.0)
+                << " GB/s)\n";
+    };
+
+    const Isa active = active_isa();
+    std::cout << "[bench] kernels: cpu supports " << isa_name(detected_isa()) << ", active "
+              << isa_name(active) << " (QE_ISA overrides)\n";
+    for (Isa isa : {Isa::Scalar, Isa::Avx2, Isa::Avx512}) {
+      if (set_active_isa(isa) != isa) continue;
+
+      report("returns", (2 * n - 1) * 8, [&] {
+        kernels::returns(close.data(), n, out.data());
+        return out[n - 2];
+      });
+      report("rolling_mean w=20", 3 * n * 8, [&] {
+        kernels::rolling_mean(close.data(), n, std::min<std::size_t>(20, n), out.data());
+        return out[n - 1];
+      });
+      report("crossover_returns", 4 * ret.size() * 8, [&] {
+        kernels::crossover_returns(sma_fast.data(), sma_slow.data(), ret.data(), ret.size(), 0, 2e-4, out.data(),
+                                   traded.data());
+        return out[ret.size() - 1];
+      });
+      report("max_drawdown", equity.size() * 8, [&] {
+        return kernels::max_drawdown(equity.data(), equity.size());
+      });
+      report("mean_var", 2 * ret.size() * 8, [&] {
+        return kernels::mean_var(ret.data(), ret.size()).var;
+      });
+      report("count_wins", ret.size() * 8, [&] {
+        return static_cast<double>(kernels::count_wins(ret.data(), ret.size()).wins);
+      });
+      report("black_scholes 64k", 7 * n_bs * 8, [&] {
+        kernels::black_scholes(bs_s.data(), bs_k.data(), bs_r.data(), bs_sigma.data(), bs_t.data(), n_bs,
+                               bs_call.data(), bs_put.data());
+        return bs_call[n_bs - 1];
+      });
+    }
+    set_active_isa(active);
+  }
+
+  // compressed columns: size and block decode throughput
+  {
+    const CompressedOhlcv packed = compress(table.view());
+    const CompressedOhlcvView pv = packed.view();
+    const double raw_bytes = static_cast<double>(table.size()) * 48.0;
+    std::cout << "[bench] compress: " << raw_bytes / 1e6 << " MB -> "
+              << static_cast<double>(pv.bytes()) / 1e6 << " MB ("
+              << raw_bytes / static_cast<double>(pv.bytes()) << "x; close "
+              << static_cast<double>(table.size()) * 8.0 / static_cast<double>(pv.close.bytes())
+              << "x, ts " << static_cast<double>(table.size()) * 8.0 / static_cast<double>(pv.ts.bytes())
+              << "x)\n";
+
+    auto t0 = std::chrono::steady_clock::now();
+    volatile double sink = 0.0;
+    OhlcvColumns block;
+    for (std::size_t i = 0; i < iters; ++i) {
+      for (std::size_t b = 0; b < pv.blocks(); ++b) {
+        pv.decode_block(b, block);
+        sink += block.close.back();
+      }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    double ms = ms_since(t0, t1);
+    std::cout << "[bench] decode all columns: " << ms << " ms (" << iters << " iters, "
+              << (ms > 0.0 ? raw_bytes * static_cast<double>(iters) / (ms / 1000.0) / 1e9 : 0.0)
+              << " GB/s decoded)\n";
+
+    // rolling mean fed block by block from the compressed close column
+    const std::size_t w = clamp_min(std::min<std::size_t>(20, table.size()), 2);
+    t0 = std::chrono::steady_clock::now();
+    std::vector<double> vals(kCodecBlock);
+    std::vector<double> means;
+    for (std::size_t i = 0; i < iters; ++i) {
+      RollingMeanStream rm(w);
+      for (std::size_t b = 0; b < pv.blocks(); ++b) {
+        const std::size_t n = decode_doubles_block(pv.close, b, vals.data());
+        rm.process(std::span<const double>(vals.data(), n), means);
+      }
+      sink += means.back();
+    }
+    t1 = std::chrono::steady_clock::now();
+    ms = ms_since(t0, t1);
+    std::cout << "[bench] rolling_mean from compressed close (w=" << w << "): " << ms
+              << " ms (" << iters << " iters)\n";
   }
 
   std::cout << "[bench] rows=" << table.size()
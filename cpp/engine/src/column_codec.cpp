@@ -0,0 +1,395 @@
+#include "qe/column_codec.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace qe {
+
+namespace {
+
+class BitWriter {
+public:
+  explicit BitWriter(std::vector<std::uint64_t>& words) : words_(words) {}
+
+  // appends the low n bits of v, n in [1, 64]
+  void write(std::uint64_t v, unsigned n) {
+    if (n < 64) v &= (std::uint64_t{1} << n) - 1;
+    const unsigned room = 64 - used_;
+    if (n < room) {
+      cur_ |= v << (room - n);
+      used_ += n;
+      return;
+    }
+    cur_ |= v >> (n - room);
+    words_.push_back(cur_);
+    used_ = n - room;
+    cur_ = used_ ? v << (64 - used_) : 0;
+  }
+
+  std::uint64_t bit_count() const { return words_.size() * 64 + used_; }
+
+  void finish() {
+    if (used_) words_.push_back(cur_);
+    cur_ = 0;
+    used_ = 0;
+  }
+
+private:
+  std::vector<std::uint64_t>& words_;
+  std::uint64_t cur_ = 0;
+  unsigned used_ = 0;
+};
+
+class BitReader {
+public:
+  BitReader(std::span<const std::uint64_t> words, std::uint64_t pos)
+    : w_(words.data()), n_(words.size()), pos_(pos) {}
+
+  // next 64 bits without consuming them (zeros past the end)
+  std::uint64_t peek() const {
+    const std::size_t i = static_cast<std::size_t>(pos_ >> 6);
+    const unsigned off = static_cast<unsigned>(pos_ & 63);
+    if (i >= n_) return 0;
+    std::uint64_t v = w_[i] << off;
+    if (off && i + 1 < n_) v |= w_[i + 1] >> (64 - off);
+    return v;
+  }
+
+  void skip(unsigned n) { pos_ += n; }
+
+  // n in [1, 64]
+  std::uint64_t read(unsigned n) {
+    const std::uint64_t v = peek() >> (64 - n);
+    pos_ += n;
+    return v;
+  }
+
+private:
+  const std::uint64_t* w_;
+  std::size_t n_;
+  std::uint64_t pos_;
+};
+
+// signed integers in variable-width buckets: bucket k is k one-bits (then a zero, except
+// for the last bucket) followed by widths[k] payload bits; bucket 0 is the value 0.
+constexpr unsigned kBuckets = 6;
+constexpr unsigned kDodBits[kBuckets] = {0, 7, 9, 12, 32, 64};   // timestamp delta-of-delta
+constexpr unsigned kDeltaBits[kBuckets] = {0, 6, 10, 14, 20, 64}; // scaled decimal deltas
+
+bool fits_signed(std::int64_t v, unsigned bits) {
+  if (bits == 64) return true;
+  const std::int64_t lim = std::int64_t{1} << (bits - 1);
+  return v >= -lim && v < lim;
+}
+
+std::int64_t sign_extend(std::uint64_t v, unsigned bits) {
+  if (bits == 64) return static_cast<std::int64_t>(v);
+  const std::uint64_t m = std::uint64_t{1} << (bits - 1);
+  return static_cast<std::int64_t>((v ^ m) - m);
+}
+
+void write_bucketed(BitWriter& bw, std::int64_t v, const unsigned (&widths)[kBuckets]) {
+  if (v == 0) {
+    bw.write(0, 1);
+    return;
+  }
+  for (unsigned k = 1; k < kBuckets; ++k) {
+    if (!fits_signed(v, widths[k])) continue;
+    if (k == kBuckets - 1) {
+      bw.write((std::uint64_t{1} << k) - 1, k);
+    } else {
+      bw.write(((std::uint64_t{1} << k) - 1) << 1, k + 1);
+    }
+    bw.write(static_cast<std::uint64_t>(v), widths[k]);
+    return;
+  }
+}
+
+std::int64_t read_bucketed(BitReader& br, const unsigned (&widths)[kBuckets]) {
+  const std::uint64_t p = br.peek();
+  if ((p >> 63) == 0) {
+    br.skip(1);
+    return 0;
+  }
+  const unsigned k = std::min(static_cast<unsigned>(std::countl_one(p)), kBuckets - 1);
+  br.skip(k == kBuckets - 1 ? k : k + 1);
+  return sign_extend(br.read(widths[k]), widths[k]);
+}
+
+// double blocks start with a 4-bit mode: kXorMode, or d < kXorMode meaning every value
+// in the block is exactly k / 10^d for an integer k (fixed-decimal prices, volumes),
+// stored as bucketed deltas of k
+constexpr unsigned kXorMode = 15;
+constexpr unsigned kMaxDecimals = 12;
+constexpr double kPow10[kMaxDecimals + 1] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6,
+                                             1e7, 1e8, 1e9, 1e10, 1e11, 1e12};
+
+bool scaled_exactly(double v, unsigned d, std::int64_t& k) {
+  const double x = v * kPow10[d];
+  if (!(std::fabs(x) < 9.0e15)) return false; // also rejects NaN / inf
+  k = std::llround(x);
+  const double back = static_cast<double>(k) / kPow10[d];
+  return std::bit_cast<std::uint64_t>(back) == std::bit_cast<std::uint64_t>(v);
+}
+
+// smallest decimal count that reproduces every value bit-exactly, or kXorMode
+unsigned pick_decimals(const double* v, std::size_t n) {
+  std::int64_t k;
+  for (unsigned d = 0; d <= kMaxDecimals; ++d) {
+    std::size_t i = 0;
+    while (i < n && scaled_exactly(v[i], d, k)) ++i;
+    if (i == n) return d;
+  }
+  return kXorMode;
+}
+
+std::uint64_t double_bits(double d) {
+  return std::bit_cast<std::uint64_t>(d);
+}
+
+void encode_ts_block(BitWriter& bw, const std::int64_t* v, std::size_t n) {
+  // deltas in wrapping unsigned arithmetic so extreme inputs still round-trip
+  bw.write(static_cast<std::uint64_t>(v[0]), 64);
+  std::uint64_t prev = static_cast<std::uint64_t>(v[0]);
+  std::uint64_t prev_delta = 0;
+
+  for (std::size_t i = 1; i < n; ++i) {
+    const std::uint64_t cur = static_cast<std::uint64_t>(v[i]);
+    const std::uint64_t delta = cur - prev;
+    write_bucketed(bw, static_cast<std::int64_t>(delta - prev_delta), kDodBits);
+    prev = cur;
+    prev_delta = delta;
+  }
+}
+
+void encode_decimal_block(BitWriter& bw, const double* v, std::size_t n, unsigned d) {
+  std::int64_t prev = 0;
+  scaled_exactly(v[0], d, prev);
+  bw.write(static_cast<std::uint64_t>(prev), 64);
+
+  for (std::size_t i = 1; i < n; ++i) {
+    std::int64_t k = 0;
+    scaled_exactly(v[i], d, k);
+    write_bucketed(bw, k - prev, kDeltaBits);
+    prev = k;
+  }
+}
+
+void encode_f64_block(BitWriter& bw, const double* v, std::size_t n) {
+  const unsigned mode = pick_decimals(v, n);
+  bw.write(mode, 4);
+  if (mode != kXorMode) {
+    encode_decimal_block(bw, v, n, mode);
+    return;
+  }
+
+  std::uint64_t prev = double_bits(v[0]);
+  bw.write(prev, 64);
+
+  unsigned win_lead = 0;
+  unsigned win_trail = 0;
+  bool have_window = false;
+
+  for (std::size_t i = 1; i < n; ++i) {
+    const std::uint64_t cur = double_bits(v[i]);
+    const std::uint64_t x = cur ^ prev;
+    prev = cur;
+
+    if (x == 0) {
+      bw.write(0, 1);
+      continue;
+    }
+
+    const unsigned lead = std::min(static_cast<unsigned>(std::countl_zero(x)), 31u);
+    const auto trail = static_cast<unsigned>(std::countr_zero(x));
+
+    if (have_window && lead >= win_lead && trail >= win_trail) {
+      // '10' + the bits inside the previous window
+      bw.write(0b10, 2);
+      bw.write(x >> win_trail, 64 - win_lead - win_trail);
+    } else {
+      // '11' + 5-bit leading zeros + 6-bit (length - 1) + meaningful bits
+      const unsigned len = 64 - lead - trail;
+      bw.write(0b11, 2);
+      bw.write(lead, 5);
+      bw.write(len - 1, 6);
+      bw.write(x >> trail, len);
+      win_lead = lead;
+      win_trail = trail;
+      have_window = true;
+    }
+  }
+}
+
+template <class T, class EncodeBlock>
+EncodedColumn encode_blocks(std::span<const T> values, EncodeBlock encode_block) {
+  EncodedColumn col;
+  col.size = values.size();
+  col.block_bit.reserve((values.size() + kCodecBlock - 1) / kCodecBlock);
+
+  BitWriter bw(col.words);
+  for (std::size_t at = 0; at < values.size(); at += kCodecBlock) {
+    col.block_bit.push_back(bw.bit_count());
+    encode_block(bw, values.data() + at, std::min(kCodecBlock, values.size() - at));
+  }
+  bw.finish();
+  return col;
+}
+
+} // namespace
+
+std::size_t EncodedColumnView::block_size(std::size_t b) const {
+  return std::min(kCodecBlock, size - b * kCodecBlock);
+}
+
+EncodedColumn encode_timestamps(std::span<const std::int64_t> values) {
+  return encode_blocks(values, encode_ts_block);
+}
+
+EncodedColumn encode_doubles(std::span<const double> values) {
+  return encode_blocks(values, encode_f64_block);
+}
+
+void decode_timestamps(std::span<const std::uint64_t> words, std::uint64_t first_bit,
+                       std::size_t count, std::int64_t* out) {
+  if (count == 0) return;
+
+  BitReader br(words, first_bit);
+  std::uint64_t prev = br.read(64);
+  std::uint64_t delta = 0;
+  out[0] = static_cast<std::int64_t>(prev);
+
+  for (std::size_t i = 1; i < count; ++i) {
+    delta += static_cast<std::uint64_t>(read_bucketed(br, kDodBits));
+    prev += delta;
+    out[i] = static_cast<std::int64_t>(prev);
+  }
+}
+
+void decode_doubles(std::span<const std::uint64_t> words, std::uint64_t first_bit,
+                    std::size_t count, double* out) {
+  if (count == 0) return;
+
+  BitReader br(words, first_bit);
+  const auto mode = static_cast<unsigned>(br.read(4));
+  if (mode > kMaxDecimals && mode != kXorMode) {
+    throw std::runtime_error("qec: corrupt compressed column");
+  }
+  if (mode != kXorMode) {
+    const double scale = kPow10[mode];
+    auto k = static_cast<std::int64_t>(br.read(64));
+    out[0] = static_cast<double>(k) / scale;
+    for (std::size_t i = 1; i < count; ++i) {
+      k += read_bucketed(br, kDeltaBits);
+      out[i] = static_cast<double>(k) / scale;
+    }
+    return;
+  }
+
+  std::uint64_t prev = br.read(64);
+  out[0] = std::bit_cast<double>(prev);
+
+  unsigned win_lead = 0;
+  unsigned win_trail = 0;
+
+  for (std::size_t i = 1; i < count; ++i) {
+    const std::uint64_t p = br.peek();
+    if ((p >> 63) == 0) {
+      br.skip(1);
+    } else if (((p >> 62) & 1) == 0) {
+      br.skip(2);
+      prev ^= br.read(64 - win_lead - win_trail) << win_trail;
+    } else {
+      win_lead = static_cast<unsigned>((p >> 57) & 31);
+      const unsigned len = static_cast<unsigned>((p >> 51) & 63) + 1;
+      if (win_lead + len > 64) {
+        throw std::runtime_error("qec: corrupt compressed column");
+      }
+      win_trail = 64 - win_lead - len;
+      br.skip(13);
+      prev ^= br.read(len) << win_trail;
+    }
+    out[i] = std::bit_cast<double>(prev);
+  }
+}
+
+bool double_block_mode_valid(std::span<const std::uint64_t> words, std::uint64_t first_bit) {
+  const auto mode = static_cast<unsigned>(BitReader(words, first_bit).read(4));
+  return mode <= kMaxDecimals || mode == kXorMode;
+}
+
+std::size_t decode_timestamps_block(const EncodedColumnView& col, std::size_t b, std::int64_t* out) {
+  const std::size_t n = col.block_size(b);
+  decode_timestamps(col.words, col.block_bit[b], n, out);
+  return n;
+}
+
+std::size_t decode_doubles_block(const EncodedColumnView& col, std::size_t b, double* out) {
+  const std::size_t n = col.block_size(b);
+  decode_doubles(col.words, col.block_bit[b], n, out);
+  return n;
+}
+
+std::size_t CompressedOhlcvView::bytes() const {
+  return ts.bytes() + open.bytes() + high.bytes() + low.bytes() + close.bytes() + volume.bytes();
+}
+
+namespace {
+
+// sizes the selected columns of out to n and empties the rest
+void size_columns(OhlcvColumns& out, Columns columns, std::size_t n) {
+  out.ts.resize(has_column(columns, Columns::Timestamp) ? n : 0);
+  out.open.resize(has_column(columns, Columns::Open) ? n : 0);
+  out.high.resize(has_column(columns, Columns::High) ? n : 0);
+  out.low.resize(has_column(columns, Columns::Low) ? n : 0);
+  out.close.resize(has_column(columns, Columns::Close) ? n : 0);
+  out.volume.resize(has_column(columns, Columns::Volume) ? n : 0);
+}
+
+// decodes block b of every non-empty column of out, starting at row `at`
+void decode_selected(const CompressedOhlcvView& in, std::size_t b, OhlcvColumns& out, std::size_t at) {
+  if (!out.ts.empty()) decode_timestamps_block(in.ts, b, out.ts.data() + at);
+  if (!out.open.empty()) decode_doubles_block(in.open, b, out.open.data() + at);
+  if (!out.high.empty()) decode_doubles_block(in.high, b, out.high.data() + at);
+  if (!out.low.empty()) decode_doubles_block(in.low, b, out.low.data() + at);
+  if (!out.close.empty()) decode_doubles_block(in.close, b, out.close.data() + at);
+  if (!out.volume.empty()) decode_doubles_block(in.volume, b, out.volume.data() + at);
+}
+
+} // namespace
+
+void CompressedOhlcvView::decode_block(std::size_t b, OhlcvColumns& out, Columns columns) const {
+  size_columns(out, columns, close.block_size(b));
+  decode_selected(*this, b, out, 0);
+}
+
+OhlcvColumns CompressedOhlcvView::decode(Columns columns) const {
+  OhlcvColumns out;
+  size_columns(out, columns, size());
+  for (std::size_t b = 0; b < blocks(); ++b) {
+    decode_selected(*this, b, out, b * kCodecBlock);
+  }
+  return out;
+}
+
+CompressedOhlcv compress(const OhlcvView& data) {
+  const std::size_t n = data.size();
+  if (data.ts.size() != n || data.open.size() != n || data.high.size() != n ||
+      data.low.size() != n || data.close.size() != n || data.volume.size() != n) {
+    throw std::invalid_argument("compress: all columns must have the same length");
+  }
+
+  CompressedOhlcv c;
+  c.ts = encode_timestamps(data.ts);
+  c.open = encode_doubles(data.open);
+  c.high = encode_doubles(data.high);
+  c.low = encode_doubles(data.low);
+  c.close = encode_doubles(data.close);
+  c.volume = encode_doubles(data.volume);
+  return c;
+}
+
+} // namespace qe
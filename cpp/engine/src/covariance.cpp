@@ -0,0 +1,277 @@
+#include "qe/covariance.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#include "kernels.hpp"
+#include "run_workers.hpp"
+
+namespace qe {
+
+static double nanv() {
+  return std::numeric_limits<double>::quiet_NaN();
+}
+
+// below this many multiply-adds an update is not worth waking threads for
+static constexpr std::size_t kMinParallelWork = std::size_t{1} << 20;
+
+// columns per tile: the k bars of a tile (both the added and removed ones) stay around 256 KB
+static std::size_t tile_columns(std::size_t k) {
+  const std::size_t cols = std::clamp<std::size_t>(16384 / std::max<std::size_t>(k, 1), 64, 1024);
+  return cols / 16 * 16;
+}
+
+static std::size_t resolve_threads(std::size_t threads) {
+  if (threads != 0) return threads;
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+RollingCovariance::RollingCovariance(std::size_t n_series, std::size_t window, std::size_t threads)
+  : n_(n_series), window_(window), threads_(resolve_threads(threads)) {
+  if (n_series == 0) {
+    throw std::invalid_argument("rolling_covariance: n_series must be > 0");
+  }
+  if (window == 0) {
+    throw std::invalid_argument("rolling_covariance: window must be > 0");
+  }
+  threads_ = std::min(threads_, n_);
+  ring_.assign(window_ * n_, 0.0);
+  shift_.assign(n_, 0.0);
+  sum_.assign(n_, 0.0);
+  cross_.assign(n_ * n_, 0.0);
+
+  // row i of the upper triangle has n - i entries; cut where the running area passes k / threads
+  shard_rows_.assign(threads_ + 1, n_);
+  shard_rows_[0] = 0;
+  const double total = static_cast<double>(n_) * static_cast<double>(n_ + 1) / 2.0;
+  double area = 0.0;
+  std::size_t shard = 1;
+  for (std::size_t i = 0; i < n_ && shard < threads_; ++i) {
+    area += static_cast<double>(n_ - i);
+    if (area >= total * static_cast<double>(shard) / static_cast<double>(threads_)) {
+      shard_rows_[shard++] = i + 1;
+    }
+  }
+}
+
+template <class Fn>
+void RollingCovariance::for_row_shards(std::size_t work, Fn&& fn) {
+  if (threads_ <= 1 || work < kMinParallelWork) {
+    fn(std::size_t{0}, n_);
+    return;
+  }
+  detail::run_workers(threads_, [&](std::size_t k) { fn(shard_rows_[k], shard_rows_[k + 1]); });
+}
+
+void RollingCovariance::push(std::span<const double> bar) {
+  if (bar.size() != n_) {
+    throw std::invalid_argument("rolling_covariance: a bar must have n_series values");
+  }
+  push_bars(bar);
+}
+
+void RollingCovariance::push_bars(std::span<const double> bars) {
+  if (bars.size() % n_ != 0) {
+    throw std::invalid_argument("rolling_covariance: bars must hold a whole number of bars");
+  }
+  const std::size_t total = bars.size() / n_;
+  std::size_t b = 0;
+  while (b < total) {
+    if (count_ < window_) {
+      std::copy_n(bars.begin() + static_cast<std::ptrdiff_t>(b * n_), n_,
+                  ring_.begin() + static_cast<std::ptrdiff_t>(count_ * n_));
+      ++b;
+      if (++count_ == window_) rebuild();
+      continue;
+    }
+
+    // the cross products are rebuilt whenever count_ reaches a multiple of the window, so
+    // bars that run up to that point only need to land in the ring
+    const std::size_t to_rebuild = window_ - count_ % window_;
+    const std::size_t k = std::min(total - b, to_rebuild);
+    if (k == to_rebuild) {
+      for (std::size_t t = 0; t < k; ++t) {
+        std::copy_n(bars.begin() + static_cast<std::ptrdiff_t>((b + t) * n_), n_,
+                    ring_.begin() + static_cast<std::ptrdiff_t>(((count_ + t) % window_) * n_));
+      }
+      count_ += k;
+      rebuild();
+    } else {
+      update(b, k, bars);
+      count_ += k;
+    }
+    b += k;
+  }
+}
+
+void RollingCovariance::rebuild() {
+  const std::size_t w = window_;
+  const double wd = static_cast<double>(w);
+
+  std::fill(shift_.begin(), shift_.end(), 0.0);
+  for (std::size_t b = 0; b < w; ++b) {
+    for (std::size_t i = 0; i < n_; ++i) shift_[i] += ring_[b * n_ + i];
+  }
+  for (double& s : shift_) s /= wd;
+
+  // centered window in added_, its transpose (the per-row coefficients) in removed_
+  added_.resize(w * n_);
+  removed_.resize(w * n_);
+  std::fill(sum_.begin(), sum_.end(), 0.0);
+  for (std::size_t b = 0; b < w; ++b) {
+    for (std::size_t i = 0; i < n_; ++i) {
+      const double d = ring_[b * n_ + i] - shift_[i];
+      added_[b * n_ + i] = d;
+      removed_[i * w + b] = d;
+      sum_[i] += d;
+    }
+  }
+
+  const std::size_t tile = tile_columns(w);
+  for_row_shards(n_ * n_ / 2 * w, [&](std::size_t row_begin, std::size_t row_end) {
+    for (std::size_t i = row_begin; i < row_end; ++i) {
+      std::fill(cross_.begin() + static_cast<std::ptrdiff_t>(i * n_ + i),
+                cross_.begin() + static_cast<std::ptrdiff_t>((i + 1) * n_), 0.0);
+    }
+    for (std::size_t j0 = 0; j0 < n_; j0 += tile) {
+      const std::size_t j1 = std::min(n_, j0 + tile);
+      for (std::size_t i = row_begin; i < std::min(row_end, j1); ++i) {
+        const std::size_t first = std::max(i, j0);
+        kernels::cross_update(cross_.data() + i * n_ + first, j1 - first, added_.data() + first, nullptr,
+                              n_, removed_.data() + i * w, nullptr, w);
+      }
+    }
+  });
+}
+
+void RollingCovariance::update(std::size_t first_bar, std::size_t k, std::span<const double> bars) {
+  const std::size_t w = window_;
+
+  // centered bars in and out, time-major (k x n) for the rows and transposed for the coefficients
+  added_.resize(2 * k * n_);
+  removed_.resize(2 * k * n_);
+  double* in = added_.data();
+  double* in_t = added_.data() + k * n_;
+  double* out = removed_.data();
+  double* out_t = removed_.data() + k * n_;
+  for (std::size_t t = 0; t < k; ++t) {
+    const double* bar = bars.data() + (first_bar + t) * n_;
+    double* slot = ring_.data() + ((count_ + t) % w) * n_;
+    for (std::size_t i = 0; i < n_; ++i) {
+      const double a = bar[i] - shift_[i];
+      const double r = slot[i] - shift_[i];
+      in[t * n_ + i] = a;
+      in_t[i * k + t] = a;
+      out[t * n_ + i] = r;
+      out_t[i * k + t] = r;
+      sum_[i] += a - r;
+      slot[i] = bar[i];
+    }
+  }
+
+  const std::size_t tile = tile_columns(2 * k);
+  for_row_shards(n_ * n_ * k, [&](std::size_t row_begin, std::size_t row_end) {
+    for (std::size_t j0 = 0; j0 < n_; j0 += tile) {
+      const std::size_t j1 = std::min(n_, j0 + tile);
+      for (std::size_t i = row_begin; i < std::min(row_end, j1); ++i) {
+        const std::size_t first = std::max(i, j0);
+        kernels::cross_update(cross_.data() + i * n_ + first, j1 - first, in + first, out + first, n_,
+                              in_t + i * k, out_t + i * k, k);
+      }
+    }
+  });
+}
+
+void RollingCovariance::covariance(std::span<double> out) const {
+  if (out.size() != n_ * n_) {
+    throw std::invalid_argument("rolling_covariance: output must hold n_series * n_series values");
+  }
+  if (!ready()) {
+    std::fill(out.begin(), out.end(), nanv());
+    return;
+  }
+  const double wd = static_cast<double>(window_);
+  for (std::size_t i = 0; i < n_; ++i) {
+    for (std::size_t j = i; j < n_; ++j) {
+      const double c = (cross_[i * n_ + j] - sum_[i] * sum_[j] / wd) / wd;
+      out[i * n_ + j] = c;
+      out[j * n_ + i] = c;
+    }
+  }
+}
+
+void RollingCovariance::correlation(std::span<double> out) const {
+  covariance(out);
+  if (!ready()) return;
+
+  std::vector<double> inv_sd(n_);
+  for (std::size_t i = 0; i < n_; ++i) {
+    const double var = out[i * n_ + i];
+    inv_sd[i] = var > 0.0 ? 1.0 / std::sqrt(var) : nanv(); // NaN variance stays NaN
+  }
+  for (std::size_t i = 0; i < n_; ++i) {
+    for (std::size_t j = i + 1; j < n_; ++j) {
+      const double r = out[i * n_ + j] * inv_sd[i] * inv_sd[j];
+      out[i * n_ + j] = r;
+      out[j * n_ + i] = r;
+    }
+    out[i * n_ + i] = std::isnan(inv_sd[i]) ? nanv() : 1.0;
+  }
+}
+
+static void run_rolling_matrix(std::span<const double> bars, std::size_t n_series, const RollingCovOptions& opts,
+                               const MatrixVisitor& visit, bool correlation) {
+  if (n_series == 0 || bars.size() % n_series != 0) {
+    throw std::invalid_argument("rolling_covariance: bars must hold a whole number of n_series-value bars");
+  }
+  if (opts.stride == 0) {
+    throw std::invalid_argument("rolling_covariance: stride must be > 0");
+  }
+  RollingCovariance engine(n_series, opts.window, opts.threads);
+  const std::size_t total = bars.size() / n_series;
+  if (total < opts.window) return;
+
+  std::vector<double> matrix(n_series * n_series);
+  std::size_t pushed = 0;
+  for (std::size_t t = opts.window - 1; t < total; t += opts.stride) {
+    engine.push_bars(bars.subspan(pushed * n_series, (t + 1 - pushed) * n_series));
+    pushed = t + 1;
+    if (correlation) {
+      engine.correlation(matrix);
+    } else {
+      engine.covariance(matrix);
+    }
+    visit(t, matrix);
+  }
+}
+
+void rolling_covariance(std::span<const double> bars, std::size_t n_series, const RollingCovOptions& opts,
+                        const MatrixVisitor& visit) {
+  run_rolling_matrix(bars, n_series, opts, visit, false);
+}
+
+void rolling_correlation(std::span<const double> bars, std::size_t n_series, const RollingCovOptions& opts,
+                         const MatrixVisitor& visit) {
+  run_rolling_matrix(bars, n_series, opts, visit, true);
+}
+
+std::vector<double> time_major(const std::vector<std::span<const double>>& series) {
+  if (series.empty()) return {};
+  const std::size_t len = series.front().size();
+  for (const auto& s : series) {
+    if (s.size() != len) {
+      throw std::invalid_argument("time_major: series must have the same length");
+    }
+  }
+  const std::size_t n = series.size();
+  std::vector<double> out(len * n);
+  for (std::size_t k = 0; k < n; ++k) {
+    for (std::size_t t = 0; t < len; ++t) out[t * n + k] = series[k][t];
+  }
+  return out;
+}
+
+} // namespace qe
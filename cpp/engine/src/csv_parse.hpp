@@ -0,0 +1,99 @@
+#pragma once
+
+// OHLCV CSV line parsing shared by the readers in csv_reader.cpp and bar_stream.cpp.
+// Internal to qe_engine, not installed with the public headers.
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace qe::csv_detail {
+
+inline constexpr const char* kFieldNames[] = {"timestamp", "open", "high", "low", "close", "volume"};
+
+// std::stod-compatible leniency: skips leading blanks and a '+' sign, ignores trailing blanks
+inline bool parse_double(const char* first, const char* last, double& out) {
+  while (first < last && (*first == ' ' || *first == '\t')) ++first;
+  if (first < last && *first == '+') ++first;
+
+  const auto res = std::from_chars(first, last, out);
+  if (res.ec != std::errc{} || res.ptr == first) return false;
+
+  for (const char* p = res.ptr; p < last; ++p) {
+    if (*p != ' ' && *p != '\t') return false;
+  }
+  return true;
+}
+
+[[noreturn]] inline void throw_parse_error(const std::string& path, std::size_t line_no, std::size_t field) {
+  throw std::runtime_error(
+    "CSV parse error in " + path + " at line " + std::to_string(line_no) +
+    ": bad or missing " + kFieldNames[field] + " field"
+  );
+}
+
+// where a data line failed to parse; line == 0 means no failure
+struct ParseFailure {
+  std::size_t line = 0;
+  std::size_t field = 0;
+};
+
+// field mask with every column selected; bit i is kFieldNames[i] (same bits as qe::Columns)
+inline constexpr unsigned kAllFields = (1u << 6) - 1;
+
+// splits one data line (no newline) into the timestamp text and the five numeric fields.
+// only the fields in mask are converted: the others are skipped unchecked (vals[f] is left
+// untouched), and nothing after the last selected field is looked at.
+// returns the index of the first bad/missing field, or -1.
+inline int parse_fields(const char* b, const char* e, std::string_view& ts, double (&vals)[5],
+                        unsigned mask = kAllFields) {
+  const char* comma = static_cast<const char*>(std::memchr(b, ',', static_cast<std::size_t>(e - b)));
+  if (!comma) return 1;
+  ts = std::string_view(b, static_cast<std::size_t>(comma - b));
+
+  const char* p = comma + 1;
+  for (int f = 0; f < 5 && (mask >> (f + 1)) != 0; ++f) {
+    // trailing columns after volume are ignored, as before
+    const char* stop = static_cast<const char*>(std::memchr(p, ',', static_cast<std::size_t>(e - p)));
+    if (!stop) {
+      if (f < 4 && (mask >> (f + 2)) != 0) return f + 2;
+      stop = e;
+    }
+    if ((mask >> (f + 1)) & 1u) {
+      if (!parse_double(p, stop, vals[f])) return f + 1;
+    }
+    p = stop + 1;
+  }
+  return -1;
+}
+
+// parses every non-blank line in [p, end) into sink, numbering lines from first_line.
+// sink(ts, vals) returns false if it rejects the timestamp.
+template <class Sink>
+ParseFailure parse_range(const char* p, const char* end, std::size_t first_line, Sink& sink,
+                         unsigned mask = kAllFields) {
+  std::size_t line_no = first_line - 1;
+  std::string_view ts;
+  double vals[5];
+
+  while (p < end) {
+    ++line_no;
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+    const char* line_end = nl ? nl : end;
+    const char* next = nl ? nl + 1 : end;
+
+    if (line_end > p && line_end[-1] == '\r') --line_end;
+    if (line_end > p) {
+      const int bad = parse_fields(p, line_end, ts, vals, mask);
+      if (bad >= 0) return {line_no, static_cast<std::size_t>(bad)};
+      if (!sink(ts, vals)) return {line_no, 0};
+    }
+    p = next;
+  }
+  return {};
+}
+
+} // namespace qe::csv_detail
@@ -1,61 +1,188 @@
 #include "qe/csv_reader.hpp"
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
 #include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "qe/mapped_file.hpp"
+#include "qe/timestamp.hpp"
+
+#include "csv_parse.hpp"
+#include "run_workers.hpp"
 
 namespace qe {
 
-OhlcvTable read_ohlcv_csv(const std::string& path) {
-  std::ifstream file(path);
-  if (!file.is_open()) {
-    throw std::runtime_error("Failed to open CSV file: " + path);
-  }
+namespace {
 
-  OhlcvTable table;
-  std::string line;
+using namespace csv_detail;
+using detail::run_workers;
 
-  // Read header line
-  if (!std::getline(file, line)) {
-    throw std::runtime_error("CSV file is empty: " + path);
-  }
+struct RowSink {
+  OhlcvTable out;
+  unsigned mask = kAllFields;
 
-  // Read data lines
-  while (std::getline(file, line)) {
-    if (line.empty()) continue;
+  void reserve(std::size_t n) { out.reserve(n); }
+  bool operator()(std::string_view ts, const double (&v)[5]) {
+    constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+    auto field = [&](int f) { return (mask >> (f + 1)) & 1u ? v[f] : nan; };
+    out.push_back(OhlcvRow{(mask & 1u) ? std::string(ts) : std::string(),
+                           field(0), field(1), field(2), field(3), field(4)});
+    return true;
+  }
 
-    std::stringstream ss(line);
-    std::string cell;
+  static void splice(OhlcvTable& dst, std::vector<RowSink>& parts) {
+    std::size_t total = 0;
+    for (const auto& part : parts) total += part.out.size();
+    dst.reserve(total);
+    for (auto& part : parts) {
+      std::move(part.out.begin(), part.out.end(), std::back_inserter(dst));
+      part.out = {};
+    }
+  }
+};
 
-    OhlcvRow row;
+struct ColumnSink {
+  OhlcvColumns out;
+  unsigned mask = kAllFields;
 
-    // timestamp
-    std::getline(ss, row.timestamp, ',');
+  std::vector<double>* field(int f) {
+    std::vector<double>* cols[] = {&out.open, &out.high, &out.low, &out.close, &out.volume};
+    return cols[f];
+  }
 
-    // open
-    std::getline(ss, cell, ',');
-    row.open = std::stod(cell);
+  void reserve(std::size_t n) {
+    if (mask & 1u) out.ts.reserve(n);
+    for (int f = 0; f < 5; ++f) {
+      if ((mask >> (f + 1)) & 1u) field(f)->reserve(n);
+    }
+  }
 
-    // high
-    std::getline(ss, cell, ',');
-    row.high = std::stod(cell);
+  bool operator()(std::string_view ts, const double (&v)[5]) {
+    if (mask == kAllFields) {
+      std::int64_t t = 0;
+      if (!try_parse_timestamp_ns(ts, t)) return false;
+      out.push_back(t, v[0], v[1], v[2], v[3], v[4]);
+      return true;
+    }
+
+    if (mask & 1u) {
+      std::int64_t t = 0;
+      if (!try_parse_timestamp_ns(ts, t)) return false;
+      out.ts.push_back(t);
+    }
+    for (int f = 0; f < 5; ++f) {
+      if ((mask >> (f + 1)) & 1u) field(f)->push_back(v[f]);
+    }
+    return true;
+  }
 
-    // low
-    std::getline(ss, cell, ',');
-    row.low = std::stod(cell);
+  static void splice(OhlcvColumns& dst, std::vector<ColumnSink>& parts) {
+    std::size_t total = 0;
+    for (const auto& part : parts) total += part.out.size();
+    dst.reserve(total);
+    for (auto& part : parts) {
+      const OhlcvColumns& src = part.out;
+      dst.ts.insert(dst.ts.end(), src.ts.begin(), src.ts.end());
+      dst.open.insert(dst.open.end(), src.open.begin(), src.open.end());
+      dst.high.insert(dst.high.end(), src.high.begin(), src.high.end());
+      dst.low.insert(dst.low.end(), src.low.begin(), src.low.end());
+      dst.close.insert(dst.close.end(), src.close.begin(), src.close.end());
+      dst.volume.insert(dst.volume.end(), src.volume.begin(), src.volume.end());
+      part.out = {};
+    }
+  }
+};
+
+// maps the file, skips the header and parses the body, split into newline-aligned
+// chunks when opts.threads > 1; chunks are stitched back in file order.
+template <class Sink, class Out>
+void read_csv(const std::string& path, const CsvReadOptions& opts, Out& out) {
+  MappedFile file;
+  if (!file.open(path)) {
+    throw std::runtime_error("Failed to open CSV file: " + path);
+  }
+  if (file.size() == 0) {
+    throw std::runtime_error("CSV file is empty: " + path);
+  }
 
-    // close
-    std::getline(ss, cell, ',');
-    row.close = std::stod(cell);
+  const char* const begin = file.data();
+  const char* const end = begin + file.size();
+
+  // skip header line
+  const char* nl = static_cast<const char*>(std::memchr(begin, '\n', file.size()));
+  const char* const body = nl ? nl + 1 : end;
+  const auto body_bytes = static_cast<std::size_t>(end - body);
+
+  std::size_t threads = opts.threads == 0 ? std::thread::hardware_concurrency() : opts.threads;
+  const std::size_t min_chunk = std::max<std::size_t>(opts.min_chunk_bytes, 1);
+  threads = std::clamp<std::size_t>(std::min(threads, body_bytes / min_chunk), 1, kMaxCsvThreads);
+
+  // chunk k covers [cuts[k], cuts[k+1]); every interior cut sits just after a '\n'
+  std::vector<const char*> cuts(threads + 1, end);
+  cuts[0] = body;
+  for (std::size_t k = 1; k < threads; ++k) {
+    const char* target = std::max(body + body_bytes / threads * k, cuts[k - 1]);
+    const char* cut = static_cast<const char*>(
+      std::memchr(target, '\n', static_cast<std::size_t>(end - target)));
+    cuts[k] = cut ? cut + 1 : end;
+  }
 
-    // volume
-    std::getline(ss, cell, ',');
-    row.volume = std::stod(cell);
+  std::vector<Sink> parts(threads);
+  const auto mask = static_cast<unsigned>(opts.columns);
+  for (auto& part : parts) part.mask = mask;
+  std::vector<std::size_t> newlines(threads, 0);
+  std::vector<ParseFailure> failures(threads);
+
+  run_workers(threads, [&](std::size_t k) {
+    // upper bound on rows, avoids regrowing the output on large files
+    newlines[k] = static_cast<std::size_t>(std::count(cuts[k], cuts[k + 1], '\n'));
+    parts[k].reserve(newlines[k] + 1);
+    failures[k] = parse_range(cuts[k], cuts[k + 1], 1, parts[k], mask);
+  });
+
+  // report the first failure in file order with its absolute line number
+  std::size_t line_base = 1; // header
+  for (std::size_t k = 0; k < threads; ++k) {
+    if (failures[k].line != 0) {
+      throw_parse_error(path, line_base + failures[k].line, failures[k].field);
+    }
+    line_base += newlines[k];
+  }
 
-    table.push_back(row);
+  if (threads == 1) {
+    out = std::move(parts[0].out);
+  } else {
+    Sink::splice(out, parts);
   }
+}
+
+} // namespace
 
+OhlcvTable read_ohlcv_csv(const std::string& path, CsvReadOptions opts) {
+  OhlcvTable table;
+  read_csv<RowSink>(path, opts, table);
   return table;
 }
 
-} 
+OhlcvColumns read_ohlcv_columns(const std::string& path, CsvReadOptions opts) {
+  OhlcvColumns cols;
+  read_csv<ColumnSink>(path, opts, cols);
+  return cols;
+}
+
+OhlcvTable read_ohlcv_csv(const std::string& path, Columns columns, CsvReadOptions opts) {
+  opts.columns = columns;
+  return read_ohlcv_csv(path, opts);
+}
+
+OhlcvColumns read_ohlcv_columns(const std::string& path, Columns columns, CsvReadOptions opts) {
+  opts.columns = columns;
+  return read_ohlcv_columns(path, opts);
+}
+
+}
@@ -0,0 +1,52 @@
+#include "qe/data.hpp"
+
+#include "qe/timestamp.hpp"
+
+namespace qe {
+
+void OhlcvColumns::reserve(std::size_t n) {
+  ts.reserve(n);
+  open.reserve(n);
+  high.reserve(n);
+  low.reserve(n);
+  close.reserve(n);
+  volume.reserve(n);
+}
+
+void OhlcvColumns::resize(std::size_t n) {
+  ts.resize(n);
+  open.resize(n);
+  high.resize(n);
+  low.resize(n);
+  close.resize(n);
+  volume.resize(n);
+}
+
+void OhlcvColumns::clear() {
+  ts.clear();
+  open.clear();
+  high.clear();
+  low.clear();
+  close.clear();
+  volume.clear();
+}
+
+void OhlcvColumns::push_back(std::int64_t t, double o, double h, double l, double c, double v) {
+  ts.push_back(t);
+  open.push_back(o);
+  high.push_back(h);
+  low.push_back(l);
+  close.push_back(c);
+  volume.push_back(v);
+}
+
+OhlcvColumns to_columns(const OhlcvTable& rows) {
+  OhlcvColumns out;
+  out.reserve(rows.size());
+  for (const auto& row : rows) {
+    out.push_back(parse_timestamp_ns(row.timestamp), row.open, row.high, row.low, row.close, row.volume);
+  }
+  return out;
+}
+
+} // namespace qe
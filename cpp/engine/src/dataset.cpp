@@ -0,0 +1,72 @@
+#include "qe/dataset.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "qe/csv_reader.hpp"
+#include "qe/qec.hpp"
+
+namespace qe {
+
+Dataset::Dataset(OhlcvColumns columns)
+  : owned_(std::move(columns)) {
+  view_ = owned_.view();
+}
+
+Dataset Dataset::from_qec(MappedFile file, bool verify_checksum, Columns columns) {
+  if (qec_is_compressed(parse_qec_header(file.view(), file.size()))) {
+    // encoded columns are decoded once; the mapping is not needed afterwards
+    return Dataset(qec_compressed_view(file.view(), verify_checksum).decode(columns));
+  }
+
+  Dataset ds;
+  ds.view_ = qec_view(file.view(), verify_checksum);
+  ds.mapped_ = std::move(file);
+  return ds;
+}
+
+void Dataset::keep_rows(std::size_t first, std::size_t count) {
+  view_ = view_.subview(first, count);
+}
+
+Dataset load_dataset(const std::string& path, DatasetOptions opts) {
+  MappedFile file;
+  if (!file.open(path)) {
+    throw std::runtime_error("Failed to open data file: " + path);
+  }
+
+  if (is_qec(file.view())) {
+    return Dataset::from_qec(std::move(file), opts.verify_checksum, opts.columns);
+  }
+
+  file.close();
+  return Dataset(read_ohlcv_columns(path, {.threads = opts.threads, .columns = opts.columns}));
+}
+
+Dataset load_dataset_range(const std::string& path, const TimeRange& range, DatasetOptions opts) {
+  MappedFile file;
+  if (!file.open(path)) {
+    throw std::runtime_error("Failed to open data file: " + path);
+  }
+
+  if (!is_qec(file.view())) {
+    file.close();
+    return Dataset(read_ohlcv_columns(path, load_ts_index(path), range));
+  }
+
+  Dataset ds = Dataset::from_qec(std::move(file), opts.verify_checksum);
+  const auto ts = ds.view().ts;
+  const auto start = static_cast<std::size_t>(std::lower_bound(ts.begin(), ts.end(), range.start_ns) - ts.begin());
+  const auto stop = static_cast<std::size_t>(std::lower_bound(ts.begin(), ts.end(), range.end_ns) - ts.begin());
+  if (range.start_ns >= range.end_ns || start >= stop) {
+    ds.keep_rows(0, 0);
+    return ds;
+  }
+
+  const std::size_t first = start - std::min(range.warmup_bars, start);
+  ds.keep_rows(first, stop - first);
+  return ds;
+}
+
+} // namespace qe
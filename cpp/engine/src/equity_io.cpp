@@ -7,17 +7,24 @@
 
 namespace qe {
 
-void write_equity_csv(const std::string& path,
-                      const std::vector<double>& equity) {
-  std::ofstream out(path, std::ios::binary);
-  if (!out) {
+EquityCsvWriter::EquityCsvWriter(const std::string& path)
+  : out_(path, std::ios::binary) {
+  if (!out_) {
     throw std::runtime_error("failed to open equity path for write: " + path);
   }
+  out_ << "i,equity\n";
+}
 
-  out << "i,equity\n";
-  for (std::size_t i = 0; i < equity.size(); ++i) {
-    out << i << "," << equity[i] << "\n";
+void EquityCsvWriter::write(std::span<const double> equity) {
+  for (double v : equity) {
+    out_ << next_++ << "," << v << "\n";
   }
 }
 
+void write_equity_csv(const std::string& path,
+                      const std::vector<double>& equity) {
+  EquityCsvWriter out(path);
+  out.write(equity);
+}
+
 } 
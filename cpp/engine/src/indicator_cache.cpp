@@ -0,0 +1,174 @@
+#include "qe/indicator_cache.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "qe/indicators.hpp"
+
+namespace qe {
+
+static std::uint64_t mix64(std::uint64_t x) {
+  // splitmix64 finalizer
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+std::uint64_t content_hash(std::span<const double> values) {
+  // four independent lanes so the multiply chains overlap; folded with the length at the end
+  constexpr std::uint64_t k = 0x9e3779b97f4a7c15ULL;
+  std::uint64_t h[4] = {k, k ^ 1, k ^ 2, k ^ 3};
+  const std::size_t n = values.size();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    for (std::size_t j = 0; j < 4; ++j) {
+      std::uint64_t bits = 0;
+      std::memcpy(&bits, &values[i + j], sizeof bits);
+      h[j] = (h[j] ^ bits) * k;
+      h[j] ^= h[j] >> 29;
+    }
+  }
+  for (; i < n; ++i) {
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &values[i], sizeof bits);
+    h[i % 4] = (h[i % 4] ^ bits) * k;
+    h[i % 4] ^= h[i % 4] >> 29;
+  }
+  return mix64(mix64(h[0] ^ mix64(h[1] ^ mix64(h[2] ^ mix64(h[3])))) ^ n);
+}
+
+SeriesSource make_series_source(std::span<const double> values, std::string column) {
+  return {values, std::move(column), content_hash(values)};
+}
+
+const char* indicator_kind_name(IndicatorKind kind) {
+  switch (kind) {
+    case IndicatorKind::Returns: return "returns";
+    case IndicatorKind::RollingMean: return "rolling_mean";
+    case IndicatorKind::RollingStd: return "rolling_std";
+    case IndicatorKind::RollingMin: return "rolling_min";
+    case IndicatorKind::RollingMax: return "rolling_max";
+  }
+  return "unknown";
+}
+
+std::size_t IndicatorCache::KeyHash::operator()(const IndicatorKey& k) const {
+  std::uint64_t h = mix64(k.content_hash ^ k.length);
+  h = mix64(h ^ std::hash<std::string>{}(k.column));
+  h = mix64(h ^ static_cast<std::uint64_t>(k.kind));
+  h = mix64(h ^ k.window);
+  h = mix64(h ^ k.first);
+  return static_cast<std::size_t>(h);
+}
+
+IndicatorCache::IndicatorCache(std::size_t max_bytes) : max_bytes_(max_bytes) {
+  stats_.max_bytes = max_bytes;
+}
+
+IndicatorCache::Series IndicatorCache::get_or_compute(const IndicatorKey& key,
+                                                      const std::function<std::vector<double>()>& compute) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      ++stats_.hits;
+      lru_.splice(lru_.begin(), lru_, it->second.lru);
+      return it->second.series;
+    }
+    ++stats_.misses;
+  }
+
+  auto series = std::make_shared<const std::vector<double>>(compute());
+  const std::size_t bytes = series->capacity() * sizeof(double);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    return it->second.series; // another thread stored it meanwhile
+  }
+  if (bytes > max_bytes_) {
+    return series;
+  }
+  evict_to(max_bytes_ - bytes);
+  lru_.push_front(key);
+  entries_.emplace(key, Entry{series, bytes, lru_.begin()});
+  stats_.bytes += bytes;
+  stats_.entries = entries_.size();
+  return series;
+}
+
+void IndicatorCache::evict_to(std::size_t limit) {
+  while (stats_.bytes > limit && !lru_.empty()) {
+    auto it = entries_.find(lru_.back());
+    stats_.bytes -= it->second.bytes;
+    entries_.erase(it);
+    lru_.pop_back();
+    ++stats_.evictions;
+  }
+  stats_.entries = entries_.size();
+}
+
+static std::span<const double> tail(const SeriesSource& source, std::size_t first) {
+  if (first > source.values.size()) {
+    throw std::invalid_argument("indicator cache: first is past the end of the series");
+  }
+  return source.values.subspan(first);
+}
+
+static IndicatorKey key_for(const SeriesSource& source, IndicatorKind kind, std::size_t window,
+                            std::size_t first) {
+  return {source.content_hash, source.values.size(), source.column, kind, window, first};
+}
+
+IndicatorCache::Series IndicatorCache::returns(const SeriesSource& source, std::size_t first) {
+  const std::span<const double> v = tail(source, first);
+  return get_or_compute(key_for(source, IndicatorKind::Returns, 0, first),
+                        [&] { return compute_returns(v); });
+}
+
+IndicatorCache::Series IndicatorCache::rolling_mean(const SeriesSource& source, std::size_t window,
+                                                    std::size_t first) {
+  const std::span<const double> v = tail(source, first);
+  return get_or_compute(key_for(source, IndicatorKind::RollingMean, window, first),
+                        [&] { return qe::rolling_mean(v, window); });
+}
+
+IndicatorCache::Series IndicatorCache::rolling_std(const SeriesSource& source, std::size_t window,
+                                                   std::size_t first) {
+  const std::span<const double> v = tail(source, first);
+  return get_or_compute(key_for(source, IndicatorKind::RollingStd, window, first),
+                        [&] { return qe::rolling_std(v, window); });
+}
+
+IndicatorCache::Series IndicatorCache::rolling_min(const SeriesSource& source, std::size_t window,
+                                                   std::size_t first) {
+  const std::span<const double> v = tail(source, first);
+  return get_or_compute(key_for(source, IndicatorKind::RollingMin, window, first),
+                        [&] { return qe::rolling_min(v, window); });
+}
+
+IndicatorCache::Series IndicatorCache::rolling_max(const SeriesSource& source, std::size_t window,
+                                                   std::size_t first) {
+  const std::span<const double> v = tail(source, first);
+  return get_or_compute(key_for(source, IndicatorKind::RollingMax, window, first),
+                        [&] { return qe::rolling_max(v, window); });
+}
+
+IndicatorCacheStats IndicatorCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void IndicatorCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  lru_.clear();
+  entries_.clear();
+  stats_.bytes = 0;
+  stats_.entries = 0;
+}
+
+} // namespace qe
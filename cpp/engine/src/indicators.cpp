@@ -1,8 +1,16 @@
 #include "qe/indicators.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "qe/fixed_window.hpp"
+
+#include "kernels.hpp"
+#include "rolling_moments.hpp"
 
 namespace qe {
 
@@ -11,80 +19,471 @@ static double nanv() {
 } // need this for a "quiet" nan, avoids polluting the public API and marks undefineds or invalids
 
 std::vector<double> compute_returns(const OhlcvTable& data) {
-  if (data.size() < 2) {
+  std::vector<double> close;
+  close.reserve(data.size());
+  for (const auto& row : data) close.push_back(row.close);
+  return compute_returns(close);
+}
+
+std::vector<double> compute_returns(std::span<const double> close) {
+  if (close.size() < 2) {
     return {};
   }
 
-  std::vector<double> out;
-  out.reserve(data.size() - 1);
-
-  for (std::size_t i = 1; i < data.size(); ++i) {
-    const double prev = data[i - 1].close;
-    const double curr = data[i].close;
+  std::vector<double> out(close.size() - 1);
+  compute_returns(close, out);
+  return out;
+} // simple returns from a time-ordered OHLCV table, return_i = (close_i - close{i-1} / close_{i-1}), returns empty vector if fewer than 2 data pts provided
 
-    if (prev == 0.0) {
-      out.push_back(nanv());
-    } else {
-      out.push_back((curr - prev) / prev);
-    }
+void compute_returns(std::span<const double> close, std::span<double> out) {
+  const std::size_t n = close.size() < 2 ? 0 : close.size() - 1;
+  if (out.size() != n) {
+    throw std::invalid_argument("compute_returns: output must have close.size() - 1 values");
   }
+  if (n > 0) kernels::returns(close.data(), close.size(), out.data());
+}
 
+std::vector<double> rolling_mean(std::span<const double> values, std::size_t window) {
+  std::vector<double> out(values.size());
+  rolling_mean(values, window, out);
   return out;
-} // simple returns from a time-ordered OHLCV table, return_i = (close_i - close{i-1} / close_{i-1}), returns empty vector if fewer than 2 data pts provided
+}
 
-std::vector<double> rolling_mean(const std::vector<double>& values, std::size_t window) {
+void rolling_mean(std::span<const double> values, std::size_t window, std::span<double> out) {
   if (window == 0) {
     throw std::invalid_argument("rolling_mean: window must be > 0");
   } // vals before window is "full" are set as Nan, output vector is the same size as the input.
+  if (out.size() != values.size()) {
+    throw std::invalid_argument("rolling_mean: output must have the same length as values");
+  }
 
-  std::vector<double> out(values.size(), nanv());
   if (values.size() < window) {
-    return out;
+    std::fill(out.begin(), out.end(), nanv());
+    return;
   }
 
-  double sum = 0.0;
-  for (std::size_t i = 0; i < values.size(); ++i) {
-    sum += values[i];
-    if (i >= window) {
-      sum -= values[i - window];
-    }
-    if (i + 1 >= window) {
-      out[i] = sum / static_cast<double>(window);
-    }
+  std::fill(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(window - 1), nanv());
+  kernels::rolling_mean(values.data(), values.size(), window, out.data());
+} // sliding-window accumulation: the running sum of (curr - value leaving the window), O(n) time.
+  // taken as a blocked prefix scan (see kernels.hpp) so it vectorizes; RollingMean replays the same order one value at a time.
+
+void detail::fixed_rolling_mean(std::size_t slot, std::span<const double> values, std::span<double> out) {
+  const std::size_t window = kFixedWindows[slot];
+  if (out.size() != values.size()) {
+    throw std::invalid_argument("rolling_mean: output must have the same length as values");
+  }
+  if (values.size() < window) {
+    std::fill(out.begin(), out.end(), nanv());
+    return;
   }
+  std::fill(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(window - 1), nanv());
+  kernels::rolling_mean_fixed(slot, values.data(), values.size(), out.data());
+}
 
+template <std::size_t... K>
+static FixedRollingMean fixed_rolling_mean_at(std::size_t slot, std::index_sequence<K...>) {
+  static constexpr FixedRollingMean fns[] = {&rolling_mean<kFixedWindows[K]>...};
+  return fns[slot];
+}
+
+FixedRollingMean find_fixed_rolling_mean(std::size_t window) {
+  const std::size_t slot = detail::fixed_window_slot(window);
+  if (slot == detail::kNoSlot) return nullptr;
+  return fixed_rolling_mean_at(slot, std::make_index_sequence<std::size(kFixedWindows)>{});
+}
+
+RollingMeans rolling_means(std::span<const double> values, const std::vector<std::size_t>& windows,
+                           MatrixLayout layout) {
+  RollingMeans out;
+  rolling_means(values, windows, layout, out);
   return out;
-} // very important to have sliding-window accumulation : add curr, sub the val that falls out the window. this does yield a O(n) time w/ extra space.
+}
 
-std::vector<double> rolling_std(const std::vector<double>& values, std::size_t window) {
-  if (window == 0) {
-    throw std::invalid_argument("rolling_std: window must be > 0");
+void rolling_means(std::span<const double> values, const std::vector<std::size_t>& windows,
+                   MatrixLayout layout, RollingMeans& out) {
+  for (std::size_t w : windows) {
+    if (w == 0) {
+      throw std::invalid_argument("rolling_means: windows must be > 0");
+    }
   }
 
-  std::vector<double> out(values.size(), nanv());
-  if (values.size() < window) {
-    return out;
-  } // this implementation favors clarity and numerical correctness, it does overperform w/ O(n * window), likely needs optimization
-  for (std::size_t i = window - 1; i < values.size(); ++i) {
-    double mean = 0.0;
-    for (std::size_t j = i + 1 - window; j <= i; ++j) {
-      mean += values[j];
+  const std::size_t n = values.size();
+  const std::size_t k_count = windows.size();
+  out.windows = windows;
+  out.length = n;
+  out.layout = layout;
+  out.data.resize(n * k_count); // every element is written below
+  if (n == 0 || k_count == 0) {
+    return;
+  }
+
+  // prefix[i] = sum(values[0 .. i)) as hi + lo, accumulated with an exact TwoSum so the
+  // window differences don't inherit the rounding of a long running sum. It is built one
+  // block at a time into a buffer that also keeps the previous max_w entries (the furthest
+  // any window reaches back), so the whole matrix comes from one cache-resident pass.
+  std::size_t max_w = 0;
+  for (std::size_t w : windows) max_w = std::max(max_w, std::min(w, n));
+  const std::size_t block = std::max<std::size_t>(4096, max_w);
+  std::vector<double> hi(max_w + block + 1);
+  std::vector<double> lo(max_w + block + 1);
+
+  double s = 0.0;
+  double c = 0.0;
+  std::size_t base = 0; // prefix index held in hi[0] / lo[0]
+  std::size_t filled = 1;
+  hi[0] = 0.0;
+  lo[0] = 0.0;
+
+  for (std::size_t start = 0; start < n; start += block) {
+    const std::size_t end = std::min(n, start + block);
+    for (std::size_t i = start; i < end; ++i) {
+      const double x = values[i];
+      const double t = s + x;
+      const double xp = t - s;
+      c += (s - (t - xp)) + (x - xp);
+      s = t;
+      hi[i + 1 - base] = s;
+      lo[i + 1 - base] = c;
     }
-    mean /= static_cast<double>(window);
+    filled = end + 1 - base;
 
-    double var = 0.0;
-    for (std::size_t j = i + 1 - window; j <= i; ++j) {
-      const double d = values[j] - mean;
-      var += d * d;
+    for (std::size_t k = 0; k < k_count; ++k) {
+      const std::size_t w = windows[k];
+      const double wd = static_cast<double>(w);
+      const double* h = hi.data() - base; // indexable by absolute prefix position
+      const double* l = lo.data() - base;
+      for (std::size_t i = start; i < end; ++i) {
+        const double m = i + 1 < w ? nanv() : ((h[i + 1] - h[i + 1 - w]) + (l[i + 1] - l[i + 1 - w])) / wd;
+        if (layout == MatrixLayout::WindowMajor) {
+          out.data[k * n + i] = m;
+        } else {
+          out.data[i * k_count + k] = m;
+        }
+      }
     }
-    var /= static_cast<double>(window);
 
-    out[i] = std::sqrt(var);
+    // keep the last max_w prefix entries for the next block's windows
+    const std::size_t keep = std::min(filled, max_w);
+    std::copy(hi.begin() + static_cast<std::ptrdiff_t>(filled - keep), hi.begin() + static_cast<std::ptrdiff_t>(filled), hi.begin());
+    std::copy(lo.begin() + static_cast<std::ptrdiff_t>(filled - keep), lo.begin() + static_cast<std::ptrdiff_t>(filled), lo.begin());
+    base += filled - keep;
   }
+} // one O(n) prefix pass plus O(n) per window, instead of a full rolling_mean per window
+
+std::vector<double> rolling_std(std::span<const double> values, std::size_t window) {
+  std::vector<double> out(values.size());
+  rolling_std(values, window, out);
+  return out;
+}
+
+void rolling_std(std::span<const double> values, std::size_t window, std::span<double> out,
+                 std::pmr::memory_resource* scratch) {
+  RollingStd state(window, scratch);
+  if (out.size() != values.size()) {
+    throw std::invalid_argument("rolling_std: output must have the same length as values");
+  }
+  for (std::size_t i = 0; i < values.size(); ++i) out[i] = state.push(values[i]);
+} // O(n): sliding Welford update with exact two-pass refreshes (see rolling_moments.hpp)
+
+std::vector<double> ema(std::span<const double> values, std::size_t period) {
+  Ema state(period);
+  std::vector<double> out(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i) out[i] = state.push(values[i]);
+  return out;
+}
+
+std::vector<double> rsi(std::span<const double> values, std::size_t period) {
+  Rsi state(period);
+  std::vector<double> out(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i) out[i] = state.push(values[i]);
+  return out;
+}
+
+std::vector<double> atr(std::span<const double> high, std::span<const double> low,
+                        std::span<const double> close, std::size_t period) {
+  if (high.size() != close.size() || low.size() != close.size()) {
+    throw std::invalid_argument("atr: high, low and close must have the same length");
+  }
+  Atr state(period);
+  std::vector<double> out(close.size());
+  for (std::size_t i = 0; i < close.size(); ++i) out[i] = state.push(high[i], low[i], close[i]);
+  return out;
+}
+
+BollingerSeries bollinger(std::span<const double> values, std::size_t window, double k) {
+  Bollinger state(window, k);
+  BollingerSeries out;
+  out.middle.resize(values.size());
+  out.upper.resize(values.size());
+  out.lower.resize(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    const BollingerBand b = state.push(values[i]);
+    out.middle[i] = b.middle;
+    out.upper[i] = b.upper;
+    out.lower[i] = b.lower;
+  }
+  return out;
+}
+
+std::vector<double> rolling_min(std::span<const double> values, std::size_t window) {
+  RollingMin state(window);
+  std::vector<double> out(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i) out[i] = state.push(values[i]);
+  return out;
+}
+
+std::vector<double> rolling_max(std::span<const double> values, std::size_t window) {
+  RollingMax state(window);
+  std::vector<double> out(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i) out[i] = state.push(values[i]);
+  return out;
+}
+
+DonchianSeries donchian(std::span<const double> high, std::span<const double> low, std::size_t window) {
+  if (high.size() != low.size()) {
+    throw std::invalid_argument("donchian: high and low must have the same length");
+  }
+  Donchian state(window);
+  DonchianSeries out;
+  out.upper.resize(high.size());
+  out.middle.resize(high.size());
+  out.lower.resize(high.size());
+  for (std::size_t i = 0; i < high.size(); ++i) {
+    const DonchianBand b = state.push(high[i], low[i]);
+    out.upper[i] = b.upper;
+    out.middle[i] = b.middle;
+    out.lower[i] = b.lower;
+  }
+  return out;
+}
 
+std::vector<double> rolling_max_drawdown(std::span<const double> equity, std::size_t window) {
+  RollingMaxDrawdown state(window);
+  std::vector<double> out(equity.size());
+  for (std::size_t i = 0; i < equity.size(); ++i) out[i] = state.push(equity[i]);
   return out;
-}  // compute mean and variance per window (O(n*window)).
-  // FLAG ::: likely need to optimize this, will assess later
-  // use Welford's algo / rolling variance (?)
+}
+
+// ---- push-one-bar state ----
+
+static std::size_t checked_window(const char* name, std::size_t window) {
+  if (window == 0) {
+    throw std::invalid_argument(std::string(name) + ": window must be > 0");
+  }
+  return window;
+}
+
+static std::size_t checked_period(const char* name, std::size_t period) {
+  if (period == 0) {
+    throw std::invalid_argument(std::string(name) + ": period must be > 0");
+  }
+  return period;
+}
+
+RollingMean::RollingMean(std::size_t window, std::pmr::memory_resource* resource)
+  : ring_(checked_window("rolling_mean", window), 0.0, resource), value_(nanv()) {}
+
+double RollingMean::push(double v) {
+  // same summation order as rolling_mean (kernels::rolling_sum_step) so results are bit-identical
+  const double d = count_ >= ring_.size() ? v - ring_[head_] : v - 0.0;
+  const double sum = kernels::rolling_sum_step(carry_, block_, count_ % 4, d);
+  ring_[head_] = v;
+  head_ = (head_ + 1 == ring_.size()) ? 0 : head_ + 1;
+  ++count_;
+
+  if (count_ >= ring_.size()) value_ = sum / static_cast<double>(ring_.size());
+  return value_;
+}
+
+RollingStd::RollingStd(std::size_t window, std::pmr::memory_resource* resource)
+  : ring_(checked_window("rolling_std", window), 0.0, resource), value_(nanv()) {}
+
+double RollingStd::push(double v) {
+  const std::size_t w = ring_.size();
+  const double leaving = ring_[head_];
+  ring_[head_] = v;
+  head_ = (head_ + 1 == w) ? 0 : head_ + 1;
+  ++count_;
+  if (!std::isfinite(v)) ++nonfinite_;
+  const bool cleared = !std::isfinite(leaving) && --nonfinite_ == 0;
+  if (count_ < w) return value_;
+
+  // a window holding NaN/inf has no std dev; the moments are rebuilt once the last one leaves
+  if (nonfinite_ > 0) {
+    value_ = nanv();
+    return value_;
+  }
+
+  // the window starts at head_ now; refresh once per turnover, when the last non-finite
+  // value has just left, or when the slide cancels
+  if ((count_ - w) % w == 0 || cleared ||
+      !detail::slide_moments(v, leaving, w, mean_, m2_, m2_peak_)) {
+    detail::refresh_moments([&](std::size_t k) { return ring_[head_ + k < w ? head_ + k : head_ + k - w]; },
+                            w, mean_, m2_, m2_peak_);
+  }
+  value_ = detail::moments_stddev(m2_, w);
+  return value_;
+}
+
+Ema::Ema(std::size_t period)
+  : period_(checked_period("ema", period)),
+    alpha_(2.0 / (static_cast<double>(period) + 1.0)),
+    value_(nanv()) {}
+
+double Ema::push(double v) {
+  if (count_ < period_) {
+    seed_sum_ += v;
+    if (++count_ == period_) value_ = seed_sum_ / static_cast<double>(period_);
+    return value_;
+  }
+  value_ += alpha_ * (v - value_);
+  return value_;
+}
+
+Rsi::Rsi(std::size_t period)
+  : period_(checked_period("rsi", period)), value_(nanv()) {}
+
+double Rsi::push(double v) {
+  const double change = v - prev_;
+  prev_ = v;
+  if (++count_ == 1) return value_;
+
+  // std::max keeps a NaN change (first argument) so it propagates
+  const double gain = std::max(change, 0.0);
+  const double loss = std::max(-change, 0.0);
+  const std::size_t changes = count_ - 1;
+  const double p = static_cast<double>(period_);
+  if (changes < period_) {
+    avg_gain_ += gain;
+    avg_loss_ += loss;
+    return value_;
+  }
+  if (changes == period_) {
+    avg_gain_ = (avg_gain_ + gain) / p;
+    avg_loss_ = (avg_loss_ + loss) / p;
+  } else {
+    avg_gain_ = (avg_gain_ * (p - 1.0) + gain) / p;
+    avg_loss_ = (avg_loss_ * (p - 1.0) + loss) / p;
+  }
+
+  if (avg_loss_ == 0.0) {
+    value_ = avg_gain_ == 0.0 ? 50.0 : 100.0;
+  } else {
+    value_ = 100.0 - 100.0 / (1.0 + avg_gain_ / avg_loss_);
+  }
+  return value_;
+}
+
+Atr::Atr(std::size_t period)
+  : period_(checked_period("atr", period)), value_(nanv()) {}
+
+double Atr::push(double high, double low, double close) {
+  double tr = high - low;
+  if (count_ > 0) {
+    tr = std::max({tr, std::fabs(high - prev_close_), std::fabs(low - prev_close_)});
+  }
+  prev_close_ = close;
+  ++count_;
+
+  const double p = static_cast<double>(period_);
+  if (count_ < period_) {
+    tr_sum_ += tr;
+  } else if (count_ == period_) {
+    value_ = (tr_sum_ + tr) / p;
+  } else {
+    value_ = (value_ * (p - 1.0) + tr) / p;
+  }
+  return value_;
+}
+
+Bollinger::Bollinger(std::size_t window, double k)
+  : mean_(checked_window("bollinger", window)),
+    std_(window),
+    k_(k),
+    value_{nanv(), nanv(), nanv()} {}
+
+BollingerBand Bollinger::push(double v) {
+  const double m = mean_.push(v);
+  const double sd = std_.push(v);
+  value_ = {m, m + k_ * sd, m - k_ * sd};
+  return value_;
+}
+
+RollingMin::RollingMin(std::size_t window)
+  : window_(checked_window("rolling_min", window)), candidates_(window), value_(nanv()) {}
+
+double RollingMin::push(double v) {
+  candidates_.push(count_++, v);
+  if (count_ >= window_) value_ = candidates_.empty() ? nanv() : candidates_.front();
+  return value_;
+}
+
+RollingMax::RollingMax(std::size_t window)
+  : window_(checked_window("rolling_max", window)), candidates_(window), value_(nanv()) {}
+
+double RollingMax::push(double v) {
+  candidates_.push(count_++, v);
+  if (count_ >= window_) value_ = candidates_.empty() ? nanv() : candidates_.front();
+  return value_;
+}
+
+Donchian::Donchian(std::size_t window)
+  : upper_(checked_window("donchian", window)),
+    lower_(window),
+    value_{nanv(), nanv(), nanv()} {}
+
+DonchianBand Donchian::push(double high, double low) {
+  const double hi = upper_.push(high);
+  const double lo = lower_.push(low);
+  value_ = {hi, 0.5 * (hi + lo), lo};
+  return value_;
+}
+
+static constexpr double kNoPeak = -std::numeric_limits<double>::infinity();
+static constexpr double kNoTrough = std::numeric_limits<double>::infinity();
+
+RollingMaxDrawdown::RollingMaxDrawdown(std::size_t window)
+  : ring_(checked_window("rolling_max_drawdown", window)),
+    suffix_(window),
+    back_{kNoPeak, kNoTrough, 0.0},
+    value_(nanv()) {}
+
+RollingMaxDrawdown::Run RollingMaxDrawdown::combine(const Run& a, const Run& b) {
+  // as in max_drawdown, only a positive peak makes a drawdown
+  const double across = a.peak > 0.0 ? (a.peak - b.trough) / a.peak : 0.0;
+  return {std::max(a.peak, b.peak), std::min(a.trough, b.trough), std::max({a.max_dd, b.max_dd, across})};
+}
+
+double RollingMaxDrawdown::push(double equity) {
+  const std::size_t w = ring_.size();
+  const auto slot = [&](std::size_t k) { return head_ + k < w ? head_ + k : head_ + k - w; };
+  const auto run_of = [](double v) {
+    return std::isnan(v) ? Run{kNoPeak, kNoTrough, 0.0} : Run{v, v, 0.0};
+  };
+
+  if (size_ == w) {
+    if (front_ == 0) {
+      // move everything to the front, summarizing each value with all newer ones
+      Run acc{kNoPeak, kNoTrough, 0.0};
+      for (std::size_t k = size_; k-- > 0;) {
+        acc = combine(run_of(ring_[slot(k)]), acc);
+        suffix_[slot(k)] = acc;
+      }
+      front_ = size_;
+      back_ = {kNoPeak, kNoTrough, 0.0};
+    }
+    head_ = slot(1);
+    --size_;
+    --front_;
+  }
+  ring_[slot(size_)] = equity;
+  ++size_;
+  back_ = combine(back_, run_of(equity));
+
+  if (++count_ < w) return value_;
+  const Run all = front_ > 0 ? combine(suffix_[head_], back_) : back_;
+  value_ = all.peak == kNoPeak ? nanv() : all.max_dd;
+  return value_;
+}
 
 } // namespace qe
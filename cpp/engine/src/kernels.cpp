@@ -0,0 +1,209 @@
+#include "kernels.hpp"
+
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>   // std::getenv
+#include <string>
+
+#if QE_KERNELS_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace qe {
+
+namespace {
+
+#if QE_KERNELS_X86
+
+struct CpuidRegs {
+  unsigned eax, ebx, ecx, edx;
+};
+
+CpuidRegs cpuid(unsigned leaf, unsigned subleaf) {
+  CpuidRegs r{};
+#if defined(_MSC_VER)
+  int regs[4];
+  __cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+  r = {static_cast<unsigned>(regs[0]), static_cast<unsigned>(regs[1]),
+       static_cast<unsigned>(regs[2]), static_cast<unsigned>(regs[3])};
+#else
+  __cpuid_count(leaf, subleaf, r.eax, r.ebx, r.ecx, r.edx);
+#endif
+  return r;
+}
+
+// register state the OS saves on context switch (XCR0)
+std::uint64_t xcr0() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  unsigned lo = 0, hi = 0;
+  __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return (static_cast<std::uint64_t>(hi) << 32) | lo;
+#endif
+}
+
+Isa detect() {
+  if (cpuid(0, 0).eax < 7) return Isa::Scalar;
+
+  const CpuidRegs l1 = cpuid(1, 0);
+  const bool osxsave = (l1.ecx >> 27) & 1u;
+  const bool avx = (l1.ecx >> 28) & 1u;
+  if (!osxsave || !avx) return Isa::Scalar;
+
+  const std::uint64_t xcr = xcr0();
+  if ((xcr & 0x6) != 0x6) return Isa::Scalar; // XMM and YMM state
+
+  const CpuidRegs l7 = cpuid(7, 0);
+  if (((l7.ebx >> 5) & 1u) == 0) return Isa::Scalar; // AVX2
+
+  const bool avx512 = ((l7.ebx >> 16) & 1u) && ((l7.ebx >> 17) & 1u) // F, DQ
+                      && (xcr & 0xE6) == 0xE6;                      // + opmask and ZMM state
+  return avx512 ? Isa::Avx512 : Isa::Avx2;
+}
+
+#else
+
+Isa detect() {
+  return Isa::Scalar;
+}
+
+#endif
+
+const kernels::KernelTable* table_for(Isa isa) {
+#if QE_KERNELS_X86
+  switch (isa) {
+    case Isa::Avx512: return &kernels::avx512::kTable;
+    case Isa::Avx2: return &kernels::avx2::kTable;
+    case Isa::Scalar: break;
+  }
+#else
+  (void)isa;
+#endif
+  return &kernels::scalar::kTable;
+}
+
+Isa clamp_to_cpu(Isa isa) {
+  const Isa best = detected_isa();
+  return static_cast<int>(isa) > static_cast<int>(best) ? best : isa;
+}
+
+Isa initial_isa() {
+  if (const char* v = std::getenv("QE_ISA")) {
+    std::string name(v);
+    for (char& ch : name) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    for (Isa isa : {Isa::Scalar, Isa::Avx2, Isa::Avx512}) {
+      if (name == isa_name(isa)) return clamp_to_cpu(isa);
+    }
+  }
+  return detected_isa();
+}
+
+std::atomic<const kernels::KernelTable*>& active_table() {
+  static std::atomic<const kernels::KernelTable*> table{table_for(initial_isa())};
+  return table;
+}
+
+const kernels::KernelTable& kt() {
+  return *active_table().load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+const char* isa_name(Isa isa) {
+  switch (isa) {
+    case Isa::Avx512: return "avx512";
+    case Isa::Avx2: return "avx2";
+    case Isa::Scalar: break;
+  }
+  return "scalar";
+}
+
+Isa detected_isa() {
+  static const Isa isa = detect();
+  return isa;
+}
+
+Isa active_isa() {
+  return kt().isa;
+}
+
+Isa set_active_isa(Isa isa) {
+  const kernels::KernelTable* t = table_for(clamp_to_cpu(isa));
+  active_table().store(t, std::memory_order_relaxed);
+  return t->isa;
+}
+
+namespace kernels {
+
+const char* isa() {
+  return isa_name(active_isa());
+}
+
+void returns(const double* close, std::size_t n, double* out) {
+  kt().returns(close, n, out);
+}
+
+void rolling_mean(const double* v, std::size_t n, std::size_t w, double* out) {
+  kt().rolling_mean(v, n, w, out);
+}
+
+int crossover_returns(const double* fast, const double* slow, const double* r, std::size_t n,
+                      int pos, double cost, double* out, std::uint8_t* traded) {
+  return kt().crossover_returns(fast, slow, r, n, pos, cost, out, traded);
+}
+
+double max_drawdown(const double* equity, std::size_t n) {
+  return kt().max_drawdown(equity, n);
+}
+
+MeanVar mean_var(const double* x, std::size_t n) {
+  return kt().mean_var(x, n);
+}
+
+WinCount count_wins(const double* x, std::size_t n) {
+  return kt().count_wins(x, n);
+}
+
+void black_scholes(const double* S, const double* K, const double* r, const double* sigma,
+                   const double* T, std::size_t n, double* call, double* put) {
+  kt().black_scholes(S, K, r, sigma, T, n, call, put);
+}
+
+void cross_update(double* row, std::size_t n, const double* x, const double* y, std::size_t ld,
+                  const double* a, const double* c, std::size_t k) {
+  kt().cross_update(row, n, x, y, ld, a, c, k);
+}
+
+void rolling_mean_fixed(std::size_t slot, const double* v, std::size_t n, double* out) {
+  kt().fixed.rolling_mean[slot](v, n, out);
+}
+
+BacktestPass sma_backtest(const double* close, std::size_t n, std::size_t fast, std::size_t slow,
+                          double initial, double cost, double* strat_ret, double* equity) {
+  return kt().sma_backtest(close, n, fast, slow, initial, cost, strat_ret, equity);
+}
+
+void sma_backtest_batch(const double* close, std::size_t n, const std::size_t* fast, const std::size_t* slow,
+                        std::size_t lanes, double initial, double cost, BacktestPass* out) {
+  kt().sma_backtest_batch(close, n, fast, slow, lanes, initial, cost, out);
+}
+
+BacktestPass strategy_backtest(std::size_t m, double initial, double cost, StrategySignal signal, void* ctx,
+                               double* strat_ret, double* equity) {
+  return kt().strategy_backtest(m, initial, cost, signal, ctx, strat_ret, equity);
+}
+
+BacktestPass sma_backtest_fixed(std::size_t slot, const double* close, std::size_t n, double initial,
+                                double cost, double* strat_ret, double* equity) {
+  return kt().fixed.sma_backtest[slot](close, n, initial, cost, strat_ret, equity);
+}
+
+} // namespace kernels
+
+} // namespace qe
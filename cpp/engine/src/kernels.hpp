@@ -0,0 +1,176 @@
+#pragma once
+
+// Vectorized inner loops behind compute_returns, rolling_mean, the backtest signal loop and
+// metrics (and the fused backtest pass, also across parameters or for any strategy),
+// compute_win_rate, black_scholes_batch and the rolling covariance matrix updates.
+// Internal to qe_engine.
+//
+// Every kernel is compiled three times (kernels_scalar.cpp, kernels_avx2.cpp with -mavx2,
+// kernels_avx512.cpp with -mavx512f/dq) and kernels.cpp picks one table at runtime from the
+// CPU's features, or from QE_ISA (see qe/dispatch.hpp). The variants produce bit-identical
+// results: element-wise kernels and max/count reductions are exact, and the sums use one
+// fixed association order that the scalar code spells out (see rolling_sum_step, mean_var).
+// black_scholes is the exception: the vector variants bring their own exp/log/erfc.
+//
+// The per-ISA files are built with different target flags, so nothing they share may have
+// external linkage (the linker could keep the AVX copy of an inline function for everyone):
+// shared helpers live in anonymous namespaces and the ISA files avoid inline std:: functions.
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include "qe/dispatch.hpp"
+#include "qe/fixed_window.hpp"
+
+namespace qe::kernels {
+
+// "avx512", "avx2" or "scalar" (the active variant)
+const char* isa();
+
+// out[i] = (close[i + 1] - close[i]) / close[i], NaN where close[i] == 0; n >= 1 closes
+void returns(const double* close, std::size_t n, double* out);
+
+// out[i] = sum(v[i + 1 - w .. i]) / w for i >= w - 1 (out[0 .. w - 2] is not written)
+void rolling_mean(const double* v, std::size_t n, std::size_t w, double* out);
+
+// SMA crossover signal: where fast[i] and slow[i] are both defined the position becomes
+// fast[i] > slow[i] (1 = long, 0 = flat), otherwise it is held; out[i] = pos * r[i], less
+// cost where the position changed at i (traded[i] = 1, else 0). pos is the position before
+// i = 0; returns the position after the last bar.
+int crossover_returns(const double* fast, const double* slow, const double* r, std::size_t n,
+                      int pos, double cost, double* out, std::uint8_t* traded);
+
+// largest (peak - v) / peak over the running peak of equity (0 if never positive)
+double max_drawdown(const double* equity, std::size_t n);
+
+// population mean and variance (two-pass); {0, 0} when n == 0
+struct MeanVar {
+  double mean;
+  double var;
+};
+MeanVar mean_var(const double* x, std::size_t n);
+
+// wins: x > 0, total: x is not NaN
+struct WinCount {
+  std::size_t wins;
+  std::size_t total;
+};
+WinCount count_wins(const double* x, std::size_t n);
+
+// European call and put prices, inputs as in black_scholes_call (already validated)
+void black_scholes(const double* S, const double* K, const double* r, const double* sigma,
+                   const double* T, std::size_t n, double* call, double* put);
+
+// rank-k update of a matrix row segment: for each j < n, with b = 0 .. k - 1 in order,
+// row[j] = (row[j] + a[b] * x[b * ld + j]) - c[b] * y[b * ld + j]. y (and c) may be null,
+// then only the a * x terms are added.
+void cross_update(double* row, std::size_t n, const double* x, const double* y, std::size_t ld,
+                  const double* a, const double* c, std::size_t k);
+
+// rolling_mean with the window a compile-time constant, w = kFixedWindows[slot]
+void rolling_mean_fixed(std::size_t slot, const double* v, std::size_t n, double* out);
+
+// the metrics of sma_backtest
+struct BacktestPass {
+  double final_equity;  // equity[n - 2]
+  double max_drawdown;  // max_drawdown(equity, n - 1)
+  double mean;          // mean_var(strat_ret, n - 1)
+  double var;
+  WinCount wins;        // count_wins(strat_ret, n - 1)
+  std::size_t trades;   // position changes
+  double total_cost;    // sum of cost * equity before each trade, in step order
+};
+
+// The SMA crossover backtest in one pass over n >= 2 closes (0 < fast < slow): strat_ret[i]
+// for i < n - 1 is what crossover_returns(fast, slow, r, n - 1, 0, cost, ...) gives from the
+// returns and the rolling_means (NaN heads) of close[1..], equity[i] compounds it from
+// initial, and the metrics are those of the separate kernels, bit for bit, without writing
+// the returns or SMAs. The variance takes a second pass over strat_ret. strat_ret and equity
+// may both be null for the metrics alone in O(1) memory; the second pass then recomputes the
+// signal from close instead, with the same bits.
+BacktestPass sma_backtest(const double* close, std::size_t n, std::size_t fast, std::size_t slow,
+                          double initial, double cost, double* strat_ret, double* equity);
+
+// sma_backtest's metrics (strat_ret and equity null) for lanes <= kBatchLanes (fast[k], slow[k])
+// pairs over the same n closes, one pair per SIMD lane: every step reads close once for all of
+// them, and out[k] has the bits of sma_backtest(close, n, fast[k], slow[k], initial, cost,
+// nullptr, nullptr). Each pair as sma_backtest requires.
+constexpr std::size_t kBatchLanes = 16;
+void sma_backtest_batch(const double* close, std::size_t n, const std::size_t* fast, const std::size_t* slow,
+                        std::size_t lanes, double initial, double cost, BacktestPass* out);
+
+// the strategy returns and trade flags of steps [first, last) into out[i - first] and
+// traded[i - first] (as signal_step writes them); called for consecutive chunks from
+// first = 0, and once more from first = 0 (a restart) for the second pass of metrics only
+using StrategySignal = void (*)(void* ctx, std::size_t first, std::size_t last, double* out,
+                                std::uint8_t* traded);
+
+// sma_backtest's equity, cost and metrics pass over m >= 1 steps whose strategy returns come
+// from signal(ctx, ...) a chunk at a time instead of the SMA crossover: one indirect call per
+// chunk, the same bits as sma_backtest for the same returns and trades
+BacktestPass strategy_backtest(std::size_t m, double initial, double cost, StrategySignal signal, void* ctx,
+                               double* strat_ret, double* equity);
+
+// sma_backtest with (fast, slow) = kFixedPairs[slot] compiled in
+BacktestPass sma_backtest_fixed(std::size_t slot, const double* close, std::size_t n, double initial,
+                                double cost, double* strat_ret, double* equity);
+
+// the instantiations behind the two fixed-window kernels, one per slot
+struct FixedKernels {
+  void (*rolling_mean[std::size(kFixedWindows)])(const double*, std::size_t, double*);
+  BacktestPass (*sma_backtest[std::size(kFixedPairs)])(const double*, std::size_t, double, double, double*,
+                                                       double*);
+};
+
+// one compiled variant
+struct KernelTable {
+  Isa isa;
+  void (*returns)(const double*, std::size_t, double*);
+  void (*rolling_mean)(const double*, std::size_t, std::size_t, double*);
+  int (*crossover_returns)(const double*, const double*, const double*, std::size_t, int, double, double*,
+                           std::uint8_t*);
+  double (*max_drawdown)(const double*, std::size_t);
+  MeanVar (*mean_var)(const double*, std::size_t);
+  WinCount (*count_wins)(const double*, std::size_t);
+  void (*black_scholes)(const double*, const double*, const double*, const double*, const double*,
+                        std::size_t, double*, double*);
+  void (*cross_update)(double*, std::size_t, const double*, const double*, std::size_t, const double*,
+                       const double*, std::size_t);
+  BacktestPass (*sma_backtest)(const double*, std::size_t, std::size_t, std::size_t, double, double, double*,
+                               double*);
+  void (*sma_backtest_batch)(const double*, std::size_t, const std::size_t*, const std::size_t*, std::size_t,
+                             double, double, BacktestPass*);
+  BacktestPass (*strategy_backtest)(std::size_t, double, double, StrategySignal, void*, double*, double*);
+  FixedKernels fixed;
+};
+
+namespace scalar { extern const KernelTable kTable; }
+#if QE_KERNELS_X86
+namespace avx2 { extern const KernelTable kTable; }
+namespace avx512 { extern const KernelTable kTable; }
+#endif
+
+namespace {
+
+// Canonical order of the rolling-window sum. The running sum of d[i] = v[i] - v[i - w]
+// is taken in aligned blocks of 4 (a two-step Hillis-Steele scan inside the block, then
+// the carry from earlier blocks is added), which is what a 4- or 8-lane register does.
+// pos = i % 4; block keeps the d values of the current block; returns the sum at i.
+inline double rolling_sum_step(double& carry, double (&block)[4], std::size_t pos, double d) {
+  block[pos] = d;
+  double y;
+  switch (pos) {
+    case 0: y = (block[0] + 0.0) + 0.0; break;
+    case 1: y = (block[1] + block[0]) + 0.0; break;
+    case 2: y = (block[2] + block[1]) + (block[0] + 0.0); break;
+    default: y = (block[3] + block[2]) + (block[1] + block[0]); break;
+  }
+  const double s = carry + y;
+  if (pos == 3) carry = s;
+  return s;
+}
+
+} // namespace
+
+} // namespace qe::kernels
@@ -0,0 +1,418 @@
+// AVX2 kernel variant, built with -mavx2 (/arch:AVX2); only run when the CPU has AVX2.
+
+#include "kernels_common.hpp"
+
+#include <immintrin.h>
+#include <utility>
+
+#include "vec_backtest.hpp"
+#include "vec_math.hpp"
+
+namespace qe::kernels::avx2 {
+
+namespace {
+
+// [0, x0, x1, x2] and [0, 0, x0, x1]
+inline __m256d shift1_zero(__m256d x) {
+  return _mm256_blend_pd(_mm256_permute4x64_pd(x, 0x90), _mm256_setzero_pd(), 0x1);
+}
+inline __m256d shift2_zero(__m256d x) {
+  return _mm256_permute2f128_pd(x, x, 0x08);
+}
+
+void returns(const double* close, std::size_t n, double* out) {
+  const std::size_t m = n - 1;
+  const __m256d nan = _mm256_set1_pd(kNaN);
+  const __m256d zero = _mm256_setzero_pd();
+  std::size_t j = 0;
+  for (; j + 4 <= m; j += 4) {
+    const __m256d prev = _mm256_loadu_pd(close + j);
+    const __m256d cur = _mm256_loadu_pd(close + j + 1);
+    const __m256d is_zero = _mm256_cmp_pd(prev, zero, _CMP_EQ_OQ);
+    const __m256d r = _mm256_div_pd(_mm256_sub_pd(cur, prev), prev);
+    _mm256_storeu_pd(out + j, _mm256_blendv_pd(r, nan, is_zero));
+  }
+  for (; j < m; ++j) out[j] = return_at(close, j);
+}
+
+// W != 0 fixes the window at compile time (the w argument is then ignored)
+template <std::size_t W>
+void rolling_mean_impl(const double* v, std::size_t n, std::size_t w_arg, double* out) {
+  const std::size_t w = W != 0 ? W : w_arg;
+  double carry = 0.0;
+  double block[4] = {};
+  const std::size_t round_w = (w + 3) / 4 * 4;
+  const std::size_t head = n < round_w ? n : round_w;
+  rolling_mean_scalar(v, 0, head, w, carry, block, out);
+
+  // one canonical 4-block per register
+  const __m256d wd = _mm256_set1_pd(static_cast<double>(w));
+  __m256d c = _mm256_set1_pd(carry);
+
+  std::size_t i = head;
+  for (; i + 4 <= n; i += 4) {
+    const __m256d d = _mm256_sub_pd(_mm256_loadu_pd(v + i), _mm256_loadu_pd(v + i - w));
+    const __m256d x = _mm256_add_pd(d, shift1_zero(d));
+    const __m256d y = _mm256_add_pd(x, shift2_zero(x));
+    const __m256d s = _mm256_add_pd(c, y);
+    _mm256_storeu_pd(out + i, _mm256_div_pd(s, wd));
+    c = _mm256_permute4x64_pd(s, 0xFF);
+  }
+
+  carry = _mm256_cvtsd_f64(c);
+  rolling_mean_scalar(v, i, n, w, carry, block, out);
+}
+
+void rolling_mean(const double* v, std::size_t n, std::size_t w, double* out) {
+  rolling_mean_impl<0>(v, n, w, out);
+}
+
+template <std::size_t W>
+void rolling_mean_fixed(const double* v, std::size_t n, double* out) {
+  rolling_mean_impl<W>(v, n, W, out);
+}
+
+// pos * r less cost where the position changed; returns the trade bits
+inline unsigned signal_block(__m256d up, __m256d r, int pos, __m256d cost, double* out) {
+  const unsigned changed = trade_bits(static_cast<unsigned>(_mm256_movemask_pd(up)), 4, pos);
+  const __m256i lane_bit = _mm256_set_epi64x(8, 4, 2, 1);
+  const __m256i hit = _mm256_and_si256(_mm256_set1_epi64x(changed), lane_bit);
+  const __m256d traded = _mm256_castsi256_pd(_mm256_cmpeq_epi64(hit, lane_bit));
+  const __m256d x = _mm256_mul_pd(_mm256_and_pd(up, _mm256_set1_pd(1.0)), r);
+  _mm256_storeu_pd(out, _mm256_blendv_pd(x, _mm256_sub_pd(x, cost), traded));
+  return changed;
+}
+
+int crossover_returns(const double* fast, const double* slow, const double* r, std::size_t n,
+                      int pos, double cost, double* out, std::uint8_t* traded) {
+  // blocks where both SMAs are defined need no carried position; others go scalar
+  const __m256d cv = _mm256_set1_pd(cost);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m256d f = _mm256_loadu_pd(fast + i);
+    const __m256d s = _mm256_loadu_pd(slow + i);
+    if (_mm256_movemask_pd(_mm256_cmp_pd(f, s, _CMP_ORD_Q)) != 0xF) {
+      pos = crossover_scalar(fast, slow, r, i, i + 4, pos, cost, out, traded);
+      continue;
+    }
+    const __m256d up = _mm256_cmp_pd(f, s, _CMP_GT_OQ);
+    store_flags(traded + i, signal_block(up, _mm256_loadu_pd(r + i), pos, cv, out + i), 4);
+    pos = (_mm256_movemask_pd(up) >> 3) & 1;
+  }
+  return crossover_scalar(fast, slow, r, i, n, pos, cost, out, traded);
+}
+
+// the carry-chained scan of rolling_mean_impl over one register of d values
+inline __m256d window_sums(__m256d d, __m256d& carry) {
+  const __m256d x = _mm256_add_pd(d, shift1_zero(d));
+  const __m256d y = _mm256_add_pd(x, shift2_zero(x));
+  const __m256d s = _mm256_add_pd(carry, y);
+  carry = _mm256_permute4x64_pd(s, 0xFF);
+  return s;
+}
+
+// returns, both window sums and the signal per register for return indices [first, last)
+// into out[i - first] and traded[i - first], continuing st (first % 4 == 0); nonzero Fast /
+// Slow fix the windows
+template <std::size_t Fast, std::size_t Slow>
+void sma_crossover_range(const double* close, std::size_t first, std::size_t last, std::size_t fw_arg,
+                         std::size_t sw_arg, double cost, CrossoverState& st, double* out,
+                         std::uint8_t* traded) {
+  const std::size_t fw = Fast != 0 ? Fast : fw_arg;
+  const std::size_t sw = Slow != 0 ? Slow : sw_arg;
+  const double* v = close + 1;
+  // past the head both windows are full (fw < sw)
+  const std::size_t round_w = (sw + 3) / 4 * 4;
+  std::size_t i = first;
+  if (i < round_w) {
+    i = last < round_w ? last : round_w;
+    sma_crossover_scalar(close, first, i, fw, sw, cost, st, out, traded);
+  }
+
+  const __m256d nan = _mm256_set1_pd(kNaN);
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d cv = _mm256_set1_pd(cost);
+  const __m256d fd = _mm256_set1_pd(static_cast<double>(fw));
+  const __m256d sd = _mm256_set1_pd(static_cast<double>(sw));
+  __m256d fc = _mm256_set1_pd(st.fast_carry);
+  __m256d sc = _mm256_set1_pd(st.slow_carry);
+
+  for (; i + 4 <= last; i += 4) {
+    const __m256d prev = _mm256_loadu_pd(close + i);
+    const __m256d cur = _mm256_loadu_pd(v + i);
+    const __m256d is_zero = _mm256_cmp_pd(prev, zero, _CMP_EQ_OQ);
+    const __m256d r = _mm256_blendv_pd(_mm256_div_pd(_mm256_sub_pd(cur, prev), prev), nan, is_zero);
+    const __m256d f = _mm256_div_pd(window_sums(_mm256_sub_pd(cur, _mm256_loadu_pd(v + i - fw)), fc), fd);
+    const __m256d s = _mm256_div_pd(window_sums(_mm256_sub_pd(cur, _mm256_loadu_pd(v + i - sw)), sc), sd);
+
+    if (_mm256_movemask_pd(_mm256_cmp_pd(f, s, _CMP_ORD_Q)) != 0xF) {
+      double fb[4];
+      double sb[4];
+      double rb[4];
+      _mm256_storeu_pd(fb, f);
+      _mm256_storeu_pd(sb, s);
+      _mm256_storeu_pd(rb, r);
+      st.pos = crossover_scalar(fb, sb, rb, 0, 4, st.pos, cost, out + (i - first), traded + (i - first));
+      continue;
+    }
+    const __m256d up = _mm256_cmp_pd(f, s, _CMP_GT_OQ);
+    store_flags(traded + (i - first), signal_block(up, r, st.pos, cv, out + (i - first)), 4);
+    st.pos = (_mm256_movemask_pd(up) >> 3) & 1;
+  }
+
+  st.fast_carry = _mm256_cvtsd_f64(fc);
+  st.slow_carry = _mm256_cvtsd_f64(sc);
+  sma_crossover_scalar(close, i, last, fw, sw, cost, st, out + (i - first), traded + (i - first));
+}
+
+// max_drawdown's steps over equity[0, n) from st, whose peak the vector loop carries in
+void drawdown_run(const double* equity, std::size_t n, Drawdown& st) {
+  const __m256d neg_inf = _mm256_set1_pd(kNegInf);
+  const __m256d zero = _mm256_setzero_pd();
+  __m256d peak = _mm256_set1_pd(st.peak);
+  __m256d acc = zero;
+
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m256d v = _mm256_loadu_pd(equity + i);
+    __m256d m = _mm256_blendv_pd(v, neg_inf, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+    m = _mm256_max_pd(m, _mm256_blend_pd(_mm256_permute4x64_pd(m, 0x90), neg_inf, 0x1));
+    m = _mm256_max_pd(m, _mm256_blend_pd(_mm256_permute4x64_pd(m, 0x40), neg_inf, 0x3));
+    const __m256d p = _mm256_max_pd(m, peak);
+
+    const __m256d positive = _mm256_cmp_pd(p, zero, _CMP_GT_OQ);
+    const __m256d dd = _mm256_and_pd(positive, _mm256_div_pd(_mm256_sub_pd(p, v), p));
+    acc = _mm256_max_pd(dd, acc);
+    peak = _mm256_permute4x64_pd(p, 0xFF);
+  }
+
+  double lanes[4];
+  _mm256_storeu_pd(lanes, acc);
+  st.peak = _mm256_cvtsd_f64(peak);
+  st.max_dd = max_of(st.max_dd, max_of(max_of(lanes[0], lanes[1]), max_of(lanes[2], lanes[3])));
+  for (; i < n; ++i) st.step(equity[i]);
+}
+
+double max_drawdown(const double* equity, std::size_t n) {
+  if (n == 0 || is_nan(equity[0])) return 0.0;
+  Drawdown st{equity[0], 0.0};
+  drawdown_run(equity, n, st);
+  return st.max_dd;
+}
+
+double variance_about(const double* x, std::size_t n, double mean) {
+  if (n == 0) return 0.0;
+
+  double lane[8];
+  const std::size_t n8 = n / 8 * 8;
+
+  const __m256d mv = _mm256_set1_pd(mean);
+  __m256d lo = _mm256_setzero_pd();
+  __m256d hi = _mm256_setzero_pd();
+  for (std::size_t i = 0; i < n8; i += 8) {
+    const __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(x + i), mv);
+    const __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(x + i + 4), mv);
+    lo = _mm256_add_pd(lo, _mm256_mul_pd(d0, d0));
+    hi = _mm256_add_pd(hi, _mm256_mul_pd(d1, d1));
+  }
+  _mm256_storeu_pd(lane, lo);
+  _mm256_storeu_pd(lane + 4, hi);
+  for (std::size_t i = n8; i < n; ++i) lane[i % 8] += squared_dev(x[i], mean);
+  return fold_lanes(lane) / static_cast<double>(n);
+}
+
+// adds x[i] to lane[i % 8]
+void lane_sums(const double* x, std::size_t n, double (&lane)[8]) {
+  const std::size_t n8 = n / 8 * 8;
+  __m256d lo = _mm256_loadu_pd(lane);
+  __m256d hi = _mm256_loadu_pd(lane + 4);
+  for (std::size_t i = 0; i < n8; i += 8) {
+    lo = _mm256_add_pd(lo, _mm256_loadu_pd(x + i));
+    hi = _mm256_add_pd(hi, _mm256_loadu_pd(x + i + 4));
+  }
+  _mm256_storeu_pd(lane, lo);
+  _mm256_storeu_pd(lane + 4, hi);
+  for (std::size_t i = n8; i < n; ++i) lane[i % 8] += x[i];
+}
+
+MeanVar mean_var(const double* x, std::size_t n) {
+  if (n == 0) return {0.0, 0.0};
+
+  double lane[8] = {};
+  lane_sums(x, n, lane);
+  const double mean = fold_lanes(lane) / static_cast<double>(n);
+  return {mean, variance_about(x, n, mean)};
+}
+
+WinCount count_wins(const double* x, std::size_t n) {
+  WinCount c{0, 0};
+  const __m256d zero = _mm256_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m256d v = _mm256_loadu_pd(x + i);
+    c.wins += bit_count(static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(v, zero, _CMP_GT_OQ))));
+    c.total += bit_count(static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(v, v, _CMP_ORD_Q))));
+  }
+  count_wins_scalar(x, i, n, c);
+  return c;
+}
+
+// one sma_backtest chunk's share of max_drawdown, mean_var's sums and count_wins
+void pass_stats(const double* r, const double* equity, std::size_t n, PassStats& st) {
+  drawdown_run(equity, n, st.dd);
+  lane_sums(r, n, st.lane);
+  const WinCount c = count_wins(r, n);
+  st.wins.wins += c.wins;
+  st.wins.total += c.total;
+}
+
+template <std::size_t Fast, std::size_t Slow>
+BacktestPass sma_backtest_impl(const double* close, std::size_t n, std::size_t fw, std::size_t sw,
+                               double initial, double cost, double* strat_ret, double* equity) {
+  const auto signal = [&](CrossoverState& st, std::size_t first, std::size_t last, double* out,
+                          std::uint8_t* traded) {
+    sma_crossover_range<Fast, Slow>(close, first, last, fw, sw, cost, st, out, traded);
+  };
+  return sma_backtest_chunks(n - 1, initial, cost, strat_ret, equity, signal, pass_stats, variance_about);
+}
+
+BacktestPass sma_backtest(const double* close, std::size_t n, std::size_t fast, std::size_t slow,
+                          double initial, double cost, double* strat_ret, double* equity) {
+  return sma_backtest_impl<0, 0>(close, n, fast, slow, initial, cost, strat_ret, equity);
+}
+
+template <std::size_t Fast, std::size_t Slow>
+BacktestPass sma_backtest_fixed(const double* close, std::size_t n, double initial, double cost,
+                                double* strat_ret, double* equity) {
+  return sma_backtest_impl<Fast, Slow>(close, n, Fast, Slow, initial, cost, strat_ret, equity);
+}
+
+BacktestPass strategy_backtest(std::size_t m, double initial, double cost, StrategySignal signal, void* ctx,
+                               double* strat_ret, double* equity) {
+  const auto chunk = [&](CrossoverState&, std::size_t first, std::size_t last, double* out, std::uint8_t* traded) {
+    signal(ctx, first, last, out, traded);
+  };
+  return sma_backtest_chunks(m, initial, cost, strat_ret, equity, chunk, pass_stats, variance_about);
+}
+
+void cross_update(double* row, std::size_t n, const double* x, const double* y, std::size_t ld,
+                  const double* a, const double* c, std::size_t k) {
+  // two registers of the row stay loaded across all k terms
+  std::size_t j = 0;
+  for (; j + 8 <= n; j += 8) {
+    __m256d r0 = _mm256_loadu_pd(row + j);
+    __m256d r1 = _mm256_loadu_pd(row + j + 4);
+    for (std::size_t b = 0; b < k; ++b) {
+      const double* xb = x + b * ld + j;
+      const __m256d ab = _mm256_set1_pd(a[b]);
+      r0 = _mm256_add_pd(r0, _mm256_mul_pd(ab, _mm256_loadu_pd(xb)));
+      r1 = _mm256_add_pd(r1, _mm256_mul_pd(ab, _mm256_loadu_pd(xb + 4)));
+      if (y) {
+        const double* yb = y + b * ld + j;
+        const __m256d cb = _mm256_set1_pd(c[b]);
+        r0 = _mm256_sub_pd(r0, _mm256_mul_pd(cb, _mm256_loadu_pd(yb)));
+        r1 = _mm256_sub_pd(r1, _mm256_mul_pd(cb, _mm256_loadu_pd(yb + 4)));
+      }
+    }
+    _mm256_storeu_pd(row + j, r0);
+    _mm256_storeu_pd(row + j + 4, r1);
+  }
+  cross_update_scalar(row, j, n, x, y, ld, a, c, k);
+}
+
+// lane type for vec_math.hpp and vec_backtest.hpp
+struct Mask;
+
+struct Vec {
+  static constexpr std::size_t kLanes = 4;
+  __m256d v;
+
+  Vec() : v(_mm256_setzero_pd()) {}
+  Vec(__m256d x) : v(x) {}
+  Vec(double x) : v(_mm256_set1_pd(x)) {}
+
+  static Vec load(const double* p) { return _mm256_loadu_pd(p); }
+  void store(double* p) const { _mm256_storeu_pd(p, v); }
+  static Vec gather(const double* p, const std::int64_t* idx, Mask m);
+};
+
+struct Mask {
+  __m256d m;
+};
+
+inline Vec Vec::gather(const double* p, const std::int64_t* idx, Mask m) {
+  const __m256i i = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx));
+  return _mm256_mask_i64gather_pd(_mm256_setzero_pd(), p, i, m.m, 8);
+}
+
+inline Vec operator+(Vec a, Vec b) { return _mm256_add_pd(a.v, b.v); }
+inline Vec operator-(Vec a, Vec b) { return _mm256_sub_pd(a.v, b.v); }
+inline Vec operator*(Vec a, Vec b) { return _mm256_mul_pd(a.v, b.v); }
+inline Vec operator/(Vec a, Vec b) { return _mm256_div_pd(a.v, b.v); }
+inline Vec operator-(Vec a) { return _mm256_xor_pd(a.v, _mm256_set1_pd(-0.0)); }
+
+inline Mask less(Vec a, Vec b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)}; }
+inline Mask greater(Vec a, Vec b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ)}; }
+inline Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_pd(b.v, a.v, m.m); }
+inline Mask at_least(Vec a, Vec b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ)}; }
+inline Mask ordered(Vec a, Vec b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_ORD_Q)}; }
+inline Mask differ(Vec a, Vec b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_NEQ_OQ)}; }
+inline bool any(Mask m) { return _mm256_movemask_pd(m.m) != 0; }
+
+inline Vec vsqrt(Vec a) { return _mm256_sqrt_pd(a.v); }
+inline Vec vfloor(Vec a) { return _mm256_floor_pd(a.v); }
+inline Vec vabs(Vec a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v); }
+
+inline Vec pow2(Vec n) {
+  // n + 1.5 * 2^52 leaves n as a two's-complement integer in the low bits
+  const __m256d magic = _mm256_set1_pd(6755399441055744.0);
+  const __m256i k = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(n.v, magic)), _mm256_castpd_si256(magic));
+  return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(k, _mm256_set1_epi64x(1023)), 52));
+}
+
+inline Vec split_exponent(Vec x, Vec& e) {
+  const __m256i bits = _mm256_castpd_si256(x.v);
+  // biased exponent, converted by placing it in the mantissa of 2^52
+  const __m256d two52 = _mm256_set1_pd(4503599627370496.0);
+  const __m256d biased = _mm256_sub_pd(_mm256_or_pd(_mm256_castsi256_pd(_mm256_srli_epi64(bits, 52)), two52), two52);
+  e = _mm256_sub_pd(biased, _mm256_set1_pd(1022.0));
+  const __m256i mantissa = _mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFF));
+  return _mm256_castsi256_pd(_mm256_or_si256(mantissa, _mm256_set1_epi64x(0x3FE0000000000000)));
+}
+
+void black_scholes(const double* S, const double* K, const double* r, const double* sigma,
+                   const double* T, std::size_t n, double* call, double* put) {
+  vmath::black_scholes_batch<Vec>(S, K, r, sigma, T, n, call, put);
+}
+
+void sma_backtest_batch(const double* close, std::size_t n, const std::size_t* fast, const std::size_t* slow,
+                        std::size_t lanes, double initial, double cost, BacktestPass* out) {
+  vbacktest::sma_backtest_batch<Vec>(close, n, fast, slow, lanes, initial, cost, out);
+}
+
+template <std::size_t... W, std::size_t... P>
+constexpr FixedKernels fixed_kernels(std::index_sequence<W...>, std::index_sequence<P...>) {
+  return {{&rolling_mean_fixed<kFixedWindows[W]>...},
+          {&sma_backtest_fixed<kFixedPairs[P].fast, kFixedPairs[P].slow>...}};
+}
+
+} // namespace
+
+const KernelTable kTable = {
+  Isa::Avx2,
+  returns,
+  rolling_mean,
+  crossover_returns,
+  max_drawdown,
+  mean_var,
+  count_wins,
+  black_scholes,
+  cross_update,
+  sma_backtest,
+  sma_backtest_batch,
+  strategy_backtest,
+  fixed_kernels(std::make_index_sequence<std::size(kFixedWindows)>{},
+                std::make_index_sequence<std::size(kFixedPairs)>{}),
+};
+
+} // namespace qe::kernels::avx2
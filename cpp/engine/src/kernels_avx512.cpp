@@ -0,0 +1,403 @@
+// AVX-512 kernel variant, built with -mavx512f -mavx512dq (/arch:AVX512); only run when the
+// CPU has AVX-512 F and DQ.
+
+#include "kernels_common.hpp"
+
+#include <immintrin.h>
+#include <utility>
+
+#include "vec_backtest.hpp"
+#include "vec_math.hpp"
+
+namespace qe::kernels::avx512 {
+
+namespace {
+
+void returns(const double* close, std::size_t n, double* out) {
+  const std::size_t m = n - 1;
+  const __m512d nan = _mm512_set1_pd(kNaN);
+  std::size_t j = 0;
+  for (; j + 8 <= m; j += 8) {
+    const __m512d prev = _mm512_loadu_pd(close + j);
+    const __m512d cur = _mm512_loadu_pd(close + j + 1);
+    const __mmask8 zero = _mm512_cmp_pd_mask(prev, _mm512_setzero_pd(), _CMP_EQ_OQ);
+    const __m512d r = _mm512_div_pd(_mm512_sub_pd(cur, prev), prev);
+    _mm512_storeu_pd(out + j, _mm512_mask_blend_pd(zero, r, nan));
+  }
+  for (; j < m; ++j) out[j] = return_at(close, j);
+}
+
+// W != 0 fixes the window at compile time (the w argument is then ignored)
+template <std::size_t W>
+void rolling_mean_impl(const double* v, std::size_t n, std::size_t w_arg, double* out) {
+  const std::size_t w = W != 0 ? W : w_arg;
+  double carry = 0.0;
+  double block[4] = {};
+  const std::size_t round_w = (w + 3) / 4 * 4;
+  const std::size_t head = n < round_w ? n : round_w;
+  rolling_mean_scalar(v, 0, head, w, carry, block, out);
+
+  // two canonical 4-blocks per register: scan within each half, then chain the carries
+  const __m512i shift1 = _mm512_set_epi64(6, 5, 4, 4, 2, 1, 0, 0);
+  const __m512i shift2 = _mm512_set_epi64(5, 4, 4, 4, 1, 0, 0, 0);
+  const __m512i lane3 = _mm512_set1_epi64(3);
+  const __m512i lane7 = _mm512_set1_epi64(7);
+  const __m512d wd = _mm512_set1_pd(static_cast<double>(w));
+  __m512d c = _mm512_set1_pd(carry);
+
+  std::size_t i = head;
+  for (; i + 8 <= n; i += 8) {
+    const __m512d d = _mm512_sub_pd(_mm512_loadu_pd(v + i), _mm512_loadu_pd(v + i - w));
+    const __m512d x = _mm512_add_pd(d, _mm512_maskz_permutexvar_pd(0xEE, shift1, d));
+    const __m512d y = _mm512_add_pd(x, _mm512_maskz_permutexvar_pd(0xCC, shift2, x));
+    const __m512d c_hi = _mm512_add_pd(c, _mm512_permutexvar_pd(lane3, y));
+    const __m512d s = _mm512_add_pd(_mm512_mask_blend_pd(0xF0, c, c_hi), y);
+    _mm512_storeu_pd(out + i, _mm512_div_pd(s, wd));
+    c = _mm512_permutexvar_pd(lane7, s);
+  }
+
+  carry = _mm512_cvtsd_f64(c);
+  rolling_mean_scalar(v, i, n, w, carry, block, out);
+}
+
+void rolling_mean(const double* v, std::size_t n, std::size_t w, double* out) {
+  rolling_mean_impl<0>(v, n, w, out);
+}
+
+template <std::size_t W>
+void rolling_mean_fixed(const double* v, std::size_t n, double* out) {
+  rolling_mean_impl<W>(v, n, W, out);
+}
+
+// pos * r less cost where the position changed; returns the trade bits
+inline unsigned signal_block(__mmask8 up, __m512d r, int pos, __m512d cost, double* out) {
+  const unsigned changed = trade_bits(up, 8, pos);
+  const __m512d x = _mm512_mul_pd(_mm512_maskz_mov_pd(up, _mm512_set1_pd(1.0)), r);
+  _mm512_storeu_pd(out, _mm512_mask_sub_pd(x, static_cast<__mmask8>(changed), x, cost));
+  return changed;
+}
+
+int crossover_returns(const double* fast, const double* slow, const double* r, std::size_t n,
+                      int pos, double cost, double* out, std::uint8_t* traded) {
+  // blocks where both SMAs are defined need no carried position; others go scalar
+  const __m512d cv = _mm512_set1_pd(cost);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m512d f = _mm512_loadu_pd(fast + i);
+    const __m512d s = _mm512_loadu_pd(slow + i);
+    const __mmask8 defined = _mm512_cmp_pd_mask(f, s, _CMP_ORD_Q);
+    if (defined != 0xFF) {
+      pos = crossover_scalar(fast, slow, r, i, i + 8, pos, cost, out, traded);
+      continue;
+    }
+    const __mmask8 up = _mm512_cmp_pd_mask(f, s, _CMP_GT_OQ);
+    store_flags(traded + i, signal_block(up, _mm512_loadu_pd(r + i), pos, cv, out + i), 8);
+    pos = (up >> 7) & 1;
+  }
+  return crossover_scalar(fast, slow, r, i, n, pos, cost, out, traded);
+}
+
+// the carry-chained scan of rolling_mean_impl over one register of d values
+inline __m512d window_sums(__m512d d, __m512d& carry) {
+  const __m512i shift1 = _mm512_set_epi64(6, 5, 4, 4, 2, 1, 0, 0);
+  const __m512i shift2 = _mm512_set_epi64(5, 4, 4, 4, 1, 0, 0, 0);
+  const __m512d x = _mm512_add_pd(d, _mm512_maskz_permutexvar_pd(0xEE, shift1, d));
+  const __m512d y = _mm512_add_pd(x, _mm512_maskz_permutexvar_pd(0xCC, shift2, x));
+  const __m512d c_hi = _mm512_add_pd(carry, _mm512_permutexvar_pd(_mm512_set1_epi64(3), y));
+  const __m512d s = _mm512_add_pd(_mm512_mask_blend_pd(0xF0, carry, c_hi), y);
+  carry = _mm512_permutexvar_pd(_mm512_set1_epi64(7), s);
+  return s;
+}
+
+// returns, both window sums and the signal per register for return indices [first, last)
+// into out[i - first] and traded[i - first], continuing st (first % 4 == 0); nonzero Fast /
+// Slow fix the windows
+template <std::size_t Fast, std::size_t Slow>
+void sma_crossover_range(const double* close, std::size_t first, std::size_t last, std::size_t fw_arg,
+                         std::size_t sw_arg, double cost, CrossoverState& st, double* out,
+                         std::uint8_t* traded) {
+  const std::size_t fw = Fast != 0 ? Fast : fw_arg;
+  const std::size_t sw = Slow != 0 ? Slow : sw_arg;
+  const double* v = close + 1;
+  // past the head both windows are full (fw < sw)
+  const std::size_t round_w = (sw + 3) / 4 * 4;
+  std::size_t i = first;
+  if (i < round_w) {
+    i = last < round_w ? last : round_w;
+    sma_crossover_scalar(close, first, i, fw, sw, cost, st, out, traded);
+  }
+
+  const __m512d nan = _mm512_set1_pd(kNaN);
+  const __m512d cv = _mm512_set1_pd(cost);
+  const __m512d fd = _mm512_set1_pd(static_cast<double>(fw));
+  const __m512d sd = _mm512_set1_pd(static_cast<double>(sw));
+  __m512d fc = _mm512_set1_pd(st.fast_carry);
+  __m512d sc = _mm512_set1_pd(st.slow_carry);
+
+  for (; i + 8 <= last; i += 8) {
+    const __m512d prev = _mm512_loadu_pd(close + i);
+    const __m512d cur = _mm512_loadu_pd(v + i);
+    const __mmask8 zero = _mm512_cmp_pd_mask(prev, _mm512_setzero_pd(), _CMP_EQ_OQ);
+    const __m512d r = _mm512_mask_blend_pd(zero, _mm512_div_pd(_mm512_sub_pd(cur, prev), prev), nan);
+    const __m512d f = _mm512_div_pd(window_sums(_mm512_sub_pd(cur, _mm512_loadu_pd(v + i - fw)), fc), fd);
+    const __m512d s = _mm512_div_pd(window_sums(_mm512_sub_pd(cur, _mm512_loadu_pd(v + i - sw)), sc), sd);
+
+    if (_mm512_cmp_pd_mask(f, s, _CMP_ORD_Q) != 0xFF) {
+      double fb[8];
+      double sb[8];
+      double rb[8];
+      _mm512_storeu_pd(fb, f);
+      _mm512_storeu_pd(sb, s);
+      _mm512_storeu_pd(rb, r);
+      st.pos = crossover_scalar(fb, sb, rb, 0, 8, st.pos, cost, out + (i - first), traded + (i - first));
+      continue;
+    }
+    const __mmask8 up = _mm512_cmp_pd_mask(f, s, _CMP_GT_OQ);
+    store_flags(traded + (i - first), signal_block(up, r, st.pos, cv, out + (i - first)), 8);
+    st.pos = (up >> 7) & 1;
+  }
+
+  st.fast_carry = _mm512_cvtsd_f64(fc);
+  st.slow_carry = _mm512_cvtsd_f64(sc);
+  sma_crossover_scalar(close, i, last, fw, sw, cost, st, out + (i - first), traded + (i - first));
+}
+
+// max_drawdown's steps over equity[0, n) from st, whose peak the vector loop carries in
+void drawdown_run(const double* equity, std::size_t n, Drawdown& st) {
+  // running max inside the register (NaN bars never raise the peak), then the carry
+  const __m512d neg_inf = _mm512_set1_pd(kNegInf);
+  const __m512d zero = _mm512_setzero_pd();
+  const __m512i shift1 = _mm512_set_epi64(6, 5, 4, 3, 2, 1, 0, 0);
+  const __m512i shift2 = _mm512_set_epi64(5, 4, 3, 2, 1, 0, 0, 0);
+  const __m512i shift4 = _mm512_set_epi64(3, 2, 1, 0, 0, 0, 0, 0);
+  const __m512i lane7 = _mm512_set1_epi64(7);
+  __m512d peak = _mm512_set1_pd(st.peak);
+  __m512d acc = zero;
+
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m512d v = _mm512_loadu_pd(equity + i);
+    __m512d m = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(v, v, _CMP_UNORD_Q), v, neg_inf);
+    m = _mm512_max_pd(m, _mm512_mask_permutexvar_pd(neg_inf, 0xFE, shift1, m));
+    m = _mm512_max_pd(m, _mm512_mask_permutexvar_pd(neg_inf, 0xFC, shift2, m));
+    m = _mm512_max_pd(m, _mm512_mask_permutexvar_pd(neg_inf, 0xF0, shift4, m));
+    const __m512d p = _mm512_max_pd(m, peak);
+
+    const __mmask8 positive = _mm512_cmp_pd_mask(p, zero, _CMP_GT_OQ);
+    const __m512d dd = _mm512_maskz_div_pd(positive, _mm512_sub_pd(p, v), p);
+    acc = _mm512_max_pd(dd, acc); // a NaN dd keeps acc
+    peak = _mm512_permutexvar_pd(lane7, p);
+  }
+
+  st.peak = _mm512_cvtsd_f64(peak);
+  st.max_dd = max_of(st.max_dd, _mm512_reduce_max_pd(acc));
+  for (; i < n; ++i) st.step(equity[i]);
+}
+
+double max_drawdown(const double* equity, std::size_t n) {
+  if (n == 0 || is_nan(equity[0])) return 0.0;
+  Drawdown st{equity[0], 0.0};
+  drawdown_run(equity, n, st);
+  return st.max_dd;
+}
+
+double variance_about(const double* x, std::size_t n, double mean) {
+  if (n == 0) return 0.0;
+
+  double lane[8];
+  const std::size_t n8 = n / 8 * 8;
+
+  const __m512d mv = _mm512_set1_pd(mean);
+  __m512d acc = _mm512_setzero_pd();
+  for (std::size_t i = 0; i < n8; i += 8) {
+    const __m512d d = _mm512_sub_pd(_mm512_loadu_pd(x + i), mv);
+    acc = _mm512_add_pd(acc, _mm512_mul_pd(d, d));
+  }
+  _mm512_storeu_pd(lane, acc);
+  for (std::size_t i = n8; i < n; ++i) lane[i % 8] += squared_dev(x[i], mean);
+  return fold_lanes(lane) / static_cast<double>(n);
+}
+
+// adds x[i] to lane[i % 8]
+void lane_sums(const double* x, std::size_t n, double (&lane)[8]) {
+  const std::size_t n8 = n / 8 * 8;
+  __m512d acc = _mm512_loadu_pd(lane);
+  for (std::size_t i = 0; i < n8; i += 8) acc = _mm512_add_pd(acc, _mm512_loadu_pd(x + i));
+  _mm512_storeu_pd(lane, acc);
+  for (std::size_t i = n8; i < n; ++i) lane[i % 8] += x[i];
+}
+
+MeanVar mean_var(const double* x, std::size_t n) {
+  if (n == 0) return {0.0, 0.0};
+
+  double lane[8] = {};
+  lane_sums(x, n, lane);
+  const double mean = fold_lanes(lane) / static_cast<double>(n);
+  return {mean, variance_about(x, n, mean)};
+}
+
+WinCount count_wins(const double* x, std::size_t n) {
+  WinCount c{0, 0};
+  const __m512d zero = _mm512_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m512d v = _mm512_loadu_pd(x + i);
+    c.wins += bit_count(static_cast<unsigned>(_mm512_cmp_pd_mask(v, zero, _CMP_GT_OQ)));
+    c.total += bit_count(static_cast<unsigned>(_mm512_cmp_pd_mask(v, v, _CMP_ORD_Q)));
+  }
+  count_wins_scalar(x, i, n, c);
+  return c;
+}
+
+// one sma_backtest chunk's share of max_drawdown, mean_var's sums and count_wins
+void pass_stats(const double* r, const double* equity, std::size_t n, PassStats& st) {
+  drawdown_run(equity, n, st.dd);
+  lane_sums(r, n, st.lane);
+  const WinCount c = count_wins(r, n);
+  st.wins.wins += c.wins;
+  st.wins.total += c.total;
+}
+
+template <std::size_t Fast, std::size_t Slow>
+BacktestPass sma_backtest_impl(const double* close, std::size_t n, std::size_t fw, std::size_t sw,
+                               double initial, double cost, double* strat_ret, double* equity) {
+  const auto signal = [&](CrossoverState& st, std::size_t first, std::size_t last, double* out,
+                          std::uint8_t* traded) {
+    sma_crossover_range<Fast, Slow>(close, first, last, fw, sw, cost, st, out, traded);
+  };
+  return sma_backtest_chunks(n - 1, initial, cost, strat_ret, equity, signal, pass_stats, variance_about);
+}
+
+BacktestPass sma_backtest(const double* close, std::size_t n, std::size_t fast, std::size_t slow,
+                          double initial, double cost, double* strat_ret, double* equity) {
+  return sma_backtest_impl<0, 0>(close, n, fast, slow, initial, cost, strat_ret, equity);
+}
+
+template <std::size_t Fast, std::size_t Slow>
+BacktestPass sma_backtest_fixed(const double* close, std::size_t n, double initial, double cost,
+                                double* strat_ret, double* equity) {
+  return sma_backtest_impl<Fast, Slow>(close, n, Fast, Slow, initial, cost, strat_ret, equity);
+}
+
+BacktestPass strategy_backtest(std::size_t m, double initial, double cost, StrategySignal signal, void* ctx,
+                               double* strat_ret, double* equity) {
+  const auto chunk = [&](CrossoverState&, std::size_t first, std::size_t last, double* out, std::uint8_t* traded) {
+    signal(ctx, first, last, out, traded);
+  };
+  return sma_backtest_chunks(m, initial, cost, strat_ret, equity, chunk, pass_stats, variance_about);
+}
+
+void cross_update(double* row, std::size_t n, const double* x, const double* y, std::size_t ld,
+                  const double* a, const double* c, std::size_t k) {
+  // two registers of the row stay loaded across all k terms
+  std::size_t j = 0;
+  for (; j + 16 <= n; j += 16) {
+    __m512d r0 = _mm512_loadu_pd(row + j);
+    __m512d r1 = _mm512_loadu_pd(row + j + 8);
+    for (std::size_t b = 0; b < k; ++b) {
+      const double* xb = x + b * ld + j;
+      const __m512d ab = _mm512_set1_pd(a[b]);
+      r0 = _mm512_add_pd(r0, _mm512_mul_pd(ab, _mm512_loadu_pd(xb)));
+      r1 = _mm512_add_pd(r1, _mm512_mul_pd(ab, _mm512_loadu_pd(xb + 8)));
+      if (y) {
+        const double* yb = y + b * ld + j;
+        const __m512d cb = _mm512_set1_pd(c[b]);
+        r0 = _mm512_sub_pd(r0, _mm512_mul_pd(cb, _mm512_loadu_pd(yb)));
+        r1 = _mm512_sub_pd(r1, _mm512_mul_pd(cb, _mm512_loadu_pd(yb + 8)));
+      }
+    }
+    _mm512_storeu_pd(row + j, r0);
+    _mm512_storeu_pd(row + j + 8, r1);
+  }
+  cross_update_scalar(row, j, n, x, y, ld, a, c, k);
+}
+
+// lane type for vec_math.hpp and vec_backtest.hpp
+struct Mask;
+
+struct Vec {
+  static constexpr std::size_t kLanes = 8;
+  __m512d v;
+
+  Vec() : v(_mm512_setzero_pd()) {}
+  Vec(__m512d x) : v(x) {}
+  Vec(double x) : v(_mm512_set1_pd(x)) {}
+
+  static Vec load(const double* p) { return _mm512_loadu_pd(p); }
+  void store(double* p) const { _mm512_storeu_pd(p, v); }
+  static Vec gather(const double* p, const std::int64_t* idx, Mask m);
+};
+
+struct Mask {
+  __mmask8 m;
+};
+
+inline Vec Vec::gather(const double* p, const std::int64_t* idx, Mask m) {
+  return _mm512_mask_i64gather_pd(_mm512_setzero_pd(), m.m, _mm512_loadu_si512(idx), p, 8);
+}
+
+inline Vec operator+(Vec a, Vec b) { return _mm512_add_pd(a.v, b.v); }
+inline Vec operator-(Vec a, Vec b) { return _mm512_sub_pd(a.v, b.v); }
+inline Vec operator*(Vec a, Vec b) { return _mm512_mul_pd(a.v, b.v); }
+inline Vec operator/(Vec a, Vec b) { return _mm512_div_pd(a.v, b.v); }
+inline Vec operator-(Vec a) { return _mm512_xor_pd(a.v, _mm512_set1_pd(-0.0)); }
+
+inline Mask less(Vec a, Vec b) { return {_mm512_cmp_pd_mask(a.v, b.v, _CMP_LT_OQ)}; }
+inline Mask greater(Vec a, Vec b) { return {_mm512_cmp_pd_mask(a.v, b.v, _CMP_GT_OQ)}; }
+inline Vec select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_pd(m.m, b.v, a.v); }
+inline Mask at_least(Vec a, Vec b) { return {_mm512_cmp_pd_mask(a.v, b.v, _CMP_GE_OQ)}; }
+inline Mask ordered(Vec a, Vec b) { return {_mm512_cmp_pd_mask(a.v, b.v, _CMP_ORD_Q)}; }
+inline Mask differ(Vec a, Vec b) { return {_mm512_cmp_pd_mask(a.v, b.v, _CMP_NEQ_OQ)}; }
+inline bool any(Mask m) { return m.m != 0; }
+
+inline Vec vsqrt(Vec a) { return _mm512_sqrt_pd(a.v); }
+inline Vec vfloor(Vec a) { return _mm512_roundscale_pd(a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+inline Vec vabs(Vec a) { return _mm512_abs_pd(a.v); }
+
+inline Vec pow2(Vec n) {
+  return _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_add_epi64(_mm512_cvtpd_epi64(n.v), _mm512_set1_epi64(1023)), 52));
+}
+
+inline Vec split_exponent(Vec x, Vec& e) {
+  const __m512i bits = _mm512_castpd_si512(x.v);
+  e = _mm512_sub_pd(_mm512_cvtepi64_pd(_mm512_srli_epi64(bits, 52)), _mm512_set1_pd(1022.0));
+  const __m512i mantissa = _mm512_and_si512(bits, _mm512_set1_epi64(0x000FFFFFFFFFFFFF));
+  return _mm512_castsi512_pd(_mm512_or_si512(mantissa, _mm512_set1_epi64(0x3FE0000000000000)));
+}
+
+void black_scholes(const double* S, const double* K, const double* r, const double* sigma,
+                   const double* T, std::size_t n, double* call, double* put) {
+  vmath::black_scholes_batch<Vec>(S, K, r, sigma, T, n, call, put);
+}
+
+void sma_backtest_batch(const double* close, std::size_t n, const std::size_t* fast, const std::size_t* slow,
+                        std::size_t lanes, double initial, double cost, BacktestPass* out) {
+  vbacktest::sma_backtest_batch<Vec>(close, n, fast, slow, lanes, initial, cost, out);
+}
+
+template <std::size_t... W, std::size_t... P>
+constexpr FixedKernels fixed_kernels(std::index_sequence<W...>, std::index_sequence<P...>) {
+  return {{&rolling_mean_fixed<kFixedWindows[W]>...},
+          {&sma_backtest_fixed<kFixedPairs[P].fast, kFixedPairs[P].slow>...}};
+}
+
+} // namespace
+
+const KernelTable kTable = {
+  Isa::Avx512,
+  returns,
+  rolling_mean,
+  crossover_returns,
+  max_drawdown,
+  mean_var,
+  count_wins,
+  black_scholes,
+  cross_update,
+  sma_backtest,
+  sma_backtest_batch,
+  strategy_backtest,
+  fixed_kernels(std::make_index_sequence<std::size(kFixedWindows)>{},
+                std::make_index_sequence<std::size(kFixedPairs)>{}),
+};
+
+} // namespace qe::kernels::avx512
@@ -0,0 +1,242 @@
+#pragma once
+
+// Scalar definitions shared by the kernel variants: the scalar table is built from them and
+// the vector loops reproduce them exactly (and use them for heads and tails). Included by
+// kernels_*.cpp only; everything here has internal linkage (see kernels.hpp).
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "kernels.hpp"
+
+namespace qe::kernels {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+constexpr double kNegInf = -std::numeric_limits<double>::infinity();
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+inline bool is_nan(double x) {
+  return x != x;
+}
+
+inline double max_of(double a, double b) {
+  return a < b ? b : a;
+}
+
+inline std::size_t bit_count(unsigned m) {
+  std::size_t c = 0;
+  for (; m != 0; m &= m - 1) ++c;
+  return c;
+}
+
+inline double return_at(const double* close, std::size_t j) {
+  const double prev = close[j];
+  return prev == 0.0 ? kNaN : (close[j + 1] - prev) / prev;
+}
+
+// rolling sums for i in [first, n), first % 4 == 0 or continuing the block in `block`
+inline void rolling_mean_scalar(const double* v, std::size_t first, std::size_t n, std::size_t w,
+                                double& carry, double (&block)[4], double* out) {
+  const double wd = static_cast<double>(w);
+  for (std::size_t i = first; i < n; ++i) {
+    const double d = i >= w ? v[i] - v[i - w] : v[i] - 0.0;
+    const double s = rolling_sum_step(carry, block, i % 4, d);
+    if (i + 1 >= w) out[i] = s / wd;
+  }
+}
+
+// one bar of the signal: the position follows fast > slow where both are defined and is held
+// otherwise; a change of position is a trade (traded = 1), which takes cost off that return
+inline int signal_step(double f, double s, double r, int pos, double cost, double& out,
+                       std::uint8_t& traded) {
+  const int next = (!is_nan(f) && !is_nan(s)) ? ((f > s) ? 1 : 0) : pos;
+  const double x = static_cast<double>(next) * r;
+  traded = next != pos ? 1 : 0;
+  out = next != pos ? x - cost : x;
+  return next;
+}
+
+// crossover_returns over [first, n)
+inline int crossover_scalar(const double* fast, const double* slow, const double* r,
+                            std::size_t first, std::size_t n, int pos, double cost, double* out,
+                            std::uint8_t* traded) {
+  for (std::size_t i = first; i < n; ++i) {
+    pos = signal_step(fast[i], slow[i], r[i], pos, cost, out[i], traded[i]);
+  }
+  return pos;
+}
+
+// trades within one register of `lanes` positions (bit k of up = position at lane k), pos the
+// position before lane 0: bit k is set where lane k differs from the lane before it
+inline unsigned trade_bits(unsigned up, unsigned lanes, int pos) {
+  const unsigned all = (1u << lanes) - 1;
+  return (up ^ ((up << 1) | static_cast<unsigned>(pos))) & all;
+}
+
+inline void store_flags(std::uint8_t* traded, unsigned bits, unsigned lanes) {
+  for (unsigned k = 0; k < lanes; ++k) traded[k] = static_cast<std::uint8_t>((bits >> k) & 1u);
+}
+
+// running state of the fused SMA crossover signal: both window sums as rolling_mean_scalar
+// keeps them, and the position
+struct CrossoverState {
+  double fast_carry = 0.0;
+  double fast_block[4] = {};
+  double slow_carry = 0.0;
+  double slow_block[4] = {};
+  int pos = 0;
+};
+
+// the fused signal (fast window fw, slow window sw) for return indices [first, m), m = closes
+// - 1, into out[i - first] and traded[i - first]; first % 4 == 0 or continuing the blocks in st
+inline void sma_crossover_scalar(const double* close, std::size_t first, std::size_t m, std::size_t fw,
+                                 std::size_t sw, double cost, CrossoverState& st, double* out,
+                                 std::uint8_t* traded) {
+  const double* v = close + 1;
+  const double fd = static_cast<double>(fw);
+  const double sd = static_cast<double>(sw);
+  for (std::size_t i = first; i < m; ++i) {
+    const double df = i >= fw ? v[i] - v[i - fw] : v[i] - 0.0;
+    const double ds = i >= sw ? v[i] - v[i - sw] : v[i] - 0.0;
+    const double sum_f = rolling_sum_step(st.fast_carry, st.fast_block, i % 4, df);
+    const double sum_s = rolling_sum_step(st.slow_carry, st.slow_block, i % 4, ds);
+    const double f = i + 1 >= fw ? sum_f / fd : kNaN;
+    const double s = i + 1 >= sw ? sum_s / sd : kNaN;
+    st.pos = signal_step(f, s, return_at(close, i), st.pos, cost, out[i - first], traded[i - first]);
+  }
+}
+
+// cross_update for columns [first, n)
+inline void cross_update_scalar(double* row, std::size_t first, std::size_t n, const double* x,
+                                const double* y, std::size_t ld, const double* a, const double* c,
+                                std::size_t k) {
+  for (std::size_t j = first; j < n; ++j) {
+    double r = row[j];
+    for (std::size_t b = 0; b < k; ++b) {
+      r = r + a[b] * x[b * ld + j];
+      if (y) r = r - c[b] * y[b * ld + j];
+    }
+    row[j] = r;
+  }
+}
+
+// peak and drawdown running state of max_drawdown
+struct Drawdown {
+  double peak;
+  double max_dd;
+
+  void step(double v) {
+    peak = max_of(peak, v);
+    if (peak > 0.0) max_dd = max_of(max_dd, (peak - v) / peak);
+  }
+};
+
+// sums are kept in 8 lanes (lane i % 8) and folded as ((l0+l4)+(l2+l6)) + ((l1+l5)+(l3+l7))
+inline double fold_lanes(const double (&lane)[8]) {
+  const double t0 = lane[0] + lane[4];
+  const double t1 = lane[1] + lane[5];
+  const double t2 = lane[2] + lane[6];
+  const double t3 = lane[3] + lane[7];
+  return (t0 + t2) + (t1 + t3);
+}
+
+// sma_backtest's serial half: compounds the equity step by step, charging each trade on the
+// equity before it
+struct EquityPass {
+  double eq;
+  double cost;
+  std::size_t trades = 0;
+  double total_cost = 0.0;
+
+  EquityPass(double initial, double cost_) : eq(initial), cost(cost_) {}
+
+  void run(const double* r, const std::uint8_t* traded, std::size_t len, double* equity) {
+    for (std::size_t k = 0; k < len; ++k) {
+      if (traded[k]) {
+        ++trades;
+        total_cost += eq * cost;
+      }
+      eq *= (1.0 + r[k]);
+      equity[k] = eq;
+    }
+  }
+};
+
+// sma_backtest's running reductions: the max_drawdown state (started at equity[0]),
+// mean_var's lane sums and count_wins' counts
+struct PassStats {
+  Drawdown dd{0.0, 0.0};
+  bool dd_valid = false;  // max_drawdown is 0 when equity[0] is NaN
+  double lane[8] = {};
+  WinCount wins{0, 0};
+};
+
+inline double squared_dev(double x, double mean) {
+  const double d = x - mean;
+  return d * d;
+}
+
+// sma_backtest over m = n - 1 steps in chunks of kPassChunk: signal(st, first, last, out,
+// traded) writes the chunk's strategy returns and trade flags (out[0] is step first) carrying
+// st across calls, EquityPass compounds them, and stats(out, equity, len, PassStats&) folds
+// the chunk into the reductions while it is still in L1. Chunks start at multiples of 8, so
+// the vector loops stay on the canonical blocks and lanes. With strat_ret the variance comes
+// from variance(strat_ret, m, mean); without it (metrics only, the series go to stack
+// buffers) a second run of the signal feeds the squared deviations to the same lanes.
+// strategy_backtest drives it with a signal that ignores st.
+constexpr std::size_t kPassChunk = 512;
+
+template <class Signal, class Stats, class Variance>
+BacktestPass sma_backtest_chunks(std::size_t m, double initial, double cost, double* strat_ret, double* equity,
+                                 Signal&& signal, Stats&& stats, Variance&& variance) {
+  double rbuf[kPassChunk];
+  double ebuf[kPassChunk];
+  std::uint8_t traded[kPassChunk];
+  EquityPass pass(initial, cost);
+  PassStats acc;
+  CrossoverState st;
+  for (std::size_t first = 0; first < m; first += kPassChunk) {
+    const std::size_t last = m - first < kPassChunk ? m : first + kPassChunk;
+    double* out = strat_ret ? strat_ret + first : rbuf;
+    double* eq = equity ? equity + first : ebuf;
+    signal(st, first, last, out, traded);
+    pass.run(out, traded, last - first, eq);
+    if (first == 0) {
+      acc.dd = {eq[0], 0.0};
+      acc.dd_valid = !is_nan(eq[0]);
+    }
+    stats(out, eq, last - first, acc);
+  }
+
+  const double steps = static_cast<double>(m);
+  BacktestPass res{pass.eq, acc.dd_valid ? acc.dd.max_dd : 0.0, fold_lanes(acc.lane) / steps, 0.0,
+                   acc.wins, pass.trades, pass.total_cost};
+  if (strat_ret) {
+    res.var = variance(strat_ret, m, res.mean);
+    return res;
+  }
+  CrossoverState again;
+  double sq[8] = {};
+  for (std::size_t first = 0; first < m; first += kPassChunk) {
+    const std::size_t last = m - first < kPassChunk ? m : first + kPassChunk;
+    signal(again, first, last, rbuf, traded);
+    for (std::size_t k = 0; k < last - first; ++k) sq[k % 8] += squared_dev(rbuf[k], res.mean);
+  }
+  res.var = fold_lanes(sq) / steps;
+  return res;
+}
+
+inline void count_wins_scalar(const double* x, std::size_t first, std::size_t n, WinCount& c) {
+  for (std::size_t i = first; i < n; ++i) {
+    if (is_nan(x[i])) continue;
+    ++c.total;
+    if (x[i] > 0.0) ++c.wins;
+  }
+}
+
+} // namespace
+
+} // namespace qe::kernels
@@ -0,0 +1,185 @@
+// Portable kernel variant; the reference the vector variants reproduce.
+
+#include "kernels_common.hpp"
+
+#include <cmath>
+#include <utility>
+
+#include "vec_backtest.hpp"
+
+namespace qe::kernels::scalar {
+
+namespace {
+
+void returns(const double* close, std::size_t n, double* out) {
+  for (std::size_t j = 0; j + 1 < n; ++j) out[j] = return_at(close, j);
+}
+
+void rolling_mean(const double* v, std::size_t n, std::size_t w, double* out) {
+  double carry = 0.0;
+  double block[4] = {};
+  rolling_mean_scalar(v, 0, n, w, carry, block, out);
+}
+
+template <std::size_t W>
+void rolling_mean_fixed(const double* v, std::size_t n, double* out) {
+  rolling_mean(v, n, W, out);
+}
+
+int crossover_returns(const double* fast, const double* slow, const double* r, std::size_t n,
+                      int pos, double cost, double* out, std::uint8_t* traded) {
+  return crossover_scalar(fast, slow, r, 0, n, pos, cost, out, traded);
+}
+
+void drawdown_run(const double* equity, std::size_t n, Drawdown& st) {
+  for (std::size_t i = 0; i < n; ++i) st.step(equity[i]);
+}
+
+double max_drawdown(const double* equity, std::size_t n) {
+  if (n == 0 || is_nan(equity[0])) return 0.0;
+  Drawdown st{equity[0], 0.0};
+  drawdown_run(equity, n, st);
+  return st.max_dd;
+}
+
+double variance_about(const double* x, std::size_t n, double mean) {
+  if (n == 0) return 0.0;
+  double sq[8] = {};
+  for (std::size_t i = 0; i < n; ++i) sq[i % 8] += squared_dev(x[i], mean);
+  return fold_lanes(sq) / static_cast<double>(n);
+}
+
+// adds x[i] to lane[i % 8]
+void lane_sums(const double* x, std::size_t n, double (&lane)[8]) {
+  for (std::size_t i = 0; i < n; ++i) lane[i % 8] += x[i];
+}
+
+MeanVar mean_var(const double* x, std::size_t n) {
+  if (n == 0) return {0.0, 0.0};
+
+  double lane[8] = {};
+  lane_sums(x, n, lane);
+  const double mean = fold_lanes(lane) / static_cast<double>(n);
+  return {mean, variance_about(x, n, mean)};
+}
+
+WinCount count_wins(const double* x, std::size_t n) {
+  WinCount c{0, 0};
+  count_wins_scalar(x, 0, n, c);
+  return c;
+}
+
+// one sma_backtest chunk's share of max_drawdown, mean_var's sums and count_wins
+void pass_stats(const double* r, const double* equity, std::size_t n, PassStats& st) {
+  drawdown_run(equity, n, st.dd);
+  lane_sums(r, n, st.lane);
+  count_wins_scalar(r, 0, n, st.wins);
+}
+
+double norm_cdf(double x) {
+  return 0.5 * std::erfc(-x / std::sqrt(2.0));
+}
+
+// the same expressions as black_scholes_call / black_scholes_put in options.cpp
+void black_scholes(const double* S, const double* K, const double* r, const double* sigma,
+                   const double* T, std::size_t n, double* call, double* put) {
+  for (std::size_t i = 0; i < n; ++i) {
+    const double vol_sqrt_t = sigma[i] * std::sqrt(T[i]);
+    const double d1 = (std::log(S[i] / K[i]) + (r[i] + 0.5 * sigma[i] * sigma[i]) * T[i]) / vol_sqrt_t;
+    const double d2 = d1 - sigma[i] * std::sqrt(T[i]);
+    const double disc_k = K[i] * std::exp(-r[i] * T[i]);
+    call[i] = S[i] * norm_cdf(d1) - disc_k * norm_cdf(d2);
+    put[i] = disc_k * norm_cdf(-d2) - S[i] * norm_cdf(-d1);
+  }
+}
+
+void cross_update(double* row, std::size_t n, const double* x, const double* y, std::size_t ld,
+                  const double* a, const double* c, std::size_t k) {
+  cross_update_scalar(row, 0, n, x, y, ld, a, c, k);
+}
+
+BacktestPass sma_backtest(const double* close, std::size_t n, std::size_t fast, std::size_t slow,
+                          double initial, double cost, double* strat_ret, double* equity) {
+  const auto signal = [&](CrossoverState& st, std::size_t first, std::size_t last, double* out,
+                          std::uint8_t* traded) {
+    sma_crossover_scalar(close, first, last, fast, slow, cost, st, out, traded);
+  };
+  return sma_backtest_chunks(n - 1, initial, cost, strat_ret, equity, signal, pass_stats, variance_about);
+}
+
+BacktestPass strategy_backtest(std::size_t m, double initial, double cost, StrategySignal signal, void* ctx,
+                               double* strat_ret, double* equity) {
+  const auto chunk = [&](CrossoverState&, std::size_t first, std::size_t last, double* out, std::uint8_t* traded) {
+    signal(ctx, first, last, out, traded);
+  };
+  return sma_backtest_chunks(m, initial, cost, strat_ret, equity, chunk, pass_stats, variance_about);
+}
+
+// one-lane type for vec_backtest.hpp, so the batch takes the pairs one after another
+struct Mask {
+  bool m;
+};
+
+struct Vec {
+  static constexpr std::size_t kLanes = 1;
+  double v;
+
+  Vec() : v(0.0) {}
+  Vec(double x) : v(x) {}
+
+  static Vec load(const double* p) { return p[0]; }
+  void store(double* p) const { p[0] = v; }
+  static Vec gather(const double* p, const std::int64_t* idx, Mask m) { return m.m ? p[idx[0]] : 0.0; }
+};
+
+inline Vec operator+(Vec a, Vec b) { return a.v + b.v; }
+inline Vec operator-(Vec a, Vec b) { return a.v - b.v; }
+inline Vec operator*(Vec a, Vec b) { return a.v * b.v; }
+inline Vec operator/(Vec a, Vec b) { return a.v / b.v; }
+
+inline Mask less(Vec a, Vec b) { return {a.v < b.v}; }
+inline Mask greater(Vec a, Vec b) { return {a.v > b.v}; }
+inline Mask at_least(Vec a, Vec b) { return {a.v >= b.v}; }
+inline Mask ordered(Vec a, Vec b) { return {!is_nan(a.v) && !is_nan(b.v)}; }
+inline Mask differ(Vec a, Vec b) { return {a.v != b.v}; }
+inline bool any(Mask m) { return m.m; }
+inline Vec select(Mask m, Vec a, Vec b) { return m.m ? a : b; }
+inline Vec vabs(Vec a) { return a.v < 0.0 ? -a.v : a.v; }
+
+void sma_backtest_batch(const double* close, std::size_t n, const std::size_t* fast, const std::size_t* slow,
+                        std::size_t lanes, double initial, double cost, BacktestPass* out) {
+  vbacktest::sma_backtest_batch<Vec>(close, n, fast, slow, lanes, initial, cost, out);
+}
+
+template <std::size_t Fast, std::size_t Slow>
+BacktestPass sma_backtest_fixed(const double* close, std::size_t n, double initial, double cost,
+                                double* strat_ret, double* equity) {
+  return sma_backtest(close, n, Fast, Slow, initial, cost, strat_ret, equity);
+}
+
+template <std::size_t... W, std::size_t... P>
+constexpr FixedKernels fixed_kernels(std::index_sequence<W...>, std::index_sequence<P...>) {
+  return {{&rolling_mean_fixed<kFixedWindows[W]>...},
+          {&sma_backtest_fixed<kFixedPairs[P].fast, kFixedPairs[P].slow>...}};
+}
+
+} // namespace
+
+const KernelTable kTable = {
+  Isa::Scalar,
+  returns,
+  rolling_mean,
+  crossover_returns,
+  max_drawdown,
+  mean_var,
+  count_wins,
+  black_scholes,
+  cross_update,
+  sma_backtest,
+  sma_backtest_batch,
+  strategy_backtest,
+  fixed_kernels(std::make_index_sequence<std::size(kFixedWindows)>{},
+                std::make_index_sequence<std::size(kFixedPairs)>{}),
+};
+
+} // namespace qe::kernels::scalar
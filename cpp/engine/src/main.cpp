@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <cstdlib>   // std::getenv
@@ -7,8 +8,11 @@
 #include <fstream>
 #include <iostream>
 #include <optional>
+#include <span>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <system_error>
 #include <vector>
 
@@ -23,12 +27,22 @@
 #include <boost/json.hpp>
 
 #include "qe/backtest.hpp"
+#include "qe/bar_stream.hpp"
 #include "qe/config.hpp"
-#include "qe/csv_reader.hpp"
+#include "qe/dataset.hpp"
+#include "qe/dispatch.hpp"
 #include "qe/equity_io.hpp"
+#include "qe/indicator_cache.hpp"
 #include "qe/indicators.hpp"
+#include "qe/multi_dataset.hpp"
 #include "qe/options.hpp"
+#include "qe/qec.hpp"
 #include "qe/report.hpp"
+#include "qe/resample.hpp"
+#include "qe/strategy.hpp"
+#include "qe/streaming.hpp"
+#include "qe/sweep.hpp"
+#include "qe/timestamp.hpp"
 #include "qe/version.hpp"
 
 namespace json = boost::json;
@@ -37,14 +51,35 @@ static void print_usage() {
   std::cout << "qe_cli\n";
   std::cout << "Usage:\n";
   std::cout << "  qe_cli --version\n";
-  std::cout << "  qe_cli run --data <csv_path>\n";
-  std::cout << "  qe_cli indicators --data <csv_path> [--window N]\n";
-  std::cout << "  qe_cli backtest --data <csv_path> "
-               "[--config cfg.json] "
+  std::cout << "  qe_cli run --data <path> [--threads N] [--resample <interval>]\n";
+  std::cout << "  qe_cli indicators --data <path> [--window N] [--threads N] [--resample <interval>]\n";
+  std::cout << "  qe_cli backtest --data <path> [--threads N] [--resample <interval>] [--symbol <name>] "
+               "[--config cfg.json] [--strategy <name>] "
                "[--fast N] [--slow N] [--initial X] "
                "[--fee-bps N] [--slip-bps N] "
-               "[--out <dir>]\n";
+               "[--out <dir>] [--start <ts>] [--end <ts>] "
+               "[--stream [--batch-rows N] [--max-mem-mb N]]\n";
+  std::cout << "  qe_cli sweep --data <path> --fast lo:hi[:step] --slow lo:hi[:step] [--workers N] [--threads N] "
+               "[--resample <interval>] [--config cfg.json] [--strategy <name>] [--initial X] [--fee-bps N] "
+               "[--slip-bps N] [--out <dir>] [--top N] [--cache-mb N] [--cache-stats]\n";
   std::cout << "  qe_cli options --S <spot> --K <strike> --r <rate> --sigma <vol> --T <years>\n";
+  std::cout << "  qe_cli convert --data <csv_path> --out <qec_path> [--threads N] [--compress]\n";
+  std::cout << "\n";
+  std::cout << "--data accepts an OHLCV CSV or a .qec file (detected by magic bytes)\n";
+  std::cout << "--threads N parses CSV input on N threads (0 = all cores)\n";
+  std::cout << "--start/--end select bars with start <= ts < end (e.g. 2023-01-01); CSV input\n"
+               "  gets a sparse <path>.qei index on first use so later ranges seek instead of parsing\n";
+  std::cout << "--data may also be a directory of per-symbol files or a CSV with a symbol column;\n"
+               "  backtest then runs every symbol (or just --symbol) in one process\n";
+  std::cout << "--resample 5m|1h|1d aggregates the input into UTC-aligned bars before use\n";
+  std::cout << "--strategy sma_crossover|breakout overrides the config's strategy (default sma_crossover);\n"
+               "  both take the --fast/--slow windows (breakout: exit and entry channel lengths)\n";
+  std::cout << "--stream runs the backtest in bounded memory, reading --batch-rows bars at a time\n";
+  std::cout << "sweep runs every (fast, slow) of the grid with fast < slow over one load of the data, on\n"
+               "  --workers N threads (0 = all cores, the default), and writes <out>/sweep.csv\n";
+  std::cout << "--cache-mb N caps the indicator cache a sweep's pairs share (default 256): a strategy\n"
+               "  without SIMD batching (breakout) computes each window's series once for the grid;\n"
+               "  --cache-stats prints its hit rate and bytes held at the end\n";
   std::cout << "\n";
   std::cout << "Optional env:\n";
   std::cout << "  QE_API_URL=http://localhost:8787   (default)\n";
@@ -188,13 +223,7 @@ static void api_record_run_only(
   std::cout << "[api] recorded run_id=" << std::string(idv->as_string()) << "\n";
 }
 
-static void api_record_backtest_success(
-    const std::string& api_base,
-    const std::string& data_ref,
-    const std::string& out_dir,
-    const qe::BacktestConfig& cfg,
-    const qe::BacktestResult& r
-) {
+static json::object backtest_args(const qe::BacktestConfig& cfg) {
   json::object args;
   args["strategy"] = cfg.strategy;
   args["fast"] = static_cast<std::int64_t>(cfg.fast);
@@ -202,6 +231,19 @@ static void api_record_backtest_success(
   args["initial"] = cfg.initial;
   args["fee_bps"] = cfg.fee_bps;
   args["slippage_bps"] = cfg.slippage_bps;
+  return args;
+}
+
+static void api_record_backtest_success(
+    const std::string& api_base,
+    const std::string& data_ref,
+    const std::string& out_dir,
+    const qe::BacktestConfig& cfg,
+    const qe::BacktestResult& r,
+    double win_rate,
+    double final_equity
+) {
+  const json::object args = backtest_args(cfg);
 
   json::object run_body;
   run_body["engine_version"] = qe::version();
@@ -247,10 +289,10 @@ static void api_record_backtest_success(
   metrics["total_return"] = r.total_return;
   metrics["sharpe"] = r.sharpe;
   metrics["max_drawdown"] = r.max_drawdown;
-  metrics["win_rate"] = qe::compute_win_rate(r.strat_ret);
+  metrics["win_rate"] = win_rate;
   metrics["n_trades"] = static_cast<std::int64_t>(r.n_trades);
   metrics["total_cost"] = r.total_cost;
-  metrics["final_equity"] = r.equity.empty() ? 0.0 : r.equity.back();
+  metrics["final_equity"] = final_equity;
 
   const auto metrics_path = make_temp_json_path("qe_metrics");
   if (!write_text_file(metrics_path, json::serialize(metrics))) {
@@ -277,13 +319,7 @@ static void api_record_backtest_failure(
     const qe::BacktestConfig& cfg,
     const std::string& error_msg
 ) {
-  json::object args;
-  args["strategy"] = cfg.strategy;
-  args["fast"] = static_cast<std::int64_t>(cfg.fast);
-  args["slow"] = static_cast<std::int64_t>(cfg.slow);
-  args["initial"] = cfg.initial;
-  args["fee_bps"] = cfg.fee_bps;
-  args["slippage_bps"] = cfg.slippage_bps;
+  const json::object args = backtest_args(cfg);
 
   api_record_run_only(
     api_base,
@@ -297,12 +333,92 @@ static void api_record_backtest_failure(
   );
 }
 
+static void print_cache_stats(const qe::IndicatorCache& cache) {
+  const qe::IndicatorCacheStats s = cache.stats();
+  std::cout << "cache: hits=" << s.hits
+            << " misses=" << s.misses
+            << " hit_rate=" << s.hit_rate()
+            << " entries=" << s.entries
+            << " bytes=" << s.bytes
+            << " limit=" << s.max_bytes
+            << " evictions=" << s.evictions << "\n";
+}
+
+// one backtest per symbol of a multi-symbol source, in a single process; returns how many
+// symbols had enough bars to run
+static std::size_t run_universe_backtest(
+    const std::string& data_path,
+    const qe::DatasetOptions& load_opts,
+    const qe::BacktestConfig& cfg,
+    const qe::StrategyKernels& strategy,
+    std::optional<std::int64_t> resample_ns,
+    const std::string& out_dir
+) {
+  const qe::MultiDataset universe = qe::load_multi_dataset(data_path, load_opts);
+  std::cout << "universe: " << universe.symbol_count() << " symbols, "
+            << universe.size() << " bars\n";
+
+  std::ofstream summary;
+  std::string path;
+  if (!out_dir.empty()) {
+    path = (std::filesystem::path(out_dir) / "universe.csv").string();
+    summary.open(path, std::ios::binary);
+    if (!summary) {
+      throw std::runtime_error("failed to open file for writing: " + path);
+    }
+    summary << "symbol,bars,total_return,sharpe,max_drawdown,win_rate\n";
+  }
+
+  const qe::BacktestCosts costs{ cfg.fee_bps, cfg.slippage_bps };
+  std::size_t ran = 0;
+  for (qe::SymbolId id = 0; id < universe.symbol_count(); ++id) {
+    const std::string& name = universe.symbols().name(id);
+
+    qe::OhlcvColumns resampled;
+    std::span<const double> close = universe.slice(id).close;
+    if (resample_ns) {
+      resampled = qe::resample(universe.slice(id), *resample_ns);
+      close = resampled.close;
+    }
+
+    if (close.size() < cfg.slow + 1) {
+      std::cout << name << ": skipped (" << close.size() << " bars)\n";
+      continue;
+    }
+
+    const qe::WindowPair windows{cfg.fast, cfg.slow};
+    // only the metrics are reported, so no per-symbol series are allocated
+    const qe::BacktestResult r =
+      qe::run_backtest(strategy, close, windows, cfg.initial, costs, qe::BacktestOutput::MetricsOnly);
+    ++ran;
+    std::cout << name
+              << ": total_return=" << r.total_return
+              << " sharpe=" << r.sharpe
+              << " max_drawdown=" << r.max_drawdown
+              << " win_rate=" << r.win_rate << "\n";
+    if (summary.is_open()) {
+      summary << name << "," << close.size() << "," << r.total_return << "," << r.sharpe << ","
+              << r.max_drawdown << "," << r.win_rate << "\n";
+    }
+  }
+
+  if (summary.is_open()) {
+    summary.close();
+    if (!summary) {
+      throw std::runtime_error("failed to write " + path);
+    }
+    std::cout << "wrote " << path << "\n";
+  }
+  return ran;
+}
+
 int main(int argc, char** argv) {
   if (argc >= 2) {
     std::string cmd = argv[1];
 
     if (cmd == "--version" || cmd == "-v") {
       std::cout << "qe_cli version " << qe::version() << "\n";
+      std::cout << "kernels: " << qe::isa_name(qe::active_isa()) << "\n";
       return 0;
     }
 
@@ -310,22 +426,33 @@ int main(int argc, char** argv) {
 
     if (cmd == "run") {
       std::string data_path;
+      qe::DatasetOptions load_opts;
+      std::string resample_text;
 
       for (int i = 2; i < argc; ++i) {
-        if (std::string(argv[i]) == "--data" && i + 1 < argc) {
+        std::string arg = argv[i];
+        if (arg == "--data" && i + 1 < argc) {
           data_path = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+          load_opts.threads = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--resample" && i + 1 < argc) {
+          resample_text = argv[++i];
         }
       }
 
       if (data_path.empty()) {
-        std::cerr << "Error: --data <csv_path> is required\n";
+        std::cerr << "Error: --data <path> is required\n";
         return 1;
       }
 
       try {
-        qe::OhlcvTable table = qe::read_ohlcv_csv(data_path);
+        qe::Dataset table = qe::load_dataset(data_path, load_opts);
         std::cout << "Loaded " << table.size()
                   << " rows from " << data_path << "\n";
+        if (!resample_text.empty()) {
+          table = qe::Dataset(qe::resample(table.view(), qe::parse_bar_interval(resample_text)));
+          std::cout << "Resampled to " << table.size() << " " << resample_text << " bars\n";
+        }
       } catch (const std::exception& ex) {
         std::cerr << "Error: " << ex.what() << "\n";
         return 1;
@@ -337,6 +464,8 @@ int main(int argc, char** argv) {
     if (cmd == "indicators") {
       std::string data_path;
       std::size_t window = 5;
+      qe::DatasetOptions load_opts;
+      std::string resample_text;
 
       for (int i = 2; i < argc; ++i) {
         std::string arg = argv[i];
@@ -344,18 +473,27 @@ int main(int argc, char** argv) {
           data_path = argv[++i];
         } else if (arg == "--window" && i + 1 < argc) {
           window = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+          load_opts.threads = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--resample" && i + 1 < argc) {
+          resample_text = argv[++i];
         }
       }
 
       if (data_path.empty()) {
-        std::cerr << "Error: --data <csv_path> is required\n";
+        std::cerr << "Error: --data <path> is required\n";
         return 1;
       }
 
       try {
-        qe::OhlcvTable table = qe::read_ohlcv_csv(data_path);
+        // returns and rolling stats read close only; resampling needs every field
+        load_opts.columns = resample_text.empty() ? qe::Columns::Close : qe::Columns::All;
+        qe::Dataset table = qe::load_dataset(data_path, load_opts);
+        if (!resample_text.empty()) {
+          table = qe::Dataset(qe::resample(table.view(), qe::parse_bar_interval(resample_text)));
+        }
 
-        std::vector<double> returns = qe::compute_returns(table);
+        std::vector<double> returns = qe::compute_returns(table.view().close);
         std::vector<double> mean = qe::rolling_mean(returns, window);
         std::vector<double> stddev = qe::rolling_std(returns, window);
 
@@ -477,16 +615,221 @@ int main(int argc, char** argv) {
       return 0;
     }
 
+    if (cmd == "convert") {
+      std::string data_path;
+      std::string out_path;
+      qe::DatasetOptions load_opts;
+      qe::QecWriteOptions write_opts;
+
+      for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--data" && i + 1 < argc) {
+          data_path = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+          out_path = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+          load_opts.threads = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--compress") {
+          write_opts.compress = true;
+        }
+      }
+
+      if (data_path.empty() || out_path.empty()) {
+        std::cerr << "Error: convert requires --data <csv_path> --out <qec_path>\n";
+        return 1;
+      }
+
+      try {
+        qe::Dataset table = qe::load_dataset(data_path, load_opts);
+        qe::write_qec(out_path, table.view(), write_opts);
+
+        // read back with the payload checksum so a bad write fails here, not at first use
+        qe::Dataset check = qe::load_dataset(out_path, {.verify_checksum = true});
+        if (check.size() != table.size()) {
+          throw std::runtime_error("qec: row count mismatch after write");
+        }
+
+        std::cout << "converted " << table.size() << " rows from " << data_path
+                  << " to " << out_path << " (" << std::filesystem::file_size(out_path) << " bytes"
+                  << (write_opts.compress ? ", compressed" : "") << ")\n";
+      } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+      }
+
+      return 0;
+    }
+
+    if (cmd == "sweep") {
+      std::string data_path;
+      std::string config_path;
+      std::string out_dir;
+      std::string fast_text;
+      std::string slow_text;
+      std::string resample_text;
+      qe::DatasetOptions load_opts;
+      qe::SweepOptions sweep_opts;
+      std::optional<double> initial_override;
+      std::optional<double> fee_override;
+      std::optional<double> slip_override;
+      std::optional<std::string> strategy_override;
+      std::size_t top = 5;
+      std::size_t cache_mb = 256;
+      bool cache_stats = false;
+
+      for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--data" && i + 1 < argc) {
+          data_path = argv[++i];
+        } else if (arg == "--config" && i + 1 < argc) {
+          config_path = argv[++i];
+        } else if (arg == "--fast" && i + 1 < argc) {
+          fast_text = argv[++i];
+        } else if (arg == "--slow" && i + 1 < argc) {
+          slow_text = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+          sweep_opts.threads = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+          load_opts.threads = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--resample" && i + 1 < argc) {
+          resample_text = argv[++i];
+        } else if (arg == "--initial" && i + 1 < argc) {
+          initial_override = std::stod(argv[++i]);
+        } else if (arg == "--fee-bps" && i + 1 < argc) {
+          fee_override = std::stod(argv[++i]);
+        } else if (arg == "--slip-bps" && i + 1 < argc) {
+          slip_override = std::stod(argv[++i]);
+        } else if (arg == "--out" && i + 1 < argc) {
+          out_dir = argv[++i];
+        } else if (arg == "--strategy" && i + 1 < argc) {
+          strategy_override = argv[++i];
+        } else if (arg == "--top" && i + 1 < argc) {
+          top = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--cache-mb" && i + 1 < argc) {
+          cache_mb = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--cache-stats") {
+          cache_stats = true;
+        }
+      }
+
+      if (data_path.empty() || fast_text.empty() || slow_text.empty()) {
+        std::cerr << "Error: sweep requires --data <path> --fast lo:hi[:step] --slow lo:hi[:step]\n";
+        return 1;
+      }
+      if (qe::is_multi_symbol_source(data_path)) {
+        std::cerr << "Error: sweep needs a single-symbol data file\n";
+        return 1;
+      }
+
+      json::object args;
+      args["fast"] = fast_text;
+      args["slow"] = slow_text;
+
+      try {
+        qe::BacktestConfig cfg{};
+        if (!config_path.empty()) cfg = qe::load_backtest_config_json(config_path);
+        if (strategy_override) cfg.strategy = *strategy_override;
+        if (initial_override) cfg.initial = *initial_override;
+        if (fee_override) cfg.fee_bps = *fee_override;
+        if (slip_override) cfg.slippage_bps = *slip_override;
+        sweep_opts.initial_equity = cfg.initial;
+        sweep_opts.costs = {cfg.fee_bps, cfg.slippage_bps};
+        args["strategy"] = cfg.strategy;
+        args["initial"] = cfg.initial;
+        args["fee_bps"] = cfg.fee_bps;
+        args["slippage_bps"] = cfg.slippage_bps;
+        const qe::StrategyKernels& strategy = qe::find_strategy(cfg.strategy);
+
+        const std::vector<qe::WindowPair> grid =
+          qe::sma_grid(qe::parse_window_range(fast_text), qe::parse_window_range(slow_text));
+
+        // loaded once for the whole grid; the sweep reads close only
+        load_opts.columns = resample_text.empty() ? qe::Columns::Close : qe::Columns::All;
+        qe::Dataset table = qe::load_dataset(data_path, load_opts);
+        if (!resample_text.empty()) {
+          table = qe::Dataset(qe::resample(table.view(), qe::parse_bar_interval(resample_text)));
+        }
+        const std::span<const double> close = table.view().close;
+
+        // the pairs share each window's series, unless the strategy batches them in SIMD lanes
+        qe::IndicatorCache cache(cache_mb << 20);
+        if (strategy.cached) sweep_opts.cache = &cache;
+
+        const auto t0 = std::chrono::steady_clock::now();
+        const std::vector<qe::SweepRow> rows = qe::sweep_strategy(strategy, close, grid, sweep_opts);
+        const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        std::cout << "sweep: " << rows.size() << " " << strategy.name << " backtests over " << close.size()
+                  << " bars in " << secs * 1000.0 << " ms (" << (secs > 0.0 ? static_cast<double>(rows.size()) / secs : 0.0)
+                  << " backtests/s)\n";
+        if (cache_stats) {
+          if (sweep_opts.cache) {
+            print_cache_stats(cache);
+          } else {
+            std::cout << "cache: unused (" << strategy.name << " batches its pairs in one pass over the data)\n";
+          }
+        }
+
+        std::vector<qe::SweepRow> best = rows;
+        const std::size_t shown = std::min(top, best.size());
+        std::partial_sort(best.begin(), best.begin() + static_cast<std::ptrdiff_t>(shown), best.end(),
+                          [](const qe::SweepRow& a, const qe::SweepRow& b) { return a.sharpe > b.sharpe; });
+        for (std::size_t k = 0; k < shown; ++k) {
+          const qe::SweepRow& r = best[k];
+          std::cout << "fast=" << r.fast << " slow=" << r.slow
+                    << " total_return=" << r.total_return
+                    << " sharpe=" << r.sharpe
+                    << " max_drawdown=" << r.max_drawdown
+                    << " win_rate=" << r.win_rate
+                    << " trades=" << r.n_trades << "\n";
+        }
+
+        if (!out_dir.empty()) {
+          std::filesystem::create_directories(out_dir);
+          const std::string path = (std::filesystem::path(out_dir) / "sweep.csv").string();
+          qe::write_sweep_csv(path, rows);
+          std::cout << "wrote " << path << "\n";
+        }
+
+        // one run record for the whole grid
+        args["runs"] = static_cast<std::int64_t>(rows.size());
+        if (!best.empty()) {
+          json::object b;
+          b["fast"] = static_cast<std::int64_t>(best.front().fast);
+          b["slow"] = static_cast<std::int64_t>(best.front().slow);
+          b["sharpe"] = best.front().sharpe;
+          b["total_return"] = best.front().total_return;
+          args["best"] = b;
+        }
+        api_record_run_only(api_base, qe::version(), "sweep", "success", args, data_path, out_dir, std::nullopt);
+      } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        api_record_run_only(api_base, qe::version(), "sweep", "failed", args, data_path, out_dir,
+                            std::string(ex.what()));
+        return 1;
+      }
+
+      return 0;
+    }
+
     if (cmd == "backtest") {
       std::string data_path;
       std::string config_path;
       std::string out_dir;
+      qe::DatasetOptions load_opts;
 
       std::optional<std::size_t> fast_override;
       std::optional<std::size_t> slow_override;
       std::optional<double> initial_override;
       std::optional<double> fee_override;
       std::optional<double> slip_override;
+      std::optional<std::string> strategy_override;
+      bool stream = false;
+      qe::BarStreamOptions stream_opts;
+      std::string start_text;
+      std::string end_text;
+      std::string resample_text;
+      std::string symbol;
 
       for (int i = 2; i < argc; ++i) {
         std::string arg = argv[i];
@@ -494,6 +837,8 @@ int main(int argc, char** argv) {
           data_path = argv[++i];
         } else if (arg == "--config" && i + 1 < argc) {
           config_path = argv[++i];
+        } else if (arg == "--strategy" && i + 1 < argc) {
+          strategy_override = argv[++i];
         } else if (arg == "--fast" && i + 1 < argc) {
           fast_override = static_cast<std::size_t>(std::stoul(argv[++i]));
         } else if (arg == "--slow" && i + 1 < argc) {
@@ -506,11 +851,41 @@ int main(int argc, char** argv) {
           slip_override = std::stod(argv[++i]);
         } else if (arg == "--out" && i + 1 < argc) {
           out_dir = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+          load_opts.threads = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--resample" && i + 1 < argc) {
+          resample_text = argv[++i];
+        } else if (arg == "--symbol" && i + 1 < argc) {
+          symbol = argv[++i];
+        } else if (arg == "--start" && i + 1 < argc) {
+          start_text = argv[++i];
+        } else if (arg == "--end" && i + 1 < argc) {
+          end_text = argv[++i];
+        } else if (arg == "--stream") {
+          stream = true;
+        } else if (arg == "--batch-rows" && i + 1 < argc) {
+          stream_opts.batch_rows = static_cast<std::size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--max-mem-mb" && i + 1 < argc) {
+          stream_opts.max_bytes = static_cast<std::size_t>(std::stoul(argv[++i])) << 20;
         }
       }
 
       if (data_path.empty()) {
-        std::cerr << "Error: --data <csv_path> is required\n";
+        std::cerr << "Error: --data <path> is required\n";
+        return 1;
+      }
+      if (stream && (!start_text.empty() || !end_text.empty())) {
+        std::cerr << "Error: --stream cannot be combined with --start/--end\n";
+        return 1;
+      }
+
+      const bool multi = qe::is_multi_symbol_source(data_path);
+      if (multi && (stream || !start_text.empty() || !end_text.empty())) {
+        std::cerr << "Error: --stream and --start/--end need a single-symbol data file\n";
+        return 1;
+      }
+      if (!multi && !symbol.empty()) {
+        std::cerr << "Error: --symbol needs a directory or a CSV with a symbol column\n";
         return 1;
       }
 
@@ -526,6 +901,7 @@ int main(int argc, char** argv) {
         }
       }
 
+      if (strategy_override) cfg.strategy = *strategy_override;
       if (fast_override) cfg.fast = *fast_override;
       if (slow_override) cfg.slow = *slow_override;
       if (initial_override) cfg.initial = *initial_override;
@@ -546,12 +922,111 @@ int main(int argc, char** argv) {
       }
 
       try {
-        qe::OhlcvTable table = qe::read_ohlcv_csv(data_path);
-
         qe::BacktestCosts costs{ cfg.fee_bps, cfg.slippage_bps };
+        const qe::StrategyKernels& strategy = qe::find_strategy(cfg.strategy);
+        if (stream && std::string_view(strategy.name) != "sma_crossover") {
+          throw std::invalid_argument("--stream supports the sma_crossover strategy only");
+        }
+
+        std::optional<std::int64_t> resample_ns;
+        if (!resample_text.empty()) resample_ns = qe::parse_bar_interval(resample_text);
+
+        // the backtest reads close only; resampling needs every field
+        const qe::Columns fields = resample_ns ? qe::Columns::All : qe::Columns::Close;
+        load_opts.columns = fields;
+        stream_opts.columns = fields;
+
+        qe::BacktestResult r;
+        double win_rate = 0.0;
+        double final_equity = 0.0;
+        std::size_t n_steps = 0;
+
+        if (multi && symbol.empty()) {
+          const std::size_t ran = run_universe_backtest(data_path, load_opts, cfg, strategy,
+                                                        resample_ns, out_dir);
+          // one run record for the whole universe, as sweep does for its grid
+          json::object args = backtest_args(cfg);
+          args["symbols"] = static_cast<std::int64_t>(ran);
+          api_record_run_only(api_base, qe::version(), "backtest", "success", args, data_path, out_dir,
+                              std::nullopt);
+          return 0;
+        }
 
-        qe::BacktestResult r =
-          qe::backtest_sma_crossover(table, cfg.fast, cfg.slow, cfg.initial, costs);
+        if (stream) {
+          // bounded memory: one batch of bars and the SMA windows, equity written as it goes
+          qe::BarStream bars(data_path, stream_opts);
+          qe::SmaCrossoverStream bt(cfg.fast, cfg.slow, cfg.initial, costs);
+          std::optional<qe::EquityCsvWriter> equity_out;
+          if (!out_dir.empty()) equity_out.emplace(equity_path);
+
+          qe::OhlcvColumns batch;
+          std::vector<double> equity;
+          auto feed = [&](const qe::OhlcvColumns& b) {
+            bt.process(b.close, equity_out ? &equity : nullptr);
+            if (equity_out) equity_out->write(equity);
+          };
+
+          if (resample_ns) {
+            qe::Resampler rs(*resample_ns);
+            qe::OhlcvColumns bars_out;
+            while (bars.next(batch)) {
+              rs.process(batch.view(), bars_out);
+              feed(bars_out);
+            }
+            rs.finish(bars_out);
+            feed(bars_out);
+          } else {
+            while (bars.next(batch)) feed(batch);
+          }
+
+          r = bt.result();
+          win_rate = bt.win_rate();
+          final_equity = bt.final_equity();
+          n_steps = bt.steps();
+        } else {
+          qe::Dataset table;
+          qe::MultiDataset universe;
+          std::span<const double> close;
+          if (multi) {
+            // one symbol's slice of the arena, no copy unless resampled
+            universe = qe::load_multi_dataset(data_path, load_opts);
+            close = universe.slice(symbol).close;
+            if (resample_ns) {
+              table = qe::Dataset(qe::resample(universe.slice(symbol), *resample_ns));
+              close = table.view().close;
+            }
+          } else if (start_text.empty() && end_text.empty()) {
+            table = qe::load_dataset(data_path, load_opts);
+            if (resample_ns) table = qe::Dataset(qe::resample(table.view(), *resample_ns));
+            close = table.view().close;
+          } else {
+            // seek straight to the range; slow_window earlier bars warm up the SMAs
+            qe::TimeRange range;
+            if (!start_text.empty()) range.start_ns = qe::parse_timestamp_ns(start_text);
+            if (!end_text.empty()) range.end_ns = qe::parse_timestamp_ns(end_text);
+            const std::int64_t start_ns = range.start_ns;
+            if (resample_ns && !start_text.empty()) {
+              // warm-up is counted in resampled bars, so widen the range by time instead
+              range.start_ns -= static_cast<std::int64_t>(cfg.slow) * *resample_ns;
+            } else {
+              range.warmup_bars = cfg.slow;
+            }
+            table = qe::load_dataset_range(data_path, range, load_opts);
+            if (resample_ns) table = qe::Dataset(qe::resample(table.view(), *resample_ns));
+
+            const auto ts = table.view().ts;
+            const auto warm = std::lower_bound(ts.begin(), ts.end(), start_ns) - ts.begin();
+            std::cout << "range: " << (static_cast<std::ptrdiff_t>(ts.size()) - warm)
+                      << " bars (+" << warm << " warm-up)\n";
+            close = table.view().close;
+          }
+          const qe::WindowPair windows{cfg.fast, cfg.slow};
+          // one window pair per file: the fused kernel, nothing worth caching
+          r = qe::run_backtest(strategy, close, windows, cfg.initial, costs);
+          win_rate = qe::compute_win_rate(r.strat_ret);
+          final_equity = r.equity.empty() ? 0.0 : r.equity.back();
+          n_steps = r.equity.size();
+        }
 
         std::cout << "backtest: " << cfg.strategy
                   << " fast=" << cfg.fast
@@ -563,23 +1038,24 @@ int main(int argc, char** argv) {
         std::cout << "total_return=" << r.total_return
                   << " sharpe=" << r.sharpe
                   << " max_drawdown=" << r.max_drawdown
-                  << " win_rate=" << qe::compute_win_rate(r.strat_ret) << "\n";
+                  << " win_rate=" << win_rate << "\n";
 
         std::cout << "trades=" << r.n_trades
                   << " total_cost=" << r.total_cost << "\n";
 
-        if (!r.equity.empty()) {
-          std::cout << "final_equity=" << r.equity.back() << "\n";
+        if (n_steps > 0) {
+          std::cout << "final_equity=" << final_equity << "\n";
         }
 
         if (!out_dir.empty()) {
-          qe::write_equity_csv(equity_path, r.equity);
-          qe::write_report_json(report_path, cfg.strategy, cfg.fast, cfg.slow, cfg.initial, r);
+          if (!stream) qe::write_equity_csv(equity_path, r.equity);
+          qe::write_report_json(report_path, cfg.strategy, cfg.fast, cfg.slow, cfg.initial, r,
+                                win_rate, n_steps);
           std::cout << "wrote " << equity_path << "\n";
           std::cout << "wrote " << report_path << "\n";
         }
 
-        api_record_backtest_success(api_base, data_path, out_dir, cfg, r);
+        api_record_backtest_success(api_base, data_path, out_dir, cfg, r, win_rate, final_equity);
 
       } catch (const std::exception& ex) {
         std::cerr << "Error: " << ex.what() << "\n";
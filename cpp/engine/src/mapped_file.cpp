@@ -0,0 +1,130 @@
+#include "qe/mapped_file.hpp"
+
+#include <utility>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace qe {
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+  : data_(std::exchange(other.data_, nullptr)),
+    size_(std::exchange(other.size_, 0)),
+    open_(std::exchange(other.open_, false)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    close();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    open_ = std::exchange(other.open_, false);
+  }
+  return *this;
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const std::string& path) {
+  close();
+
+  HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER sz{};
+  if (!::GetFileSizeEx(file, &sz)) {
+    ::CloseHandle(file);
+    return false;
+  }
+
+  if (sz.QuadPart == 0) {
+    ::CloseHandle(file);
+    open_ = true;
+    return true;
+  }
+
+  HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  ::CloseHandle(file);
+  if (!mapping) return false;
+
+  void* p = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  ::CloseHandle(mapping); // the view keeps the mapping alive
+  if (!p) return false;
+
+  data_ = static_cast<const char*>(p);
+  size_ = static_cast<std::size_t>(sz.QuadPart);
+  open_ = true;
+  return true;
+}
+
+void MappedFile::close() {
+  if (data_) {
+    ::UnmapViewOfFile(data_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  open_ = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+  close();
+
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+
+  if (st.st_size == 0) {
+    ::close(fd);
+    open_ = true;
+    return true;
+  }
+
+  const auto len = static_cast<std::size_t>(st.st_size);
+  void* p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping keeps its own reference
+  if (p == MAP_FAILED) return false;
+
+  // hint only; we scan front to back
+  ::madvise(p, len, MADV_SEQUENTIAL);
+
+  data_ = static_cast<const char*>(p);
+  size_ = len;
+  open_ = true;
+  return true;
+}
+
+void MappedFile::close() {
+  if (data_) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  open_ = false;
+}
+
+#endif
+
+} // namespace qe
@@ -0,0 +1,281 @@
+#include "qe/multi_dataset.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "qe/mapped_file.hpp"
+#include "qe/timestamp.hpp"
+
+#include "csv_parse.hpp"
+#include "run_workers.hpp"
+
+namespace qe {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using namespace csv_detail;
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+  return s;
+}
+
+bool is_symbol_header(std::string_view field) {
+  field = trim(field);
+  constexpr std::string_view kName = "symbol";
+  return field.size() == kName.size() &&
+         std::equal(field.begin(), field.end(), kName.begin(),
+                    [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; });
+}
+
+// index of the "symbol" column in a CSV header line, or -1
+int symbol_column(std::string_view header) {
+  int col = 0;
+  for (;;) {
+    const std::size_t comma = header.find(',');
+    if (is_symbol_header(header.substr(0, comma))) return col;
+    if (comma == std::string_view::npos) return -1;
+    header.remove_prefix(comma + 1);
+    ++col;
+  }
+}
+
+std::string_view first_line(std::string_view bytes) {
+  return bytes.substr(0, bytes.find('\n'));
+}
+
+// builds the arena from rows tagged with symbol ids: a stable counting sort by id
+MultiDataset group_by_symbol(SymbolTable symbols, const OhlcvColumns& rows,
+                             const std::vector<SymbolId>& ids) {
+  std::vector<SymbolRange> ranges(symbols.size());
+  for (SymbolId id : ids) ++ranges[id].count;
+
+  std::size_t offset = 0;
+  for (auto& r : ranges) {
+    r.offset = offset;
+    offset += r.count;
+  }
+
+  OhlcvColumns arena;
+  arena.resize(rows.size());
+  std::vector<std::size_t> next(ranges.size());
+  for (std::size_t s = 0; s < ranges.size(); ++s) next[s] = ranges[s].offset;
+
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    const std::size_t j = next[ids[i]]++;
+    arena.ts[j] = rows.ts[i];
+    arena.open[j] = rows.open[i];
+    arena.high[j] = rows.high[i];
+    arena.low[j] = rows.low[i];
+    arena.close[j] = rows.close[i];
+    arena.volume[j] = rows.volume[i];
+  }
+
+  return MultiDataset(std::move(symbols), std::move(arena), std::move(ranges));
+}
+
+MultiDataset load_long_csv(const std::string& path) {
+  MappedFile file;
+  if (!file.open(path)) {
+    throw std::runtime_error("Failed to open CSV file: " + path);
+  }
+  if (file.size() == 0) {
+    throw std::runtime_error("CSV file is empty: " + path);
+  }
+
+  const std::string_view header = first_line(file.view());
+  const int sym_col = symbol_column(header);
+  if (sym_col < 0 || sym_col > 6) {
+    throw std::runtime_error("CSV has no symbol column: " + path);
+  }
+
+  const char* p = file.data() + std::min(header.size() + 1, file.size());
+  const char* const end = file.data() + file.size();
+
+  SymbolTable symbols;
+  OhlcvColumns rows;
+  std::vector<SymbolId> ids;
+  const auto approx_rows = static_cast<std::size_t>(std::count(p, end, '\n')) + 1;
+  rows.reserve(approx_rows);
+  ids.reserve(approx_rows);
+
+  std::string rest; // the line without its symbol field
+  std::string_view ts;
+  double vals[5];
+  std::size_t line_no = 1;
+
+  while (p < end) {
+    ++line_no;
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+    const char* line_end = nl ? nl : end;
+    const char* line = p;
+    p = nl ? nl + 1 : end;
+
+    if (line_end > line && line_end[-1] == '\r') --line_end;
+    if (line_end == line) continue;
+
+    // locate the symbol field
+    const char* sb = line;
+    for (int c = 0; c < sym_col && sb; ++c) {
+      sb = static_cast<const char*>(std::memchr(sb, ',', static_cast<std::size_t>(line_end - sb)));
+      if (sb) ++sb;
+    }
+    const char* se = sb ? static_cast<const char*>(std::memchr(sb, ',', static_cast<std::size_t>(line_end - sb))) : nullptr;
+    if (!se) se = line_end;
+    const std::string_view symbol = sb ? trim(std::string_view(sb, static_cast<std::size_t>(se - sb))) : std::string_view{};
+    if (symbol.empty()) {
+      throw std::runtime_error("CSV parse error in " + path + " at line " + std::to_string(line_no) +
+                               ": bad or missing symbol field");
+    }
+
+    int bad;
+    if (sym_col == 0) {
+      bad = se < line_end ? parse_fields(se + 1, line_end, ts, vals) : 1;
+    } else {
+      rest.assign(line, static_cast<std::size_t>(sb - 1 - line));
+      rest.append(se, static_cast<std::size_t>(line_end - se));
+      bad = parse_fields(rest.data(), rest.data() + rest.size(), ts, vals);
+    }
+    if (bad >= 0) throw_parse_error(path, line_no, static_cast<std::size_t>(bad));
+
+    std::int64_t t = 0;
+    if (!try_parse_timestamp_ns(ts, t)) throw_parse_error(path, line_no, 0);
+
+    ids.push_back(symbols.intern(symbol));
+    rows.push_back(t, vals[0], vals[1], vals[2], vals[3], vals[4]);
+  }
+
+  return group_by_symbol(std::move(symbols), rows, ids);
+}
+
+MultiDataset load_directory(const std::string& path, const DatasetOptions& opts) {
+  std::vector<fs::path> files;
+  for (const auto& entry : fs::directory_iterator(path)) {
+    if (!entry.is_regular_file()) continue;
+    const auto ext = entry.path().extension();
+    if (ext == ".csv" || ext == ".qec") files.push_back(entry.path());
+  }
+  if (files.empty()) {
+    throw std::runtime_error("no .csv or .qec files in " + path);
+  }
+  std::sort(files.begin(), files.end(),
+            [](const fs::path& a, const fs::path& b) { return a.filename() < b.filename(); });
+
+  SymbolTable symbols;
+  for (const auto& f : files) {
+    const std::string stem = f.stem().string();
+    if (symbols.find(stem)) {
+      throw std::runtime_error("duplicate symbol " + stem + " in " + path);
+    }
+    symbols.intern(stem);
+  }
+
+  // files are independent, so spread them over the workers (each parses single-threaded)
+  std::size_t threads = opts.threads == 0 ? std::thread::hardware_concurrency() : opts.threads;
+  threads = std::clamp<std::size_t>(threads, 1, files.size());
+
+  std::vector<Dataset> parts(files.size());
+  detail::run_workers(threads, [&](std::size_t k) {
+    for (std::size_t i = k; i < files.size(); i += threads) {
+      parts[i] = load_dataset(files[i].string(), {.verify_checksum = opts.verify_checksum, .threads = 1});
+    }
+  });
+
+  std::vector<SymbolRange> ranges(files.size());
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < parts.size(); ++i) {
+    ranges[i] = {total, parts[i].size()};
+    total += parts[i].size();
+  }
+
+  OhlcvColumns arena;
+  arena.resize(total);
+  for (std::size_t i = 0; i < parts.size(); ++i) {
+    const OhlcvView v = parts[i].view();
+    const std::size_t at = ranges[i].offset;
+    std::copy(v.ts.begin(), v.ts.end(), arena.ts.begin() + at);
+    std::copy(v.open.begin(), v.open.end(), arena.open.begin() + at);
+    std::copy(v.high.begin(), v.high.end(), arena.high.begin() + at);
+    std::copy(v.low.begin(), v.low.end(), arena.low.begin() + at);
+    std::copy(v.close.begin(), v.close.end(), arena.close.begin() + at);
+    std::copy(v.volume.begin(), v.volume.end(), arena.volume.begin() + at);
+    parts[i] = Dataset{};
+  }
+
+  return MultiDataset(std::move(symbols), std::move(arena), std::move(ranges));
+}
+
+} // namespace
+
+SymbolId SymbolTable::intern(std::string_view name) {
+  if (auto it = ids_.find(name); it != ids_.end()) {
+    return it->second;
+  }
+  const auto id = static_cast<SymbolId>(names_.size());
+  names_.emplace_back(name);
+  ids_.emplace(names_.back(), id);
+  return id;
+}
+
+std::optional<SymbolId> SymbolTable::find(std::string_view name) const {
+  if (auto it = ids_.find(name); it != ids_.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+MultiDataset::MultiDataset(SymbolTable symbols, OhlcvColumns arena, std::vector<SymbolRange> ranges)
+  : symbols_(std::move(symbols)), arena_(std::move(arena)), ranges_(std::move(ranges)) {
+  if (ranges_.size() != symbols_.size()) {
+    throw std::invalid_argument("MultiDataset: one range per symbol required");
+  }
+  for (const auto& r : ranges_) {
+    if (r.offset + r.count > arena_.size()) {
+      throw std::invalid_argument("MultiDataset: symbol range outside the arena");
+    }
+  }
+}
+
+OhlcvView MultiDataset::slice(SymbolId id) const {
+  const SymbolRange r = ranges_.at(id);
+  return view().subview(r.offset, r.count);
+}
+
+OhlcvView MultiDataset::slice(std::string_view symbol) const {
+  const auto id = symbols_.find(symbol);
+  if (!id) {
+    throw std::out_of_range("unknown symbol: " + std::string(symbol));
+  }
+  return slice(*id);
+}
+
+bool is_multi_symbol_source(const std::string& path) {
+  std::error_code ec;
+  if (fs::is_directory(path, ec)) return true;
+
+  // only the header line is read; a .qec file never has a "symbol" field there
+  std::ifstream in(path, std::ios::binary);
+  std::string header;
+  if (!in || !std::getline(in, header)) return false;
+  return symbol_column(header) >= 0;
+}
+
+MultiDataset load_multi_dataset(const std::string& path, DatasetOptions opts) {
+  std::error_code ec;
+  if (fs::is_directory(path, ec)) {
+    return load_directory(path, opts);
+  }
+  return load_long_csv(path);
+}
+
+} // namespace qe
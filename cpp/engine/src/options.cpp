@@ -6,6 +6,8 @@
 #include <stdexcept>
 #include <string>
 
+#include "kernels.hpp"
+
 namespace qe {
 
 static void require_finite(const char* name, double x) {
@@ -181,6 +183,20 @@ BsResult black_scholes_all(double S, double K, double r, double sigma, double T)
   return out;
 }
 
+void black_scholes_batch(std::span<const double> S, std::span<const double> K,
+                         std::span<const double> r, std::span<const double> sigma,
+                         std::span<const double> T, std::span<double> call, std::span<double> put) {
+  const std::size_t n = S.size();
+  if (K.size() != n || r.size() != n || sigma.size() != n || T.size() != n ||
+      call.size() != n || put.size() != n) {
+    throw std::runtime_error("options: batch inputs and outputs must have the same length");
+  }
+  for (std::size_t i = 0; i < n; ++i) validate_inputs(S[i], K[i], r[i], sigma[i], T[i]);
+
+  kernels::black_scholes(S.data(), K.data(), r.data(), sigma.data(), T.data(), n,
+                         call.data(), put.data());
+}
+
 static double intrinsic_call(double S, double K, double r, double T) {
   const double discK = K * std::exp(-r * T);
   return std::max(0.0, S - discK);
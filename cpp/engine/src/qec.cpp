@@ -0,0 +1,265 @@
+#include "qe/qec.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace qe {
+
+namespace {
+
+constexpr std::uint64_t kMul = 0x9E3779B97F4A7C15ULL;
+constexpr std::size_t kHeaderChecked = offsetof(QecHeader, header_checksum);
+
+std::uint64_t mix(std::uint64_t h, std::uint64_t w) {
+  h = (h ^ w) * kMul;
+  return h ^ (h >> 29);
+}
+
+std::size_t align_up(std::size_t n) {
+  return (n + kQecAlign - 1) & ~(kQecAlign - 1);
+}
+
+void require_little_endian() {
+  if constexpr (std::endian::native != std::endian::little) {
+    throw std::runtime_error("qec: only little-endian hosts are supported");
+  }
+}
+
+std::uint64_t header_checksum(const QecHeader& h) {
+  return qec_checksum(&h, kHeaderChecked);
+}
+
+// compressed column layout: values, blocks, words, block_bit[], words[]
+constexpr std::size_t kBlobHeaderWords = 3;
+
+std::vector<std::uint64_t> encoded_blob(const EncodedColumn& col) {
+  std::vector<std::uint64_t> blob;
+  blob.reserve(kBlobHeaderWords + col.block_bit.size() + col.words.size());
+  blob.push_back(col.size);
+  blob.push_back(col.block_bit.size());
+  blob.push_back(col.words.size());
+  blob.insert(blob.end(), col.block_bit.begin(), col.block_bit.end());
+  blob.insert(blob.end(), col.words.begin(), col.words.end());
+  return blob;
+}
+
+} // namespace
+
+std::uint64_t qec_checksum(const void* data, std::size_t n) {
+  const auto* p = static_cast<const unsigned char*>(data);
+
+  // four independent lanes so the loop is not one long dependency chain
+  std::uint64_t h[4] = {n, ~static_cast<std::uint64_t>(n), n * kMul, 0x165667B19E3779F9ULL};
+
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    for (int k = 0; k < 4; ++k) {
+      std::uint64_t w;
+      std::memcpy(&w, p + i + 8 * k, 8);
+      h[k] = mix(h[k], w);
+    }
+  }
+  for (; i < n; i += 8) {
+    std::uint64_t w = 0;
+    std::memcpy(&w, p + i, (n - i < 8) ? n - i : 8);
+    h[0] = mix(h[0], w);
+  }
+
+  std::uint64_t out = h[0];
+  for (int k = 1; k < 4; ++k) out = mix(out, h[k]);
+  return out;
+}
+
+bool is_qec(std::string_view bytes) {
+  return bytes.size() >= sizeof(kQecMagic) &&
+         std::memcmp(bytes.data(), kQecMagic, sizeof(kQecMagic)) == 0;
+}
+
+void write_qec(const std::string& path, const OhlcvView& data, QecWriteOptions opts) {
+  require_little_endian();
+
+  const std::size_t n = data.size();
+  if (!data.complete()) {
+    throw std::runtime_error("qec: all columns must have the same length");
+  }
+
+  const void* cols[kQecColumns] = {data.ts.data(), data.open.data(), data.high.data(),
+                                   data.low.data(), data.close.data(), data.volume.data()};
+  std::size_t col_bytes[kQecColumns];
+  for (auto& b : col_bytes) b = n * 8;
+
+  std::vector<std::uint64_t> blobs[kQecColumns];
+  if (opts.compress) {
+    const CompressedOhlcv c = compress(data);
+    const EncodedColumn* enc[kQecColumns] = {&c.ts, &c.open, &c.high, &c.low, &c.close, &c.volume};
+    for (std::size_t k = 0; k < kQecColumns; ++k) {
+      blobs[k] = encoded_blob(*enc[k]);
+      cols[k] = blobs[k].data();
+      col_bytes[k] = blobs[k].size() * 8;
+    }
+  }
+
+  QecHeader h{};
+  std::memcpy(h.magic, kQecMagic, sizeof(kQecMagic));
+  h.version = opts.compress ? kQecVersionCompressed : kQecVersion;
+  h.header_bytes = sizeof(QecHeader);
+  h.rows = n;
+  h.columns = kQecColumns;
+  h.flags = opts.compress ? kQecFlagCompressed : 0;
+
+  std::size_t off = align_up(sizeof(QecHeader));
+  std::uint64_t payload = 0;
+  for (std::size_t c = 0; c < kQecColumns; ++c) {
+    h.column_offset[c] = off;
+    off = align_up(off + col_bytes[c]);
+    payload = mix(payload, qec_checksum(cols[c], col_bytes[c]));
+  }
+  h.payload_checksum = payload;
+  h.header_checksum = header_checksum(h);
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("failed to open qec path for write: " + path);
+  }
+
+  static const char zeros[kQecAlign] = {};
+  std::size_t pos = 0;
+  auto write = [&](const void* p, std::size_t bytes) {
+    out.write(static_cast<const char*>(p), static_cast<std::streamsize>(bytes));
+    pos += bytes;
+  };
+  auto pad_to = [&](std::size_t target) {
+    if (target > pos) write(zeros, target - pos);
+  };
+
+  write(&h, sizeof(h));
+  for (std::size_t c = 0; c < kQecColumns; ++c) {
+    pad_to(h.column_offset[c]);
+    write(cols[c], col_bytes[c]);
+  }
+  pad_to(align_up(pos));
+
+  if (!out) {
+    throw std::runtime_error("failed writing qec file: " + path);
+  }
+}
+
+QecHeader parse_qec_header(std::string_view head, std::uint64_t file_size) {
+  require_little_endian();
+
+  if (!is_qec(head) || head.size() < sizeof(QecHeader) || file_size < sizeof(QecHeader)) {
+    throw std::runtime_error("qec: not a qec file");
+  }
+
+  QecHeader h;
+  std::memcpy(&h, head.data(), sizeof(h));
+
+  if (h.version != kQecVersion && h.version != kQecVersionCompressed) {
+    throw std::runtime_error("qec: unsupported version " + std::to_string(h.version));
+  }
+  if (h.header_bytes != sizeof(QecHeader) || h.columns != kQecColumns ||
+      h.header_checksum != header_checksum(h) ||
+      (h.version == kQecVersionCompressed) != qec_is_compressed(h)) {
+    throw std::runtime_error("qec: corrupt header");
+  }
+
+  // raw columns hold 8 bytes per row; encoded ones at least their blob header
+  const bool compressed = qec_is_compressed(h);
+  if (!compressed && h.rows > file_size / 8) {
+    throw std::runtime_error("qec: truncated file");
+  }
+  const std::uint64_t min_bytes = compressed ? kBlobHeaderWords * 8 : h.rows * 8;
+  for (std::size_t c = 0; c < kQecColumns; ++c) {
+    const std::uint64_t off = h.column_offset[c];
+    if (off % kQecAlign != 0 || off < sizeof(QecHeader) || off > file_size ||
+        file_size - off < min_bytes) {
+      throw std::runtime_error("qec: truncated file");
+    }
+  }
+  return h;
+}
+
+bool qec_is_compressed(const QecHeader& h) {
+  return (h.flags & kQecFlagCompressed) != 0;
+}
+
+OhlcvView qec_view(std::string_view bytes, bool verify_payload) {
+  const QecHeader h = parse_qec_header(bytes, bytes.size());
+  if (qec_is_compressed(h)) {
+    throw std::runtime_error("qec: compressed file has no raw columns (use qec_compressed_view)");
+  }
+
+  const auto n = static_cast<std::size_t>(h.rows);
+  const char* base[kQecColumns];
+  for (std::size_t c = 0; c < kQecColumns; ++c) {
+    base[c] = bytes.data() + h.column_offset[c];
+  }
+
+  if (verify_payload) {
+    std::uint64_t payload = 0;
+    for (std::size_t c = 0; c < kQecColumns; ++c) {
+      payload = mix(payload, qec_checksum(base[c], n * 8));
+    }
+    if (payload != h.payload_checksum) {
+      throw std::runtime_error("qec: payload checksum mismatch");
+    }
+  }
+
+  OhlcvView v;
+  v.ts = {reinterpret_cast<const std::int64_t*>(base[0]), n};
+  v.open = {reinterpret_cast<const double*>(base[1]), n};
+  v.high = {reinterpret_cast<const double*>(base[2]), n};
+  v.low = {reinterpret_cast<const double*>(base[3]), n};
+  v.close = {reinterpret_cast<const double*>(base[4]), n};
+  v.volume = {reinterpret_cast<const double*>(base[5]), n};
+  return v;
+}
+
+CompressedOhlcvView qec_compressed_view(std::string_view bytes, bool verify_payload) {
+  const QecHeader h = parse_qec_header(bytes, bytes.size());
+  if (!qec_is_compressed(h)) {
+    throw std::runtime_error("qec: file is not compressed");
+  }
+
+  const std::uint64_t blocks = (h.rows + kCodecBlock - 1) / kCodecBlock;
+  EncodedColumnView cols[kQecColumns];
+  std::uint64_t payload = 0;
+
+  for (std::size_t c = 0; c < kQecColumns; ++c) {
+    const std::uint64_t off = h.column_offset[c];
+    const auto* words = reinterpret_cast<const std::uint64_t*>(bytes.data() + off);
+    const std::uint64_t avail = (bytes.size() - off) / 8;
+
+    // words[0..2] = values, blocks, word count; parse_qec_header checked they are in the file
+    if (words[0] != h.rows || words[1] != blocks || words[2] > avail ||
+        kBlobHeaderWords + blocks > avail - words[2]) {
+      throw std::runtime_error("qec: corrupt compressed column");
+    }
+
+    EncodedColumnView& v = cols[c];
+    v.size = static_cast<std::size_t>(h.rows);
+    v.block_bit = {words + kBlobHeaderWords, static_cast<std::size_t>(blocks)};
+    v.words = {words + kBlobHeaderWords + blocks, static_cast<std::size_t>(words[2])};
+    for (std::size_t b = 0; b < v.block_bit.size(); ++b) {
+      if (v.block_bit[b] >= v.words.size() * 64 || (b && v.block_bit[b] < v.block_bit[b - 1])) {
+        throw std::runtime_error("qec: corrupt compressed column");
+      }
+    }
+
+    if (verify_payload) {
+      payload = mix(payload, qec_checksum(words, (kBlobHeaderWords + blocks + words[2]) * 8));
+    }
+  }
+
+  if (verify_payload && payload != h.payload_checksum) {
+    throw std::runtime_error("qec: payload checksum mismatch");
+  }
+
+  return {cols[0], cols[1], cols[2], cols[3], cols[4], cols[5]};
+}
+
+} // namespace qe
@@ -4,6 +4,9 @@
 #include <iomanip>
 #include <stdexcept>
 #include <cmath>
+
+#include "kernels.hpp"
+
 namespace qe {
 
 double compute_win_rate(const std::vector<double>& strat_returns) {
@@ -11,24 +14,12 @@ double compute_win_rate(const std::vector<double>& strat_returns) {
     return 0.0;
   }
 
-  std::size_t wins = 0;
-  std::size_t total = 0;
-
-  for (double r : strat_returns) {
-    // Ignore NaNs if ever appear
-    if (std::isnan(r)) {
-      continue;
-    }
-    ++total;
-    if (r > 0.0) {
-      ++wins;
-    }
-  }
-
-  if (total == 0) {
+  // NaNs are ignored if they ever appear
+  const kernels::WinCount c = kernels::count_wins(strat_returns.data(), strat_returns.size());
+  if (c.total == 0) {
     return 0.0;
   }
-  return static_cast<double>(wins) / static_cast<double>(total);
+  return static_cast<double>(c.wins) / static_cast<double>(c.total);
 }
 
 static std::string json_escape(const std::string& s) {
@@ -56,14 +47,26 @@ void write_report_json(
   std::size_t slow_window,
   double initial_equity,
   const BacktestResult& result
+) {
+  write_report_json(path, strategy_name, fast_window, slow_window, initial_equity, result,
+                    compute_win_rate(result.strat_ret), result.equity.size());
+}
+
+void write_report_json(
+  const std::string& path,
+  const std::string& strategy_name,
+  std::size_t fast_window,
+  std::size_t slow_window,
+  double initial_equity,
+  const BacktestResult& result,
+  double win_rate,
+  std::size_t n_steps
 ) {
   std::ofstream out(path);
   if (!out.is_open()) {
     throw std::runtime_error("failed to open file for writing: " + path);
   }
 
-  const double win_rate = compute_win_rate(result.strat_ret);
-
   out << std::setprecision(17);
   out << "{\n";
   out << "  \"strategy\": \"" << json_escape(strategy_name) << "\",\n";
@@ -79,7 +82,7 @@ void write_report_json(
   out << "    \"win_rate\": " << win_rate << "\n";
   out << "  },\n";
   out << "  \"series\": {\n";
-  out << "    \"n_steps\": " << result.equity.size() << "\n";
+  out << "    \"n_steps\": " << n_steps << "\n";
   out << "  }\n";
   out << "}\n";
 }
@@ -0,0 +1,113 @@
+#include "qe/resample.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace qe {
+
+namespace {
+
+// floor division, so pre-1970 bars land in the bucket that starts before them. Only a
+// negative q can overflow; min / interval rounds toward zero, so q below it would.
+std::int64_t floor_to(std::int64_t ts, std::int64_t interval) {
+  std::int64_t q = ts / interval;
+  if (ts % interval < 0) --q;
+  if (q < std::numeric_limits<std::int64_t>::min() / interval) {
+    throw std::invalid_argument("resample: bucket start is out of range for this interval");
+  }
+  return q * interval;
+}
+
+} // namespace
+
+std::int64_t parse_bar_interval(std::string_view text) {
+  std::int64_t count = 0;
+  const auto res = std::from_chars(text.data(), text.data() + text.size(), count);
+  const std::string_view unit = text.substr(static_cast<std::size_t>(res.ptr - text.data()));
+
+  std::int64_t unit_ns = 0;
+  if (unit == "s") unit_ns = 1'000'000'000LL;
+  else if (unit == "m" || unit == "min") unit_ns = 60'000'000'000LL;
+  else if (unit == "h") unit_ns = 3'600'000'000'000LL;
+  else if (unit == "d") unit_ns = 86'400'000'000'000LL;
+
+  if (res.ec != std::errc{} || res.ptr == text.data() || unit_ns == 0 || count <= 0 ||
+      count > std::numeric_limits<std::int64_t>::max() / unit_ns) {
+    throw std::invalid_argument("invalid bar interval (expected e.g. 5m, 1h, 1d): " + std::string(text));
+  }
+  return count * unit_ns;
+}
+
+Resampler::Resampler(std::int64_t interval_ns)
+  : interval_(interval_ns) {
+  if (interval_ns <= 0) {
+    throw std::invalid_argument("Resampler: interval must be > 0");
+  }
+}
+
+void Resampler::emit(OhlcvColumns& out) {
+  out.push_back(bucket_, o_, h_, l_, c_, v_);
+}
+
+void Resampler::add(const OhlcvView& in, std::size_t i, OhlcvColumns& out) {
+  const std::int64_t bucket = floor_to(in.ts[i], interval_);
+
+  if (open_ && bucket == bucket_) {
+    // NaN highs / lows are skipped wherever they fall, as rolling_max / rolling_min do
+    if (in.high[i] > h_ || std::isnan(h_)) h_ = in.high[i];
+    if (in.low[i] < l_ || std::isnan(l_)) l_ = in.low[i];
+    c_ = in.close[i];
+    v_ += in.volume[i];
+    return;
+  }
+
+  if (open_) {
+    if (bucket < bucket_) {
+      throw std::invalid_argument("resample: bars must be in time order");
+    }
+    emit(out);
+  }
+
+  open_ = true;
+  bucket_ = bucket;
+  o_ = in.open[i];
+  h_ = in.high[i];
+  l_ = in.low[i];
+  c_ = in.close[i];
+  v_ = in.volume[i];
+}
+
+void Resampler::process(const OhlcvView& in, OhlcvColumns& out) {
+  if (!in.complete()) {
+    throw std::invalid_argument("resample: needs every column (load with Columns::All)");
+  }
+  out.clear();
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    add(in, i, out);
+  }
+}
+
+void Resampler::finish(OhlcvColumns& out) {
+  out.clear();
+  if (open_) {
+    emit(out);
+    open_ = false;
+  }
+}
+
+OhlcvColumns resample(const OhlcvView& in, std::int64_t interval_ns) {
+  Resampler rs(interval_ns);
+  OhlcvColumns out;
+  OhlcvColumns last;
+  rs.process(in, out);
+  rs.finish(last);
+  if (!last.empty()) {
+    out.push_back(last.ts[0], last.open[0], last.high[0], last.low[0], last.close[0], last.volume[0]);
+  }
+  return out;
+}
+
+} // namespace qe
@@ -0,0 +1,55 @@
+#pragma once
+
+// Sliding-window mean / sum of squared deviations (m2) of RollingStd (and so rolling_std). Internal to qe_engine.
+//
+// Each step replaces the oldest value with the newest in O(1) (Welford-style update).
+// The moments are recomputed with the exact two-pass formula every `window` steps, so
+// drift never accumulates past one window, and as soon as m2 falls far below its peak
+// since the last refresh (large values left the window: the remaining m2 would be mostly
+// their rounding error). The turnover refresh costs O(1) per step amortized. The
+// cancellation refresh fires only when m2 drops by kMomentsCancellation against the last
+// refresh, which ordinary series do about once per spike; an input whose amplitude decays
+// by ~100x per bar can trigger it every step, so the worst case is O(n * window).
+// Non-finite values are not slid through (the caller reports NaN while one is in the window).
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace qe::detail {
+
+// exact two-pass moments of the window; at(k) is its k-th oldest value
+template <class At>
+inline void refresh_moments(At at, std::size_t window, double& mean, double& m2, double& m2_peak) {
+  double sum = 0.0;
+  for (std::size_t k = 0; k < window; ++k) sum += at(k);
+  mean = sum / static_cast<double>(window);
+
+  m2 = 0.0;
+  for (std::size_t k = 0; k < window; ++k) {
+    const double d = at(k) - mean;
+    m2 += d * d;
+  }
+  m2_peak = m2;
+}
+
+// m2 below this fraction of its peak has lost too many digits to cancellation
+inline constexpr double kMomentsCancellation = 1e-4;
+
+// x_in enters the window, x_out (the previous oldest value) leaves it.
+// returns false if the result is not trustworthy; the caller refreshes instead.
+inline bool slide_moments(double x_in, double x_out, std::size_t window,
+                          double& mean, double& m2, double& m2_peak) {
+  const double old_mean = mean;
+  mean += (x_in - x_out) / static_cast<double>(window);
+  m2 += (x_in - x_out) * ((x_in - mean) + (x_out - old_mean));
+  m2_peak = std::max(m2_peak, m2);
+  return m2 >= m2_peak * kMomentsCancellation;
+}
+
+// population std dev; m2 can dip just below zero through cancellation on flat data
+inline double moments_stddev(double m2, std::size_t window) {
+  return std::sqrt(std::max(m2, 0.0) / static_cast<double>(window));
+}
+
+} // namespace qe::detail
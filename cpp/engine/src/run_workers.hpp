@@ -0,0 +1,49 @@
+#pragma once
+
+// Minimal fork/join helper shared by the parallel loaders. Internal to qe_engine.
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace qe::detail {
+
+// runs fn(0..n-1) on n threads (index 0 on the caller) and rethrows the first exception
+// (n == 0 runs nothing). If a thread cannot be started, the ones already running are
+// joined and the std::system_error is rethrown.
+template <class Fn>
+void run_workers(std::size_t n, Fn&& fn) {
+  if (n == 0) return;
+
+  std::vector<std::exception_ptr> errors(n);
+  std::vector<std::thread> threads;
+  threads.reserve(n - 1);
+
+  try {
+    for (std::size_t k = 1; k < n; ++k) {
+      threads.emplace_back([&, k] {
+        try {
+          fn(k);
+        } catch (...) {
+          errors[k] = std::current_exception();
+        }
+      });
+    }
+  } catch (...) {
+    for (auto& t : threads) t.join();
+    throw;
+  }
+  try {
+    fn(0);
+  } catch (...) {
+    errors[0] = std::current_exception();
+  }
+  for (auto& t : threads) t.join();
+
+  for (auto& e : errors) {
+    if (e) std::rethrow_exception(e);
+  }
+}
+
+} // namespace qe::detail
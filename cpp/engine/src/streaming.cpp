@@ -0,0 +1,151 @@
+#include "qe/streaming.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace qe {
+
+static double nanv() {
+  return std::numeric_limits<double>::quiet_NaN();
+}
+
+void ReturnsStream::process(std::span<const double> close, std::vector<double>& out) {
+  out.clear();
+  out.reserve(close.size());
+
+  for (double curr : close) {
+    if (has_prev_) {
+      out.push_back(prev_ == 0.0 ? nanv() : (curr - prev_) / prev_);
+    }
+    prev_ = curr;
+    has_prev_ = true;
+  }
+}
+
+void RollingMeanStream::process(std::span<const double> values, std::vector<double>& out) {
+  out.resize(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    out[i] = push(values[i]);
+  }
+}
+
+void RollingStdStream::process(std::span<const double> values, std::vector<double>& out) {
+  out.resize(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    out[i] = push(values[i]);
+  }
+}
+
+static std::size_t checked_fast(std::size_t fast_window, std::size_t slow_window) {
+  if (fast_window == 0 || slow_window == 0) {
+    throw std::invalid_argument("windows must be > 0");
+  }
+  if (fast_window >= slow_window) {
+    throw std::invalid_argument("fast_window must be < slow_window");
+  }
+  return fast_window;
+}
+
+SmaCrossoverStream::SmaCrossoverStream(
+  std::size_t fast_window,
+  std::size_t slow_window,
+  double initial_equity,
+  BacktestCosts costs
+)
+  : slow_window_(slow_window),
+    initial_equity_(initial_equity),
+    fast_(checked_fast(fast_window, slow_window)),
+    slow_(slow_window),
+    cost_(costs.per_trade()),
+    equity_(initial_equity) {
+  if (initial_equity <= 0.0) {
+    throw std::invalid_argument("initial_equity must be > 0");
+  }
+  if (!(costs.fee_bps >= 0.0) || !(costs.slippage_bps >= 0.0)) {
+    throw std::invalid_argument("fee_bps and slippage_bps must be >= 0");
+  }
+}
+
+void SmaCrossoverStream::process(std::span<const double> close, std::vector<double>* equity_out) {
+  if (equity_out) {
+    equity_out->clear();
+    equity_out->reserve(close.size());
+  }
+
+  for (double c : close) {
+    if (closes_++ == 0) {
+      prev_close_ = c;
+      continue;
+    }
+
+    const double r = (prev_close_ == 0.0) ? nanv() : (c - prev_close_) / prev_close_;
+    prev_close_ = c;
+
+    // SMAs run over close[1..], aligned with the return ending at this bar
+    const double f = fast_.push(c);
+    const double s = slow_.push(c);
+    const int prev_pos = pos_;
+    if (!std::isnan(f) && !std::isnan(s)) {
+      pos_ = (f > s) ? 1 : 0;
+    }
+
+    double sr = static_cast<double>(pos_) * r;
+    if (pos_ != prev_pos) {
+      // a trade: charged on the equity before this step
+      ++trades_;
+      total_cost_ += equity_ * cost_;
+      sr = sr - cost_;
+    }
+    equity_ *= (1.0 + sr);
+
+    if (steps_ == 0) peak_ = equity_;
+    peak_ = std::max(peak_, equity_);
+    if (peak_ > 0.0) {
+      max_dd_ = std::max(max_dd_, (peak_ - equity_) / peak_);
+    }
+
+    ++steps_;
+    const double delta = sr - mean_;
+    mean_ += delta / static_cast<double>(steps_);
+    m2_ += delta * (sr - mean_);
+
+    if (!std::isnan(sr)) {
+      ++counted_;
+      if (sr > 0.0) ++wins_;
+    }
+
+    if (equity_out) equity_out->push_back(equity_);
+  }
+}
+
+BacktestResult SmaCrossoverStream::result() const {
+  const std::size_t min_rows = slow_window_ + 1;
+  if (closes_ < min_rows) {
+    throw std::invalid_argument(
+      "not enough data: need at least " + std::to_string(min_rows) +
+      " rows for slow_window=" + std::to_string(slow_window_) +
+      " (got " + std::to_string(closes_) + ")"
+    );
+  }
+
+  BacktestResult out;
+  out.total_return = (equity_ / initial_equity_) - 1.0;
+  out.max_drawdown = max_dd_;
+
+  const double sd = std::sqrt(m2_ / static_cast<double>(steps_));
+  out.sharpe = (sd == 0.0) ? 0.0 : mean_ / sd;
+  out.win_rate = win_rate();
+  out.n_trades = trades_;
+  out.total_cost = total_cost_;
+  return out;
+}
+
+double SmaCrossoverStream::win_rate() const {
+  if (counted_ == 0) return 0.0;
+  return static_cast<double>(wins_) / static_cast<double>(counted_);
+}
+
+} // namespace qe
@@ -0,0 +1,129 @@
+#include "qe/sweep.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "qe/indicator_cache.hpp"
+#include "work_stealing.hpp"
+
+namespace qe {
+
+static std::size_t parse_window(const std::string& text, const std::string& whole) {
+  const bool digits = !text.empty() && text.size() <= 9 &&
+                      std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; });
+  if (!digits) {
+    throw std::invalid_argument("bad window range '" + whole + "' (expected lo:hi[:step])");
+  }
+  return static_cast<std::size_t>(std::stoul(text));
+}
+
+WindowRange parse_window_range(const std::string& text) {
+  const std::size_t c1 = text.find(':');
+  if (c1 == std::string::npos) {
+    const std::size_t n = parse_window(text, text);
+    return {n, n, 1};
+  }
+  const std::size_t c2 = text.find(':', c1 + 1);
+  WindowRange r;
+  r.lo = parse_window(text.substr(0, c1), text);
+  r.hi = parse_window(text.substr(c1 + 1, c2 == std::string::npos ? std::string::npos : c2 - c1 - 1), text);
+  if (c2 != std::string::npos) r.step = parse_window(text.substr(c2 + 1), text);
+  return r;
+}
+
+std::vector<WindowPair> sma_grid(const WindowRange& fast, const WindowRange& slow) {
+  if (fast.step == 0 || slow.step == 0) {
+    throw std::invalid_argument("sma_grid: step must be > 0");
+  }
+  if (fast.lo == 0 || slow.lo == 0) {
+    throw std::invalid_argument("sma_grid: windows must be > 0");
+  }
+  std::vector<WindowPair> grid;
+  for (std::size_t f = fast.lo; f <= fast.hi; f += fast.step) {
+    for (std::size_t s = slow.lo; s <= slow.hi; s += slow.step) {
+      if (f < s) grid.push_back({f, s});
+    }
+  }
+  return grid;
+}
+
+std::vector<SweepRow> sweep_sma_crossover(std::span<const double> close, std::span<const WindowPair> grid,
+                                          const SweepOptions& opts) {
+  return sweep_strategy(find_strategy("sma_crossover"), close, grid, opts);
+}
+
+std::vector<SweepRow> sweep_strategy(const StrategyKernels& strategy, std::span<const double> close,
+                                     std::span<const WindowPair> grid, const SweepOptions& opts) {
+  for (const WindowPair& p : grid) {
+    if (p.fast == 0 || p.fast >= p.slow) {
+      throw std::invalid_argument("sweep: need 0 < fast < slow (got " + std::to_string(p.fast) + "/" +
+                                  std::to_string(p.slow) + ")");
+    }
+    if (close.size() < p.slow + 1) {
+      throw std::invalid_argument("sweep: not enough data for slow_window=" + std::to_string(p.slow) +
+                                  " (got " + std::to_string(close.size()) + " rows)");
+    }
+  }
+  if (opts.initial_equity <= 0.0) {
+    throw std::invalid_argument("initial_equity must be > 0");
+  }
+  if (!(opts.costs.fee_bps >= 0.0) || !(opts.costs.slippage_bps >= 0.0)) {
+    throw std::invalid_argument("fee_bps and slippage_bps must be >= 0");
+  }
+
+  std::vector<SweepRow> rows(grid.size());
+  if (grid.empty()) return rows;
+
+  const std::size_t threads =
+    opts.threads != 0 ? opts.threads : std::max(1u, std::thread::hardware_concurrency());
+  // pairs per task: up to a full batch, fewer when that leaves workers idle
+  const std::size_t batch = std::clamp<std::size_t>((grid.size() + threads - 1) / threads, 1, kSmaBatchLanes);
+  const std::size_t batches = (grid.size() + batch - 1) / batch;
+  const std::size_t workers = std::min(threads, batches);
+
+  // hashed once for the whole grid when the pairs share series through the cache
+  const bool cached = opts.cache != nullptr && strategy.cached != nullptr;
+  const SeriesSource source = cached ? make_series_source(close, "close") : SeriesSource{close, "close"};
+
+  // small chunks of batches keep the tail short
+  const std::size_t chunk = std::clamp<std::size_t>(batches / (workers * 16), 1, 64);
+  detail::run_stealing(batches, workers, chunk, [&](std::size_t, std::size_t b) {
+    const std::size_t first = b * batch;
+    const std::span<const WindowPair> pairs = grid.subspan(first, std::min(batch, grid.size() - first));
+    std::vector<BacktestResult> results;
+    if (cached) {
+      results.reserve(pairs.size());
+      for (const WindowPair& p : pairs) {
+        results.push_back(strategy.cached(source, p, opts.initial_equity, opts.costs, *opts.cache, {}, {}));
+      }
+    } else {
+      results = strategy.batch(close, pairs, opts.initial_equity, opts.costs);
+    }
+    for (std::size_t k = 0; k < pairs.size(); ++k) {
+      const BacktestResult& r = results[k];
+      rows[first + k] = {pairs[k].fast, pairs[k].slow, r.total_return, r.sharpe, r.max_drawdown, r.win_rate,
+                         r.n_trades, r.total_cost};
+    }
+  });
+  return rows;
+}
+
+void write_sweep_csv(const std::string& path, const std::vector<SweepRow>& rows) {
+  std::ofstream out(path, std::ios::binary);
+  if (!out) {
+    throw std::runtime_error("failed to open file for writing: " + path);
+  }
+  out << "fast,slow,total_return,sharpe,max_drawdown,win_rate,n_trades,total_cost\n";
+  for (const SweepRow& r : rows) {
+    out << r.fast << "," << r.slow << "," << r.total_return << "," << r.sharpe << "," << r.max_drawdown << ","
+        << r.win_rate << "," << r.n_trades << "," << r.total_cost << "\n";
+  }
+  if (!out) {
+    throw std::runtime_error("failed to write " + path);
+  }
+}
+
+} // namespace qe
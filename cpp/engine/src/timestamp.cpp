@@ -0,0 +1,212 @@
+#include "qe/timestamp.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+namespace qe {
+
+namespace {
+
+constexpr std::int64_t kNsPerSec = 1'000'000'000;
+constexpr std::int64_t kNsPerDay = 86'400 * kNsPerSec;
+
+// int64 nanoseconds cover 1677-09-21T00:12:43.145224192 .. 2262-04-11T23:47:16.854775807:
+// days -106752 (partly) to 106751
+constexpr std::int64_t kMaxDays = INT64_MAX / kNsPerDay;
+constexpr std::int64_t kMinDays = -kMaxDays - 1;
+
+// days * kNsPerDay + rest (the time of day and offset, well under a week either way),
+// false if that leaves int64
+bool day_ns(std::int64_t days, std::int64_t rest, std::int64_t& out) {
+  // whole days of rest first, so an offset can carry a date across either end
+  days += rest / kNsPerDay;
+  rest %= kNsPerDay;
+  if (rest < 0) {
+    --days;
+    rest += kNsPerDay;
+  }
+  if (days > kMaxDays || days < kMinDays) return false;
+  // midnight of kMinDays is itself out of range, so negative days count from the day after
+  if (days < 0) {
+    ++days;
+    rest -= kNsPerDay;
+  }
+  const std::int64_t base = days * kNsPerDay;
+  if (rest > 0 ? base > INT64_MAX - rest : base < INT64_MIN - rest) return false;
+  out = base + rest;
+  return true;
+}
+
+// reads exactly n digits starting at s[pos]
+bool read_digits(std::string_view s, std::size_t pos, std::size_t n, int& out) {
+  if (pos + n > s.size()) return false;
+  int v = 0;
+  for (std::size_t i = pos; i < pos + n; ++i) {
+    const char c = s[i];
+    if (c < '0' || c > '9') return false;
+    v = v * 10 + (c - '0');
+  }
+  out = v;
+  return true;
+}
+
+bool parse_epoch_integer(std::string_view s, std::int64_t& out) {
+  std::size_t i = 0;
+  const bool neg = !s.empty() && s[0] == '-';
+  if (neg) i = 1;
+  if (i >= s.size() || s.size() - i > 19) return false;
+
+  std::uint64_t u = 0;
+  for (; i < s.size(); ++i) {
+    const char c = s[i];
+    if (c < '0' || c > '9') return false;
+    u = u * 10 + static_cast<std::uint64_t>(c - '0');
+  }
+  if (u > static_cast<std::uint64_t>(INT64_MAX)) return false;
+  std::int64_t v = static_cast<std::int64_t>(u);
+
+  std::int64_t scale = 1;
+  if (v < 100'000'000'000LL) {
+    scale = kNsPerSec;
+  } else if (v < 100'000'000'000'000LL) {
+    scale = 1'000'000;
+  } else if (v < 100'000'000'000'000'000LL) {
+    scale = 1'000;
+  }
+  // e.g. 2e10 seconds is past 2262, the end of the int64 nanosecond range
+  if (v > INT64_MAX / scale) return false;
+  v *= scale;
+  out = neg ? -v : v;
+  return true;
+}
+
+} // namespace
+
+bool try_parse_timestamp_ns(std::string_view s, std::int64_t& out) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+  if (s.empty()) return false;
+
+  // plain integers are epoch values; dates always have a '-' at index 4
+  if (s.size() < 5 || s[4] != '-') {
+    return parse_epoch_integer(s, out);
+  }
+
+  int y = 0, mo = 0, d = 0;
+  if (!read_digits(s, 0, 4, y) || s[4] != '-' || !read_digits(s, 5, 2, mo) ||
+      s.size() < 10 || s[7] != '-' || !read_digits(s, 8, 2, d)) {
+    return false;
+  }
+
+  const std::chrono::year_month_day ymd{
+    std::chrono::year{y}, std::chrono::month{static_cast<unsigned>(mo)},
+    std::chrono::day{static_cast<unsigned>(d)}};
+  if (!ymd.ok()) return false;
+
+  const std::int64_t days = std::chrono::sys_days{ymd}.time_since_epoch().count();
+  std::int64_t rest = 0;
+  std::size_t pos = 10;
+
+  if (pos < s.size()) {
+    if (s[pos] != 'T' && s[pos] != ' ') return false;
+    ++pos;
+
+    int hh = 0, mm = 0, ss = 0;
+    if (!read_digits(s, pos, 2, hh) || pos + 2 >= s.size() || s[pos + 2] != ':' ||
+        !read_digits(s, pos + 3, 2, mm)) {
+      return false;
+    }
+    pos += 5;
+
+    if (pos < s.size() && s[pos] == ':') {
+      if (!read_digits(s, pos + 1, 2, ss)) return false;
+      pos += 3;
+    }
+    if (hh > 23 || mm > 59 || ss > 60) return false;
+
+    std::int64_t frac = 0;
+    if (pos < s.size() && s[pos] == '.') {
+      ++pos;
+      std::int64_t scale = 100'000'000;
+      std::size_t n = 0;
+      while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9') {
+        if (n < 9) {
+          frac += (s[pos] - '0') * scale;
+          scale /= 10;
+        }
+        ++n;
+        ++pos;
+      }
+      if (n == 0) return false;
+    }
+
+    rest += (static_cast<std::int64_t>(hh) * 3600 + mm * 60 + ss) * kNsPerSec + frac;
+
+    if (pos < s.size()) {
+      if (s[pos] == 'Z' && pos + 1 == s.size()) {
+        ++pos;
+      } else if (s[pos] == '+' || s[pos] == '-') {
+        int oh = 0, om = 0;
+        if (!read_digits(s, pos + 1, 2, oh)) return false;
+        std::size_t mpos = pos + 3;
+        if (mpos < s.size() && s[mpos] == ':') ++mpos;
+        if (!read_digits(s, mpos, 2, om) || mpos + 2 != s.size()) return false;
+
+        const std::int64_t off = (static_cast<std::int64_t>(oh) * 3600 + om * 60) * kNsPerSec;
+        rest += (s[pos] == '+') ? -off : off;
+        pos = s.size();
+      } else {
+        return false;
+      }
+    }
+  }
+
+  return day_ns(days, rest, out);
+}
+
+std::int64_t parse_timestamp_ns(std::string_view text) {
+  std::int64_t ns = 0;
+  if (!try_parse_timestamp_ns(text, ns)) {
+    throw std::invalid_argument("invalid timestamp: '" + std::string(text) + "'");
+  }
+  return ns;
+}
+
+std::string format_timestamp(std::int64_t ns) {
+  std::int64_t days = ns / kNsPerDay;
+  std::int64_t rem = ns % kNsPerDay;
+  if (rem < 0) {
+    rem += kNsPerDay;
+    --days;
+  }
+
+  const std::chrono::year_month_day ymd{
+    std::chrono::sys_days{std::chrono::days{static_cast<int>(days)}}};
+
+  char buf[40];
+  const int y = static_cast<int>(ymd.year());
+  const unsigned mo = static_cast<unsigned>(ymd.month());
+  const unsigned d = static_cast<unsigned>(ymd.day());
+
+  if (rem == 0) {
+    std::snprintf(buf, sizeof(buf), "%04d-%02u-%02u", y, mo, d);
+    return buf;
+  }
+
+  const std::int64_t secs = rem / kNsPerSec;
+  const std::int64_t frac = rem % kNsPerSec;
+  const int hh = static_cast<int>(secs / 3600);
+  const int mm = static_cast<int>((secs / 60) % 60);
+  const int ss = static_cast<int>(secs % 60);
+
+  if (frac == 0) {
+    std::snprintf(buf, sizeof(buf), "%04d-%02u-%02uT%02d:%02d:%02d", y, mo, d, hh, mm, ss);
+  } else {
+    std::snprintf(buf, sizeof(buf), "%04d-%02u-%02uT%02d:%02d:%02d.%09lld", y, mo, d, hh, mm, ss,
+                  static_cast<long long>(frac));
+  }
+  return buf;
+}
+
+} // namespace qe
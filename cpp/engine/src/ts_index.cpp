@@ -0,0 +1,310 @@
+#include "qe/ts_index.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+#include "qe/mapped_file.hpp"
+#include "qe/qec.hpp"
+#include "qe/timestamp.hpp"
+
+#include "csv_parse.hpp"
+
+namespace qe {
+
+namespace {
+
+using namespace csv_detail;
+
+// walks the data lines of a mapped CSV; line is the file line number at p
+struct Cursor {
+  const char* p;
+  const char* end;
+  std::uint64_t line;
+};
+
+// next non-blank line as [b, e) (CR stripped) with its line number; false at end of data
+bool next_row(Cursor& c, const char*& b, const char*& e, std::uint64_t& line) {
+  while (c.p < c.end) {
+    const char* nl = static_cast<const char*>(
+      std::memchr(c.p, '\n', static_cast<std::size_t>(c.end - c.p)));
+    b = c.p;
+    e = nl ? nl : c.end;
+    line = c.line++;
+    c.p = nl ? nl + 1 : c.end;
+
+    if (e > b && e[-1] == '\r') --e;
+    if (e > b) return true;
+  }
+  return false;
+}
+
+// parses just the timestamp field of a row, reporting errors like the full parser
+std::int64_t row_ts(const std::string& path, const char* b, const char* e, std::uint64_t line) {
+  const char* comma = static_cast<const char*>(std::memchr(b, ',', static_cast<std::size_t>(e - b)));
+  if (!comma) throw_parse_error(path, line, 1);
+
+  std::int64_t t = 0;
+  if (!try_parse_timestamp_ns(std::string_view(b, static_cast<std::size_t>(comma - b)), t)) {
+    throw_parse_error(path, line, 0);
+  }
+  return t;
+}
+
+void map_csv(MappedFile& file, const std::string& path) {
+  if (!file.open(path)) {
+    throw std::runtime_error("Failed to open CSV file: " + path);
+  }
+  if (file.size() == 0) {
+    throw std::runtime_error("CSV file is empty: " + path);
+  }
+}
+
+// cursor at the first line after the header
+Cursor body_cursor(const MappedFile& file) {
+  const char* begin = file.data();
+  const char* end = begin + file.size();
+  const char* nl = static_cast<const char*>(std::memchr(begin, '\n', file.size()));
+  return Cursor{nl ? nl + 1 : end, end, 2};
+}
+
+std::int64_t file_mtime(const std::string& path) {
+  std::error_code ec;
+  const auto t = std::filesystem::last_write_time(path, ec);
+  return ec ? 0 : static_cast<std::int64_t>(t.time_since_epoch().count());
+}
+
+// data row position inside a mapped CSV
+struct RowPos {
+  std::uint64_t row;
+  const char* p;
+  std::uint64_t line;
+};
+
+class RangeLocator {
+public:
+  RangeLocator(const std::string& path, const MappedFile& file, const TsIndex& index)
+    : path_(path), begin_(file.data()), end_(file.data() + file.size()), index_(index) {}
+
+  // first row with ts >= t (rows == index.rows if there is none)
+  RowPos first_at_or_after(std::int64_t t) const {
+    const auto& entries = index_.entries;
+    const auto it = std::lower_bound(entries.begin(), entries.end(), t,
+                                     [](const TsIndexEntry& e, std::int64_t v) { return e.ts < v; });
+    const std::size_t k = (it == entries.begin()) ? 0 : static_cast<std::size_t>(it - entries.begin()) - 1;
+
+    Cursor c = at_entry(k);
+    std::uint64_t row = k * index_.stride;
+    const char* b;
+    const char* e;
+    std::uint64_t line;
+    while (next_row(c, b, e, line)) {
+      if (row_ts(path_, b, e, line) >= t) return {row, b, line};
+      ++row;
+    }
+    return {index_.rows, end_, c.line};
+  }
+
+  // position of an arbitrary row (< index.rows)
+  RowPos seek_row(std::uint64_t row) const {
+    const std::size_t k = static_cast<std::size_t>(row / index_.stride);
+    Cursor c = at_entry(k);
+    const char* b = c.p;
+    const char* e;
+    std::uint64_t line = c.line;
+    for (std::uint64_t r = k * index_.stride; r <= row; ++r) {
+      if (!next_row(c, b, e, line)) throw_stale();
+    }
+    return {row, b, line};
+  }
+
+private:
+  Cursor at_entry(std::size_t k) const {
+    const TsIndexEntry& entry = index_.entries[k];
+    return Cursor{begin_ + entry.offset, end_, entry.line};
+  }
+
+  [[noreturn]] void throw_stale() const {
+    throw std::runtime_error("timestamp index does not match " + path_ + " (rebuild " +
+                             ts_index_path(path_) + ")");
+  }
+
+  const std::string& path_;
+  const char* begin_;
+  const char* end_;
+  const TsIndex& index_;
+};
+
+struct ColumnSink {
+  OhlcvColumns out;
+
+  bool operator()(std::string_view ts, const double (&v)[5]) {
+    std::int64_t t = 0;
+    if (!try_parse_timestamp_ns(ts, t)) return false;
+    out.push_back(t, v[0], v[1], v[2], v[3], v[4]);
+    return true;
+  }
+};
+
+} // namespace
+
+std::string ts_index_path(const std::string& csv_path) {
+  return csv_path + ".qei";
+}
+
+TsIndex build_ts_index(const std::string& csv_path, std::size_t stride) {
+  if (stride == 0) {
+    throw std::invalid_argument("build_ts_index: stride must be > 0");
+  }
+
+  MappedFile file;
+  map_csv(file, csv_path);
+
+  TsIndex index;
+  index.stride = stride;
+  index.source_size = file.size();
+  index.source_mtime = file_mtime(csv_path);
+
+  Cursor c = body_cursor(file);
+  const char* b;
+  const char* e;
+  std::uint64_t line;
+  std::uint64_t row = 0;
+  std::int64_t prev = std::numeric_limits<std::int64_t>::min();
+  while (next_row(c, b, e, line)) {
+    // every row is checked, not just sampled ones: range lookups scan a stride linearly
+    // and would silently return the wrong rows if it were out of order
+    const std::int64_t t = row_ts(csv_path, b, e, line);
+    if (t < prev) {
+      throw std::runtime_error("CSV is not sorted by timestamp: " + csv_path + " at line " +
+                               std::to_string(line));
+    }
+    prev = t;
+    if (row % stride == 0) {
+      index.entries.push_back({t, static_cast<std::uint64_t>(b - file.data()), line});
+    }
+    ++row;
+  }
+  index.rows = row;
+  return index;
+}
+
+void write_ts_index(const std::string& path, const TsIndex& index) {
+  const std::size_t entry_bytes = index.entries.size() * sizeof(TsIndexEntry);
+
+  TsIndexHeader h{};
+  std::memcpy(h.magic, kTsIndexMagic, sizeof(kTsIndexMagic));
+  h.version = kTsIndexVersion;
+  h.stride = static_cast<std::uint32_t>(index.stride);
+  h.rows = index.rows;
+  h.source_size = index.source_size;
+  h.source_mtime = index.source_mtime;
+  h.entries = index.entries.size();
+  h.entries_checksum = qec_checksum(index.entries.data(), entry_bytes);
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("failed to open timestamp index for write: " + path);
+  }
+  out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  out.write(reinterpret_cast<const char*>(index.entries.data()),
+            static_cast<std::streamsize>(entry_bytes));
+  if (!out) {
+    throw std::runtime_error("failed to write timestamp index: " + path);
+  }
+}
+
+std::optional<TsIndex> read_ts_index(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return std::nullopt;
+
+  TsIndexHeader h{};
+  if (!in.read(reinterpret_cast<char*>(&h), sizeof(h))) return std::nullopt;
+  if (std::memcmp(h.magic, kTsIndexMagic, sizeof(kTsIndexMagic)) != 0 ||
+      h.version != kTsIndexVersion || h.stride == 0 ||
+      h.entries != (h.rows + h.stride - 1) / h.stride) {
+    return std::nullopt;
+  }
+
+  // the entry count must fit in what is left of the file before anything is allocated
+  std::error_code ec;
+  const auto file_bytes = std::filesystem::file_size(path, ec);
+  if (ec || file_bytes < sizeof(h) ||
+      h.entries > (file_bytes - sizeof(h)) / sizeof(TsIndexEntry)) {
+    return std::nullopt;
+  }
+
+  TsIndex index;
+  index.stride = h.stride;
+  index.rows = h.rows;
+  index.source_size = h.source_size;
+  index.source_mtime = h.source_mtime;
+  index.entries.resize(static_cast<std::size_t>(h.entries));
+
+  const std::size_t entry_bytes = index.entries.size() * sizeof(TsIndexEntry);
+  if (!in.read(reinterpret_cast<char*>(index.entries.data()), static_cast<std::streamsize>(entry_bytes)) ||
+      qec_checksum(index.entries.data(), entry_bytes) != h.entries_checksum) {
+    return std::nullopt;
+  }
+  return index;
+}
+
+TsIndex load_ts_index(const std::string& csv_path) {
+  const std::string sidecar = ts_index_path(csv_path);
+
+  std::error_code ec;
+  const auto size = std::filesystem::file_size(csv_path, ec);
+  if (!ec) {
+    if (auto cached = read_ts_index(sidecar)) {
+      if (cached->source_size == size && cached->source_mtime == file_mtime(csv_path)) {
+        return std::move(*cached);
+      }
+    }
+  }
+
+  TsIndex index = build_ts_index(csv_path);
+  try {
+    write_ts_index(sidecar, index);
+  } catch (const std::runtime_error&) {
+    // not fatal: the index is only a cache
+  }
+  return index;
+}
+
+OhlcvColumns read_ohlcv_columns(const std::string& csv_path, const TsIndex& index,
+                                const TimeRange& range) {
+  MappedFile file;
+  map_csv(file, csv_path);
+  if (file.size() != index.source_size) {
+    throw std::runtime_error("timestamp index does not match " + csv_path + " (rebuild " +
+                             ts_index_path(csv_path) + ")");
+  }
+  if (index.rows == 0 || range.start_ns >= range.end_ns) {
+    return {};
+  }
+
+  const RangeLocator locate(csv_path, file, index);
+  const RowPos start = locate.first_at_or_after(range.start_ns);
+  const RowPos stop = locate.first_at_or_after(range.end_ns);
+  if (start.row >= stop.row) {
+    return {}; // nothing in range, so no warm-up either
+  }
+
+  const std::uint64_t warmup = std::min<std::uint64_t>(range.warmup_bars, start.row);
+  const RowPos first = (warmup == 0) ? start : locate.seek_row(start.row - warmup);
+
+  ColumnSink sink;
+  sink.out.reserve(static_cast<std::size_t>(stop.row - first.row));
+  const ParseFailure failure = parse_range(first.p, stop.p, static_cast<std::size_t>(first.line), sink);
+  if (failure.line != 0) {
+    throw_parse_error(csv_path, failure.line, failure.field);
+  }
+  return std::move(sink.out);
+}
+
+} // namespace qe
@@ -0,0 +1,301 @@
+#pragma once
+
+// sma_backtest across parameters for the sma_backtest_batch kernels: one (fast, slow) pair per
+// SIMD lane, each lane taking exactly the steps sma_backtest takes for its pair
+// (rolling_sum_step's blocks, signal_step, EquityPass, Drawdown::step, the i % 8 lane sums and
+// the two-pass variance), so every lane's metrics are sma_backtest's bit for bit. Written once
+// against a lane type V that the including kernels_*.cpp defines in its anonymous namespace (as
+// for vec_math.hpp). Besides V(double), load/store, + - * /, less, greater and select, V
+// provides:
+//   at_least(a, b) (a >= b), ordered(a, b) (neither is NaN), differ(a, b) (a != b) -> mask,
+//   any(mask), vabs,
+//   V::gather(p, idx, mask) = p[idx[k]] in the lanes of mask and 0.0 in the others.
+// The divisions a step needs are mostly settled without dividing: the crossover from the
+// window sums times the reciprocal windows, and the drawdown against max_dd * peak. Each
+// falls back to the exact division, for the whole register, where a lane's products are too
+// close to call, so the results do not depend on the shortcut.
+// Include after kernels_common.hpp.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace qe::kernels::vbacktest {
+
+// one register of pairs: the windows and each pair's running state
+template <class V>
+struct Lanes {
+  V fw;                                // windows, as doubles
+  V sw;
+  V inv_fw;                            // 1 / fw and 1 / sw
+  V inv_sw;
+  std::int64_t fast_back[V::kLanes];   // -fw and -sw, the gather offsets from close + 1 + i
+  std::int64_t slow_back[V::kLanes];
+
+  // CrossoverState
+  V fast_carry;
+  V fast_block[4];
+  V slow_carry;
+  V slow_block[4];
+  V pos;
+
+  // EquityPass and PassStats, win counts as doubles
+  V eq;
+  V trades;
+  V total_cost;
+  V peak;
+  V max_dd;
+  V dd_valid;
+  V lane[8];
+  V wins;
+  V total;
+
+  // the second (variance) pass
+  V mean;
+  V sq[8];
+};
+
+// rolling_sum_step at block position Pos on every lane
+template <std::size_t Pos, class V>
+inline V window_sum(V& carry, V (&block)[4], V d) {
+  const V zero = 0.0;
+  block[Pos] = d;
+  V y;
+  if constexpr (Pos == 0) {
+    y = (block[0] + zero) + zero;
+  } else if constexpr (Pos == 1) {
+    y = (block[1] + block[0]) + zero;
+  } else if constexpr (Pos == 2) {
+    y = (block[2] + block[1]) + (block[0] + zero);
+  } else {
+    y = (block[3] + block[2]) + (block[1] + block[0]);
+  }
+  const V s = carry + y;
+  if constexpr (Pos == 3) carry = s;
+  return s;
+}
+
+template <class V>
+inline void reset_signal(Lanes<V>& s) {
+  s.fast_carry = 0.0;
+  s.slow_carry = 0.0;
+  for (std::size_t k = 0; k < 4; ++k) {
+    s.fast_block[k] = 0.0;
+    s.slow_block[k] = 0.0;
+  }
+  s.pos = 0.0;
+}
+
+// Lanes where qf > qs (each within 3 ulp of its SMA) might not give the order of the SMAs
+// themselves: closer than 2^-49 relative, or too small for relative bounds. NaN lanes are
+// not close calls; inf - inf only arises for equal SMAs, which greater() orders correctly.
+template <class V>
+inline auto close_call(V qf, V qs) {
+  const V size = vabs(qf) + vabs(qs);
+  const V margin = select(at_least(size, V(0x1p-960)), size * V(0x1p-49), V(kInf));
+  return at_least(margin, vabs(qf - qs));
+}
+
+// sma_crossover_scalar's step i (K = i % 8) on every lane: the strategy return into out;
+// returns where the position changed
+template <std::size_t K, class V>
+inline auto signal(Lanes<V>& s, const double* close, std::size_t i, V cost, V& out) {
+  const double* v = close + 1;
+  const V at = static_cast<double>(i);
+  const V filled = static_cast<double>(i + 1);
+  const V cur = v[i];
+  const V df = cur - V::gather(v + i, s.fast_back, at_least(at, s.fw));
+  const V ds = cur - V::gather(v + i, s.slow_back, at_least(at, s.sw));
+  const V sum_f = window_sum<K % 4>(s.fast_carry, s.fast_block, df);
+  const V sum_s = window_sum<K % 4>(s.slow_carry, s.slow_block, ds);
+  const auto fast_ready = at_least(filled, s.fw);
+  const auto slow_ready = at_least(filled, s.sw);
+
+  // the SMAs within a few ulp (and NaN, inf and the heads exactly as the SMAs)
+  const V qf = select(fast_ready, sum_f * s.inv_fw, V(kNaN));
+  const V qs = select(slow_ready, sum_s * s.inv_sw, V(kNaN));
+  auto up = greater(qf, qs);
+  if (any(close_call(qf, qs))) {
+    up = greater(select(fast_ready, sum_f / s.fw, V(kNaN)), select(slow_ready, sum_s / s.sw, V(kNaN)));
+  }
+
+  const V next = select(ordered(qf, qs), select(up, V(1.0), V(0.0)), s.pos);
+  const auto changed = differ(next, s.pos);
+  const V x = next * V(return_at(close, i));
+  out = select(changed, x - cost, x);
+  s.pos = next;
+  return changed;
+}
+
+// EquityPass, the drawdown (started at equity[0]), the lane sums and the win counts for step i
+// (K = i % 8)
+template <std::size_t K, class V, class Mask>
+inline void account(Lanes<V>& s, std::size_t i, Mask changed, V r, V cost) {
+  const V zero = 0.0;
+  const V one = 1.0;
+  s.trades = select(changed, s.trades + one, s.trades);
+  s.total_cost = select(changed, s.total_cost + s.eq * cost, s.total_cost);
+  s.eq = s.eq * (one + r);
+
+  if (i == 0) {
+    s.peak = s.eq;
+    s.max_dd = zero;
+    s.dd_valid = select(ordered(s.eq, s.eq), one, zero);
+  }
+  s.peak = select(less(s.peak, s.eq), s.eq, s.peak);
+  // drop <= max_dd * peak (less a margin for its rounding) means drop / peak <= max_dd, so
+  // only a register where some lane may set a new maximum divides
+  const V drop = s.peak - s.eq;
+  const V bound = s.max_dd * s.peak;
+  const V limit = select(at_least(bound, V(0x1p-960)), bound * V(1.0 - 0x1p-50), zero);
+  if (any(greater(drop, limit))) {
+    // dd is >= 0 or NaN, so a 0 where the peak is not positive leaves max_dd as it is
+    const V dd = select(greater(s.peak, zero), drop / s.peak, zero);
+    s.max_dd = select(less(s.max_dd, dd), dd, s.max_dd);
+  }
+
+  s.lane[K] = s.lane[K] + r;
+  s.wins = select(greater(r, zero), s.wins + one, s.wins);
+  s.total = select(ordered(r, r), s.total + one, s.total);
+}
+
+// fold_lanes on every lane
+template <class V>
+inline V fold(const V (&lane)[8]) {
+  const V t0 = lane[0] + lane[4];
+  const V t1 = lane[1] + lane[5];
+  const V t2 = lane[2] + lane[6];
+  const V t3 = lane[3] + lane[7];
+  return (t0 + t2) + (t1 + t3);
+}
+
+// the first pass (signal, equity and metrics) or the second (squared deviations from mean)
+enum class Pass { Metrics, Variance };
+
+template <Pass P, std::size_t K, class V>
+inline void step(Lanes<V>& s, const double* close, std::size_t i, V cost) {
+  V r;
+  const auto changed = signal<K>(s, close, i, cost, r);
+  if constexpr (P == Pass::Metrics) {
+    account<K>(s, i, changed, r, cost);
+  } else {
+    const V d = r - s.mean;
+    s.sq[K] = s.sq[K] + d * d;
+  }
+}
+
+// steps [first, last) of one register, first % 8 == 0: unrolled by 8 so every step's block
+// position and lane is a constant, on a local copy of the state so it can stay in registers
+template <Pass P, class V>
+void run_chunk(Lanes<V>& state, const double* close, std::size_t first, std::size_t last, V cost) {
+  Lanes<V> s = state;
+  std::size_t i = first;
+  for (; i + 8 <= last; i += 8) {
+    step<P, 0>(s, close, i, cost);
+    step<P, 1>(s, close, i + 1, cost);
+    step<P, 2>(s, close, i + 2, cost);
+    step<P, 3>(s, close, i + 3, cost);
+    step<P, 4>(s, close, i + 4, cost);
+    step<P, 5>(s, close, i + 5, cost);
+    step<P, 6>(s, close, i + 6, cost);
+    step<P, 7>(s, close, i + 7, cost);
+  }
+  if (i < last) step<P, 0>(s, close, i, cost);
+  if (i + 1 < last) step<P, 1>(s, close, i + 1, cost);
+  if (i + 2 < last) step<P, 2>(s, close, i + 2, cost);
+  if (i + 3 < last) step<P, 3>(s, close, i + 3, cost);
+  if (i + 4 < last) step<P, 4>(s, close, i + 4, cost);
+  if (i + 5 < last) step<P, 5>(s, close, i + 5, cost);
+  if (i + 6 < last) step<P, 6>(s, close, i + 6, cost);
+  state = s;
+}
+
+// kernels::sma_backtest_batch. Pairs are padded to whole registers with copies of the last
+// one; the steps run in chunks of kPassChunk, each register in turn, so the chunk of close
+// is read from memory once and from L1 for the other registers.
+template <class V>
+void sma_backtest_batch(const double* close, std::size_t n, const std::size_t* fast, const std::size_t* slow,
+                        std::size_t lanes, double initial, double cost, BacktestPass* out) {
+  constexpr std::size_t L = V::kLanes;
+  const std::size_t regs = (lanes + L - 1) / L;
+  const std::size_t m = n - 1;
+  const V cv = cost;
+
+  Lanes<V> st[kBatchLanes / L];
+  for (std::size_t g = 0; g < regs; ++g) {
+    Lanes<V>& s = st[g];
+    double fw[L];
+    double sw[L];
+    for (std::size_t k = 0; k < L; ++k) {
+      const std::size_t pair = g * L + k < lanes ? g * L + k : lanes - 1;
+      fw[k] = static_cast<double>(fast[pair]);
+      sw[k] = static_cast<double>(slow[pair]);
+      s.fast_back[k] = -static_cast<std::int64_t>(fast[pair]);
+      s.slow_back[k] = -static_cast<std::int64_t>(slow[pair]);
+    }
+    s.fw = V::load(fw);
+    s.sw = V::load(sw);
+    s.inv_fw = V(1.0) / s.fw;
+    s.inv_sw = V(1.0) / s.sw;
+    reset_signal(s);
+    s.eq = initial;
+    s.trades = 0.0;
+    s.total_cost = 0.0;
+    s.peak = 0.0;
+    s.max_dd = 0.0;
+    s.dd_valid = 0.0;
+    for (std::size_t k = 0; k < 8; ++k) {
+      s.lane[k] = 0.0;
+      s.sq[k] = 0.0;
+    }
+    s.wins = 0.0;
+    s.total = 0.0;
+  }
+
+  for (std::size_t first = 0; first < m; first += kPassChunk) {
+    const std::size_t last = m - first < kPassChunk ? m : first + kPassChunk;
+    for (std::size_t g = 0; g < regs; ++g) run_chunk<Pass::Metrics>(st[g], close, first, last, cv);
+  }
+
+  const V steps = static_cast<double>(m);
+  for (std::size_t g = 0; g < regs; ++g) {
+    st[g].mean = fold(st[g].lane) / steps;
+    reset_signal(st[g]);
+  }
+  for (std::size_t first = 0; first < m; first += kPassChunk) {
+    const std::size_t last = m - first < kPassChunk ? m : first + kPassChunk;
+    for (std::size_t g = 0; g < regs; ++g) run_chunk<Pass::Variance>(st[g], close, first, last, cv);
+  }
+
+  for (std::size_t g = 0; g < regs; ++g) {
+    const Lanes<V>& s = st[g];
+    double eq[L];
+    double dd[L];
+    double valid[L];
+    double mean[L];
+    double var[L];
+    double wins[L];
+    double total[L];
+    double trades[L];
+    double total_cost[L];
+    s.eq.store(eq);
+    s.max_dd.store(dd);
+    s.dd_valid.store(valid);
+    s.mean.store(mean);
+    (fold(s.sq) / steps).store(var);
+    s.wins.store(wins);
+    s.total.store(total);
+    s.trades.store(trades);
+    s.total_cost.store(total_cost);
+    for (std::size_t k = 0; k < L && g * L + k < lanes; ++k) {
+      out[g * L + k] = {eq[k],
+                        valid[k] != 0.0 ? dd[k] : 0.0,
+                        mean[k],
+                        var[k],
+                        {static_cast<std::size_t>(wins[k]), static_cast<std::size_t>(total[k])},
+                        static_cast<std::size_t>(trades[k]),
+                        total_cost[k]};
+    }
+  }
+}
+
+} // namespace qe::kernels::vbacktest
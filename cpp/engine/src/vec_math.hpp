@@ -0,0 +1,230 @@
+#pragma once
+
+// exp, log and erfc over SIMD registers for the vector black_scholes kernels, after the
+// Cephes double-precision routines (range reduction plus rational approximations, a few ulp).
+// Written once against a lane type V that the including kernels_*.cpp defines in its
+// anonymous namespace, so each instantiation stays local to its ISA file. V provides:
+//   V(double) broadcast, + - * / and unary -, less(a, b) / greater(a, b) -> mask,
+//   select(mask, a, b) = mask ? a : b, vsqrt, vfloor, vabs,
+//   pow2(n) = 2^n for integral n in [-1022, 1023],
+//   split_exponent(x, e) = m with x = m * 2^e, m in [0.5, 1) (x positive and normal).
+// Arguments are finite (black_scholes_batch validates them).
+
+#include <cstddef>
+#include <limits>
+
+namespace qe::kernels::vmath {
+
+// coefficients from Cephes exp.c, log.c and ndtr.c
+inline constexpr double kExpP[] = {
+  1.26177193074810590878E-4,
+  3.02994407707441961300E-2,
+  9.99999999999999999910E-1,
+};
+inline constexpr double kExpQ[] = {
+  3.00198505138664455042E-6,
+  2.52448340349684104192E-3,
+  2.27265548208155028766E-1,
+  2.00000000000000000009E0,
+};
+inline constexpr double kLog2e = 1.4426950408889634073599;
+inline constexpr double kExpC1 = 6.93145751953125E-1;
+inline constexpr double kExpC2 = 1.42860682030941723212E-6;
+inline constexpr double kMaxLog = 7.09782712893383996843E2;
+inline constexpr double kMinLog = -7.08396418532264106224E2;
+
+inline constexpr double kLogP[] = {
+  1.01875663804580931796E-4,
+  4.97494994976747001425E-1,
+  4.70579119878881725854E0,
+  1.44989225341610930846E1,
+  1.79368678507819816313E1,
+  7.70838733755885391666E0,
+};
+inline constexpr double kLogQ[] = { // leading 1 implied
+  1.12873587189167450590E1,
+  4.52279145837532221105E1,
+  8.29875266912776603211E1,
+  7.11544750618563894466E1,
+  2.31251620126765340583E1,
+};
+inline constexpr double kSqrtHalf = 7.07106781186547524401E-1;
+
+inline constexpr double kErfcP[] = {
+  2.46196981473530512524E-10,
+  5.64189564831068821977E-1,
+  7.46321056442269912687E0,
+  4.86371970985681366614E1,
+  1.96520832956077098242E2,
+  5.26445194995477358631E2,
+  9.34528527171957607540E2,
+  1.02755188689515710272E3,
+  5.57535335369399327526E2,
+};
+inline constexpr double kErfcQ[] = { // leading 1 implied
+  1.32281951154744992508E1,
+  8.67072140885989742329E1,
+  3.54937778887819891062E2,
+  9.75708501743205489753E2,
+  1.82390916687909736289E3,
+  2.24633760818710981792E3,
+  1.65666309194161350182E3,
+  5.57535340817727675546E2,
+};
+inline constexpr double kErfcR[] = {
+  5.64189583547755073984E-1,
+  1.27536670759978104416E0,
+  5.01905042251180477414E0,
+  6.16021097993053585195E0,
+  7.40974269950448939160E0,
+  2.97886665372100240670E0,
+};
+inline constexpr double kErfcS[] = { // leading 1 implied
+  2.26052863220117276590E0,
+  9.39603524938001434673E0,
+  1.20489539808096656605E1,
+  1.70814450747565897222E1,
+  9.60896809063285878198E0,
+  3.36907645100081516050E0,
+};
+inline constexpr double kErfT[] = {
+  9.60497373987051638749E0,
+  9.00260197203842689217E1,
+  2.23200534594684319226E3,
+  7.00332514112805075473E3,
+  5.55923013010394962768E4,
+};
+inline constexpr double kErfU[] = { // leading 1 implied
+  3.35617141647503099647E1,
+  5.21357949780152679795E2,
+  4.59432382970980127987E3,
+  2.26290000613890934246E4,
+  4.92673942608635921086E4,
+};
+
+inline constexpr double kSqrt2 = 1.41421356237309504880;
+inline constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+// c[0] x^(N-1) + ... + c[N-1]
+template <class V, std::size_t N>
+V polevl(V x, const double (&c)[N]) {
+  V y = c[0];
+  for (std::size_t i = 1; i < N; ++i) y = y * x + c[i];
+  return y;
+}
+
+// x^N + c[0] x^(N-1) + ... + c[N-1]
+template <class V, std::size_t N>
+V p1evl(V x, const double (&c)[N]) {
+  V y = x + c[0];
+  for (std::size_t i = 1; i < N; ++i) y = y * x + c[i];
+  return y;
+}
+
+template <class V>
+V vexp(V x) {
+  // x = n ln2 + g, |g| <= ln2 / 2; exp(g) = 1 + 2g P(g^2) / (Q(g^2) - g P(g^2))
+  const V n = vfloor(kLog2e * x + 0.5);
+  V g = x - n * kExpC1;
+  g = g - n * kExpC2;
+  const V gg = g * g;
+  const V p = g * polevl(gg, kExpP);
+  V y = p / (polevl(gg, kExpQ) - p);
+  y = 1.0 + 2.0 * y;
+
+  // 2^n in two halves, so n up to 1024 stays representable
+  const V half = vfloor(n * 0.5);
+  y = y * pow2(half) * pow2(n - half);
+  y = select(less(x, V(kMinLog)), V(0.0), y);
+  return select(greater(x, V(kMaxLog)), V(kInfinity), y);
+}
+
+template <class V>
+V vlog(V x) {
+  // x = m 2^e; log(x) = log1p(m - 1) + e ln2, with m in [sqrt(1/2), sqrt(2))
+  V e;
+  const V m = split_exponent(x, e);
+  const auto low = less(m, V(kSqrtHalf));
+  e = select(low, e - 1.0, e);
+  const V f = select(low, (m + m) - 1.0, m - 1.0);
+
+  const V z = f * f;
+  V y = f * (z * polevl(f, kLogP) / p1evl(f, kLogQ));
+  y = y - e * 2.121944400546905827679E-4;
+  y = y - 0.5 * z;
+  return (f + y) + e * 0.693359375;
+}
+
+template <class V>
+V verfc(V x) {
+  const V a = vabs(x);
+  const V z = x * x;
+
+  // |x| < 1: 1 - erf(x)
+  const V inner = 1.0 - x * polevl(z, kErfT) / p1evl(z, kErfU);
+
+  // |x| >= 1: exp(-x^2) P(|x|) / Q(|x|), with separate fits below and above 8
+  const V mid = polevl(a, kErfcP) / p1evl(a, kErfcQ);
+  const V outer = polevl(a, kErfcR) / p1evl(a, kErfcS);
+  V y = vexp(-z) * select(less(a, V(8.0)), mid, outer);
+  y = select(less(x, V(0.0)), 2.0 - y, y);
+  return select(less(a, V(1.0)), inner, y);
+}
+
+// standard normal cdf, as norm_cdf in options.cpp
+template <class V>
+V vnorm_cdf(V x) {
+  return 0.5 * verfc(-x / kSqrt2);
+}
+
+// call and put prices, the expressions of black_scholes_call / black_scholes_put
+template <class V>
+void black_scholes(V S, V K, V r, V sigma, V T, V& call, V& put) {
+  const V vol_sqrt_t = sigma * vsqrt(T);
+  const V d1 = (vlog(S / K) + (r + 0.5 * sigma * sigma) * T) / vol_sqrt_t;
+  const V d2 = d1 - vol_sqrt_t;
+  const V disc_k = K * vexp(-r * T);
+  call = S * vnorm_cdf(d1) - disc_k * vnorm_cdf(d2);
+  put = disc_k * vnorm_cdf(-d2) - S * vnorm_cdf(-d1);
+}
+
+// black_scholes over arrays; the tail runs as one padded register so every element takes
+// the same path
+template <class V>
+void black_scholes_batch(const double* S, const double* K, const double* r, const double* sigma,
+                         const double* T, std::size_t n, double* call, double* put) {
+  constexpr std::size_t L = V::kLanes;
+  std::size_t i = 0;
+  for (; i + L <= n; i += L) {
+    V c = 0.0;
+    V p = 0.0;
+    black_scholes(V::load(S + i), V::load(K + i), V::load(r + i), V::load(sigma + i),
+                  V::load(T + i), c, p);
+    c.store(call + i);
+    p.store(put + i);
+  }
+  if (i == n) return;
+
+  double in[5][L];
+  for (std::size_t k = 0; k < L; ++k) {
+    const bool live = i + k < n;
+    in[0][k] = live ? S[i + k] : 1.0;
+    in[1][k] = live ? K[i + k] : 1.0;
+    in[2][k] = live ? r[i + k] : 0.0;
+    in[3][k] = live ? sigma[i + k] : 1.0;
+    in[4][k] = live ? T[i + k] : 1.0;
+  }
+  V c = 0.0;
+  V p = 0.0;
+  black_scholes(V::load(in[0]), V::load(in[1]), V::load(in[2]), V::load(in[3]), V::load(in[4]), c, p);
+  double out_c[L];
+  double out_p[L];
+  c.store(out_c);
+  p.store(out_p);
+  for (std::size_t k = 0; i + k < n; ++k) {
+    call[i + k] = out_c[k];
+    put[i + k] = out_p[k];
+  }
+}
+
+} // namespace qe::kernels::vmath
@@ -0,0 +1,73 @@
+#pragma once
+
+// Work-stealing loop over independent tasks, used by the parameter sweeps. Internal to qe_engine.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "run_workers.hpp"
+
+namespace qe::detail {
+
+// Runs fn(worker, task) for every task in [0, n_tasks) on `workers` threads (see
+// run_workers). Tasks are dealt round-robin in chunks of `chunk` to per-worker queues; a
+// worker takes chunks from the front of its own queue and, once that is empty, steals from
+// the back of the others, so one that drew slow tasks does not hold up the rest. After an
+// exception the workers stop taking chunks and the first one is rethrown.
+template <class Fn>
+void run_stealing(std::size_t n_tasks, std::size_t workers, std::size_t chunk, Fn&& fn) {
+  struct Range {
+    std::size_t begin;
+    std::size_t end;
+  };
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Range> ranges;
+  };
+
+  if (n_tasks == 0) return;
+  workers = std::clamp<std::size_t>(workers, 1, n_tasks);
+  chunk = std::max<std::size_t>(chunk, 1);
+
+  std::vector<Queue> queues(workers);
+  std::size_t k = 0;
+  for (std::size_t b = 0; b < n_tasks; b += chunk, ++k) {
+    queues[k % workers].ranges.push_back({b, std::min(n_tasks, b + chunk)});
+  }
+
+  auto take = [&](std::size_t w, Range& out) {
+    for (std::size_t d = 0; d < workers; ++d) {
+      Queue& q = queues[(w + d) % workers];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (q.ranges.empty()) continue;
+      if (d == 0) {
+        out = q.ranges.front();
+        q.ranges.pop_front();
+      } else {
+        out = q.ranges.back();
+        q.ranges.pop_back();
+      }
+      return true;
+    }
+    return false; // nothing is ever queued again, so every task has been taken
+  };
+
+  std::atomic<bool> failed{false};
+  run_workers(workers, [&](std::size_t w) {
+    Range r{};
+    while (!failed.load(std::memory_order_relaxed) && take(w, r)) {
+      try {
+        for (std::size_t i = r.begin; i < r.end; ++i) fn(w, i);
+      } catch (...) {
+        failed.store(true, std::memory_order_relaxed);
+        throw;
+      }
+    }
+  });
+}
+
+} // namespace qe::detail
@@ -0,0 +1,27 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Every heap allocation in the test binary goes through here, so a test can check that a path
+// allocates nothing: the count is process-wide, so compare it around single-threaded calls.
+// Kept in its own file so the compiler never inlines these into a caller.
+static std::atomic<std::size_t> g_heap_allocations{0};
+
+std::size_t heap_allocations() {
+  return g_heap_allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t bytes) {
+  g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(bytes == 0 ? 1 : bytes)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
@@ -1,12 +1,25 @@
+#include <algorithm>
 #include <cmath>
+#include <span>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include "qe/backtest.hpp"
 #include "qe/data.hpp"
+#include "qe/dispatch.hpp"
+#include "qe/indicators.hpp"
+#include "qe/strategy.hpp"
+#include "test_support.hpp"
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
 
+using qe_test::IsaGuard;
+using qe_test::same_bits;
+using qe_test::SmaPositions;
+using qe_test::supported_isas;
+
 // small helper for float compares
 static bool approx(double a, double b, double eps = 1e-12) {
   return std::fabs(a - b) <= eps;
@@ -71,3 +84,154 @@ TEST_CASE("backtest_sma_crossover: produces finite outputs") {
   REQUIRE(std::isfinite(r.max_drawdown));
   REQUIRE(std::isfinite(r.sharpe));
 }
+
+TEST_CASE("backtest_sma_crossover: close span overload matches the row table") {
+  qe::OhlcvTable t;
+  std::vector<double> close{100.0, 90.0, 95.0, 85.0, 88.0, 92.0, 97.0, 94.0};
+  for (double c : close) t.push_back({"t", 0,0,0, c, 0});
+
+  auto a = qe::backtest_sma_crossover(t, 2, 3, 1.0);
+  auto b = qe::backtest_sma_crossover(close, 2, 3, 1.0);
+
+  REQUIRE(a.equity == b.equity);
+  REQUIRE(a.strat_ret == b.strat_ret);
+  REQUIRE(a.total_return == b.total_return);
+  REQUIRE(a.max_drawdown == b.max_drawdown);
+  REQUIRE(a.sharpe == b.sharpe);
+}
+
+TEST_CASE("backtest_sma_crossover: metrics match their scalar definitions") {
+  std::vector<double> close;
+  for (int i = 0; i < 1037; ++i) close.push_back(100.0 + 8.0 * std::sin(i * 0.05) + 2.0 * std::cos(i * 0.9));
+
+  const qe::BacktestResult r = qe::backtest_sma_crossover(close, 3, 17, 1000.0);
+
+  // running-peak drawdown: max is exact, so the vector scan must agree bit for bit
+  double peak = r.equity[0];
+  double max_dd = 0.0;
+  for (double v : r.equity) {
+    peak = std::max(peak, v);
+    if (peak > 0.0) max_dd = std::max(max_dd, (peak - v) / peak);
+  }
+  REQUIRE(r.max_drawdown == max_dd);
+
+  // sums are taken in 8 lanes, so sharpe agrees with the sequential two-pass to rounding
+  double mean = 0.0;
+  for (double x : r.strat_ret) mean += x;
+  mean /= static_cast<double>(r.strat_ret.size());
+  double var = 0.0;
+  for (double x : r.strat_ret) var += (x - mean) * (x - mean);
+  var /= static_cast<double>(r.strat_ret.size());
+  REQUIRE(r.sharpe == Catch::Approx(mean / std::sqrt(var)).epsilon(1e-12));
+}
+
+TEST_CASE("backtest_sma_crossover: caller buffers, no heap allocation") {
+  std::vector<double> close;
+  for (int i = 0; i < 2000; ++i) close.push_back(100.0 + 8.0 * std::sin(i * 0.05) + 2.0 * std::cos(i * 0.9));
+  const qe::BacktestResult ref = qe::backtest_sma_crossover(close, 5, 40, 10.0);
+
+  std::vector<double> strat_ret(close.size() - 1);
+  std::vector<double> equity(close.size() - 1);
+
+  std::size_t before = heap_allocations();
+  const qe::BacktestResult first = qe::backtest_sma_crossover(close, 5, 40, 10.0, {}, strat_ret, equity);
+  REQUIRE(heap_allocations() == before);
+  REQUIRE(first.equity.empty());
+  REQUIRE(strat_ret == ref.strat_ret);
+  REQUIRE(equity == ref.equity);
+  REQUIRE(first.total_return == ref.total_return);
+  REQUIRE(first.max_drawdown == ref.max_drawdown);
+  REQUIRE(first.sharpe == ref.sharpe);
+
+  // shorter runs into the front of the same buffers, and metrics only
+  const std::span<const double> shorter = std::span<const double>(close).first(1500);
+  before = heap_allocations();
+  const qe::BacktestResult second = qe::backtest_sma_crossover(
+      shorter, 3, 20, 1.0, {}, std::span(strat_ret).first(1499), std::span(equity).first(1499));
+  const qe::BacktestResult lean = qe::backtest_sma_crossover(close, 5, 40, 10.0, {}, {}, {});
+  REQUIRE(heap_allocations() == before);
+  REQUIRE(second.total_return == qe::backtest_sma_crossover(shorter, 3, 20, 1.0).total_return);
+  REQUIRE(lean.sharpe == ref.sharpe);
+
+  REQUIRE_THROWS_AS(qe::backtest_sma_crossover(close, 5, 40, 1.0, {}, std::span(strat_ret).first(10), equity),
+                    std::invalid_argument);
+}
+
+TEST_CASE("backtest_sma_crossover: the fused pass matches separately computed SMAs bit for bit") {
+  IsaGuard guard;
+
+  // random walk with a zero close and a NaN gap; lengths around the pass's 512-bar chunks
+  for (std::size_t n : {51u, 513u, 514u, 1029u, 3001u}) {
+    std::vector<double> close = qe_test::random_walk(n, 7, 100.0, 0.02);
+    if (n > 600) {
+      close[511] = 0.0;
+      close[n - 30] = std::nan("");
+    }
+
+    // the reference takes its positions from rolling_mean series computed up front
+    const std::span<const double> tail = std::span<const double>(close).subspan(1);
+    for (qe::Isa isa : supported_isas()) {
+      qe::set_active_isa(isa);
+      for (auto [fast, slow] : {std::pair<std::size_t, std::size_t>{3, 20}, {7, 13}, {5, 20}, {10, 50}}) {
+        const std::vector<double> fast_sma = qe::rolling_mean(tail, fast);
+        const std::vector<double> slow_sma = qe::rolling_mean(tail, slow);
+        for (const qe::BacktestCosts costs : {qe::BacktestCosts{}, qe::BacktestCosts{4.0, 1.0}}) {
+          INFO("isa " << qe::isa_name(isa) << ", n = " << n << ", " << fast << "/" << slow << ", costs "
+                      << costs.per_trade());
+          const qe::BacktestResult want =
+            qe::backtest_strategy(close, SmaPositions{&fast_sma, &slow_sma}, 3.0, costs);
+          const qe::BacktestResult got = qe::backtest_sma_crossover(close, fast, slow, 3.0, costs);
+          REQUIRE(same_bits(got.strat_ret, want.strat_ret));
+          REQUIRE(same_bits(got.equity, want.equity));
+          REQUIRE(same_bits(got.total_return, want.total_return));
+          REQUIRE(same_bits(got.max_drawdown, want.max_drawdown));
+          REQUIRE(same_bits(got.sharpe, want.sharpe));
+          REQUIRE(same_bits(got.win_rate, want.win_rate));
+          REQUIRE(got.n_trades == want.n_trades);
+          REQUIRE(same_bits(got.total_cost, want.total_cost));
+
+          // the metrics alone, from two passes over close
+          const qe::BacktestResult lean =
+            qe::backtest_sma_crossover(close, fast, slow, 3.0, costs, qe::BacktestOutput::MetricsOnly);
+          REQUIRE(lean.equity.empty());
+          REQUIRE(lean.strat_ret.empty());
+          REQUIRE(same_bits(lean.total_return, want.total_return));
+          REQUIRE(same_bits(lean.max_drawdown, want.max_drawdown));
+          REQUIRE(same_bits(lean.sharpe, want.sharpe));
+          REQUIRE(same_bits(lean.win_rate, want.win_rate));
+          REQUIRE(lean.n_trades == want.n_trades);
+          REQUIRE(same_bits(lean.total_cost, want.total_cost));
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("backtest_sma_crossover: each position change is charged on the equity before it") {
+  // long while the 2-bar SMA is above the 4-bar one: in at step 3, out at step 7, in at step 10
+  const std::vector<double> close = {10, 10, 10, 10, 11, 12, 13, 12, 11, 10, 12, 14, 15};
+  const qe::BacktestResult free = qe::backtest_sma_crossover(close, 2, 4, 100.0);
+  const qe::BacktestCosts costs{10.0, 15.0}; // 25 bps a trade
+  const qe::BacktestResult r = qe::backtest_sma_crossover(close, 2, 4, 100.0, costs);
+
+  REQUIRE(free.n_trades == 3);
+  REQUIRE(free.total_cost == 0.0);
+  REQUIRE(r.n_trades == 3);
+
+  double eq = 100.0;
+  double charged = 0.0;
+  for (std::size_t i = 0; i < free.strat_ret.size(); ++i) {
+    const bool trade = i == 3 || i == 7 || i == 10;
+    if (trade) charged += eq * 0.0025;
+    const double want = trade ? free.strat_ret[i] - 0.0025 : free.strat_ret[i];
+    REQUIRE(r.strat_ret[i] == want);
+    eq *= 1.0 + want;
+    REQUIRE(r.equity[i] == eq);
+  }
+  REQUIRE(r.total_cost == charged);
+  REQUIRE(r.total_return < free.total_return);
+
+  REQUIRE_THROWS_AS(qe::backtest_sma_crossover(close, 2, 4, 1.0, {-1.0, 0.0}), std::invalid_argument);
+  std::vector<double> strat_ret(close.size() - 1);
+  REQUIRE_THROWS_AS(qe::backtest_sma_crossover(close, 2, 4, 1.0, {}, strat_ret, {}), std::invalid_argument);
+}
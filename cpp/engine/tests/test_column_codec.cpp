@@ -0,0 +1,214 @@
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "qe/bar_stream.hpp"
+#include "qe/column_codec.hpp"
+#include "qe/dataset.hpp"
+#include "qe/qec.hpp"
+#include "test_support.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace fs = std::filesystem;
+using qe_test::same_bits;
+
+static fs::path temp_path(const std::string& name) {
+  return fs::temp_directory_path() / fs::path("qe_codec_test_" + name);
+}
+
+// minute bars with gaps, jitter and price ticks, long enough to span several blocks
+static qe::OhlcvColumns sample_bars(std::size_t n) {
+  qe::OhlcvColumns c;
+  std::int64_t t = 1'600'000'000'000'000'000LL;
+  double px = 100.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    t += 60'000'000'000LL;
+    if (i % 390 == 0) t += 17 * 3'600'000'000'000LL; // overnight gap
+    if (i % 97 == 0) t += 1'234;                    // odd jitter
+    px += ((i * 7919) % 11 == 0) ? 0.0 : (static_cast<double>((i * 31) % 9) - 4.0) * 0.01;
+    c.push_back(t, px, px + 0.05, px - 0.03, px + ((i % 3) ? 0.01 : 0.0), static_cast<double>(100 + i % 50));
+  }
+  return c;
+}
+
+TEST_CASE("codec: timestamps round-trip, including extremes", "[codec]") {
+  std::vector<std::int64_t> ts;
+  for (std::int64_t i = 0; i < 10'000; ++i) ts.push_back(i * 60'000'000'000LL + (i % 13 == 0 ? 999 : 0));
+  ts.push_back(std::numeric_limits<std::int64_t>::max());
+  ts.push_back(std::numeric_limits<std::int64_t>::min());
+  ts.push_back(0);
+  ts.push_back(-5);
+
+  const qe::EncodedColumn enc = qe::encode_timestamps(ts);
+  REQUIRE(enc.size == ts.size());
+  REQUIRE(enc.block_bit.size() == (ts.size() + qe::kCodecBlock - 1) / qe::kCodecBlock);
+
+  std::vector<std::int64_t> out(qe::kCodecBlock);
+  std::size_t at = 0;
+  for (std::size_t b = 0; b < enc.view().blocks(); ++b) {
+    const std::size_t n = qe::decode_timestamps_block(enc.view(), b, out.data());
+    for (std::size_t i = 0; i < n; ++i) REQUIRE(out[i] == ts[at + i]);
+    at += n;
+  }
+  REQUIRE(at == ts.size());
+
+  // evenly spaced bars are about one bit each
+  std::vector<std::int64_t> even(100'000);
+  for (std::size_t i = 0; i < even.size(); ++i) even[i] = static_cast<std::int64_t>(i) * 60'000'000'000LL;
+  REQUIRE(qe::encode_timestamps(even).view().bytes() < even.size() / 4);
+}
+
+TEST_CASE("codec: doubles round-trip bit-exactly", "[codec]") {
+  std::vector<double> v = {0.0, -0.0, 1.0, 1.0, 1.5, -2.25, 1e300, -1e-300,
+                           std::numeric_limits<double>::infinity(),
+                           std::numeric_limits<double>::quiet_NaN(),
+                           std::numeric_limits<double>::denorm_min(), 3.0, 3.0, 3.0};
+  for (int i = 0; i < 9000; ++i) v.push_back(100.0 + std::sin(i * 0.01) * 5.0);
+
+  const qe::EncodedColumn enc = qe::encode_doubles(v);
+  std::vector<double> out(qe::kCodecBlock);
+  std::size_t at = 0;
+  for (std::size_t b = 0; b < enc.view().blocks(); ++b) {
+    const std::size_t n = qe::decode_doubles_block(enc.view(), b, out.data());
+    for (std::size_t i = 0; i < n; ++i) REQUIRE(same_bits(out[i], v[at + i]));
+    at += n;
+  }
+  REQUIRE(at == v.size());
+
+  REQUIRE(qe::encode_doubles({}).view().blocks() == 0);
+}
+
+TEST_CASE("codec: fixed-decimal blocks are scaled, others fall back to XOR", "[codec]") {
+  // prices as parsed from 4-decimal CSV text
+  std::vector<double> v;
+  std::int64_t ticks = 1'234'567;
+  for (int i = 0; i < 2 * static_cast<int>(qe::kCodecBlock); ++i) {
+    ticks += (i * 37) % 21 - 10;
+    v.push_back(static_cast<double>(ticks) / 1e4);
+  }
+  const std::size_t decimal_bytes = qe::encode_doubles(v).view().bytes();
+  REQUIRE(decimal_bytes * 4 < v.size() * 8);
+
+  // one value that is not a short decimal pushes only its block back to XOR
+  v[qe::kCodecBlock + 5] = 1.0 / 3.0;
+  v[qe::kCodecBlock + 6] = -0.0;
+  const qe::EncodedColumn enc = qe::encode_doubles(v);
+  REQUIRE(enc.view().bytes() > decimal_bytes);
+
+  std::vector<double> out(qe::kCodecBlock);
+  for (std::size_t b = 0; b < 2; ++b) {
+    REQUIRE(qe::decode_doubles_block(enc.view(), b, out.data()) == qe::kCodecBlock);
+    for (std::size_t i = 0; i < qe::kCodecBlock; ++i) REQUIRE(same_bits(out[i], v[b * qe::kCodecBlock + i]));
+  }
+}
+
+TEST_CASE("codec: compressed OHLCV decodes to the original and is smaller", "[codec]") {
+  const qe::OhlcvColumns bars = sample_bars(3 * qe::kCodecBlock + 123);
+  const qe::CompressedOhlcv packed = qe::compress(bars.view());
+  const qe::OhlcvColumns back = packed.view().decode();
+
+  REQUIRE(back.ts == bars.ts);
+  REQUIRE(back.close == bars.close);
+  REQUIRE(back.volume == bars.volume);
+  REQUIRE(packed.view().bytes() * 2 < bars.size() * 48);
+
+  qe::OhlcvColumns block;
+  packed.view().decode_block(3, block);
+  REQUIRE(block.size() == 123);
+  REQUIRE(block.high[122] == bars.high.back());
+}
+
+TEST_CASE("qec: compressed files load, stream and verify", "[codec]") {
+  const qe::OhlcvColumns bars = sample_bars(2 * qe::kCodecBlock + 777);
+  const fs::path raw = temp_path("raw.qec");
+  const fs::path packed = temp_path("packed.qec");
+  qe::write_qec(raw.string(), bars.view());
+  qe::write_qec(packed.string(), bars.view(), {.compress = true});
+  REQUIRE(fs::file_size(packed) * 2 < fs::file_size(raw));
+
+  const qe::Dataset ds = qe::load_dataset(packed.string(), {.verify_checksum = true});
+  REQUIRE(ds.size() == bars.size());
+  REQUIRE(ds.view().ts[5000] == bars.ts[5000]);
+  REQUIRE(ds.view().close[bars.size() - 1] == bars.close.back());
+
+  qe::MappedFile f;
+  REQUIRE(f.open(packed.string()));
+  REQUIRE_THROWS_AS(qe::qec_view(f.view()), std::runtime_error);
+  REQUIRE(qe::qec_compressed_view(f.view(), true).close.blocks() == 3);
+
+  // streamed in odd batch sizes across block boundaries
+  qe::BarStream s(packed.string(), {.batch_rows = 1000});
+  qe::OhlcvColumns batch;
+  std::vector<std::int64_t> ts;
+  std::vector<double> close;
+  while (s.next(batch)) {
+    REQUIRE(batch.size() <= 1000);
+    ts.insert(ts.end(), batch.ts.begin(), batch.ts.end());
+    close.insert(close.end(), batch.close.begin(), batch.close.end());
+  }
+  REQUIRE(ts == bars.ts);
+  REQUIRE(close == bars.close);
+}
+
+TEST_CASE("qec: a double block with an unknown mode is rejected, checksum or not", "[codec]") {
+  const qe::OhlcvColumns bars = sample_bars(qe::kCodecBlock + 100);
+  const fs::path p = temp_path("bad_mode.qec");
+  qe::write_qec(p.string(), bars.view(), {.compress = true});
+
+  // the close column's first block starts at bit 0 of its words; its mode is the top nibble
+  std::fstream f(p.string(), std::ios::binary | std::ios::in | std::ios::out);
+  qe::QecHeader h{};
+  f.read(reinterpret_cast<char*>(&h), sizeof h);
+  std::uint64_t blob[4]; // values, blocks, word count, first block's bit
+  f.seekg(static_cast<std::streamoff>(h.column_offset[4]));
+  f.read(reinterpret_cast<char*>(blob), sizeof blob);
+  REQUIRE(blob[3] == 0);
+  const auto top = static_cast<std::streamoff>(h.column_offset[4] + (3 + blob[1]) * 8 + 7);
+  char byte = 0;
+  f.seekg(top);
+  f.read(&byte, 1);
+  byte = static_cast<char>((byte & 0x0F) | (13 << 4));
+  f.seekp(top);
+  f.write(&byte, 1);
+  f.close();
+
+  REQUIRE_THROWS_AS(qe::load_dataset(p.string()), std::runtime_error);
+  qe::BarStream s(p.string());
+  qe::OhlcvColumns batch;
+  REQUIRE_THROWS_AS(s.next(batch), std::runtime_error);
+}
+
+TEST_CASE("qec: a compressed column whose word count overruns the file is rejected", "[codec]") {
+  const qe::OhlcvColumns bars = sample_bars(qe::kCodecBlock + 100);
+  const fs::path p = temp_path("bad_words.qec");
+  qe::write_qec(p.string(), bars.view(), {.compress = true});
+
+  // the close column's word count plus 2^61: words * 8 and words * 64 wrap back to their
+  // real values, so only a check against the file size catches it
+  std::fstream f(p.string(), std::ios::binary | std::ios::in | std::ios::out);
+  qe::QecHeader h{};
+  f.read(reinterpret_cast<char*>(&h), sizeof h);
+  std::uint64_t words = 0;
+  f.seekg(static_cast<std::streamoff>(h.column_offset[4] + 16));
+  f.read(reinterpret_cast<char*>(&words), sizeof words);
+  words += std::uint64_t{1} << 61;
+  f.seekp(static_cast<std::streamoff>(h.column_offset[4] + 16));
+  f.write(reinterpret_cast<const char*>(&words), sizeof words);
+  f.close();
+
+  REQUIRE_THROWS_AS(qe::load_dataset(p.string()), std::runtime_error);
+  REQUIRE_THROWS_AS(qe::BarStream(p.string()), std::runtime_error);
+}
+
+TEST_CASE("codec: an XOR window wider than 64 bits is rejected", "[codec]") {
+  // mode 15, first value 0, then a new window with lead 31 and length 64
+  const std::uint64_t words[2] = {0xF000000000000000ULL, 0x0FFF800000000000ULL};
+  double out[2];
+  REQUIRE_THROWS_AS(qe::decode_doubles(words, 0, 2, out), std::runtime_error);
+}
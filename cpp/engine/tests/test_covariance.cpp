@@ -0,0 +1,229 @@
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "qe/covariance.hpp"
+#include "qe/dispatch.hpp"
+#include "test_support.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+using qe_test::IsaGuard;
+using qe_test::same_bits;
+using qe_test::supported_isas;
+
+namespace {
+
+// n_series correlated return-like series, time-major
+std::vector<double> test_bars(std::size_t n_bars, std::size_t n_series, std::uint64_t seed = 7) {
+  std::vector<double> bars(n_bars * n_series);
+  qe_test::Lcg rng(seed);
+  for (std::size_t t = 0; t < n_bars; ++t) {
+    const double market = rng.uniform() * 0.02;
+    for (std::size_t i = 0; i < n_series; ++i) {
+      bars[t * n_series + i] = 0.001 + market * (0.5 + 0.1 * static_cast<double>(i % 7)) + rng.uniform() * 0.01;
+    }
+  }
+  return bars;
+}
+
+// the window ending at bar t, two-pass around its mean
+std::vector<double> direct_covariance(const std::vector<double>& bars, std::size_t n, std::size_t w,
+                                      std::size_t t) {
+  std::vector<double> mean(n, 0.0);
+  for (std::size_t b = t + 1 - w; b <= t; ++b) {
+    for (std::size_t i = 0; i < n; ++i) mean[i] += bars[b * n + i];
+  }
+  for (double& m : mean) m /= static_cast<double>(w);
+  std::vector<double> cov(n * n, 0.0);
+  for (std::size_t b = t + 1 - w; b <= t; ++b) {
+    for (std::size_t i = 0; i < n; ++i) {
+      for (std::size_t j = 0; j < n; ++j) {
+        cov[i * n + j] += (bars[b * n + i] - mean[i]) * (bars[b * n + j] - mean[j]);
+      }
+    }
+  }
+  for (double& c : cov) c /= static_cast<double>(w);
+  return cov;
+}
+
+std::vector<double> direct_correlation(const std::vector<double>& bars, std::size_t n, std::size_t w,
+                                       std::size_t t) {
+  std::vector<double> c = direct_covariance(bars, n, w, t);
+  std::vector<double> r(n * n);
+  for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j < n; ++j) r[i * n + j] = c[i * n + j] / std::sqrt(c[i * n + i] * c[j * n + j]);
+  }
+  return r;
+}
+
+void require_close(const std::vector<double>& got, const std::vector<double>& want, double tol) {
+  REQUIRE(got.size() == want.size());
+  for (std::size_t i = 0; i < got.size(); ++i) {
+    INFO("entry " << i);
+    REQUIRE(got[i] == Catch::Approx(want[i]).margin(tol));
+  }
+}
+
+} // namespace
+
+TEST_CASE("rolling_covariance: matches a direct computation of every window", "[covariance]") {
+  for (std::size_t n : {1u, 5u, 37u}) {
+    for (std::size_t w : {1u, 4u, 20u}) {
+      const std::size_t n_bars = 3 * w + 17;
+      const std::vector<double> bars = test_bars(n_bars, n);
+      std::size_t visits = 0;
+      qe::rolling_covariance(bars, n, {w, 1, 1}, [&](std::size_t t, std::span<const double> m) {
+        INFO("n = " << n << ", window = " << w << ", t = " << t);
+        REQUIRE(t == w - 1 + visits);
+        require_close({m.begin(), m.end()}, direct_covariance(bars, n, w, t), 1e-15);
+        ++visits;
+      });
+      REQUIRE(visits == n_bars - w + 1);
+    }
+  }
+}
+
+TEST_CASE("rolling_correlation: matches a direct computation, stride skips bars", "[covariance]") {
+  const std::size_t n = 23;
+  const std::size_t w = 30;
+  const std::vector<double> bars = test_bars(200, n);
+  std::vector<std::size_t> visited;
+  qe::rolling_correlation(bars, n, {w, 7, 1}, [&](std::size_t t, std::span<const double> m) {
+    visited.push_back(t);
+    const std::vector<double> want = direct_correlation(bars, n, w, t);
+    require_close({m.begin(), m.end()}, want, 1e-12);
+    for (std::size_t i = 0; i < n; ++i) REQUIRE(m[i * n + i] == 1.0);
+  });
+  std::vector<std::size_t> expected;
+  for (std::size_t t = w - 1; t < 200; t += 7) expected.push_back(t);
+  REQUIRE(visited == expected);
+}
+
+TEST_CASE("RollingCovariance: push, push_bars and threads agree", "[covariance]") {
+  const std::size_t n = 300;
+  const std::size_t w = 25;
+  const std::vector<double> bars = test_bars(130, n);
+
+  qe::RollingCovariance one(n, w);
+  qe::RollingCovariance block(n, w);
+  qe::RollingCovariance threaded(n, w, 4);
+  REQUIRE_FALSE(one.ready());
+
+  std::vector<double> a(n * n);
+  std::vector<double> b(n * n);
+  std::vector<double> c(n * n);
+  one.covariance(a);
+  REQUIRE(std::isnan(a[0]));
+
+  std::size_t t = 0;
+  for (std::size_t step : {10u, 30u, 3u, 47u, 40u}) {
+    for (std::size_t s = 0; s < step; ++s, ++t) {
+      one.push(std::span<const double>(bars).subspan(t * n, n));
+    }
+    const std::span<const double> chunk = std::span<const double>(bars).subspan((t - step) * n, step * n);
+    block.push_bars(chunk);
+    threaded.push_bars(chunk);
+    REQUIRE(one.count() == t);
+    if (!one.ready()) continue;
+
+    INFO("t = " << t);
+    one.covariance(a);
+    block.covariance(b);
+    threaded.covariance(c);
+    // the row shards split the same per-row work, so threads change nothing
+    REQUIRE(same_bits(b, c));
+    require_close(a, b, 1e-15);
+    require_close(a, direct_covariance(bars, n, w, t - 1), 1e-15);
+  }
+}
+
+TEST_CASE("RollingCovariance: a NaN clears once it leaves the window", "[covariance]") {
+  const std::size_t n = 6;
+  const std::size_t w = 10;
+  std::vector<double> bars = test_bars(60, n);
+  bars[12 * n + 2] = std::numeric_limits<double>::quiet_NaN();
+
+  qe::RollingCovariance cov(n, w);
+  std::vector<double> m(n * n);
+  for (std::size_t t = 0; t < 60; ++t) {
+    cov.push(std::span<const double>(bars).subspan(t * n, n));
+    if (!cov.ready()) continue;
+    cov.correlation(m);
+    INFO("t = " << t);
+    if (t >= 12 && t < 22) {
+      REQUIRE(std::isnan(m[2 * n + 2]));
+      REQUIRE(std::isnan(m[2 * n + 4]));
+      REQUIRE(std::isnan(m[4 * n + 2]));
+      REQUIRE(m[0 * n + 4] == m[4 * n + 0]);
+      REQUIRE_FALSE(std::isnan(m[0 * n + 4]));
+    }
+    if (t >= 22 + w) {
+      require_close(m, direct_correlation(bars, n, w, t), 1e-12);
+    }
+  }
+}
+
+TEST_CASE("RollingCovariance: a constant series has NaN correlations", "[covariance]") {
+  const std::size_t n = 3;
+  std::vector<double> bars = test_bars(20, n);
+  for (std::size_t t = 0; t < 20; ++t) bars[t * n + 1] = 5.0;
+  qe::RollingCovariance cov(n, 8);
+  cov.push_bars(bars);
+  std::vector<double> m(n * n);
+  cov.covariance(m);
+  REQUIRE(m[1 * n + 1] == 0.0);
+  cov.correlation(m);
+  REQUIRE(std::isnan(m[1 * n + 0]));
+  REQUIRE(std::isnan(m[1 * n + 1]));
+  REQUIRE(m[0] == 1.0);
+}
+
+TEST_CASE("RollingCovariance: every variant gives bit-identical matrices", "[covariance][dispatch]") {
+  IsaGuard guard;
+  const std::size_t n = 45;
+  const std::vector<double> bars = test_bars(90, n);
+  std::vector<double> ref(n * n);
+  std::vector<double> got(n * n);
+
+  qe::set_active_isa(qe::Isa::Scalar);
+  qe::RollingCovariance scalar(n, 16);
+  scalar.push_bars(std::span<const double>(bars).first(70 * n));
+  scalar.push_bars(std::span<const double>(bars).subspan(70 * n));
+  scalar.covariance(ref);
+
+  for (qe::Isa isa : supported_isas()) {
+    qe::set_active_isa(isa);
+    INFO("isa " << qe::isa_name(isa));
+    qe::RollingCovariance cov(n, 16);
+    cov.push_bars(std::span<const double>(bars).first(70 * n));
+    cov.push_bars(std::span<const double>(bars).subspan(70 * n));
+    cov.covariance(got);
+    REQUIRE(same_bits(got, ref));
+  }
+}
+
+TEST_CASE("rolling_covariance: validates its inputs", "[covariance]") {
+  const std::vector<double> bars = test_bars(10, 4);
+  const auto ignore = [](std::size_t, std::span<const double>) {};
+  REQUIRE_THROWS_AS(qe::RollingCovariance(0, 5), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::RollingCovariance(4, 0), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::rolling_covariance(bars, 3, {5, 1, 1}, ignore), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::rolling_covariance(bars, 4, {5, 0, 1}, ignore), std::invalid_argument);
+
+  qe::RollingCovariance cov(4, 5);
+  REQUIRE_THROWS_AS(cov.push(std::span<const double>(bars).first(3)), std::invalid_argument);
+  REQUIRE_THROWS_AS(cov.push_bars(std::span<const double>(bars).first(6)), std::invalid_argument);
+  std::vector<double> small(15);
+  REQUIRE_THROWS_AS(cov.covariance(small), std::invalid_argument);
+
+  const std::vector<double> a = {1, 2, 3};
+  const std::vector<double> b = {4, 5, 6};
+  REQUIRE(qe::time_major({a, b}) == std::vector<double>{1, 4, 2, 5, 3, 6});
+  const std::vector<double> shorter = {1, 2};
+  REQUIRE_THROWS_AS(qe::time_major({a, shorter}), std::invalid_argument);
+}
@@ -0,0 +1,200 @@
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "qe/csv_reader.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+namespace fs = std::filesystem;
+
+static fs::path write_temp_csv(const std::string& name, const std::string& text) {
+  fs::path p = fs::temp_directory_path() / fs::path("qe_csv_test_" + name + ".csv");
+  std::ofstream out(p.string(), std::ios::binary);
+  out << text;
+  out.close();
+  return p;
+}
+
+TEST_CASE("read_ohlcv_csv: parses rows after the header", "[csv]") {
+  const fs::path p = write_temp_csv("basic",
+    "timestamp,open,high,low,close,volume\n"
+    "2024-01-01,99.5,100.25,99.0,99.75,1278508\n"
+    "2024-01-02,99.75,102.0,97.5,101.0,910675\n");
+
+  const qe::OhlcvTable t = qe::read_ohlcv_csv(p.string());
+
+  REQUIRE(t.size() == 2);
+  REQUIRE(t[0].timestamp == "2024-01-01");
+  REQUIRE(t[0].open == 99.5);
+  REQUIRE(t[0].high == 100.25);
+  REQUIRE(t[0].low == 99.0);
+  REQUIRE(t[0].close == 99.75);
+  REQUIRE(t[0].volume == 1278508.0);
+  REQUIRE(t[1].timestamp == "2024-01-02");
+  REQUIRE(t[1].close == 101.0);
+}
+
+TEST_CASE("read_ohlcv_csv: tolerates CRLF, blank lines and a missing final newline", "[csv]") {
+  const fs::path p = write_temp_csv("crlf",
+    "timestamp,open,high,low,close,volume\r\n"
+    "t0,1,2,0.5,1.5,10\r\n"
+    "\r\n"
+    "\n"
+    "t1, +2,3,1,2.5e0 ,20");
+
+  const qe::OhlcvTable t = qe::read_ohlcv_csv(p.string());
+
+  REQUIRE(t.size() == 2);
+  REQUIRE(t[0].timestamp == "t0");
+  REQUIRE(t[0].volume == 10.0);
+  REQUIRE(t[1].timestamp == "t1");
+  REQUIRE(t[1].open == 2.0);
+  REQUIRE(t[1].close == Catch::Approx(2.5));
+  REQUIRE(t[1].volume == 20.0);
+}
+
+TEST_CASE("read_ohlcv_csv: header only yields an empty table", "[csv]") {
+  const fs::path p = write_temp_csv("header_only", "timestamp,open,high,low,close,volume\n");
+  REQUIRE(qe::read_ohlcv_csv(p.string()).empty());
+}
+
+TEST_CASE("read_ohlcv_csv: error cases", "[csv]") {
+  REQUIRE_THROWS_AS(qe::read_ohlcv_csv("does/not/exist.csv"), std::runtime_error);
+
+  const fs::path empty = write_temp_csv("empty", "");
+  REQUIRE_THROWS_AS(qe::read_ohlcv_csv(empty.string()), std::runtime_error);
+
+  const fs::path bad = write_temp_csv("bad_number",
+    "timestamp,open,high,low,close,volume\n"
+    "t0,1,2,abc,1.5,10\n");
+  REQUIRE_THROWS_AS(qe::read_ohlcv_csv(bad.string()), std::runtime_error);
+
+  const fs::path short_row = write_temp_csv("short_row",
+    "timestamp,open,high,low,close,volume\n"
+    "t0,1,2,0.5\n");
+  REQUIRE_THROWS_AS(qe::read_ohlcv_csv(short_row.string()), std::runtime_error);
+}
+
+TEST_CASE("read_ohlcv_columns: matches the row reader column by column", "[csv]") {
+  const fs::path p = write_temp_csv("columns",
+    "timestamp,open,high,low,close,volume\n"
+    "2024-01-01,99.5,100.25,99.0,99.75,1278508\n"
+    "2024-01-02T09:30:00,99.75,102.0,97.5,101.0,910675\n");
+
+  const qe::OhlcvTable rows = qe::read_ohlcv_csv(p.string());
+  const qe::OhlcvColumns cols = qe::read_ohlcv_columns(p.string());
+
+  REQUIRE(cols.size() == rows.size());
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    REQUIRE(cols.open[i] == rows[i].open);
+    REQUIRE(cols.high[i] == rows[i].high);
+    REQUIRE(cols.low[i] == rows[i].low);
+    REQUIRE(cols.close[i] == rows[i].close);
+    REQUIRE(cols.volume[i] == rows[i].volume);
+  }
+  REQUIRE(cols.ts[1] - cols.ts[0] == (24LL * 3600 + 9 * 3600 + 30 * 60) * 1'000'000'000LL);
+
+  const fs::path bad_ts = write_temp_csv("columns_bad_ts",
+    "timestamp,open,high,low,close,volume\n"
+    "t0,1,2,0.5,1.5,10\n");
+  REQUIRE_THROWS_AS(qe::read_ohlcv_columns(bad_ts.string()), std::runtime_error);
+}
+
+TEST_CASE("read_ohlcv_csv: projection converts only the selected fields", "[csv]") {
+  // the bad low/volume fields are never looked at by a close-only read
+  const fs::path p = write_temp_csv("projection",
+    "timestamp,open,high,low,close,volume\n"
+    "2024-01-01,99.5,100.25,x,99.75,y\n"
+    "2024-01-02,99.75,102.0,x,101.0\n");
+
+  const qe::OhlcvColumns close = qe::read_ohlcv_columns(p.string(), qe::Columns::Close);
+  REQUIRE(close.size() == 2);
+  REQUIRE(close.close == std::vector<double>{99.75, 101.0});
+  REQUIRE(close.ts.empty());
+  REQUIRE(close.open.empty());
+  REQUIRE(close.volume.empty());
+
+  const qe::OhlcvColumns ts_high =
+    qe::read_ohlcv_columns(p.string(), qe::Columns::Timestamp | qe::Columns::High, {.threads = 4, .min_chunk_bytes = 1});
+  REQUIRE(ts_high.ts.size() == 2);
+  REQUIRE(ts_high.high == std::vector<double>{100.25, 102.0});
+  REQUIRE(ts_high.close.empty());
+
+  const qe::OhlcvTable rows = qe::read_ohlcv_csv(p.string(), qe::Columns::Open);
+  REQUIRE(rows.size() == 2);
+  REQUIRE(rows[1].open == 99.75);
+  REQUIRE(rows[1].timestamp.empty());
+  REQUIRE(std::isnan(rows[1].close));
+
+  // selected fields are still validated
+  REQUIRE_THROWS_AS(qe::read_ohlcv_columns(p.string(), qe::Columns::Low), std::runtime_error);
+  REQUIRE_THROWS_AS(qe::read_ohlcv_columns(p.string(), qe::Columns::All), std::runtime_error);
+}
+
+TEST_CASE("read_ohlcv_csv: threaded parse is identical to the serial parse", "[csv]") {
+  std::string text = "timestamp,open,high,low,close,volume\r\n";
+  for (int i = 0; i < 500; ++i) {
+    const int m = i % 60;
+    text += "2024-01-01T" + std::string(i / 60 < 10 ? "0" : "") + std::to_string(i / 60) + ":" +
+            (m < 10 ? "0" : "") + std::to_string(m) + ":00," + std::to_string(100 + i) + ".25," +
+            std::to_string(101 + i) + ".5," + std::to_string(99 + i) + ",100." + std::to_string(i) +
+            "," + std::to_string(1000 + i) + (i % 7 == 0 ? "\r\n" : "\n");
+    if (i % 97 == 0) text += "\n"; // blank lines land in different chunks
+  }
+  const fs::path p = write_temp_csv("threaded", text);
+
+  const qe::OhlcvTable serial_rows = qe::read_ohlcv_csv(p.string());
+  const qe::OhlcvColumns serial_cols = qe::read_ohlcv_columns(p.string());
+  REQUIRE(serial_rows.size() == 500);
+
+  for (std::size_t threads : {2, 3, 7, 64}) {
+    const qe::CsvReadOptions opts{.threads = threads, .min_chunk_bytes = 64};
+
+    const qe::OhlcvTable rows = qe::read_ohlcv_csv(p.string(), opts);
+    REQUIRE(rows.size() == serial_rows.size());
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+      REQUIRE(rows[i].timestamp == serial_rows[i].timestamp);
+      REQUIRE(rows[i].close == serial_rows[i].close);
+      REQUIRE(rows[i].volume == serial_rows[i].volume);
+    }
+
+    const qe::OhlcvColumns cols = qe::read_ohlcv_columns(p.string(), opts);
+    REQUIRE(cols.ts == serial_cols.ts);
+    REQUIRE(cols.open == serial_cols.open);
+    REQUIRE(cols.high == serial_cols.high);
+    REQUIRE(cols.low == serial_cols.low);
+    REQUIRE(cols.close == serial_cols.close);
+    REQUIRE(cols.volume == serial_cols.volume);
+  }
+}
+
+TEST_CASE("read_ohlcv_csv: threaded parse reports the same error line", "[csv]") {
+  std::string text = "timestamp,open,high,low,close,volume\n";
+  for (int i = 0; i < 300; ++i) {
+    text += (i == 211) ? "t,1,2,x,1,1\n" : "t,1,2,0.5,1.5,10\n";
+    if (i == 20) text += "\n";
+  }
+  const fs::path p = write_temp_csv("threaded_error", text);
+
+  std::string serial_msg;
+  try {
+    qe::read_ohlcv_csv(p.string());
+  } catch (const std::runtime_error& ex) {
+    serial_msg = ex.what();
+  }
+  REQUIRE(serial_msg.find("at line 214") != std::string::npos);
+
+  for (std::size_t threads : {2, 5, 16}) {
+    std::string msg;
+    try {
+      qe::read_ohlcv_csv(p.string(), {.threads = threads, .min_chunk_bytes = 32});
+    } catch (const std::runtime_error& ex) {
+      msg = ex.what();
+    }
+    REQUIRE(msg == serial_msg);
+  }
+}
@@ -0,0 +1,90 @@
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+#include "qe/data.hpp"
+#include "qe/timestamp.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+static constexpr std::int64_t kSec = 1'000'000'000;
+static constexpr std::int64_t kDay = 86'400 * kSec;
+
+TEST_CASE("parse_timestamp_ns: dates and datetimes", "[data]") {
+  REQUIRE(qe::parse_timestamp_ns("1970-01-01") == 0);
+  REQUIRE(qe::parse_timestamp_ns("1970-01-02") == kDay);
+  REQUIRE(qe::parse_timestamp_ns("2024-01-01") == 19723 * kDay);
+  REQUIRE(qe::parse_timestamp_ns("1969-12-31") == -kDay);
+
+  REQUIRE(qe::parse_timestamp_ns("2024-01-01T09:30:00") == 19723 * kDay + (9 * 3600 + 30 * 60) * kSec);
+  REQUIRE(qe::parse_timestamp_ns("2024-01-01 09:30") == 19723 * kDay + (9 * 3600 + 30 * 60) * kSec);
+  REQUIRE(qe::parse_timestamp_ns("2024-01-01T00:00:01.5Z") == 19723 * kDay + kSec + kSec / 2);
+  REQUIRE(qe::parse_timestamp_ns("2024-01-01T01:00:00+01:00") == 19723 * kDay);
+}
+
+TEST_CASE("parse_timestamp_ns: integer epochs are scaled by magnitude", "[data]") {
+  REQUIRE(qe::parse_timestamp_ns("1704067200") == 19723 * kDay);
+  REQUIRE(qe::parse_timestamp_ns("1704067200000") == 19723 * kDay);
+  REQUIRE(qe::parse_timestamp_ns("1704067200000000000") == 19723 * kDay);
+}
+
+TEST_CASE("parse_timestamp_ns: rejects malformed text", "[data]") {
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns(""), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("t0"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("2024-13-01"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("2024-02-30"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("2024-01-01X"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("2024-01-01T25:00"), std::invalid_argument);
+  // epochs whose nanoseconds do not fit in int64
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("20000000000"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("-20000000000"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("9300000000000"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("9300000000000000"), std::invalid_argument);
+  REQUIRE(qe::parse_timestamp_ns("9000000000") == 9'000'000'000LL * kSec);
+}
+
+TEST_CASE("parse_timestamp_ns: dates reach both ends of the int64 range", "[data]") {
+  constexpr std::int64_t kMax = std::numeric_limits<std::int64_t>::max();
+  constexpr std::int64_t kMin = std::numeric_limits<std::int64_t>::min();
+  REQUIRE(qe::parse_timestamp_ns("2262-04-11") == 106'751 * kDay);
+  REQUIRE(qe::parse_timestamp_ns("2262-04-11T23:47:16.854775807Z") == kMax);
+  REQUIRE(qe::parse_timestamp_ns("2262-04-12T00:47:16.854775807+01:00") == kMax);
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("2262-04-11T23:47:16.854775808"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("2262-04-12"), std::invalid_argument);
+
+  REQUIRE(qe::parse_timestamp_ns("1677-09-22") == -106'751 * kDay);
+  REQUIRE(qe::parse_timestamp_ns("1677-09-21T00:12:43.145224192") == kMin);
+  REQUIRE(qe::parse_timestamp_ns("1677-09-20T23:12:43.145224192-01:00") == kMin);
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("1677-09-21T00:12:43.145224191"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("1677-09-21"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_timestamp_ns("1677-09-20T23:59:59"), std::invalid_argument);
+}
+
+TEST_CASE("format_timestamp: round-trips parse_timestamp_ns", "[data]") {
+  REQUIRE(qe::format_timestamp(19723 * kDay) == "2024-01-01");
+  REQUIRE(qe::format_timestamp(-kDay) == "1969-12-31");
+  REQUIRE(qe::format_timestamp(qe::parse_timestamp_ns("2024-03-05T14:07:09")) == "2024-03-05T14:07:09");
+  REQUIRE(qe::format_timestamp(qe::parse_timestamp_ns("2024-03-05T14:07:09.25")) ==
+          "2024-03-05T14:07:09.250000000");
+}
+
+TEST_CASE("to_columns: splits rows into contiguous columns", "[data]") {
+  qe::OhlcvTable t;
+  t.push_back({"2024-01-01", 1.0, 2.0, 0.5, 1.5, 100.0});
+  t.push_back({"2024-01-02", 1.5, 2.5, 1.0, 2.0, 200.0});
+
+  const qe::OhlcvColumns c = qe::to_columns(t);
+
+  REQUIRE(c.size() == 2);
+  REQUIRE(c.ts[0] == 19723 * kDay);
+  REQUIRE(c.ts[1] == 19724 * kDay);
+  REQUIRE(c.open[1] == 1.5);
+  REQUIRE(c.high[1] == 2.5);
+  REQUIRE(c.low[1] == 1.0);
+  REQUIRE(c.close[1] == 2.0);
+  REQUIRE(c.volume[1] == 200.0);
+
+  qe::OhlcvTable bad;
+  bad.push_back({"t0", 0, 0, 0, 1.0, 0});
+  REQUIRE_THROWS_AS(qe::to_columns(bad), std::invalid_argument);
+}
@@ -0,0 +1,106 @@
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "qe/csv_reader.hpp"
+#include "qe/dataset.hpp"
+#include "qe/qec.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace fs = std::filesystem;
+
+static fs::path temp_path(const std::string& name) {
+  return fs::temp_directory_path() / fs::path("qe_dataset_test_" + name);
+}
+
+static qe::OhlcvColumns sample_columns(std::size_t n) {
+  qe::OhlcvColumns c;
+  for (std::size_t i = 0; i < n; ++i) {
+    const double x = 100.0 + static_cast<double>(i) * 0.25;
+    c.push_back(static_cast<std::int64_t>(i) * 60'000'000'000LL, x, x + 1.0, x - 1.0, x + 0.5,
+                1000.0 + static_cast<double>(i));
+  }
+  return c;
+}
+
+TEST_CASE("qec: write then load round-trips every column", "[qec]") {
+  const qe::OhlcvColumns src = sample_columns(37);
+  const fs::path p = temp_path("roundtrip.qec");
+  qe::write_qec(p.string(), src.view());
+
+  const qe::Dataset ds = qe::load_dataset(p.string(), {.verify_checksum = true});
+  REQUIRE(ds.is_mapped());
+  REQUIRE(ds.size() == src.size());
+
+  const qe::OhlcvView v = ds.view();
+  for (std::size_t i = 0; i < src.size(); ++i) {
+    REQUIRE(v.ts[i] == src.ts[i]);
+    REQUIRE(v.open[i] == src.open[i]);
+    REQUIRE(v.high[i] == src.high[i]);
+    REQUIRE(v.low[i] == src.low[i]);
+    REQUIRE(v.close[i] == src.close[i]);
+    REQUIRE(v.volume[i] == src.volume[i]);
+  }
+
+  // columns are 64-byte aligned in the mapping
+  REQUIRE(reinterpret_cast<std::uintptr_t>(v.close.data()) % qe::kQecAlign == 0);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(v.volume.data()) % qe::kQecAlign == 0);
+}
+
+TEST_CASE("qec: empty dataset round-trips", "[qec]") {
+  const fs::path p = temp_path("empty.qec");
+  qe::write_qec(p.string(), qe::OhlcvColumns{}.view());
+  REQUIRE(qe::load_dataset(p.string(), {.verify_checksum = true}).size() == 0);
+}
+
+TEST_CASE("qec: a projected view is rejected", "[qec]") {
+  const qe::OhlcvColumns src = sample_columns(5);
+  qe::OhlcvView no_close = src.view();
+  no_close.close = {};
+  REQUIRE_THROWS_AS(qe::write_qec(temp_path("projected.qec").string(), no_close), std::runtime_error);
+}
+
+TEST_CASE("load_dataset: falls back to CSV when there is no magic", "[qec]") {
+  const fs::path p = temp_path("plain.csv");
+  {
+    std::ofstream out(p.string(), std::ios::binary);
+    out << "timestamp,open,high,low,close,volume\n"
+           "2024-01-01,1,2,0.5,1.5,10\n"
+           "2024-01-02,1.5,2.5,1,2,20\n";
+  }
+
+  const qe::Dataset ds = qe::load_dataset(p.string());
+  REQUIRE(!ds.is_mapped());
+  REQUIRE(ds.size() == 2);
+  REQUIRE(ds.view().close[1] == 2.0);
+}
+
+TEST_CASE("qec: corruption is detected", "[qec]") {
+  const qe::OhlcvColumns src = sample_columns(16);
+  const fs::path p = temp_path("corrupt.qec");
+  qe::write_qec(p.string(), src.view());
+
+  const auto flip_byte = [&](std::streamoff off) {
+    std::fstream f(p.string(), std::ios::binary | std::ios::in | std::ios::out);
+    f.seekg(off);
+    char c = 0;
+    f.read(&c, 1);
+    c = static_cast<char>(c ^ 0x5a);
+    f.seekp(off);
+    f.write(&c, 1);
+  };
+
+  // payload byte: header still valid, only the opt-in checksum notices
+  flip_byte(static_cast<std::streamoff>(fs::file_size(p) - 70));
+  REQUIRE_NOTHROW(qe::load_dataset(p.string()));
+  REQUIRE_THROWS_AS(qe::load_dataset(p.string(), {.verify_checksum = true}), std::runtime_error);
+
+  // header byte (row count)
+  flip_byte(16);
+  REQUIRE_THROWS_AS(qe::load_dataset(p.string()), std::runtime_error);
+
+  REQUIRE_THROWS_AS(qe::load_dataset(temp_path("missing.qec").string()), std::runtime_error);
+}
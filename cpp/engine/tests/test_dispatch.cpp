@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "qe/backtest.hpp"
+#include "qe/dispatch.hpp"
+#include "qe/indicators.hpp"
+#include "qe/options.hpp"
+#include "qe/report.hpp"
+#include "test_support.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using qe_test::IsaGuard;
+using qe_test::random_walk;
+using qe_test::same_bits;
+using qe_test::supported_isas;
+
+namespace {
+
+// random walk with a zero close and a NaN gap
+std::vector<double> test_closes(std::size_t n) {
+  std::vector<double> c = random_walk(n, 12345, 100.0, 0.02);
+  if (n > 50) c[40] = 0.0;
+  if (n > 120) std::fill(c.begin() + 100, c.begin() + 103, std::nan(""));
+  return c;
+}
+
+} // namespace
+
+TEST_CASE("dispatch: active variant is supported and can be switched", "[dispatch]") {
+  IsaGuard guard;
+  const std::vector<qe::Isa> isas = supported_isas();
+  REQUIRE(static_cast<int>(qe::active_isa()) <= static_cast<int>(qe::detected_isa()));
+
+  for (qe::Isa isa : isas) {
+    REQUIRE(qe::set_active_isa(isa) == isa);
+    REQUIRE(qe::active_isa() == isa);
+  }
+  // asking for more than the CPU has falls back to the best it does have
+  REQUIRE(qe::set_active_isa(qe::Isa::Avx512) == qe::detected_isa());
+
+  REQUIRE(std::strcmp(qe::isa_name(qe::Isa::Scalar), "scalar") == 0);
+  REQUIRE(std::strcmp(qe::isa_name(qe::Isa::Avx2), "avx2") == 0);
+  REQUIRE(std::strcmp(qe::isa_name(qe::Isa::Avx512), "avx512") == 0);
+}
+
+TEST_CASE("dispatch: every variant gives bit-identical indicators and backtests", "[dispatch]") {
+  IsaGuard guard;
+  const std::vector<qe::Isa> isas = supported_isas();
+
+  for (std::size_t n : {3u, 22u, 37u, 200u, 1003u}) {
+    const std::vector<double> close = test_closes(n);
+
+    qe::set_active_isa(qe::Isa::Scalar);
+    const std::vector<double> ret = qe::compute_returns(close);
+    const std::vector<double> mean = qe::rolling_mean(close, 7);
+    const qe::BacktestResult bt = n > 21 ? qe::backtest_sma_crossover(close, 5, 20) : qe::BacktestResult{};
+    const double win = qe::compute_win_rate(ret);
+
+    for (qe::Isa isa : isas) {
+      qe::set_active_isa(isa);
+      INFO("isa " << qe::isa_name(isa) << ", n = " << n);
+      REQUIRE(same_bits(qe::compute_returns(close), ret));
+      REQUIRE(same_bits(qe::rolling_mean(close, 7), mean));
+      REQUIRE(same_bits(qe::compute_win_rate(ret), win));
+      if (n > 21) {
+        const qe::BacktestResult r = qe::backtest_sma_crossover(close, 5, 20);
+        REQUIRE(same_bits(r.strat_ret, bt.strat_ret));
+        REQUIRE(same_bits(r.equity, bt.equity));
+        REQUIRE(same_bits(r.max_drawdown, bt.max_drawdown));
+        REQUIRE(same_bits(r.sharpe, bt.sharpe));
+      }
+    }
+  }
+}
+
+TEST_CASE("black_scholes_batch: matches the scalar pricers", "[dispatch][options]") {
+  IsaGuard guard;
+
+  // a grid from deep in to deep out of the money, short to long expiries
+  std::vector<double> S, K, r, sigma, T;
+  for (double k : {40.0, 80.0, 95.0, 100.0, 105.0, 125.0, 250.0}) {
+    for (double vol : {0.05, 0.2, 0.8}) {
+      for (double t : {1.0 / 365.0, 0.25, 2.0, 10.0}) {
+        for (double rate : {-0.01, 0.0, 0.05}) {
+          S.push_back(100.0);
+          K.push_back(k);
+          sigma.push_back(vol);
+          T.push_back(t);
+          r.push_back(rate);
+        }
+      }
+    }
+  }
+  const std::size_t n = S.size();
+
+  for (qe::Isa isa : supported_isas()) {
+    qe::set_active_isa(isa);
+    INFO("isa " << qe::isa_name(isa));
+
+    // every length up to two registers, so tails are covered
+    for (std::size_t m : {std::size_t{1}, std::size_t{3}, std::size_t{9}, std::size_t{17}, n}) {
+      std::vector<double> call(m), put(m);
+      qe::black_scholes_batch(std::span(S).first(m), std::span(K).first(m), std::span(r).first(m),
+                              std::span(sigma).first(m), std::span(T).first(m), call, put);
+      for (std::size_t i = 0; i < m; ++i) {
+        const double c = qe::black_scholes_call(S[i], K[i], r[i], sigma[i], T[i]);
+        const double p = qe::black_scholes_put(S[i], K[i], r[i], sigma[i], T[i]);
+        if (isa == qe::Isa::Scalar) {
+          REQUIRE(same_bits(call[i], c));
+          REQUIRE(same_bits(put[i], p));
+        } else {
+          const double tol = 1e-12 * std::max(S[i], K[i]);
+          REQUIRE(std::fabs(call[i] - c) <= tol);
+          REQUIRE(std::fabs(put[i] - p) <= tol);
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("black_scholes_batch: validates lengths and inputs", "[dispatch][options]") {
+  std::vector<double> one{1.0};
+  std::vector<double> two{1.0, 1.0};
+  std::vector<double> out(1), out2(1);
+  REQUIRE_THROWS_AS(qe::black_scholes_batch(two, one, one, one, one, out, out2), std::runtime_error);
+  REQUIRE_THROWS_AS(qe::black_scholes_batch(one, one, one, one, one, two, out2), std::runtime_error);
+
+  std::vector<double> bad{-1.0};
+  REQUIRE_THROWS_AS(qe::black_scholes_batch(bad, one, one, one, one, out, out2), std::runtime_error);
+
+  std::vector<double> none;
+  REQUIRE_NOTHROW(qe::black_scholes_batch(none, none, none, none, none, none, none));
+}
@@ -0,0 +1,119 @@
+#include <cmath>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "qe/backtest.hpp"
+#include "qe/dispatch.hpp"
+#include "qe/fixed_window.hpp"
+#include "qe/indicators.hpp"
+#include "test_support.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using qe_test::IsaGuard;
+using qe_test::random_walk;
+using qe_test::same_bits;
+using qe_test::supported_isas;
+
+namespace {
+
+// random walk with a zero close and, when long enough, a NaN gap
+std::vector<double> test_closes(std::size_t n, bool gaps) {
+  std::vector<double> c = random_walk(n, 99, 100.0, 0.02);
+  if (gaps && n > 300) {
+    c[250] = 0.0;
+    c[n - 40] = std::nan("");
+  }
+  return c;
+}
+
+template <std::size_t W>
+void check_rolling_mean(const std::vector<double>& v) {
+  INFO("window " << W << ", n = " << v.size());
+  const std::vector<double> want = qe::rolling_mean(v, W);
+  REQUIRE(same_bits(qe::rolling_mean<W>(v), want));
+
+  std::vector<double> out(v.size());
+  qe::find_fixed_rolling_mean(W)(v, out);
+  REQUIRE(same_bits(out, want));
+}
+
+template <std::size_t Fast, std::size_t Slow>
+void check_backtest(const std::vector<double>& close) {
+  INFO("pair " << Fast << "/" << Slow << ", n = " << close.size());
+  const qe::BacktestResult want = qe::backtest_sma_crossover(close, Fast, Slow, 2.0);
+  const qe::BacktestResult got = qe::backtest_sma_crossover<Fast, Slow>(close, 2.0);
+  REQUIRE(same_bits(got.strat_ret, want.strat_ret));
+  REQUIRE(same_bits(got.equity, want.equity));
+  REQUIRE(same_bits(got.total_return, want.total_return));
+  REQUIRE(same_bits(got.max_drawdown, want.max_drawdown));
+  REQUIRE(same_bits(got.sharpe, want.sharpe));
+
+  std::vector<double> strat_ret(close.size() - 1);
+  std::vector<double> equity(close.size() - 1);
+  const qe::BacktestResult via_registry =
+    qe::find_fixed_sma_crossover(Fast, Slow)(close, 2.0, {}, strat_ret, equity);
+  REQUIRE(same_bits(strat_ret, want.strat_ret));
+  REQUIRE(same_bits(equity, want.equity));
+  REQUIRE(same_bits(via_registry.sharpe, want.sharpe));
+}
+
+} // namespace
+
+TEST_CASE("rolling_mean<W>: bit-identical to the runtime window on every variant", "[fixed_window]") {
+  IsaGuard guard;
+  for (qe::Isa isa : supported_isas()) {
+    qe::set_active_isa(isa);
+    INFO("isa " << qe::isa_name(isa));
+    for (std::size_t n : {0u, 3u, 19u, 20u, 23u, 211u, 1003u}) {
+      const std::vector<double> v = test_closes(n, true);
+      check_rolling_mean<5>(v);
+      check_rolling_mean<10>(v);
+      check_rolling_mean<20>(v);
+      check_rolling_mean<50>(v);
+      check_rolling_mean<200>(v);
+    }
+  }
+}
+
+TEST_CASE("backtest_sma_crossover<Fast, Slow>: bit-identical to the runtime windows", "[fixed_window]") {
+  IsaGuard guard;
+  for (qe::Isa isa : supported_isas()) {
+    qe::set_active_isa(isa);
+    INFO("isa " << qe::isa_name(isa));
+    for (std::size_t n : {201u, 202u, 207u, 1003u, 4096u}) {
+      for (bool gaps : {false, true}) {
+        const std::vector<double> close = test_closes(n, gaps);
+        check_backtest<5, 20>(close);
+        check_backtest<10, 50>(close);
+        check_backtest<50, 200>(close);
+      }
+    }
+    // shortest inputs each pair accepts
+    check_backtest<5, 20>(test_closes(21, false));
+    check_backtest<10, 50>(test_closes(51, false));
+  }
+}
+
+TEST_CASE("fixed windows: registry lookups and validation", "[fixed_window]") {
+  REQUIRE(qe::find_fixed_rolling_mean(7) == nullptr);
+  REQUIRE(qe::find_fixed_rolling_mean(20) != nullptr);
+  REQUIRE(qe::find_fixed_sma_crossover(5, 20) != nullptr);
+  REQUIRE(qe::find_fixed_sma_crossover(20, 5) == nullptr);
+  REQUIRE(qe::find_fixed_sma_crossover(5, 21) == nullptr);
+  for (const qe::WindowPair& p : qe::kFixedPairs) {
+    REQUIRE(qe::find_fixed_sma_crossover(p.fast, p.slow) != nullptr);
+  }
+
+  const std::vector<double> close = test_closes(100, false);
+  std::vector<double> short_out(99);
+  REQUIRE_THROWS_AS(qe::rolling_mean<5>(close, short_out), std::invalid_argument);
+  const auto too_short = [&] { return qe::backtest_sma_crossover<50, 200>(close); };
+  const auto no_equity = [&] { return qe::backtest_sma_crossover<5, 20>(close, 0.0); };
+  REQUIRE_THROWS_AS(too_short(), std::invalid_argument);
+  REQUIRE_THROWS_AS(no_equity(), std::invalid_argument);
+  std::vector<double> equity(98);
+  const auto bad_span = [&] { return qe::backtest_sma_crossover<5, 20>(close, 1.0, {}, short_out, equity); };
+  REQUIRE_THROWS_AS(bad_span(), std::invalid_argument);
+}
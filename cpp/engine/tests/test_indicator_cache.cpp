@@ -0,0 +1,120 @@
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "qe/backtest.hpp"
+#include "qe/indicator_cache.hpp"
+#include "qe/indicators.hpp"
+#include "qe/strategy.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+static std::vector<double> walk(std::size_t n, double phase) {
+  std::vector<double> v;
+  for (std::size_t i = 0; i < n; ++i) {
+    v.push_back(100.0 + 6.0 * std::sin(static_cast<double>(i) * 0.03 + phase) + std::cos(static_cast<double>(i) * 0.7));
+  }
+  return v;
+}
+
+// equal element by element, NaN matching NaN
+static bool same_series(const std::vector<double>& a, const std::vector<double>& b) {
+  if (a.size() != b.size()) return false;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    if (!(a[i] == b[i] || (std::isnan(a[i]) && std::isnan(b[i])))) return false;
+  }
+  return true;
+}
+
+TEST_CASE("indicator cache: hits by content, not by address") {
+  const std::vector<double> a = walk(1000, 0.0);
+  const std::vector<double> copy = a; // same data, different buffer
+  const std::vector<double> other = walk(1000, 1.0);
+  REQUIRE(qe::content_hash(a) == qe::content_hash(copy));
+  REQUIRE(qe::content_hash(a) != qe::content_hash(other));
+  REQUIRE(qe::content_hash(std::span(a).first(999)) != qe::content_hash(a));
+
+  qe::IndicatorCache cache;
+  const qe::SeriesSource src = qe::make_series_source(a, "close");
+  const qe::IndicatorCache::Series m1 = cache.rolling_mean(src, 20);
+  const qe::IndicatorCache::Series m2 = cache.rolling_mean(qe::make_series_source(copy, "close"), 20);
+  REQUIRE(m1 == m2); // the same shared series
+  REQUIRE(same_series(*m1, qe::rolling_mean(a, 20)));
+
+  // any part of the key differing is a different entry
+  REQUIRE(cache.rolling_mean(qe::make_series_source(a, "open"), 20) != m1);
+  REQUIRE(cache.rolling_mean(src, 21) != m1);
+  REQUIRE(cache.rolling_mean(src, 20, 1) != m1);
+  REQUIRE(cache.rolling_std(src, 20) != m1);
+  REQUIRE(cache.rolling_mean(qe::make_series_source(other, "close"), 20) != m1);
+  const qe::IndicatorCache::Series lo = cache.rolling_min(src, 20);
+  REQUIRE(cache.rolling_max(src, 20) != lo);
+  REQUIRE(same_series(*lo, qe::rolling_min(a, 20)));
+
+  const qe::IndicatorCacheStats s = cache.stats();
+  REQUIRE(s.hits == 1);
+  REQUIRE(s.misses == 8);
+  REQUIRE(s.entries == 8);
+  REQUIRE(s.bytes == (7 * 1000 + 999) * sizeof(double)); // one of them starts at index 1
+  REQUIRE(s.hit_rate() == 1.0 / 9.0);
+
+  cache.clear();
+  REQUIRE(cache.stats().entries == 0);
+  REQUIRE(cache.stats().bytes == 0);
+  REQUIRE(same_series(*m1, qe::rolling_mean(a, 20))); // handed-out series outlive the entry
+
+  REQUIRE_THROWS_AS(cache.returns(src, 1001), std::invalid_argument);
+}
+
+TEST_CASE("indicator cache: least recently used entries go first once over the limit") {
+  const std::vector<double> a = walk(1000, 0.0);
+  const qe::SeriesSource src = qe::make_series_source(a, "close");
+  qe::IndicatorCache cache(3 * 1000 * sizeof(double)); // room for three series
+
+  cache.rolling_mean(src, 5);
+  cache.rolling_mean(src, 10);
+  cache.rolling_mean(src, 20);
+  cache.rolling_mean(src, 5);  // hit, now most recent
+  cache.rolling_mean(src, 50); // evicts w=10
+  REQUIRE(cache.stats().evictions == 1);
+  REQUIRE(cache.stats().entries == 3);
+  REQUIRE(cache.stats().bytes <= 3 * 1000 * sizeof(double));
+
+  cache.rolling_mean(src, 5);  // still there
+  REQUIRE(cache.stats().hits == 2);
+  cache.rolling_mean(src, 10); // recomputed
+  REQUIRE(cache.stats().misses == 5);
+
+  // a series bigger than the whole cache is returned but not kept
+  qe::IndicatorCache tiny(100);
+  REQUIRE(tiny.returns(src)->size() == 999);
+  REQUIRE(tiny.stats().entries == 0);
+  REQUIRE(tiny.stats().bytes == 0);
+}
+
+TEST_CASE("indicator cache: backtests share series and match the uncached run") {
+  const std::vector<double> close = walk(3000, 0.5);
+  const qe::SeriesSource src = qe::make_series_source(close, "close");
+  const qe::StrategyKernels& breakout = qe::find_strategy("breakout");
+  qe::IndicatorCache cache;
+
+  for (std::size_t fast : {5u, 10u}) {
+    for (std::size_t slow : {20u, 50u}) {
+      const qe::BacktestResult a = qe::run_backtest(breakout, close, {fast, slow}, 1.0);
+      std::vector<double> strat_ret(close.size() - 1);
+      std::vector<double> equity(close.size() - 1);
+      const qe::BacktestResult b = breakout.cached(src, {fast, slow}, 1.0, {}, cache, strat_ret, equity);
+      REQUIRE(a.equity == equity);
+      REQUIRE(a.strat_ret == strat_ret);
+      REQUIRE(a.total_return == b.total_return);
+      REQUIRE(a.max_drawdown == b.max_drawdown);
+      REQUIRE(a.sharpe == b.sharpe);
+    }
+  }
+  // two lows and two highs once each; everything else is a hit
+  const qe::IndicatorCacheStats s = cache.stats();
+  REQUIRE(s.misses == 4);
+  REQUIRE(s.hits == 2 * 4 - 4);
+
+  REQUIRE_THROWS_AS(breakout.cached(src, {20, 5}, 1.0, {}, cache, {}, {}), std::invalid_argument);
+}
@@ -1,9 +1,12 @@
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <vector>
 
 #include "qe/indicators.hpp"
 #include "qe/data.hpp"
+#include "qe/memory.hpp"
+#include "test_support.hpp"
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
@@ -133,3 +136,391 @@ TEST_CASE("rolling_std: window=0 throws invalid_argument") {
   std::vector<double> v{1.0, 2.0};
   REQUIRE_THROWS_AS(qe::rolling_std(v, 0), std::invalid_argument);
 }
+
+// per-window mean then variance: the O(n * window) definition rolling_std must track
+static std::vector<double> two_pass_std(const std::vector<double>& v, std::size_t w) {
+  std::vector<double> out(v.size(), std::numeric_limits<double>::quiet_NaN());
+  for (std::size_t i = w - 1; i < v.size(); ++i) {
+    double mean = 0.0;
+    for (std::size_t j = i + 1 - w; j <= i; ++j) mean += v[j];
+    mean /= static_cast<double>(w);
+    double var = 0.0;
+    for (std::size_t j = i + 1 - w; j <= i; ++j) var += (v[j] - mean) * (v[j] - mean);
+    out[i] = std::sqrt(var / static_cast<double>(w));
+  }
+  return out;
+}
+
+TEST_CASE("rolling_std: O(n) update stays within tolerance of the two-pass result") {
+  // deterministic pseudo-random noise in [-1, 1)
+  qe_test::Lcg rng(12345);
+  auto noise = [&] { return static_cast<double>(rng.next() >> 11) / 4503599627370496.0 - 1.0; };
+
+  std::vector<std::vector<double>> series(4);
+  double px = 100.0;
+  for (int i = 0; i < 20000; ++i) {
+    px *= 1.0 + 0.001 * noise();
+    series[0].push_back(px);                 // price walk
+    series[1].push_back(0.001 * noise());    // returns
+    series[2].push_back(1e9 + noise());      // large offset, small spread
+    series[3].push_back(i >= 5000 && i < 5003 ? 1e6 : 100.0); // long flat with a spike
+  }
+
+  for (const auto& v : series) {
+    for (std::size_t w : {1, 2, 3, 20, 250, 1000}) {
+      const std::vector<double> fast = qe::rolling_std(v, w);
+      const std::vector<double> ref = two_pass_std(v, w);
+      std::size_t outside = 0;
+      for (std::size_t i = w - 1; i < v.size(); ++i) {
+        double scale = 0.0;
+        for (std::size_t j = i + 1 - w; j <= i; ++j) scale = std::max(scale, std::fabs(v[j]));
+        if (std::fabs(fast[i] - ref[i]) > std::max(1e-9 * ref[i], 1e-12 * scale)) ++outside;
+      }
+      REQUIRE(outside == 0);
+    }
+  }
+
+  // once the spike has left, the flat series is exactly flat again
+  const std::vector<double> s = qe::rolling_std(series[3], 250);
+  for (std::size_t i = 5003 + 250; i < s.size(); ++i) REQUIRE(s[i] == 0.0);
+
+  // a NaN (zero close in compute_returns) only poisons the windows that contain it
+  std::vector<double> gap = series[1];
+  gap[700] = std::numeric_limits<double>::quiet_NaN();
+  const std::vector<double> g = qe::rolling_std(gap, 20);
+  const std::vector<double> g_ref = two_pass_std(gap, 20);
+  for (std::size_t i = 19; i < g.size(); ++i) {
+    REQUIRE(std::isnan(g[i]) == (i >= 700 && i < 720));
+    if (!std::isnan(g[i])) REQUIRE(std::fabs(g[i] - g_ref[i]) <= 1e-9 * g_ref[i]);
+  }
+
+  // so does an infinity, and the moments are exact again once it leaves
+  gap[700] = std::numeric_limits<double>::infinity();
+  const std::vector<double> h = qe::rolling_std(gap, 20);
+  for (std::size_t i = 19; i < h.size(); ++i) {
+    REQUIRE(std::isnan(h[i]) == (i >= 700 && i < 720));
+    if (!std::isnan(h[i])) REQUIRE(std::fabs(h[i] - g_ref[i]) <= 1e-9 * g_ref[i]);
+  }
+}
+
+TEST_CASE("compute_returns / rolling_mean: every length and window, including vector tails") {
+  std::vector<double> v;
+  for (int i = 0; i < 70; ++i) v.push_back(100.0 + std::sin(i * 0.7) * 3.0 + (i % 11 == 4 ? -100.0 : 0.0));
+  v[20] = 0.0; // zero close -> NaN return
+
+  for (std::size_t n = 0; n <= v.size(); ++n) {
+    const std::vector<double> head(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(n));
+
+    // element-wise kernel is exact
+    const std::vector<double> r = qe::compute_returns(head);
+    REQUIRE(r.size() == (n < 2 ? 0 : n - 1));
+    for (std::size_t i = 0; i < r.size(); ++i) {
+      if (head[i] == 0.0) {
+        REQUIRE(is_nan(r[i]));
+      } else {
+        REQUIRE(r[i] == (head[i + 1] - head[i]) / head[i]);
+      }
+    }
+
+    for (std::size_t w = 1; w <= 9; ++w) {
+      const std::vector<double> m = qe::rolling_mean(head, w);
+      REQUIRE(m.size() == n);
+      for (std::size_t i = 0; i < n; ++i) {
+        if (i + 1 < w) {
+          REQUIRE(is_nan(m[i]));
+          continue;
+        }
+        double sum = 0.0;
+        for (std::size_t j = i + 1 - w; j <= i; ++j) sum += head[j];
+        REQUIRE(approx(m[i], sum / static_cast<double>(w), 1e-12));
+      }
+    }
+  }
+}
+
+TEST_CASE("ema: seeded with the simple mean, then alpha = 2 / (period + 1)") {
+  const std::vector<double> v = {1.0, 2.0, 3.0, 4.0, 5.0};
+  const std::vector<double> e = qe::ema(v, 3);
+  REQUIRE(e.size() == v.size());
+  REQUIRE(is_nan(e[0]));
+  REQUIRE(is_nan(e[1]));
+  REQUIRE(e[2] == 2.0);
+  REQUIRE(e[3] == 3.0);
+  REQUIRE(e[4] == 4.0);
+
+  REQUIRE(qe::ema(v, 1) == v);
+  REQUIRE_THROWS_AS(qe::ema(v, 0), std::invalid_argument);
+}
+
+TEST_CASE("rsi: Wilder smoothing of average gains and losses") {
+  const std::vector<double> v = {1.0, 2.0, 3.0, 2.0, 3.0};
+  const std::vector<double> r = qe::rsi(v, 2);
+  REQUIRE(is_nan(r[0]));
+  REQUIRE(is_nan(r[1]));
+  REQUIRE(r[2] == 100.0); // no losses yet
+  REQUIRE(r[3] == 50.0);  // avg gain 0.5, avg loss 0.5
+  REQUIRE(r[4] == 75.0);  // avg gain 0.75, avg loss 0.25
+
+  const std::vector<double> flat(10, 7.0);
+  REQUIRE(qe::rsi(flat, 3).back() == 50.0);
+  REQUIRE_THROWS_AS(qe::rsi(v, 0), std::invalid_argument);
+}
+
+TEST_CASE("atr: true range includes gaps from the previous close") {
+  const std::vector<double> high = {10.0, 12.0, 11.0, 20.0};
+  const std::vector<double> low = {8.0, 11.0, 9.0, 18.0};
+  const std::vector<double> close = {9.0, 11.5, 10.0, 19.0};
+  // true ranges: 2, 3 (12 - 9), 2.5 (11.5 - 9), 10 (20 - 10)
+  const std::vector<double> a = qe::atr(high, low, close, 2);
+  REQUIRE(is_nan(a[0]));
+  REQUIRE(a[1] == 2.5);
+  REQUIRE(a[2] == 2.5);
+  REQUIRE(a[3] == 6.25);
+
+  REQUIRE_THROWS_AS(qe::atr(high, low, std::vector<double>{1.0}, 2), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::atr(high, low, close, 0), std::invalid_argument);
+}
+
+TEST_CASE("bollinger: rolling mean +/- k rolling std") {
+  std::vector<double> v;
+  for (int i = 0; i < 100; ++i) v.push_back(100.0 + std::sin(i * 0.3) * 5.0);
+
+  const qe::BollingerSeries b = qe::bollinger(v, 20, 2.0);
+  const std::vector<double> m = qe::rolling_mean(v, 20);
+  const std::vector<double> s = qe::rolling_std(v, 20);
+  for (std::size_t i = 0; i < v.size(); ++i) {
+    if (i < 19) {
+      REQUIRE((is_nan(b.middle[i]) && is_nan(b.upper[i]) && is_nan(b.lower[i])));
+      continue;
+    }
+    REQUIRE(b.middle[i] == m[i]);
+    REQUIRE(b.upper[i] == m[i] + 2.0 * s[i]);
+    REQUIRE(b.lower[i] == m[i] - 2.0 * s[i]);
+  }
+  REQUIRE_THROWS_AS(qe::bollinger(v, 0), std::invalid_argument);
+}
+
+TEST_CASE("rolling_min / rolling_max: match a direct scan, NaNs skipped") {
+  std::vector<double> v;
+  qe_test::Lcg rng(99);
+  for (int i = 0; i < 300; ++i) v.push_back(static_cast<double>(rng.next() >> 40) / 1000.0);
+  v[50] = v[49]; // ties
+  for (int i = 120; i < 126; ++i) v[static_cast<std::size_t>(i)] = std::numeric_limits<double>::quiet_NaN();
+
+  for (std::size_t w : {1u, 2u, 5u, 6u, 37u, 300u, 400u}) {
+    const std::vector<double> lo = qe::rolling_min(v, w);
+    const std::vector<double> hi = qe::rolling_max(v, w);
+    for (std::size_t i = 0; i < v.size(); ++i) {
+      if (i + 1 < w) {
+        REQUIRE((is_nan(lo[i]) && is_nan(hi[i])));
+        continue;
+      }
+      double mn = std::numeric_limits<double>::infinity();
+      double mx = -std::numeric_limits<double>::infinity();
+      for (std::size_t j = i + 1 - w; j <= i; ++j) {
+        if (is_nan(v[j])) continue;
+        mn = std::min(mn, v[j]);
+        mx = std::max(mx, v[j]);
+      }
+      if (std::isinf(mn)) {
+        REQUIRE((is_nan(lo[i]) && is_nan(hi[i]))); // window of NaNs only
+      } else {
+        REQUIRE(lo[i] == mn);
+        REQUIRE(hi[i] == mx);
+      }
+    }
+  }
+  REQUIRE_THROWS_AS(qe::rolling_min(v, 0), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::rolling_max(v, 0), std::invalid_argument);
+}
+
+TEST_CASE("donchian / rolling_max_drawdown: match a direct scan of each window") {
+  // an equity curve that rallies, crashes and recovers, with a NaN gap
+  std::vector<double> eq;
+  qe_test::Lcg rng(7);
+  double px = 1.0;
+  for (int i = 0; i < 600; ++i) {
+    const double drift = i < 200 ? 0.002 : (i < 320 ? -0.006 : 0.003);
+    px *= 1.0 + drift + rng.uniform() * 0.02;
+    eq.push_back(px);
+  }
+  for (int i = 400; i < 404; ++i) eq[static_cast<std::size_t>(i)] = std::numeric_limits<double>::quiet_NaN();
+
+  for (std::size_t w : {1u, 2u, 7u, 64u, 250u, 600u, 700u}) {
+    const std::vector<double> dd = qe::rolling_max_drawdown(eq, w);
+    REQUIRE(dd.size() == eq.size());
+    for (std::size_t i = 0; i < eq.size(); ++i) {
+      if (i + 1 < w) {
+        REQUIRE(is_nan(dd[i]));
+        continue;
+      }
+      double peak = -std::numeric_limits<double>::infinity();
+      double ref = 0.0;
+      for (std::size_t j = i + 1 - w; j <= i; ++j) {
+        if (is_nan(eq[j])) continue;
+        peak = std::max(peak, eq[j]);
+        ref = std::max(ref, (peak - eq[j]) / peak);
+      }
+      if (std::isinf(peak)) {
+        REQUIRE(is_nan(dd[i])); // window of NaNs only
+      } else {
+        REQUIRE(approx(dd[i], ref, 1e-15));
+      }
+    }
+  }
+
+  std::vector<double> high, low;
+  for (double x : eq) {
+    high.push_back(x * 1.01);
+    low.push_back(x * 0.98);
+  }
+  const qe::DonchianSeries ch = qe::donchian(high, low, 20);
+  const std::vector<double> hi = qe::rolling_max(high, 20);
+  const std::vector<double> lo = qe::rolling_min(low, 20);
+  REQUIRE(is_nan(ch.upper[18]));
+  for (std::size_t i = 19; i < eq.size(); ++i) {
+    REQUIRE(ch.upper[i] == hi[i]);
+    REQUIRE(ch.lower[i] == lo[i]);
+    REQUIRE(ch.middle[i] == 0.5 * (hi[i] + lo[i]));
+  }
+
+  REQUIRE_THROWS_AS(qe::rolling_max_drawdown(eq, 0), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::donchian(high, low, 0), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::donchian(high, std::vector<double>{1.0}, 5), std::invalid_argument);
+}
+
+TEST_CASE("indicator state objects: pushing bar by bar reproduces the batch functions") {
+  std::vector<double> v;
+  for (int i = 0; i < 257; ++i) v.push_back(100.0 + std::sin(i * 0.21) * 4.0 + (i % 17) * 0.1);
+  std::vector<double> high, low;
+  for (double x : v) {
+    high.push_back(x + 0.5);
+    low.push_back(x - 0.7);
+  }
+  auto same = [](double a, double b) { return (is_nan(a) && is_nan(b)) || a == b; };
+
+  for (std::size_t w : {1u, 3u, 14u, 20u}) {
+    qe::RollingMean mean(w);
+    qe::RollingStd sd(w);
+    qe::Ema e(w);
+    qe::Rsi r(w);
+    qe::Atr a(w);
+    qe::Bollinger b(w, 1.5);
+    qe::RollingMin lo(w);
+    qe::RollingMax hi(w);
+    qe::Donchian ch(w);
+    qe::RollingMaxDrawdown dd(w);
+
+    const std::vector<double> mean_ref = qe::rolling_mean(v, w); // vector kernel, same summation order
+    const std::vector<double> sd_ref = qe::rolling_std(v, w);
+    const std::vector<double> e_ref = qe::ema(v, w);
+    const std::vector<double> r_ref = qe::rsi(v, w);
+    const std::vector<double> a_ref = qe::atr(high, low, v, w);
+    const qe::BollingerSeries b_ref = qe::bollinger(v, w, 1.5);
+    const std::vector<double> lo_ref = qe::rolling_min(v, w);
+    const std::vector<double> hi_ref = qe::rolling_max(v, w);
+    const qe::DonchianSeries ch_ref = qe::donchian(high, low, w);
+    const std::vector<double> dd_ref = qe::rolling_max_drawdown(v, w);
+
+    for (std::size_t i = 0; i < v.size(); ++i) {
+      REQUIRE(same(mean.push(v[i]), mean_ref[i]));
+      REQUIRE(same(mean.value(), mean_ref[i]));
+      REQUIRE(same(sd.push(v[i]), sd_ref[i]));
+      REQUIRE(same(e.push(v[i]), e_ref[i]));
+      REQUIRE(same(r.push(v[i]), r_ref[i]));
+      REQUIRE(same(a.push(high[i], low[i], v[i]), a_ref[i]));
+      REQUIRE(same(b.push(v[i]).upper, b_ref.upper[i]));
+      REQUIRE(same(b.value().lower, b_ref.lower[i]));
+      REQUIRE(same(lo.push(v[i]), lo_ref[i]));
+      REQUIRE(same(hi.push(v[i]), hi_ref[i]));
+      REQUIRE(same(ch.push(high[i], low[i]).middle, ch_ref.middle[i]));
+      REQUIRE(same(dd.push(v[i]), dd_ref[i]));
+      REQUIRE(same(dd.value(), dd_ref[i]));
+    }
+  }
+}
+
+TEST_CASE("rolling_means: every window from one prefix pass, either layout") {
+  std::vector<double> v;
+  double px = 5000.0;
+  for (int i = 0; i < 10000; ++i) { // several prefix blocks
+    px += std::sin(i * 0.013) * 2.0 + (i % 7) * 0.01;
+    v.push_back(px);
+  }
+  const std::vector<std::size_t> windows = {1, 5, 20, 200, 5000, 9999, 10000, 12000};
+
+  for (qe::MatrixLayout layout : {qe::MatrixLayout::WindowMajor, qe::MatrixLayout::TimeMajor}) {
+    const qe::RollingMeans rm = qe::rolling_means(v, windows, layout);
+    REQUIRE(rm.windows == windows);
+    REQUIRE(rm.length == v.size());
+    REQUIRE(rm.data.size() == v.size() * windows.size());
+
+    for (std::size_t k = 0; k < windows.size(); ++k) {
+      const std::vector<double> ref = qe::rolling_mean(v, windows[k]);
+      for (std::size_t i = 0; i < v.size(); ++i) {
+        const double m = rm.at(k, i);
+        if (is_nan(ref[i])) {
+          REQUIRE(is_nan(m));
+        } else {
+          REQUIRE(approx(m, ref[i], 1e-12 * std::fabs(ref[i])));
+        }
+      }
+    }
+  }
+
+  // contiguity of the two layouts
+  const qe::RollingMeans wm = qe::rolling_means(v, {5, 20}, qe::MatrixLayout::WindowMajor);
+  const qe::RollingMeans tm = qe::rolling_means(v, {5, 20}, qe::MatrixLayout::TimeMajor);
+  REQUIRE(wm.data[v.size() + 100] == wm.at(1, 100));
+  REQUIRE(tm.data[2 * 100 + 1] == tm.at(1, 100));
+  REQUIRE(wm.at(1, 100) == tm.at(1, 100));
+
+  // refilling an existing matrix gives the same values, heads included
+  qe::RollingMeans reused = qe::rolling_means(v, {3000, 7}, qe::MatrixLayout::TimeMajor);
+  qe::rolling_means(v, {5, 20}, qe::MatrixLayout::WindowMajor, reused);
+  REQUIRE(reused.windows == wm.windows);
+  REQUIRE(reused.layout == qe::MatrixLayout::WindowMajor);
+  REQUIRE(is_nan(reused.at(1, 18)));
+  REQUIRE(reused.at(1, 100) == wm.at(1, 100));
+
+  REQUIRE(qe::rolling_means(v, {}).data.empty());
+  REQUIRE(qe::rolling_means(std::vector<double>{}, {3}).data.empty());
+  REQUIRE_THROWS_AS(qe::rolling_means(v, {5, 0}), std::invalid_argument);
+}
+
+TEST_CASE("span outputs: same values as the vector forms, lengths checked") {
+  std::vector<double> v;
+  for (int i = 0; i < 500; ++i) v.push_back(50.0 + std::sin(i * 0.07) * 3.0 + (i % 11) * 0.05);
+  v[3] = 0.0;
+
+  std::vector<double> ret(v.size() - 1);
+  qe::compute_returns(v, ret);
+  const std::vector<double> ret_ref = qe::compute_returns(v);
+  for (std::size_t i = 0; i < ret.size(); ++i) {
+    REQUIRE(((is_nan(ret[i]) && is_nan(ret_ref[i])) || ret[i] == ret_ref[i]));
+  }
+
+  // stale contents must not leak into the nil head
+  std::vector<double> out(v.size(), 123.0);
+  qe::rolling_mean(v, 20, out);
+  REQUIRE(is_nan(out[18]));
+  const std::vector<double> mean_ref = qe::rolling_mean(v, 20);
+  for (std::size_t i = 19; i < v.size(); ++i) REQUIRE(out[i] == mean_ref[i]);
+
+  // rolling_std's window ring comes from the scratch resource
+  qe::CountingResource counter;
+  std::fill(out.begin(), out.end(), 123.0);
+  qe::rolling_std(v, 20, out, &counter);
+  REQUIRE(counter.allocations() == 1);
+  REQUIRE(counter.bytes_allocated() == 20 * sizeof(double));
+  REQUIRE(is_nan(out[18]));
+  const std::vector<double> sd_ref = qe::rolling_std(v, 20);
+  for (std::size_t i = 19; i < v.size(); ++i) REQUIRE(out[i] == sd_ref[i]);
+
+  std::vector<double> empty;
+  REQUIRE_NOTHROW(qe::compute_returns(std::vector<double>{1.0}, empty));
+  REQUIRE_THROWS_AS(qe::compute_returns(v, out), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::rolling_mean(v, 20, ret), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::rolling_std(v, 20, ret), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::rolling_mean(v, 0, out), std::invalid_argument);
+}
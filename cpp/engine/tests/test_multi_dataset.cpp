@@ -0,0 +1,143 @@
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "qe/backtest.hpp"
+#include "qe/csv_reader.hpp"
+#include "qe/multi_dataset.hpp"
+#include "qe/qec.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace fs = std::filesystem;
+
+static fs::path temp_path(const std::string& name) {
+  return fs::temp_directory_path() / fs::path("qe_multi_test_" + name);
+}
+
+static double px(int sym, int i) {
+  return 100.0 * (sym + 1) + i + (i % 3) * 0.25;
+}
+
+static void write_symbol_csv(const fs::path& p, int sym, int n) {
+  std::ofstream out(p, std::ios::binary);
+  out << "timestamp,open,high,low,close,volume\n";
+  for (int i = 0; i < n; ++i) {
+    out << "2024-01-" << (i < 9 ? "0" : "") << (i + 1) << "," << px(sym, i) << "," << px(sym, i) + 1
+        << "," << px(sym, i) - 1 << "," << px(sym, i) << "," << 10 * sym + i << "\n";
+  }
+}
+
+TEST_CASE("SymbolTable: interns in first-seen order", "[multi]") {
+  qe::SymbolTable t;
+  REQUIRE(t.intern("MSFT") == 0);
+  REQUIRE(t.intern("AAPL") == 1);
+  REQUIRE(t.intern(std::string("MSFT")) == 0);
+  REQUIRE(t.size() == 2);
+  REQUIRE(t.name(1) == "AAPL");
+  REQUIRE(t.find("AAPL") == qe::SymbolId{1});
+  REQUIRE_FALSE(t.find("GOOG").has_value());
+}
+
+TEST_CASE("load_multi_dataset: long-format CSV groups interleaved rows", "[multi]") {
+  const fs::path p = temp_path("long.csv");
+  {
+    std::ofstream out(p, std::ios::binary);
+    out << "timestamp,Symbol,open,high,low,close,volume\r\n";
+    for (int i = 0; i < 20; ++i) {
+      for (int sym : {2, 0, 1}) {
+        if (sym == 1 && i % 2) continue; // uneven lengths
+        out << "2024-01-" << (i < 9 ? "0" : "") << (i + 1) << ",S" << sym << "," << px(sym, i) << ","
+            << px(sym, i) + 1 << "," << px(sym, i) - 1 << "," << px(sym, i) << "," << 10 * sym + i << "\r\n";
+      }
+    }
+    out << "\r\n";
+  }
+
+  REQUIRE(qe::is_multi_symbol_source(p.string()));
+  const qe::MultiDataset ds = qe::load_multi_dataset(p.string());
+  REQUIRE(ds.symbol_count() == 3);
+  REQUIRE(ds.symbols().name(0) == "S2"); // first seen
+  REQUIRE(ds.size() == 20 + 20 + 10);
+
+  const qe::OhlcvView s1 = ds.slice("S1");
+  REQUIRE(s1.size() == 10);
+  for (std::size_t k = 0; k < s1.size(); ++k) {
+    REQUIRE(s1.close[k] == px(1, static_cast<int>(2 * k)));
+    REQUIRE(s1.volume[k] == 10 + 2 * static_cast<double>(k));
+    if (k) REQUIRE(s1.ts[k] > s1.ts[k - 1]);
+  }
+
+  // slices alias the arena
+  const qe::SymbolRange r = ds.range(*ds.symbols().find("S1"));
+  REQUIRE(s1.close.data() == ds.view().close.data() + r.offset);
+
+  REQUIRE_THROWS_AS(ds.slice("NOPE"), std::out_of_range);
+}
+
+TEST_CASE("load_multi_dataset: symbol column first, parse errors", "[multi]") {
+  const fs::path p = temp_path("long_first.csv");
+  {
+    std::ofstream out(p, std::ios::binary);
+    out << "symbol,timestamp,open,high,low,close,volume\n"
+        << "A,2024-01-01,1,2,0.5,1.5,10\n"
+        << "B,2024-01-01,1,2,0.5,1.5,10\n"
+        << "A,2024-01-02,1,2,0.5,1.6,10\n";
+  }
+  const qe::MultiDataset ds = qe::load_multi_dataset(p.string());
+  REQUIRE(ds.slice("A").size() == 2);
+  REQUIRE(ds.slice("A").close[1] == 1.6);
+
+  const fs::path bad = temp_path("long_bad.csv");
+  {
+    std::ofstream out(bad, std::ios::binary);
+    out << "symbol,timestamp,open,high,low,close,volume\n"
+        << "A,2024-01-01,1,2,0.5,1.5,10\n"
+        << ",2024-01-02,1,2,0.5,1.5,10\n";
+  }
+  try {
+    qe::load_multi_dataset(bad.string());
+    FAIL("expected a parse error");
+  } catch (const std::runtime_error& ex) {
+    REQUIRE(std::string(ex.what()).find("at line 3") != std::string::npos);
+    REQUIRE(std::string(ex.what()).find("symbol") != std::string::npos);
+  }
+
+  const fs::path plain = temp_path("plain.csv");
+  write_symbol_csv(plain, 0, 3);
+  REQUIRE_FALSE(qe::is_multi_symbol_source(plain.string()));
+  REQUIRE_THROWS_AS(qe::load_multi_dataset(plain.string()), std::runtime_error);
+}
+
+TEST_CASE("load_multi_dataset: directory of csv and qec files", "[multi]") {
+  const fs::path dir = temp_path("dir");
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  write_symbol_csv(dir / "MSFT.csv", 1, 25);
+  write_symbol_csv(dir / "AAPL.csv", 0, 30);
+  write_symbol_csv(temp_path("goog_src.csv"), 2, 12);
+  qe::write_qec((dir / "GOOG.qec").string(), qe::read_ohlcv_columns(temp_path("goog_src.csv").string()).view());
+  std::ofstream(dir / "notes.txt") << "ignored";
+
+  REQUIRE(qe::is_multi_symbol_source(dir.string()));
+  for (std::size_t threads : {1u, 3u}) {
+    const qe::MultiDataset ds = qe::load_multi_dataset(dir.string(), {.threads = threads});
+    REQUIRE(ds.symbol_count() == 3);
+    REQUIRE(ds.symbols().names() == std::vector<std::string>{"AAPL", "GOOG", "MSFT"});
+    REQUIRE(ds.size() == 30 + 12 + 25);
+    REQUIRE(ds.slice("GOOG").close[11] == px(2, 11));
+    REQUIRE(ds.slice("MSFT").size() == 25);
+
+    // backtest takes the slice as-is
+    const auto r = qe::backtest_sma_crossover(ds.slice("AAPL").close, 2, 5);
+    const auto ref = qe::backtest_sma_crossover(
+      qe::read_ohlcv_columns((dir / "AAPL.csv").string()).close, 2, 5);
+    REQUIRE(r.equity == ref.equity);
+  }
+
+  const fs::path empty = temp_path("empty_dir");
+  fs::create_directories(empty);
+  REQUIRE_THROWS_AS(qe::load_multi_dataset(empty.string()), std::runtime_error);
+}
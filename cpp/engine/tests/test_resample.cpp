@@ -0,0 +1,156 @@
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "qe/resample.hpp"
+#include "qe/timestamp.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+constexpr std::int64_t kMinute = 60'000'000'000LL;
+
+// minute bars with a gap, starting mid-hour
+static qe::OhlcvColumns minute_bars() {
+  qe::OhlcvColumns c;
+  const std::int64_t t0 = qe::parse_timestamp_ns("2024-03-01T09:58:00Z");
+  for (std::int64_t m = 0; m < 130; ++m) {
+    if (m >= 40 && m < 50) continue; // missing minutes
+    const double x = 100.0 + static_cast<double>(m % 17) - static_cast<double>(m % 5);
+    c.push_back(t0 + m * kMinute, x, x + 2.0, x - 3.0, x + 0.5, static_cast<double>(m + 1));
+  }
+  return c;
+}
+
+TEST_CASE("parse_bar_interval", "[resample]") {
+  REQUIRE(qe::parse_bar_interval("30s") == 30'000'000'000LL);
+  REQUIRE(qe::parse_bar_interval("5m") == 5 * kMinute);
+  REQUIRE(qe::parse_bar_interval("15min") == 15 * kMinute);
+  REQUIRE(qe::parse_bar_interval("1h") == 60 * kMinute);
+  REQUIRE(qe::parse_bar_interval("1d") == 1440 * kMinute);
+
+  REQUIRE_THROWS_AS(qe::parse_bar_interval(""), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_bar_interval("h"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_bar_interval("0m"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_bar_interval("-5m"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_bar_interval("5x"), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::parse_bar_interval("99999999999999d"), std::invalid_argument);
+}
+
+TEST_CASE("resample: aggregates OHLCV into aligned buckets", "[resample]") {
+  const qe::OhlcvColumns in = minute_bars();
+  const qe::OhlcvColumns out = qe::resample(in.view(), qe::parse_bar_interval("1h"));
+
+  // 09:58-09:59, 10:00-10:59 (with the gap), 11:00-11:59, 12:00-12:07
+  REQUIRE(out.size() == 4);
+  REQUIRE(out.ts[0] == qe::parse_timestamp_ns("2024-03-01T09:00:00Z"));
+  REQUIRE(out.ts[1] == qe::parse_timestamp_ns("2024-03-01T10:00:00Z"));
+  REQUIRE(out.ts[2] == qe::parse_timestamp_ns("2024-03-01T11:00:00Z"));
+
+  // reference by brute force over the input
+  for (std::size_t b = 0; b < out.size(); ++b) {
+    bool first = true;
+    double o = 0, h = 0, l = 0, c = 0, v = 0;
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      if (in.ts[i] < out.ts[b] || in.ts[i] >= out.ts[b] + 60 * kMinute) continue;
+      if (first) { o = in.open[i]; h = in.high[i]; l = in.low[i]; first = false; }
+      h = std::max(h, in.high[i]);
+      l = std::min(l, in.low[i]);
+      c = in.close[i];
+      v += in.volume[i];
+    }
+    REQUIRE(out.open[b] == o);
+    REQUIRE(out.high[b] == h);
+    REQUIRE(out.low[b] == l);
+    REQUIRE(out.close[b] == c);
+    REQUIRE(out.volume[b] == v);
+  }
+
+  // buckets with no input bars are skipped, not filled
+  const qe::OhlcvColumns five = qe::resample(in.view(), 5 * kMinute);
+  for (std::size_t i = 1; i < five.size(); ++i) {
+    REQUIRE(five.ts[i] - five.ts[i - 1] >= 5 * kMinute);
+    REQUIRE(five.ts[i] % (5 * kMinute) == 0);
+  }
+  REQUIRE(five.size() == 27 - 1); // 09:55 .. 12:05, minus the empty 10:40 bucket
+
+  REQUIRE(qe::resample(qe::OhlcvColumns{}.view(), kMinute).empty());
+}
+
+TEST_CASE("Resampler: batch-by-batch equals the whole table", "[resample]") {
+  const qe::OhlcvColumns in = minute_bars();
+  const qe::OhlcvColumns whole = qe::resample(in.view(), 7 * kMinute);
+
+  for (std::size_t step : {1u, 3u, 64u, 1000u}) {
+    qe::Resampler rs(7 * kMinute);
+    qe::OhlcvColumns joined;
+    qe::OhlcvColumns part;
+    auto append = [&] {
+      for (std::size_t i = 0; i < part.size(); ++i) {
+        joined.push_back(part.ts[i], part.open[i], part.high[i], part.low[i], part.close[i], part.volume[i]);
+      }
+    };
+    for (std::size_t i = 0; i < in.size(); i += step) {
+      rs.process(in.view().subview(i, std::min(step, in.size() - i)), part);
+      append();
+    }
+    rs.finish(part);
+    append();
+
+    REQUIRE(joined.ts == whole.ts);
+    REQUIRE(joined.open == whole.open);
+    REQUIRE(joined.high == whole.high);
+    REQUIRE(joined.low == whole.low);
+    REQUIRE(joined.close == whole.close);
+    REQUIRE(joined.volume == whole.volume);
+  }
+}
+
+TEST_CASE("Resampler: rejects out-of-order input and bad intervals", "[resample]") {
+  qe::OhlcvColumns in;
+  in.push_back(2 * kMinute, 1, 1, 1, 1, 1);
+  in.push_back(0, 1, 1, 1, 1, 1);
+  REQUIRE_THROWS_AS(qe::resample(in.view(), kMinute), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::Resampler(0), std::invalid_argument);
+
+  // a close-only projection cannot be aggregated
+  qe::OhlcvView close_only;
+  close_only.close = in.view().close;
+  REQUIRE_THROWS_AS(qe::resample(close_only, kMinute), std::invalid_argument);
+
+  // pre-epoch bars floor into the bucket that starts before them
+  qe::OhlcvColumns early;
+  early.push_back(-kMinute, 1, 1, 1, 1, 1);
+  REQUIRE(qe::resample(early.view(), 60 * kMinute).ts[0] == -60 * kMinute);
+
+  // ...unless that bucket would start before the int64 range
+  const std::int64_t huge = qe::parse_bar_interval("100000d");
+  REQUIRE(qe::resample(early.view(), huge).ts[0] == -huge);
+  qe::OhlcvColumns earlier;
+  earlier.push_back(-huge - 1, 1, 1, 1, 1, 1);
+  REQUIRE_THROWS_AS(qe::resample(earlier.view(), huge), std::invalid_argument);
+  qe::OhlcvColumns oldest;
+  oldest.push_back(std::numeric_limits<std::int64_t>::min() + 1, 1, 1, 1, 1, 1);
+  REQUIRE_THROWS_AS(qe::resample(oldest.view(), 60 * kMinute), std::invalid_argument);
+}
+
+TEST_CASE("resample: NaN highs and lows are skipped wherever they fall in a bucket", "[resample]") {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  qe::OhlcvColumns in;
+  // first bucket: NaN high / low on its first bar; second: on a later bar; third: all NaN
+  in.push_back(0, 10, nan, nan, 10, 1);
+  in.push_back(kMinute, 10, 12, 8, 11, 1);
+  in.push_back(60 * kMinute, 10, 13, 7, 10, 1);
+  in.push_back(61 * kMinute, 10, nan, nan, 11, 1);
+  in.push_back(120 * kMinute, 10, nan, nan, 10, 1);
+
+  const qe::OhlcvColumns out = qe::resample(in.view(), 60 * kMinute);
+  REQUIRE(out.size() == 3);
+  REQUIRE(out.high[0] == 12);
+  REQUIRE(out.low[0] == 8);
+  REQUIRE(out.high[1] == 13);
+  REQUIRE(out.low[1] == 7);
+  REQUIRE(std::isnan(out.high[2]));
+  REQUIRE(std::isnan(out.low[2]));
+}
@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "qe/backtest.hpp"
+#include "qe/dispatch.hpp"
+#include "qe/indicator_cache.hpp"
+#include "qe/indicators.hpp"
+#include "qe/strategy.hpp"
+#include "qe/sweep.hpp"
+#include "test_support.hpp"
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+using Catch::Approx;
+using qe_test::IsaGuard;
+using qe_test::random_walk;
+using qe_test::same_bits;
+using qe_test::SmaPositions;
+using qe_test::supported_isas;
+
+namespace {
+
+std::vector<double> test_closes(std::size_t n) { return random_walk(n, 77, 80.0, 0.04); }
+
+void require_same(const qe::BacktestResult& got, const qe::BacktestResult& want) {
+  REQUIRE(got.strat_ret.size() == want.strat_ret.size());
+  for (std::size_t i = 0; i < got.strat_ret.size(); ++i) {
+    INFO("step " << i);
+    REQUIRE(same_bits(got.strat_ret[i], want.strat_ret[i]));
+    REQUIRE(same_bits(got.equity[i], want.equity[i]));
+  }
+  REQUIRE(same_bits(got.total_return, want.total_return));
+  REQUIRE(same_bits(got.sharpe, want.sharpe));
+  REQUIRE(same_bits(got.max_drawdown, want.max_drawdown));
+  REQUIRE(same_bits(got.win_rate, want.win_rate));
+  REQUIRE(got.n_trades == want.n_trades);
+  REQUIRE(same_bits(got.total_cost, want.total_cost));
+}
+
+struct AlwaysLong {
+  int on_bar(std::span<const double>, std::size_t) { return 1; }
+};
+
+// Breakout by scanning both channels every bar
+struct ScanBreakout {
+  std::size_t fast;
+  std::size_t slow;
+  int pos = 0;
+
+  int on_bar(std::span<const double> close, std::size_t i) {
+    const double c = close[i];
+    if (i >= slow) {
+      double hi = close[i - slow];
+      for (std::size_t j = i + 1 - slow; j < i; ++j) hi = std::max(hi, close[j]);
+      if (c > hi) return pos = 1;
+    }
+    if (i >= fast) {
+      double lo = close[i - fast];
+      for (std::size_t j = i + 1 - fast; j < i; ++j) lo = std::min(lo, close[j]);
+      if (c < lo) pos = 0;
+    }
+    return pos;
+  }
+};
+
+// records the closes each bar could see
+struct SeenCloses {
+  std::vector<std::size_t>* seen;
+
+  int on_bar(std::span<const double> close, std::size_t) {
+    seen->push_back(close.size());
+    return 1;
+  }
+};
+
+static_assert(qe::Strategy<SmaPositions>);
+static_assert(qe::Strategy<qe::Breakout>);
+static_assert(!qe::Strategy<int>);
+
+} // namespace
+
+TEST_CASE("strategy: the engine reproduces backtest_sma_crossover from its positions", "[strategy]") {
+  IsaGuard guard;
+  std::vector<double> close = test_closes(1500);
+  close[700] = std::nan("");
+  close[900] = 0.0;
+  const std::span<const double> tail(close.data() + 1, close.size() - 1);
+  const std::vector<double> fast = qe::rolling_mean(tail, 9);
+  const std::vector<double> slow = qe::rolling_mean(tail, 40);
+
+  for (qe::Isa isa : supported_isas()) {
+    qe::set_active_isa(isa);
+    for (const qe::BacktestCosts costs : {qe::BacktestCosts{}, qe::BacktestCosts{4.0, 2.0}}) {
+      INFO(qe::isa_name(isa) << ", cost " << costs.per_trade());
+      const qe::BacktestResult want = qe::backtest_sma_crossover(close, 9, 40, 3.0, costs);
+      const qe::BacktestResult got = qe::backtest_strategy(close, SmaPositions{&fast, &slow}, 3.0, costs);
+      require_same(got, want);
+
+      // metrics only runs the strategy a second time from a fresh copy
+      const qe::BacktestResult lean = qe::backtest_strategy(close, SmaPositions{&fast, &slow}, 3.0, costs,
+                                                            qe::BacktestOutput::MetricsOnly);
+      REQUIRE(lean.equity.empty());
+      REQUIRE(lean.strat_ret.empty());
+      REQUIRE(same_bits(lean.sharpe, want.sharpe));
+      REQUIRE(same_bits(lean.max_drawdown, want.max_drawdown));
+      REQUIRE(same_bits(lean.total_cost, want.total_cost));
+    }
+  }
+}
+
+TEST_CASE("strategy: costs are charged on every change of position", "[strategy]") {
+  const std::vector<double> close = {10.0, 11.0, 12.1, 11.0, 13.2};
+  const qe::BacktestCosts costs{8.0, 2.0}; // 0.1%
+  const qe::BacktestResult r = qe::backtest_strategy(close, AlwaysLong{}, 100.0, costs);
+  REQUIRE(r.n_trades == 1);
+  REQUIRE(r.total_cost == Approx(0.1));
+  REQUIRE(r.strat_ret[0] == Approx(0.1 - 0.001));
+  REQUIRE(r.strat_ret[1] == Approx(0.1));
+  REQUIRE(r.equity.back() == Approx(100.0 * 1.099 * 1.2));
+
+  REQUIRE_THROWS_AS(qe::backtest_strategy(std::vector<double>{1.0}, AlwaysLong{}), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::backtest_strategy(close, AlwaysLong{}, 0.0), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::backtest_strategy(close, AlwaysLong{}, 1.0, qe::BacktestCosts{-1.0, 0.0}),
+                    std::invalid_argument);
+  std::vector<double> short_out(2);
+  REQUIRE_THROWS_AS(qe::backtest_strategy(close, AlwaysLong{}, 1.0, {}, short_out, short_out),
+                    std::invalid_argument);
+}
+
+TEST_CASE("strategy: breakout enters above the slow channel and exits below the fast one", "[strategy]") {
+  // the 13 breaks out at step 4 and is held over the drop to 9; the 9 exits at step 5; the 14
+  // breaks out at step 8
+  const std::vector<double> close = {10.0, 11.0, 12.0, 11.0, 13.0, 9.0, 8.0, 10.0, 14.0, 15.0};
+  const qe::BacktestResult r = qe::backtest_strategy(close, qe::Breakout(2, 3));
+  const std::vector<double> want = {0.0, 0.0, 0.0, 0.0, -4.0 / 13.0, 0.0, 0.0, 0.0, 1.0 / 14.0};
+  REQUIRE(r.strat_ret.size() == want.size());
+  for (std::size_t i = 0; i < want.size(); ++i) {
+    INFO("step " << i);
+    REQUIRE(r.strat_ret[i] == Approx(want[i]));
+  }
+  REQUIRE(r.n_trades == 3);
+
+  // the rolling channels against a scan of every window, on a random walk and on a steady
+  // fall then rise, where every bar expires a channel's extreme
+  std::vector<double> trend(600);
+  for (std::size_t i = 0; i < trend.size(); ++i) {
+    trend[i] = i < 300 ? 500.0 - static_cast<double>(i) : 200.0 + static_cast<double>(i - 300);
+  }
+  for (const std::vector<double>& series : {test_closes(2000), trend}) {
+    for (const qe::WindowPair w : {qe::WindowPair{1, 2}, qe::WindowPair{5, 20}, qe::WindowPair{13, 55}}) {
+      INFO(series.size() << " closes, " << w.fast << "/" << w.slow);
+      require_same(qe::backtest_strategy(series, qe::Breakout(w.fast, w.slow), 1.0, {2.0, 1.0}),
+                   qe::backtest_strategy(series, ScanBreakout{w.fast, w.slow}, 1.0, {2.0, 1.0}));
+    }
+  }
+
+  REQUIRE_THROWS_AS(qe::Breakout(0, 5), std::invalid_argument);
+}
+
+TEST_CASE("strategy: a bar sees only the closes up to the one its step starts from", "[strategy]") {
+  const std::vector<double> close = test_closes(1200);
+  std::vector<std::size_t> seen;
+  qe::backtest_strategy(close, SeenCloses{&seen});
+  REQUIRE(seen.size() == close.size() - 1);
+  for (std::size_t i = 0; i < seen.size(); ++i) REQUIRE(seen[i] == i + 1);
+
+  // so a breakout's entries are not picked by the bar they trade: on a driftless walk some
+  // entry steps lose
+  const qe::BacktestResult r = qe::backtest_strategy(close, qe::Breakout(10, 20));
+  std::size_t entries = 0;
+  std::size_t losing = 0;
+  for (std::size_t i = 1; i < r.strat_ret.size(); ++i) {
+    if (r.strat_ret[i] != 0.0 && r.strat_ret[i - 1] == 0.0) {
+      ++entries;
+      if (r.strat_ret[i] < 0.0) ++losing;
+    }
+  }
+  REQUIRE(entries > 5);
+  REQUIRE(losing > 0);
+}
+
+TEST_CASE("strategy: the registry runs every strategy by name, alone, batched and swept", "[strategy]") {
+  const std::vector<double> close = test_closes(900);
+  const qe::BacktestCosts costs{1.0, 1.0};
+
+  REQUIRE(qe::strategies().size() == 2);
+  REQUIRE(std::string(qe::strategies()[0].name) == "sma_crossover");
+  REQUIRE(qe::find_strategy("sma_crossover").cached == nullptr);
+  REQUIRE(qe::find_strategy("breakout").cached != nullptr);
+  REQUIRE_THROWS_AS(qe::find_strategy("momentum"), std::invalid_argument);
+
+  const qe::StrategyKernels& sma = qe::find_strategy("sma_crossover");
+  for (const qe::WindowPair w : {qe::WindowPair{5, 20}, qe::WindowPair{7, 30}}) {
+    INFO(w.fast << "/" << w.slow);
+    require_same(qe::run_backtest(sma, close, w, 2.0, costs),
+                 qe::backtest_sma_crossover(close, w.fast, w.slow, 2.0, costs));
+  }
+
+  const qe::StrategyKernels& breakout = qe::find_strategy("breakout");
+  require_same(qe::run_backtest(breakout, close, {10, 40}, 2.0, costs),
+               qe::backtest_strategy(close, qe::Breakout(10, 40), 2.0, costs));
+  REQUIRE_THROWS_AS(qe::run_backtest(breakout, close, {40, 10}), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::run_backtest(breakout, close, {10, 900}), std::invalid_argument);
+
+  // the cached kernel over the channels the cache holds, bit for bit
+  qe::IndicatorCache cache;
+  const qe::SeriesSource src = qe::make_series_source(close, "close");
+  std::vector<double> strat_ret(close.size() - 1);
+  std::vector<double> equity(close.size() - 1);
+  qe::BacktestResult via_cache = breakout.cached(src, {10, 40}, 2.0, costs, cache, strat_ret, equity);
+  via_cache.strat_ret = strat_ret;
+  via_cache.equity = equity;
+  require_same(via_cache, qe::run_backtest(breakout, close, {10, 40}, 2.0, costs));
+  REQUIRE_THROWS_AS(breakout.cached(src, {40, 10}, 1.0, {}, cache, {}, {}), std::invalid_argument);
+
+  // swept with and without a cache; only breakout uses it
+  const std::vector<qe::WindowPair> grid = qe::sma_grid({5, 25, 10}, {20, 80, 20});
+  for (const qe::StrategyKernels* s : {&sma, &breakout}) {
+    qe::IndicatorCache shared;
+    qe::SweepOptions opts;
+    opts.threads = 2;
+    opts.costs = costs;
+    const std::vector<qe::SweepRow> rows = qe::sweep_strategy(*s, close, grid, opts);
+    opts.cache = &shared;
+    const std::vector<qe::SweepRow> cached_rows = qe::sweep_strategy(*s, close, grid, opts);
+    const std::vector<qe::BacktestResult> batch = s->batch(close, grid, 1.0, costs);
+    REQUIRE(rows.size() == grid.size());
+    REQUIRE(batch.size() == grid.size());
+    for (std::size_t i = 0; i < grid.size(); ++i) {
+      INFO(s->name << " " << grid[i].fast << "/" << grid[i].slow);
+      const qe::BacktestResult want =
+        qe::run_backtest(*s, close, grid[i], 1.0, costs, qe::BacktestOutput::MetricsOnly);
+      REQUIRE(same_bits(batch[i].sharpe, want.sharpe));
+      REQUIRE(same_bits(batch[i].total_return, want.total_return));
+      REQUIRE(same_bits(rows[i].sharpe, want.sharpe));
+      REQUIRE(same_bits(rows[i].max_drawdown, want.max_drawdown));
+      REQUIRE(rows[i].n_trades == want.n_trades);
+      REQUIRE(same_bits(cached_rows[i].sharpe, want.sharpe));
+      REQUIRE(same_bits(cached_rows[i].max_drawdown, want.max_drawdown));
+      REQUIRE(cached_rows[i].n_trades == want.n_trades);
+    }
+    const qe::IndicatorCacheStats st = shared.stats();
+    if (s == &sma) {
+      REQUIRE(st.hits + st.misses == 0);
+    } else {
+      // one channel per fast window (5, 15, 25) and per slow window (20, 40, 60, 80)
+      REQUIRE(st.entries == 7);
+      REQUIRE(st.hits + st.misses == 2 * grid.size());
+      REQUIRE(st.hits >= 2 * grid.size() - 2 * 7); // two threads may both miss a key
+    }
+  }
+}
@@ -0,0 +1,228 @@
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "qe/backtest.hpp"
+#include "qe/bar_stream.hpp"
+#include "qe/csv_reader.hpp"
+#include "qe/indicators.hpp"
+#include "qe/qec.hpp"
+#include "qe/report.hpp"
+#include "qe/streaming.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+namespace fs = std::filesystem;
+
+static fs::path temp_path(const std::string& name) {
+  return fs::temp_directory_path() / fs::path("qe_streaming_test_" + name);
+}
+
+static std::vector<double> wavy_close(std::size_t n) {
+  std::vector<double> c;
+  c.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    const double x = static_cast<double>(i);
+    c.push_back(100.0 + 10.0 * std::sin(x * 0.07) + 3.0 * std::cos(x * 0.31) + x * 0.01);
+  }
+  return c;
+}
+
+static void write_csv(const fs::path& p, const std::vector<double>& close) {
+  std::ofstream out(p, std::ios::binary);
+  out << "timestamp,open,high,low,close,volume\n";
+  for (std::size_t i = 0; i < close.size(); ++i) {
+    out << "2024-01-01T00:" << (i / 60 % 60 < 10 ? "0" : "") << (i / 60 % 60) << ":"
+        << (i % 60 < 10 ? "0" : "") << (i % 60) << "Z,"
+        << close[i] << "," << close[i] + 1 << "," << close[i] - 1 << "," << close[i] << ","
+        << 100 + i << "\n";
+  }
+}
+
+// feeds values through a stream object in uneven batches and concatenates the output
+template <class Stream>
+static std::vector<double> run_in_batches(Stream& s, const std::vector<double>& v, std::size_t step) {
+  std::vector<double> all;
+  std::vector<double> part;
+  for (std::size_t i = 0; i < v.size(); ) {
+    const std::size_t n = std::min(step, v.size() - i);
+    s.process(std::span<const double>(v).subspan(i, n), part);
+    all.insert(all.end(), part.begin(), part.end());
+    i += n;
+    step = step % 7 + 1; // vary the split
+  }
+  return all;
+}
+
+static bool same(double a, double b) {
+  return (std::isnan(a) && std::isnan(b)) || a == b;
+}
+
+TEST_CASE("BarStream: csv batches reproduce read_ohlcv_columns", "[stream]") {
+  const fs::path p = temp_path("bars.csv");
+  write_csv(p, wavy_close(1000));
+  const qe::OhlcvColumns whole = qe::read_ohlcv_columns(p.string());
+
+  // tiny read buffer forces lines to straddle refills
+  qe::BarStream s(p.string(), {.batch_rows = 33, .max_bytes = 64 * 1024 + 33 * 48});
+  REQUIRE(s.batch_rows() == 33);
+
+  qe::OhlcvColumns batch;
+  std::size_t row = 0;
+  while (s.next(batch)) {
+    REQUIRE(batch.size() <= 33);
+    for (std::size_t i = 0; i < batch.size(); ++i, ++row) {
+      REQUIRE(batch.ts[i] == whole.ts[row]);
+      REQUIRE(batch.close[i] == whole.close[row]);
+      REQUIRE(batch.volume[i] == whole.volume[row]);
+    }
+  }
+  REQUIRE(row == whole.size());
+  REQUIRE(s.rows_read() == whole.size());
+}
+
+TEST_CASE("BarStream: qec batches reproduce the file", "[stream]") {
+  const fs::path csv = temp_path("bars_for_qec.csv");
+  write_csv(csv, wavy_close(777));
+  const qe::OhlcvColumns whole = qe::read_ohlcv_columns(csv.string());
+  const fs::path p = temp_path("bars.qec");
+  qe::write_qec(p.string(), whole.view());
+
+  qe::BarStream s(p.string(), {.batch_rows = 100});
+  qe::OhlcvColumns batch;
+  qe::OhlcvColumns joined;
+  while (s.next(batch)) {
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      joined.push_back(batch.ts[i], batch.open[i], batch.high[i], batch.low[i], batch.close[i],
+                       batch.volume[i]);
+    }
+  }
+  REQUIRE(joined.ts == whole.ts);
+  REQUIRE(joined.open == whole.open);
+  REQUIRE(joined.close == whole.close);
+  REQUIRE(joined.volume == whole.volume);
+}
+
+TEST_CASE("BarStream: projected batches carry only the selected columns", "[stream]") {
+  const fs::path csv = temp_path("bars_projected.csv");
+  write_csv(csv, wavy_close(5000));
+  const qe::OhlcvColumns whole = qe::read_ohlcv_columns(csv.string());
+  const fs::path plain = temp_path("bars_projected.qec");
+  const fs::path packed = temp_path("bars_projected_c.qec");
+  qe::write_qec(plain.string(), whole.view());
+  qe::write_qec(packed.string(), whole.view(), {.compress = true});
+
+  for (const fs::path& p : {csv, plain, packed}) {
+    qe::BarStream s(p.string(), {.batch_rows = 999, .columns = qe::Columns::Close});
+    qe::OhlcvColumns batch;
+    std::vector<double> close;
+    while (s.next(batch)) {
+      REQUIRE(batch.ts.empty());
+      REQUIRE(batch.open.empty());
+      REQUIRE(batch.volume.empty());
+      REQUIRE(batch.size() == batch.close.size());
+      close.insert(close.end(), batch.close.begin(), batch.close.end());
+    }
+    REQUIRE(close == whole.close);
+    REQUIRE(s.rows_read() == whole.size());
+  }
+}
+
+TEST_CASE("BarStream: parse errors carry the file line number", "[stream]") {
+  const fs::path p = temp_path("bad.csv");
+  {
+    std::ofstream out(p, std::ios::binary);
+    out << "timestamp,open,high,low,close,volume\n"
+        << "2024-01-01,1,2,0.5,1.5,10\n"
+        << "2024-01-02,1,2,0.5,oops,10\n";
+  }
+
+  qe::BarStream s(p.string(), {.batch_rows = 1});
+  qe::OhlcvColumns batch;
+  REQUIRE(s.next(batch));
+  try {
+    s.next(batch);
+    FAIL("expected a parse error");
+  } catch (const std::runtime_error& ex) {
+    REQUIRE(std::string(ex.what()).find("at line 3") != std::string::npos);
+    REQUIRE(std::string(ex.what()).find("close") != std::string::npos);
+  }
+
+  REQUIRE_THROWS_AS(qe::BarStream(p.string(), {.batch_rows = 0}), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::BarStream(temp_path("missing.csv").string()), std::runtime_error);
+}
+
+TEST_CASE("stream indicators: match the batch functions across any split", "[stream]") {
+  const std::vector<double> v = wavy_close(500);
+
+  qe::ReturnsStream rs;
+  const std::vector<double> r_ref = qe::compute_returns(v);
+  const std::vector<double> r = run_in_batches(rs, v, 5);
+  REQUIRE(r.size() == r_ref.size());
+  for (std::size_t i = 0; i < r.size(); ++i) REQUIRE(same(r[i], r_ref[i]));
+
+  for (std::size_t w : {1u, 3u, 20u, 499u, 600u}) {
+    qe::RollingMeanStream ms(w);
+    const std::vector<double> m_ref = qe::rolling_mean(v, w);
+    const std::vector<double> m = run_in_batches(ms, v, 3);
+    REQUIRE(m.size() == m_ref.size());
+    for (std::size_t i = 0; i < m.size(); ++i) REQUIRE(same(m[i], m_ref[i]));
+
+    qe::RollingStdStream ss(w);
+    const std::vector<double> s_ref = qe::rolling_std(v, w);
+    const std::vector<double> s = run_in_batches(ss, v, 4);
+    REQUIRE(s.size() == s_ref.size());
+    for (std::size_t i = 0; i < s.size(); ++i) REQUIRE(same(s[i], s_ref[i]));
+  }
+
+  REQUIRE_THROWS_AS(qe::RollingMeanStream(0), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::RollingStdStream(0), std::invalid_argument);
+}
+
+TEST_CASE("SmaCrossoverStream: matches backtest_sma_crossover", "[stream]") {
+  const std::vector<double> close = wavy_close(2000);
+  const qe::BacktestCosts costs{2.0, 1.5};
+  const qe::BacktestResult ref = qe::backtest_sma_crossover(close, 5, 30, 1000.0, costs);
+
+  qe::SmaCrossoverStream bt(5, 30, 1000.0, costs);
+  std::vector<double> equity;
+  std::vector<double> part;
+  for (std::size_t i = 0; i < close.size(); i += 97) {
+    const std::size_t n = std::min<std::size_t>(97, close.size() - i);
+    bt.process(std::span<const double>(close).subspan(i, n), &part);
+    equity.insert(equity.end(), part.begin(), part.end());
+  }
+
+  REQUIRE(equity == ref.equity);
+  REQUIRE(bt.steps() == ref.equity.size());
+  REQUIRE(bt.final_equity() == ref.equity.back());
+  REQUIRE(bt.win_rate() == qe::compute_win_rate(ref.strat_ret));
+
+  const qe::BacktestResult r = bt.result();
+  REQUIRE(r.total_return == ref.total_return);
+  REQUIRE(r.max_drawdown == ref.max_drawdown);
+  REQUIRE(r.sharpe == Catch::Approx(ref.sharpe).epsilon(1e-9));
+  REQUIRE(r.n_trades == ref.n_trades);
+  REQUIRE(r.n_trades > 0);
+  REQUIRE(r.total_cost == ref.total_cost);
+}
+
+TEST_CASE("SmaCrossoverStream: validates like the batch backtest", "[stream]") {
+  REQUIRE_THROWS_AS(qe::SmaCrossoverStream(0, 5), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::SmaCrossoverStream(5, 5), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::SmaCrossoverStream(2, 5, 0.0), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::SmaCrossoverStream(2, 5, 1.0, {-1.0, 0.0}), std::invalid_argument);
+
+  qe::SmaCrossoverStream bt(2, 5);
+  const std::vector<double> few = {1, 2, 3, 4, 5};
+  bt.process(few);
+  REQUIRE_THROWS_AS(bt.result(), std::invalid_argument);
+  const std::vector<double> one_more = {6};
+  bt.process(one_more);
+  REQUIRE_NOTHROW(bt.result());
+}
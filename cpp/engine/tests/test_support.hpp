@@ -0,0 +1,91 @@
+#pragma once
+
+// Helpers shared by the test files.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "qe/dispatch.hpp"
+
+namespace qe_test {
+
+// restores the variant that was active before the test
+struct IsaGuard {
+  qe::Isa saved = qe::active_isa();
+  ~IsaGuard() { qe::set_active_isa(saved); }
+};
+
+// every kernel variant this CPU can run, scalar first
+inline std::vector<qe::Isa> supported_isas() {
+  std::vector<qe::Isa> out;
+  for (qe::Isa isa : {qe::Isa::Scalar, qe::Isa::Avx2, qe::Isa::Avx512}) {
+    if (static_cast<int>(isa) <= static_cast<int>(qe::detected_isa())) out.push_back(isa);
+  }
+  return out;
+}
+
+// bit-for-bit equality, so NaNs compare equal to the same NaN and 0.0 differs from -0.0
+inline bool same_bits(double a, double b) {
+  std::uint64_t x = 0;
+  std::uint64_t y = 0;
+  std::memcpy(&x, &a, sizeof x);
+  std::memcpy(&y, &b, sizeof y);
+  return x == y;
+}
+
+inline bool same_bits(const std::vector<double>& a, const std::vector<double>& b) {
+  return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+}
+
+// deterministic 64-bit LCG (Knuth's MMIX constants)
+class Lcg {
+public:
+  explicit Lcg(std::uint64_t seed) : state_(seed) {}
+
+  std::uint64_t next() {
+    state_ = state_ * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state_;
+  }
+
+  // uniform in [-0.5, 0.5), from the top 53 bits
+  double uniform() { return static_cast<double>(next() >> 11) / 9007199254740992.0 - 0.5; }
+
+private:
+  std::uint64_t state_;
+};
+
+// n closes of a random walk from start; each step moves the price by a uniform fraction in
+// [-step / 2, step / 2)
+inline std::vector<double> random_walk(std::size_t n, std::uint64_t seed, double start, double step) {
+  std::vector<double> c(n);
+  Lcg rng(seed);
+  double p = start;
+  for (std::size_t i = 0; i < n; ++i) {
+    p *= 1.0 + rng.uniform() * step;
+    c[i] = p;
+  }
+  return c;
+}
+
+// the SMA crossover as a Strategy, reading SMAs over close[1..] computed up front
+struct SmaPositions {
+  const std::vector<double>* fast;
+  const std::vector<double>* slow;
+  int pos = 0;
+
+  int on_bar(std::span<const double>, std::size_t i) {
+    const double f = (*fast)[i];
+    const double s = (*slow)[i];
+    if (!std::isnan(f) && !std::isnan(s)) pos = f > s ? 1 : 0;
+    return pos;
+  }
+};
+
+} // namespace qe_test
+
+// heap allocations so far in this test binary (tests/heap_count.cpp)
+std::size_t heap_allocations();
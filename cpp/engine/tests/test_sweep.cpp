@@ -0,0 +1,129 @@
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "qe/backtest.hpp"
+#include "qe/dispatch.hpp"
+#include "qe/report.hpp"
+#include "qe/sweep.hpp"
+#include "test_support.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using qe_test::IsaGuard;
+using qe_test::random_walk;
+using qe_test::same_bits;
+using qe_test::supported_isas;
+
+namespace {
+
+// random walk with a NaN close halfway
+std::vector<double> test_closes(std::size_t n) {
+  std::vector<double> c = random_walk(n, 2024, 50.0, 0.03);
+  c[n / 2] = std::nan("");
+  return c;
+}
+
+} // namespace
+
+TEST_CASE("sweep: window ranges and grids", "[sweep]") {
+  const qe::WindowRange r = qe::parse_window_range("5:50:5");
+  REQUIRE(r.lo == 5);
+  REQUIRE(r.hi == 50);
+  REQUIRE(r.step == 5);
+  const qe::WindowRange one = qe::parse_window_range("20");
+  REQUIRE((one.lo == 20 && one.hi == 20 && one.step == 1));
+  REQUIRE(qe::parse_window_range("3:9").step == 1);
+  for (const char* bad : {"", ":", "5:", "a:9", "5:9:x", "-1:5", "5:9:1:2", "1 :5"}) {
+    INFO(bad);
+    REQUIRE_THROWS_AS(qe::parse_window_range(bad), std::invalid_argument);
+  }
+
+  const std::vector<qe::WindowPair> grid = qe::sma_grid({5, 20, 5}, {10, 20, 10});
+  REQUIRE(grid.size() == 4); // 5/10 5/20 10/20 15/20
+  REQUIRE((grid[0].fast == 5 && grid[0].slow == 10));
+  REQUIRE((grid[3].fast == 15 && grid[3].slow == 20));
+  REQUIRE(qe::sma_grid({30, 40, 1}, {10, 20, 1}).empty());
+  REQUIRE_THROWS_AS(qe::sma_grid({5, 20, 0}, {10, 20, 1}), std::invalid_argument);
+  REQUIRE_THROWS_AS(qe::sma_grid({0, 20, 1}, {10, 20, 1}), std::invalid_argument);
+}
+
+TEST_CASE("sweep: every row matches its own backtest, whatever the thread count", "[sweep]") {
+  const std::vector<double> close = test_closes(1500);
+  // 5 x 7 pairs: two full batches and a partial one on one thread
+  const std::vector<qe::WindowPair> grid = qe::sma_grid({5, 30, 5}, {20, 120, 15});
+  REQUIRE(grid.size() > 30);
+
+  for (std::size_t threads : {1u, 3u, 8u}) {
+    qe::SweepOptions opts;
+    opts.threads = threads;
+    opts.initial_equity = 10.0;
+    const std::vector<qe::SweepRow> rows = qe::sweep_sma_crossover(close, grid, opts);
+    REQUIRE(rows.size() == grid.size());
+    for (std::size_t i = 0; i < grid.size(); ++i) {
+      INFO("threads " << threads << ", pair " << grid[i].fast << "/" << grid[i].slow);
+      const qe::BacktestResult want = qe::backtest_sma_crossover(close, grid[i].fast, grid[i].slow, 10.0);
+      REQUIRE(rows[i].fast == grid[i].fast);
+      REQUIRE(rows[i].slow == grid[i].slow);
+      REQUIRE(same_bits(rows[i].total_return, want.total_return));
+      REQUIRE(same_bits(rows[i].sharpe, want.sharpe));
+      REQUIRE(same_bits(rows[i].max_drawdown, want.max_drawdown));
+      REQUIRE(same_bits(rows[i].win_rate, qe::compute_win_rate(want.strat_ret)));
+    }
+  }
+}
+
+TEST_CASE("sweep: the batch kernel matches one backtest per pair on every variant", "[sweep]") {
+  IsaGuard guard;
+  std::vector<double> close = test_closes(700);
+  close[300] = 0.0;
+  // a flat stretch, where SMAs tie and the kernels cannot settle the crossover without dividing
+  for (std::size_t i = 120; i < 200; ++i) close[i] = 40.0;
+  std::vector<qe::WindowPair> pairs;
+  for (std::size_t k = 0; k < 37; ++k) pairs.push_back({1 + (k * 7) % 30, 31 + (k * 13) % 90});
+  pairs.push_back({2, 3});
+  pairs.push_back({50, 699}); // the longest slow window the column allows
+
+  for (qe::Isa isa : supported_isas()) {
+    qe::set_active_isa(isa);
+    for (const qe::BacktestCosts costs : {qe::BacktestCosts{}, qe::BacktestCosts{3.0, 1.5}}) {
+      for (std::size_t count : {1u, 3u, 8u, 16u, 17u, 39u}) {
+        const std::span<const qe::WindowPair> some(pairs.data() + pairs.size() - count, count);
+        const std::vector<qe::BacktestResult> got = qe::backtest_sma_crossover_batch(close, some, 2.0, costs);
+        REQUIRE(got.size() == count);
+        for (std::size_t i = 0; i < count; ++i) {
+          INFO(qe::isa_name(isa) << ", " << count << " pairs, " << some[i].fast << "/" << some[i].slow);
+          const qe::BacktestResult want = qe::backtest_sma_crossover(close, some[i].fast, some[i].slow, 2.0, costs,
+                                                                     qe::BacktestOutput::MetricsOnly);
+          REQUIRE(got[i].strat_ret.empty());
+          REQUIRE(same_bits(got[i].total_return, want.total_return));
+          REQUIRE(same_bits(got[i].sharpe, want.sharpe));
+          REQUIRE(same_bits(got[i].max_drawdown, want.max_drawdown));
+          REQUIRE(same_bits(got[i].win_rate, want.win_rate));
+          REQUIRE(got[i].n_trades == want.n_trades);
+          REQUIRE(same_bits(got[i].total_cost, want.total_cost));
+        }
+      }
+    }
+  }
+
+  REQUIRE(qe::backtest_sma_crossover_batch(close, {}).empty());
+  const std::vector<qe::WindowPair> bad = {{5, 20}, {20, 5}};
+  REQUIRE_THROWS_AS(qe::backtest_sma_crossover_batch(close, bad), std::invalid_argument);
+  const std::vector<qe::WindowPair> too_long = {{5, 700}};
+  REQUIRE_THROWS_AS(qe::backtest_sma_crossover_batch(close, too_long), std::invalid_argument);
+}
+
+TEST_CASE("sweep: validates the grid before running", "[sweep]") {
+  const std::vector<double> close = test_closes(100);
+  REQUIRE(qe::sweep_sma_crossover(close, {}).empty());
+
+  const std::vector<qe::WindowPair> too_long = {{5, 20}, {10, 100}};
+  REQUIRE_THROWS_AS(qe::sweep_sma_crossover(close, too_long), std::invalid_argument);
+  const std::vector<qe::WindowPair> reversed = {{20, 5}};
+  REQUIRE_THROWS_AS(qe::sweep_sma_crossover(close, reversed), std::invalid_argument);
+  qe::SweepOptions opts;
+  opts.initial_equity = 0.0;
+  const std::vector<qe::WindowPair> ok = {{5, 20}};
+  REQUIRE_THROWS_AS(qe::sweep_sma_crossover(close, ok, opts), std::invalid_argument);
+}
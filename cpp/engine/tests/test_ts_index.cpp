@@ -0,0 +1,194 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "qe/csv_reader.hpp"
+#include "qe/dataset.hpp"
+#include "qe/qec.hpp"
+#include "qe/timestamp.hpp"
+#include "qe/ts_index.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace fs = std::filesystem;
+
+static fs::path temp_path(const std::string& name) {
+  return fs::temp_directory_path() / fs::path("qe_ts_index_test_" + name);
+}
+
+constexpr std::int64_t kDay = 86'400'000'000'000LL;
+
+// one bar per day from 2020-01-01, with a blank line and CRLF mixed in
+static void write_daily_csv(const fs::path& p, std::size_t n) {
+  std::ofstream out(p, std::ios::binary);
+  out << "timestamp,open,high,low,close,volume\n";
+  const std::int64_t t0 = qe::parse_timestamp_ns("2020-01-01");
+  for (std::size_t i = 0; i < n; ++i) {
+    if (i == 5) out << "\n";
+    out << qe::format_timestamp(t0 + static_cast<std::int64_t>(i) * kDay) << ","
+        << i << "," << i + 1 << "," << i << "," << i + 0.5 << "," << 10 * i
+        << (i % 3 == 0 ? "\r\n" : "\n");
+  }
+}
+
+// the rows of whole selected by range, computed the slow way
+static qe::OhlcvColumns expected_range(const qe::OhlcvColumns& whole, const qe::TimeRange& range) {
+  std::size_t start = 0;
+  while (start < whole.size() && whole.ts[start] < range.start_ns) ++start;
+  std::size_t stop = start;
+  while (stop < whole.size() && whole.ts[stop] < range.end_ns) ++stop;
+
+  qe::OhlcvColumns out;
+  if (start == stop) return out;
+  const std::size_t first = start - std::min(range.warmup_bars, start);
+  for (std::size_t i = first; i < stop; ++i) {
+    out.push_back(whole.ts[i], whole.open[i], whole.high[i], whole.low[i], whole.close[i], whole.volume[i]);
+  }
+  return out;
+}
+
+TEST_CASE("ts index: range reads match a full parse for any stride", "[ts_index]") {
+  const fs::path p = temp_path("daily.csv");
+  write_daily_csv(p, 200);
+  const qe::OhlcvColumns whole = qe::read_ohlcv_columns(p.string());
+  REQUIRE(whole.size() == 200);
+
+  const std::int64_t t0 = whole.ts.front();
+  const qe::TimeRange ranges[] = {
+    {t0 + 50 * kDay, t0 + 80 * kDay, 0},
+    {t0 + 50 * kDay, t0 + 80 * kDay, 20},
+    {t0 + 3 * kDay, t0 + 10 * kDay, 20},       // warm-up clipped at the first row
+    {t0 + 50 * kDay + 1, t0 + 51 * kDay, 0},   // between bars
+    {t0 + 190 * kDay, t0 + 400 * kDay, 7},     // runs off the end
+    {t0 + 300 * kDay, t0 + 400 * kDay, 7},     // nothing in range
+    {t0 - 10 * kDay, t0 + 1, 5},
+    {},                                        // everything
+  };
+
+  for (std::size_t stride : {1u, 3u, 16u, 4096u}) {
+    const qe::TsIndex index = qe::build_ts_index(p.string(), stride);
+    REQUIRE(index.rows == 200);
+    REQUIRE(index.entries.size() == (200 + stride - 1) / stride);
+
+    for (const auto& range : ranges) {
+      const qe::OhlcvColumns want = expected_range(whole, range);
+      const qe::OhlcvColumns got = qe::read_ohlcv_columns(p.string(), index, range);
+      REQUIRE(got.ts == want.ts);
+      REQUIRE(got.close == want.close);
+      REQUIRE(got.volume == want.volume);
+    }
+  }
+}
+
+TEST_CASE("ts index: sidecar round-trips and is rebuilt when stale", "[ts_index]") {
+  const fs::path p = temp_path("sidecar.csv");
+  write_daily_csv(p, 50);
+  fs::remove(qe::ts_index_path(p.string()));
+
+  const qe::TsIndex built = qe::load_ts_index(p.string());
+  REQUIRE(fs::exists(qe::ts_index_path(p.string())));
+
+  const auto cached = qe::read_ts_index(qe::ts_index_path(p.string()));
+  REQUIRE(cached.has_value());
+  REQUIRE(cached->rows == built.rows);
+  REQUIRE(cached->entries.size() == built.entries.size());
+  REQUIRE(cached->entries[0].offset == built.entries[0].offset);
+
+  // a different file under the same name must not reuse the old index
+  write_daily_csv(p, 80);
+  const qe::TsIndex fresh = qe::load_ts_index(p.string());
+  REQUIRE(fresh.rows == 80);
+
+  // damaged sidecar is ignored
+  {
+    std::ofstream out(qe::ts_index_path(p.string()), std::ios::binary | std::ios::trunc);
+    out << "junk";
+  }
+  REQUIRE_FALSE(qe::read_ts_index(qe::ts_index_path(p.string())).has_value());
+  REQUIRE(qe::load_ts_index(p.string()).rows == 80);
+
+  // a header claiming more entries than the file holds is rejected before allocating
+  {
+    qe::TsIndexHeader h{};
+    std::memcpy(h.magic, qe::kTsIndexMagic, sizeof(qe::kTsIndexMagic));
+    h.version = qe::kTsIndexVersion;
+    h.stride = 1;
+    h.rows = std::uint64_t{1} << 60;
+    h.entries = h.rows;
+    std::ofstream out(qe::ts_index_path(p.string()), std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  }
+  REQUIRE_FALSE(qe::read_ts_index(qe::ts_index_path(p.string())).has_value());
+}
+
+TEST_CASE("ts index: errors", "[ts_index]") {
+  const fs::path p = temp_path("unsorted.csv");
+  {
+    std::ofstream out(p, std::ios::binary);
+    out << "timestamp,open,high,low,close,volume\n"
+        << "2020-01-02,1,1,1,1,1\n"
+        << "2020-01-01,1,1,1,1,1\n";
+  }
+  REQUIRE_THROWS_AS(qe::build_ts_index(p.string(), 1), std::runtime_error);
+
+  // disorder between sampled rows is caught too
+  const fs::path inner = temp_path("unsorted_inner.csv");
+  {
+    std::ofstream out(inner, std::ios::binary);
+    out << "timestamp,open,high,low,close,volume\n"
+        << "2020-01-01,1,1,1,1,1\n"
+        << "2020-01-03,1,1,1,1,1\n"
+        << "2020-01-02,1,1,1,1,1\n"
+        << "2020-01-04,1,1,1,1,1\n";
+  }
+  REQUIRE_THROWS_AS(qe::build_ts_index(inner.string(), 2), std::runtime_error);
+
+  const fs::path bad = temp_path("bad_row.csv");
+  {
+    std::ofstream out(bad, std::ios::binary);
+    out << "timestamp,open,high,low,close,volume\n"
+        << "2020-01-01,1,1,1,1,1\n"
+        << "2020-01-02,1,1,1,x,1\n"
+        << "2020-01-03,1,1,1,1,1\n";
+  }
+  const qe::TsIndex index = qe::build_ts_index(bad.string(), 2);
+  try {
+    qe::read_ohlcv_columns(bad.string(), index, qe::TimeRange{});
+    FAIL("expected a parse error");
+  } catch (const std::runtime_error& ex) {
+    REQUIRE(std::string(ex.what()).find("at line 3") != std::string::npos);
+  }
+  // rows outside the range are never parsed
+  const auto t3 = qe::parse_timestamp_ns("2020-01-03");
+  REQUIRE(qe::read_ohlcv_columns(bad.string(), index, {t3, t3 + kDay, 0}).size() == 1);
+}
+
+TEST_CASE("load_dataset_range: csv and qec agree", "[ts_index]") {
+  const fs::path csv = temp_path("range.csv");
+  write_daily_csv(csv, 120);
+  const qe::OhlcvColumns whole = qe::read_ohlcv_columns(csv.string());
+  const fs::path qec = temp_path("range.qec");
+  qe::write_qec(qec.string(), whole.view());
+
+  const qe::TimeRange range{qe::parse_timestamp_ns("2020-03-01"), qe::parse_timestamp_ns("2020-04-01"), 10};
+  const qe::OhlcvColumns want = expected_range(whole, range);
+  REQUIRE(want.size() == 31 + 10);
+
+  const qe::Dataset from_csv = qe::load_dataset_range(csv.string(), range);
+  const qe::Dataset from_qec = qe::load_dataset_range(qec.string(), range);
+  REQUIRE(from_qec.is_mapped());
+  REQUIRE(from_csv.size() == want.size());
+  REQUIRE(from_qec.size() == want.size());
+  for (std::size_t i = 0; i < want.size(); ++i) {
+    REQUIRE(from_csv.view().ts[i] == want.ts[i]);
+    REQUIRE(from_qec.view().ts[i] == want.ts[i]);
+    REQUIRE(from_qec.view().close[i] == want.close[i]);
+  }
+
+  const qe::TimeRange empty{qe::parse_timestamp_ns("2030-01-01"), qe::parse_timestamp_ns("2030-02-01"), 10};
+  REQUIRE(qe::load_dataset_range(csv.string(), empty).size() == 0);
+  REQUIRE(qe::load_dataset_range(qec.string(), empty).size() == 0);
+}